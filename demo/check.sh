@@ -18,6 +18,71 @@ for i in demo/tests/input/*; do
     fi
 done
 
+# Optimized filters, with or without bind parameters, must return
+# the very same features as the filters written as is
+CONFIG=${TINYOWS_CONFIG_FILE:-/etc/tinyows.xml}
+for mode in plain optimized bound; do
+    case $mode in
+        plain)     attrs='optimize_filter="0" bind_parameters="0"' ;;
+        optimized) attrs='optimize_filter="1" bind_parameters="0"' ;;
+        bound)     attrs='optimize_filter="1" bind_parameters="1"' ;;
+    esac
+    sed -e 's/ optimize_filter="[01]"//' -e 's/ bind_parameters="[01]"//' \
+        -e "s/<tinyows /<tinyows $attrs /" $CONFIG > /tmp/tinyows_$mode.xml
+done
+
+for i in demo/tests/filters/*; do
+    echo "Running $i"
+    for mode in plain optimized bound; do
+        QUERY_STRING="$(cat $i)" TINYOWS_CONFIG_FILE=/tmp/tinyows_$mode.xml ./tinyows | sort > /tmp/output_$mode.txt
+    done
+    if grep -q ExceptionReport /tmp/output_plain.txt || ! grep -q FeatureCollection /tmp/output_plain.txt; then
+        cat /tmp/output_plain.txt
+        RET=1
+    fi
+    for mode in optimized bound; do
+        if ! diff -u /tmp/output_plain.txt /tmp/output_$mode.txt > /tmp/output.diff; then
+            echo "Features differ with $mode filter"
+            head -40 /tmp/output.diff
+            RET=1
+        fi
+    done
+done
+
+# Native GML parsing must give the very same EWKB than PostGIS does
+# First line of each GML file holds the srid and whether axis are swapped
+for i in demo/tests/gml/*.xml; do
+    echo "Running $i"
+    set -- $(sed -n '1s/^<!-- \([0-9]*\) \([01]\) -->$/\1 \2/p' $i)
+    GOT=$(./gml_ewkb $1 $2 $i || true)
+    EXPECTED=$(echo "SELECT upper(encode(ST_AsEWKB(ST_GeomFromGML('$(sed 1d $i)', $1)), 'hex'));" | su $PGUSER -c "psql -t -A $DB")
+    if test -z "$GOT" || test "$GOT" != "$EXPECTED"; then
+        echo "Got:      $GOT"
+        echo "Expected: $EXPECTED"
+        RET=1
+    fi
+done
+
+# Distances are in meters whatever the layer unit: france_ft is france
+# in a foot based projection, and must give the very same features
+sed -e 's#</tinyows>#<layer retrievable="1" ns_prefix="tows" ns_uri="http://www.tinyows.org/" name="france_ft" title="France in feet"/></tinyows>#' \
+    $CONFIG > /tmp/tinyows_units.xml
+for i in demo/tests/units/*; do
+    echo "Running $i"
+    for layer in france france_ft; do
+        QUERY_STRING="$(sed "s/tows:france/tows:$layer/" $i)" TINYOWS_CONFIG_FILE=/tmp/tinyows_units.xml ./tinyows \
+            | grep -o 'fid="[^"]*"' | sed 's/.*[.]//' | sort > /tmp/output_$layer.txt
+    done
+    if ! test -s /tmp/output_france.txt || ! diff -u /tmp/output_france.txt /tmp/output_france_ft.txt; then
+        echo "Features differ with a foot based layer"
+        RET=1
+    fi
+done
+
+# Cached prepared statements must follow their parameters types
+echo "Running test/statement_cache.c"
+su $PGUSER -c "./statement_cache dbname=$DB" || RET=1
+
 if test "$RET" -eq "0"; then
     echo "Tests OK !"
 else
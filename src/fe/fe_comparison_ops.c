@@ -36,7 +36,7 @@
  */
 static buffer *fe_binary_comparison_op(ows * o, buffer * typename, filter_encoding * fe, xmlNodePtr n)
 {
-  buffer *tmp, *type, *name;
+  buffer *tmp, *name;
   xmlChar *matchcase;
   bool bool_type = false;
   bool sensitive_case = true;
@@ -91,9 +91,8 @@ static buffer *fe_binary_comparison_op(ows * o, buffer * typename, filter_encodi
       buffer_shift(tmp, 1);
     }
 
-    type = ows_psql_type(o, ows_layer_prefix_to_uri(o->layers, typename), tmp);
-
-    if (buffer_cmp(type, "bool")) bool_type = true;
+    if (ows_psql_column_type(o, ows_layer_prefix_to_uri(o->layers, typename), tmp->buf) == OWS_PSQL_TYPE_BOOL)
+      bool_type = true;
   }
 
   if (!sensitive_case) buffer_add_str(fe->sql, ")");
@@ -154,7 +153,6 @@ static buffer *fe_property_is_like(ows * o, buffer * typename, filter_encoding *
 {
   xmlChar *content, *wildcard, *singlechar, *escape, *matchcase;
   buffer *pg_string;
-  char *escaped;
   bool sensitive_case = true;
 
   assert(o && typename && fe && n);
@@ -184,9 +182,9 @@ static buffer *fe_property_is_like(ows * o, buffer * typename, filter_encoding *
   buffer_add_str(fe->sql, "\" AS varchar)");
 
   if (!sensitive_case) {
-    buffer_add_str(fe->sql, ") LIKE LOWER(E");
+    buffer_add_str(fe->sql, ") LIKE LOWER(");
   } else {
-    buffer_add_str(fe->sql, " LIKE E");
+    buffer_add_str(fe->sql, " LIKE ");
   }
 
   n = n->next;
@@ -200,18 +198,15 @@ static buffer *fe_property_is_like(ows * o, buffer * typename, filter_encoding *
 
   /* Replace the wildcard,singlechar and escapechar */
   if ((char *) wildcard && (char *) singlechar && (char *) escape) {
-    if (strlen((char *) escape))     pg_string = buffer_replace(pg_string, (char *) escape,     "\\\\");
+    if (strlen((char *) escape))     pg_string = buffer_replace(pg_string, (char *) escape,
+                                                                o->bind_parameters ? "\\" : "\\\\");
     if (strlen((char *) wildcard))   pg_string = buffer_replace(pg_string, (char *) wildcard,   "%");
     if (strlen((char *) singlechar)) pg_string = buffer_replace(pg_string, (char *) singlechar, "_");
   } else fe->error_code = FE_ERROR_FILTER;
 
-  buffer_add_str(fe->sql, "'");
-  escaped = ows_psql_escape_string(o, pg_string->buf);
-  if (escaped) {
-    buffer_add_str(fe->sql, escaped);
-    free(escaped);
-  }
-  buffer_add_str(fe->sql, "'");
+  /* A parameter is not an E'' string, so the escape is a single backslash */
+  if (!o->bind_parameters) buffer_add(fe->sql, 'E');
+  ows_psql_param_str(o, fe->sql, pg_string->buf);
 
   if (!sensitive_case) buffer_add_str(fe->sql, ")");
 
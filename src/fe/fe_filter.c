@@ -40,6 +40,7 @@ filter_encoding *filter_encoding_init()
   assert(fe);
 
   fe->sql = buffer_init();
+  fe->envelope = NULL;
   fe->error_code = FE_NO_ERROR;
   fe->in_not = false;
   fe->is_numeric = false;
@@ -56,6 +57,7 @@ void filter_encoding_free(filter_encoding * fe)
   assert(fe);
 
   buffer_free(fe->sql);
+  if (fe->envelope) ows_bbox_free(fe->envelope);
   free(fe);
   fe = NULL;
 }
@@ -118,7 +120,6 @@ void fe_node_flush(xmlNodePtr node, FILE * output)
  */
 buffer * fe_expression(ows * o, buffer * typename, filter_encoding * fe, buffer * sql, xmlNodePtr n)
 {
-  char *escaped;
   xmlChar *content;
 
   assert(o && typename && fe && sql);
@@ -147,13 +148,8 @@ buffer * fe_expression(ows * o, buffer * typename, filter_encoding * fe, buffer
     sql = fe_property_name(o, typename, fe, sql, n, false, true);
     buffer_add(sql, '"');
   } else if (!strcmp((char *) n->name, "Literal")) {
-    if (!fe->is_numeric) buffer_add_str(sql, "'");
-    escaped = ows_psql_escape_string(o, (char *) content);
-    if (escaped) {
-      buffer_add_str(sql, escaped);
-      free(escaped);
-    }
-    if (!fe->is_numeric) buffer_add_str(sql, "'");
+    if (fe->is_numeric) ows_psql_param_numeric(o, sql, (char *) content);
+    else                ows_psql_param_str(o, sql, (char *) content);
   } else if (n->type != XML_ELEMENT_NODE) {
     sql = fe_expression(o, typename, fe, sql, n->next);
   }
@@ -244,7 +240,7 @@ buffer *fe_property_name(ows * o, buffer * typename, filter_encoding * fe, buffe
 
   if (array_is_key(prop_table, tmp->buf)) {
     buffer_copy(sql, tmp);
-    fe->is_numeric = ows_psql_is_numeric(array_get(prop_table, tmp->buf));
+    fe->is_numeric = ows_psql_is_numeric(ows_psql_column_type(o, layer_name, tmp->buf));
     if (buffer_cmp(tmp, "intProperty")) fe->is_numeric = true;
   } else if (mandatory) fe->error_code = FE_ERROR_PROPERTYNAME;
 
@@ -263,7 +259,6 @@ buffer *fe_property_name(ows * o, buffer * typename, filter_encoding * fe, buffe
  */
 buffer *fe_feature_id(ows * o, buffer * typename, filter_encoding * fe, xmlNodePtr n)
 {
-  char *escaped;
   list *fe_list;
   bool feature_id, gid;
   xmlChar *fid = NULL;
@@ -324,16 +319,10 @@ buffer *fe_feature_id(ows * o, buffer * typename, filter_encoding * fe, xmlNodeP
       }
 
       buffer_copy(fe->sql, id_name);
-      buffer_add_str(fe->sql, " = \'");
-      if (fe_list->last) escaped = ows_psql_escape_string(o, fe_list->last->value->buf);
-      else               escaped = ows_psql_escape_string(o, buf_fid->buf);
-
-      if (escaped) {
-        buffer_add_str(fe->sql, escaped);
-        free(escaped);
-      }
+      buffer_add_str(fe->sql, " = ");
+      if (fe_list->last) ows_psql_param_str(o, fe->sql, fe_list->last->value->buf);
+      else               ows_psql_param_str(o, fe->sql, buf_fid->buf);
 
-      buffer_add_str(fe->sql, "\'");
       list_free(fe_list);
       buffer_free(buf_fid);
     }
@@ -345,6 +334,46 @@ buffer *fe_feature_id(ows * o, buffer * typename, filter_encoding * fe, xmlNodeP
 }
 
 
+/*
+ * Translate a Filter element to a filter encoding structure
+ * (as fe_filter does, with no validation)
+ */
+filter_encoding *fe_filter_node(ows * o, filter_encoding * fe, buffer * typename, xmlNodePtr filter)
+{
+  xmlNodePtr n;
+  bool optimized;
+
+  assert(o && fe && typename && filter);
+
+  if (!ows_libxml_check_namespace(o, filter)) {
+    fe->error_code = FE_ERROR_NAMESPACE;
+    return fe;
+  }
+
+  /* jump to the next element if there are spaces */
+  for (n = filter->children ; n && n->type != XML_ELEMENT_NODE ; n = n->next);
+
+  if (!n) {
+    fe->error_code = FE_ERROR_FILTER;
+    return fe;
+  }
+
+  /* Logical operators are rewritten by the optimizer, if asked */
+  optimized = o->optimize_filter && fe_is_logical_op((char *) n->name)
+              && fe_optimized_filter(o, typename, fe, n);
+
+  if (fe_is_comparison_op((char *) n->name))  fe->sql = fe_comparison_op(o, typename, fe, n);
+  if (fe_is_spatial_op((char *) n->name))     fe->sql = fe_spatial_op(o, typename, fe, n);
+  if (fe_is_logical_op((char *) n->name) && !optimized)
+    fe->sql = fe_logical_op(o, typename, fe, n);
+  if (!strcmp((char *) n->name, "FeatureId")) fe->sql = fe_feature_id(o, typename, fe, n);
+  else if (!strcmp((char *) n->name, "GmlObjectId") && ows_version_get(o->request->version) == 110)
+    fe->sql = fe_feature_id(o, typename, fe, n); /* FIXME Is FeatureId should really have priority ? */
+
+  return fe;
+}
+
+
 /*
  * Translate an XML filter to a filter encoding structure with a buffer
  * containing a where condition of a SQL request usable into PostGis
@@ -354,14 +383,15 @@ filter_encoding *fe_filter(ows * o, filter_encoding * fe, buffer * typename, buf
 {
   buffer * schema_path;
   xmlDocPtr xmldoc;
-  xmlNodePtr n;
   int ret = -1;
 
   assert(o && fe && typename && xmlchar);
 
   /* No validation if Filter came from KVP method
-     FIXME: really, but why ?                     */
-  if (o->check_schema && o->request->method == OWS_METHOD_XML) {
+     FIXME: really, but why ?
+     Nor if the whole request was already validated */
+  if (o->check_schema && o->request->method == OWS_METHOD_XML
+      && !o->request->doc_valid && !o->stream) {
     schema_path = buffer_init();
     buffer_copy(schema_path, o->schema_dir);
 
@@ -386,27 +416,10 @@ filter_encoding *fe_filter(ows * o, filter_encoding * fe, buffer * typename, buf
 
   if (!xmldoc) {
     fe->error_code = FE_ERROR_FILTER;
-    xmlFreeDoc(xmldoc);
     return fe;
   }
 
-  if (!ows_libxml_check_namespace(o, xmldoc->children)) {
-    fe->error_code = FE_ERROR_NAMESPACE;
-    xmlFreeDoc(xmldoc);
-    return fe;
-  }
-
-  n = xmldoc->children->children;
-
-  /* jump to the next element if there are spaces */
-  while (n->type != XML_ELEMENT_NODE) n = n->next;
-
-  if (fe_is_comparison_op((char *) n->name))  fe->sql = fe_comparison_op(o, typename, fe, n);
-  if (fe_is_spatial_op((char *) n->name))     fe->sql = fe_spatial_op(o, typename, fe, n);
-  if (fe_is_logical_op((char *) n->name))     fe->sql = fe_logical_op(o, typename, fe, n);
-  if (!strcmp((char *) n->name, "FeatureId")) fe->sql = fe_feature_id(o, typename, fe, n);
-  else if (!strcmp((char *) n->name, "GmlObjectId") && ows_version_get(o->request->version) == 110)
-    fe->sql = fe_feature_id(o, typename, fe, n); /* FIXME Is FeatureId should really have priority ? */
+  fe = fe_filter_node(o, fe, typename, xmldoc->children);
 
   xmlFreeDoc(xmldoc);
 
@@ -419,20 +432,21 @@ filter_encoding *fe_filter(ows * o, filter_encoding * fe, buffer * typename, buf
  */
 buffer *fe_kvp_bbox(ows * o, wfs_request * wr, buffer * layer_name, ows_bbox * bbox)
 {
-  buffer *where;
+  buffer *where, *envelope;
   list *geom;
   list_node *ln;
-  int srid = -1;
+  int srid = -1, layer_srid;
   bool transform = false;
 
   assert(o && wr && layer_name && bbox);
 
   where = buffer_init();
   geom = ows_psql_geometry_column(o, layer_name);
+  layer_srid = ows_srs_get_srid_from_layer(o, layer_name);
   buffer_add_str(where, " WHERE");
 
   if (wr->srs) {
-    srid = ows_srs_get_srid_from_layer(o, layer_name);
+    srid = layer_srid;
     transform = true;
   }
   /* BBOX optional crsuri parameter since WFS 1.1 */
@@ -441,49 +455,47 @@ buffer *fe_kvp_bbox(ows * o, wfs_request * wr, buffer * layer_name, ows_bbox * b
     transform = true;
   }
 
+  envelope = buffer_init();
+  ows_bbox_to_query(o, wr->bbox, envelope);
+
   for (ln = geom->first ; ln ; ln = ln->next) {
 
     /* We use _ST_Intersects and && operator rather than ST_Intersects for performances issues */
     buffer_add_str(where, " (_ST_Intersects(");
-    if (transform) buffer_add_str(where, "ST_Transform(");
+    if (transform && srid != layer_srid) buffer_add_str(where, "ST_Transform(");
     buffer_add_str(where, "\"");
     buffer_copy(where, ln->value);
     buffer_add_str(where, "\",");
-    if (transform) {
+    if (transform && srid != layer_srid) {
       buffer_add_int(where, srid);
       buffer_add_str(where, "),");
     }
 
     if (transform) buffer_add_str(where, "ST_Transform(");
-    ows_bbox_to_query(o, wr->bbox, where);
+    buffer_copy(where, envelope);
     if (transform) {
       buffer_add_str(where, ",");
       buffer_add_int(where, srid);
       buffer_add_str(where, ")");
     }
-    buffer_add_str(where, ") AND ");
-    if (transform) buffer_add_str(where, "ST_Transform(");
-    buffer_add_str(where, "\"");
+
+    /*
+     * Index filter is always done against the column itself, in its own srid:
+     * only the envelope is reprojected, if needed
+     */
+    buffer_add_str(where, ") AND \"");
     buffer_copy(where, ln->value);
-    buffer_add_str(where, "\"");
-    if (transform) {
-      buffer_add_str(where, ",");
-      buffer_add_int(where, srid);
-      buffer_add_str(where, ")");
-    }
-    buffer_add_str(where, " && ");
-    if (transform) buffer_add_str(where, "ST_Transform(");
-    ows_bbox_to_query(o, wr->bbox, where);
-    if (transform) {
-      buffer_add_str(where, ",");
-      buffer_add_int(where, srid);
-      buffer_add_str(where, ")");
-    }
+    buffer_add_str(where, "\" && ");
+    if (transform && layer_srid > 0 && wr->bbox->srs->srid != layer_srid)
+      ows_bbox_to_srid_query(o, wr->bbox, envelope, layer_srid, where);
+    else buffer_copy(where, envelope);
 
     if (ln->next) buffer_add_str(where, ") OR ");
     else          buffer_add_str(where, ")");
   }
 
+  buffer_free(envelope);
+
   return where;
 }
 
@@ -494,7 +506,6 @@ buffer *fe_kvp_bbox(ows * o, wfs_request * wr, buffer * layer_name, ows_bbox * b
 buffer *fe_kvp_featureid(ows * o, wfs_request * wr, buffer * layer_name, list * fid)
 {
   buffer *id_name, *where;
-  char *escaped;
   list *fe;
   list_node *ln;
 
@@ -510,13 +521,8 @@ buffer *fe_kvp_featureid(ows * o, wfs_request * wr, buffer * layer_name, list *
   for (ln = fid->first ; ln ; ln = ln->next) {
     fe = list_explode('.', ln->value);
     buffer_copy(where, id_name);
-    buffer_add_str(where, " = '");
-    escaped = ows_psql_escape_string(o, fe->last->value->buf);
-    if (escaped) {
-      buffer_add_str(where, escaped);
-      free(escaped);
-    }
-    buffer_add_str(where, "'");
+    buffer_add_str(where, " = ");
+    ows_psql_param_str(o, where, fe->last->value->buf);
     list_free(fe);
 
     if (ln->next) buffer_add_str(where, " OR ");
@@ -44,35 +44,35 @@ static void fe_functions_capabilities(const ows * o)
   if (version == 100) buffer_add_str(fct_name, "Function_Name");
   else                buffer_add_str(fct_name, "FunctionName");
 
-  fprintf(o->output, "   <ogc:Functions>\n");
-  fprintf(o->output, "    <ogc:%ss>\n", fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>abs</ogc:%s>\n",     fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>acos</ogc:%s>\n",    fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>asin</ogc:%s>\n",    fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>atan</ogc:%s>\n",    fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>avg</ogc:%s>\n",     fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>cbrt</ogc:%s>\n",    fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>ceil</ogc:%s>\n",    fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>ceiling</ogc:%s>\n", fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>cos</ogc:%s>\n",     fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>cot</ogc:%s>\n",     fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>count</ogc:%s>\n",   fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>degrees</ogc:%s>\n", fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>exp</ogc:%s>\n",     fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>floor</ogc:%s>\n",   fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>length</ogc:%s>\n",  fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>ln</ogc:%s>\n",      fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>log</ogc:%s>\n",     fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>min</ogc:%s>\n",     fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>max</ogc:%s>\n",     fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>radians</ogc:%s>\n", fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>round</ogc:%s>\n",   fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>sin</ogc:%s>\n",     fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>sqrt</ogc:%s>\n",    fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>tan</ogc:%s>\n",     fct_name->buf, fct_name->buf);
-  fprintf(o->output, "     <ogc:%s nArgs='1'>trunc</ogc:%s>\n",   fct_name->buf, fct_name->buf);
-  fprintf(o->output, "    </ogc:%ss>\n", fct_name->buf);
-  fprintf(o->output, "   </ogc:Functions>\n");
+  ows_output_str(o, "   <ogc:Functions>\n");
+  ows_output_printf(o, "    <ogc:%ss>\n", fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>abs</ogc:%s>\n",     fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>acos</ogc:%s>\n",    fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>asin</ogc:%s>\n",    fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>atan</ogc:%s>\n",    fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>avg</ogc:%s>\n",     fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>cbrt</ogc:%s>\n",    fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>ceil</ogc:%s>\n",    fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>ceiling</ogc:%s>\n", fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>cos</ogc:%s>\n",     fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>cot</ogc:%s>\n",     fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>count</ogc:%s>\n",   fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>degrees</ogc:%s>\n", fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>exp</ogc:%s>\n",     fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>floor</ogc:%s>\n",   fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>length</ogc:%s>\n",  fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>ln</ogc:%s>\n",      fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>log</ogc:%s>\n",     fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>min</ogc:%s>\n",     fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>max</ogc:%s>\n",     fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>radians</ogc:%s>\n", fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>round</ogc:%s>\n",   fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>sin</ogc:%s>\n",     fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>sqrt</ogc:%s>\n",    fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>tan</ogc:%s>\n",     fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "     <ogc:%s nArgs='1'>trunc</ogc:%s>\n",   fct_name->buf, fct_name->buf);
+  ows_output_printf(o, "    </ogc:%ss>\n", fct_name->buf);
+  ows_output_str(o, "   </ogc:Functions>\n");
 
   buffer_free(fct_name);
 }
@@ -86,41 +86,41 @@ void fe_filter_capabilities_100(const ows * o)
 {
   assert(o);
 
-  fprintf(o->output, "<ogc:Filter_Capabilities>\n");
+  ows_output_str(o, "<ogc:Filter_Capabilities>\n");
 
   /* Spatial Capabilities */
-  fprintf(o->output, " <ogc:Spatial_Capabilities>\n");
-  fprintf(o->output, "  <ogc:Spatial_Operators>\n");
-  fprintf(o->output, "   <ogc:Disjoint/>\n");
-  fprintf(o->output, "   <ogc:Equals/>\n");
-  fprintf(o->output, "   <ogc:DWithin/>\n");
-  fprintf(o->output, "   <ogc:Beyond/>\n");
-  fprintf(o->output, "   <ogc:Intersect/>\n");
-  fprintf(o->output, "   <ogc:Touches/>\n");
-  fprintf(o->output, "   <ogc:Crosses/>\n");
-  fprintf(o->output, "   <ogc:Within/>\n");
-  fprintf(o->output, "   <ogc:Contains/>\n");
-  fprintf(o->output, "   <ogc:Overlaps/>\n");
-  fprintf(o->output, "   <ogc:BBOX/>\n");
-  fprintf(o->output, "  </ogc:Spatial_Operators>\n");
-  fprintf(o->output, " </ogc:Spatial_Capabilities>\n");
+  ows_output_str(o, " <ogc:Spatial_Capabilities>\n");
+  ows_output_str(o, "  <ogc:Spatial_Operators>\n");
+  ows_output_str(o, "   <ogc:Disjoint/>\n");
+  ows_output_str(o, "   <ogc:Equals/>\n");
+  ows_output_str(o, "   <ogc:DWithin/>\n");
+  ows_output_str(o, "   <ogc:Beyond/>\n");
+  ows_output_str(o, "   <ogc:Intersect/>\n");
+  ows_output_str(o, "   <ogc:Touches/>\n");
+  ows_output_str(o, "   <ogc:Crosses/>\n");
+  ows_output_str(o, "   <ogc:Within/>\n");
+  ows_output_str(o, "   <ogc:Contains/>\n");
+  ows_output_str(o, "   <ogc:Overlaps/>\n");
+  ows_output_str(o, "   <ogc:BBOX/>\n");
+  ows_output_str(o, "  </ogc:Spatial_Operators>\n");
+  ows_output_str(o, " </ogc:Spatial_Capabilities>\n");
 
   /* Scalar Capabilities */
-  fprintf(o->output, " <ogc:Scalar_Capabilities>\n");
-  fprintf(o->output, "  <ogc:Logical_Operators/>\n");
-  fprintf(o->output, "  <ogc:Comparison_Operators>\n");
-  fprintf(o->output, "   <ogc:Simple_Comparisons/>\n");
-  fprintf(o->output, "   <ogc:Between/>\n");
-  fprintf(o->output, "   <ogc:Like/>\n");
-  fprintf(o->output, "   <ogc:NullCheck/>\n");
-  fprintf(o->output, "  </ogc:Comparison_Operators>\n");
-  fprintf(o->output, "  <ogc:Arithmetic_Operators>\n");
-  fprintf(o->output, "   <ogc:Simple_Arithmetic/>\n");
+  ows_output_str(o, " <ogc:Scalar_Capabilities>\n");
+  ows_output_str(o, "  <ogc:Logical_Operators/>\n");
+  ows_output_str(o, "  <ogc:Comparison_Operators>\n");
+  ows_output_str(o, "   <ogc:Simple_Comparisons/>\n");
+  ows_output_str(o, "   <ogc:Between/>\n");
+  ows_output_str(o, "   <ogc:Like/>\n");
+  ows_output_str(o, "   <ogc:NullCheck/>\n");
+  ows_output_str(o, "  </ogc:Comparison_Operators>\n");
+  ows_output_str(o, "  <ogc:Arithmetic_Operators>\n");
+  ows_output_str(o, "   <ogc:Simple_Arithmetic/>\n");
   fe_functions_capabilities(o);
-  fprintf(o->output, "  </ogc:Arithmetic_Operators>\n");
-  fprintf(o->output, " </ogc:Scalar_Capabilities>\n");
+  ows_output_str(o, "  </ogc:Arithmetic_Operators>\n");
+  ows_output_str(o, " </ogc:Scalar_Capabilities>\n");
 
-  fprintf(o->output, "</ogc:Filter_Capabilities>\n");
+  ows_output_str(o, "</ogc:Filter_Capabilities>\n");
 }
 
 
@@ -132,68 +132,68 @@ void fe_filter_capabilities_110(const ows * o)
 {
   assert(o);
 
-  fprintf(o->output, "<ogc:Filter_Capabilities>\n");
+  ows_output_str(o, "<ogc:Filter_Capabilities>\n");
 
   /* Spatial Capabililties */
-  fprintf(o->output, " <ogc:Spatial_Capabilities>\n");
+  ows_output_str(o, " <ogc:Spatial_Capabilities>\n");
 
-  fprintf(o->output, "  <ogc:GeometryOperands>\n");
-  fprintf(o->output, "   <ogc:GeometryOperand>gml:Envelope</ogc:GeometryOperand>\n");
-  fprintf(o->output, "   <ogc:GeometryOperand>gml:Point</ogc:GeometryOperand>\n");
-  fprintf(o->output, "   <ogc:GeometryOperand>gml:LineString</ogc:GeometryOperand>\n");
-  fprintf(o->output, "   <ogc:GeometryOperand>gml:Polygon</ogc:GeometryOperand>\n");
+  ows_output_str(o, "  <ogc:GeometryOperands>\n");
+  ows_output_str(o, "   <ogc:GeometryOperand>gml:Envelope</ogc:GeometryOperand>\n");
+  ows_output_str(o, "   <ogc:GeometryOperand>gml:Point</ogc:GeometryOperand>\n");
+  ows_output_str(o, "   <ogc:GeometryOperand>gml:LineString</ogc:GeometryOperand>\n");
+  ows_output_str(o, "   <ogc:GeometryOperand>gml:Polygon</ogc:GeometryOperand>\n");
   if (ows_version_get(o->postgis_version) >= 200) {
-    fprintf(o->output, "   <ogc:GeometryOperand>gml:Triangle</ogc:GeometryOperand>\n");
-    fprintf(o->output, "   <ogc:GeometryOperand>gml:PolyhedralSurface</ogc:GeometryOperand>\n");
-    fprintf(o->output, "   <ogc:GeometryOperand>gml:Tin</ogc:GeometryOperand>\n");
+    ows_output_str(o, "   <ogc:GeometryOperand>gml:Triangle</ogc:GeometryOperand>\n");
+    ows_output_str(o, "   <ogc:GeometryOperand>gml:PolyhedralSurface</ogc:GeometryOperand>\n");
+    ows_output_str(o, "   <ogc:GeometryOperand>gml:Tin</ogc:GeometryOperand>\n");
   }
-  fprintf(o->output, "  </ogc:GeometryOperands>\n");
-
-  fprintf(o->output, "  <ogc:SpatialOperators>\n");
-  fprintf(o->output, "  <ogc:SpatialOperator name='Disjoint'/>\n");
-  fprintf(o->output, "  <ogc:SpatialOperator name='Equals'/>\n");
-  fprintf(o->output, "  <ogc:SpatialOperator name='DWithin'/>\n");
-  fprintf(o->output, "  <ogc:SpatialOperator name='Beyond'/>\n");
-  fprintf(o->output, "  <ogc:SpatialOperator name='Intersects'/>\n");
-  fprintf(o->output, "  <ogc:SpatialOperator name='Touches'/>\n");
-  fprintf(o->output, "  <ogc:SpatialOperator name='Crosses'/>\n");
-  fprintf(o->output, "  <ogc:SpatialOperator name='Within'/>\n");
-  fprintf(o->output, "  <ogc:SpatialOperator name='Contains'/>\n");
-  fprintf(o->output, "  <ogc:SpatialOperator name='Overlaps'/>\n");
-  fprintf(o->output, "  <ogc:SpatialOperator name='BBOX'/>\n");
-  fprintf(o->output, " </ogc:SpatialOperators>\n");
-  fprintf(o->output, " </ogc:Spatial_Capabilities>\n");
+  ows_output_str(o, "  </ogc:GeometryOperands>\n");
+
+  ows_output_str(o, "  <ogc:SpatialOperators>\n");
+  ows_output_str(o, "  <ogc:SpatialOperator name='Disjoint'/>\n");
+  ows_output_str(o, "  <ogc:SpatialOperator name='Equals'/>\n");
+  ows_output_str(o, "  <ogc:SpatialOperator name='DWithin'/>\n");
+  ows_output_str(o, "  <ogc:SpatialOperator name='Beyond'/>\n");
+  ows_output_str(o, "  <ogc:SpatialOperator name='Intersects'/>\n");
+  ows_output_str(o, "  <ogc:SpatialOperator name='Touches'/>\n");
+  ows_output_str(o, "  <ogc:SpatialOperator name='Crosses'/>\n");
+  ows_output_str(o, "  <ogc:SpatialOperator name='Within'/>\n");
+  ows_output_str(o, "  <ogc:SpatialOperator name='Contains'/>\n");
+  ows_output_str(o, "  <ogc:SpatialOperator name='Overlaps'/>\n");
+  ows_output_str(o, "  <ogc:SpatialOperator name='BBOX'/>\n");
+  ows_output_str(o, " </ogc:SpatialOperators>\n");
+  ows_output_str(o, " </ogc:Spatial_Capabilities>\n");
 
   /* Scalar Capabililties */
-  fprintf(o->output, " <ogc:Scalar_Capabilities>\n");
-  fprintf(o->output, "  <ogc:LogicalOperators/>\n");
-
-  fprintf(o->output, "  <ogc:ComparisonOperators>\n");
-  fprintf(o->output, "   <ogc:ComparisonOperator>EqualTo</ogc:ComparisonOperator>\n");
-  fprintf(o->output, "   <ogc:ComparisonOperator>NotEqualTo</ogc:ComparisonOperator>\n");
-  fprintf(o->output, "   <ogc:ComparisonOperator>LessThan</ogc:ComparisonOperator>\n");
-  fprintf(o->output, "   <ogc:ComparisonOperator>GreaterThan</ogc:ComparisonOperator>\n");
-  fprintf(o->output, "   <ogc:ComparisonOperator>LessThanEqualTo</ogc:ComparisonOperator>\n");
-  fprintf(o->output, "   <ogc:ComparisonOperator>GreaterThanEqualTo</ogc:ComparisonOperator>\n");
-  fprintf(o->output, "   <ogc:ComparisonOperator>Between</ogc:ComparisonOperator>\n");
-  fprintf(o->output, "   <ogc:ComparisonOperator>Like</ogc:ComparisonOperator>\n");
-  fprintf(o->output, "   <ogc:ComparisonOperator>NullCheck</ogc:ComparisonOperator>\n");
-  fprintf(o->output, "  </ogc:ComparisonOperators>\n");
-
-  fprintf(o->output, "  <ogc:ArithmeticOperators>\n");
-  fprintf(o->output, "   <ogc:SimpleArithmetic/>\n");
+  ows_output_str(o, " <ogc:Scalar_Capabilities>\n");
+  ows_output_str(o, "  <ogc:LogicalOperators/>\n");
+
+  ows_output_str(o, "  <ogc:ComparisonOperators>\n");
+  ows_output_str(o, "   <ogc:ComparisonOperator>EqualTo</ogc:ComparisonOperator>\n");
+  ows_output_str(o, "   <ogc:ComparisonOperator>NotEqualTo</ogc:ComparisonOperator>\n");
+  ows_output_str(o, "   <ogc:ComparisonOperator>LessThan</ogc:ComparisonOperator>\n");
+  ows_output_str(o, "   <ogc:ComparisonOperator>GreaterThan</ogc:ComparisonOperator>\n");
+  ows_output_str(o, "   <ogc:ComparisonOperator>LessThanEqualTo</ogc:ComparisonOperator>\n");
+  ows_output_str(o, "   <ogc:ComparisonOperator>GreaterThanEqualTo</ogc:ComparisonOperator>\n");
+  ows_output_str(o, "   <ogc:ComparisonOperator>Between</ogc:ComparisonOperator>\n");
+  ows_output_str(o, "   <ogc:ComparisonOperator>Like</ogc:ComparisonOperator>\n");
+  ows_output_str(o, "   <ogc:ComparisonOperator>NullCheck</ogc:ComparisonOperator>\n");
+  ows_output_str(o, "  </ogc:ComparisonOperators>\n");
+
+  ows_output_str(o, "  <ogc:ArithmeticOperators>\n");
+  ows_output_str(o, "   <ogc:SimpleArithmetic/>\n");
   fe_functions_capabilities(o);
-  fprintf(o->output, "  </ogc:ArithmeticOperators>\n");
+  ows_output_str(o, "  </ogc:ArithmeticOperators>\n");
 
-  fprintf(o->output, " </ogc:Scalar_Capabilities>\n");
+  ows_output_str(o, " </ogc:Scalar_Capabilities>\n");
 
   /* Id Capabilities */
-  fprintf(o->output, " <ogc:Id_Capabilities>\n");
-  fprintf(o->output, "  <ogc:EID/>\n");
-  fprintf(o->output, "  <ogc:FID/>\n");
-  fprintf(o->output, " </ogc:Id_Capabilities>\n");
+  ows_output_str(o, " <ogc:Id_Capabilities>\n");
+  ows_output_str(o, "  <ogc:EID/>\n");
+  ows_output_str(o, "  <ogc:FID/>\n");
+  ows_output_str(o, " </ogc:Id_Capabilities>\n");
 
-  fprintf(o->output, "</ogc:Filter_Capabilities>\n");
+  ows_output_str(o, "</ogc:Filter_Capabilities>\n");
 }
 
 
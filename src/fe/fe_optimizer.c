@@ -0,0 +1,588 @@
+/*
+  Copyright (c) <2007-2012> <Barbara Philippot - Olivier Courtin>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "../ows/ows.h"
+
+
+/*
+ * Filter optimizer
+ * Logical operators are kept as a tree whose leaves are the predicates,
+ * written as SQL by the usual functions. The tree is then rewritten
+ * (flattening, redundancies removal, OR of equalities folded into IN,
+ * LIKE prefix ranges, cheapest predicates first) before being written
+ */
+
+
+static fe_node *fe_node_init(enum fe_node_type type)
+{
+  fe_node *n;
+
+  n = malloc(sizeof(fe_node));
+  assert(n);
+
+  n->type = type;
+  n->predicate = FE_PREDICATE_OTHER;
+  n->sql = NULL;
+  n->column = NULL;
+  n->value = NULL;
+  n->bbox = NULL;
+  n->cost = 0;
+  n->first = NULL;
+  n->next = NULL;
+
+  return n;
+}
+
+
+static void fe_node_free(fe_node * n)
+{
+  fe_node *c, *next;
+
+  assert(n);
+
+  for (c = n->first ; c ; c = next) {
+    next = c->next;
+    fe_node_free(c);
+  }
+
+  if (n->sql)    buffer_free(n->sql);
+  if (n->column) buffer_free(n->column);
+  if (n->value)  buffer_free(n->value);
+  if (n->bbox)   ows_bbox_free(n->bbox);
+  free(n);
+}
+
+
+static xmlNodePtr fe_node_element(xmlNodePtr n)
+{
+  while (n && n->type != XML_ELEMENT_NODE) n = n->next;
+
+  return n;
+}
+
+
+static bool fe_node_match_case(xmlNodePtr n)
+{
+  xmlChar *matchcase;
+  bool ret;
+
+  matchcase = xmlGetProp(n, (xmlChar *) "matchCase");
+  ret = !(matchcase && !strcmp((char *) matchcase, "false"));
+  xmlFree(matchcase);
+
+  return ret;
+}
+
+
+/*
+ * Index usable range matching the literal prefix of a LIKE pattern:
+ * "col" COLLATE "C" >= 'abc' AND "col" COLLATE "C" < 'abd'
+ * Return NULL if the pattern doesn't start with a literal (ASCII) prefix
+ */
+static buffer *fe_node_like_range(ows * o, buffer * column, xmlNodePtr n, xmlNodePtr literal)
+{
+  xmlChar *content, *wildcard, *singlechar, *escape;
+  buffer *prefix, *range;
+  char *c;
+
+  wildcard = xmlGetProp(n, (xmlChar *) "wildCard");
+  singlechar = xmlGetProp(n, (xmlChar *) "singleChar");
+  if (ows_version_get(o->request->version) == 100)
+    escape = xmlGetProp(n, (xmlChar *) "escape");
+  else
+    escape = xmlGetProp(n, (xmlChar *) "escapeChar");
+  content = xmlNodeGetContent(literal);
+
+  prefix = buffer_init();
+  if (content && wildcard && singlechar && escape) {
+    for (c = (char *) content ; *c ; c++) {
+      if (*wildcard   && !strncmp(c, (char *) wildcard,   strlen((char *) wildcard)))   break;
+      if (*singlechar && !strncmp(c, (char *) singlechar, strlen((char *) singlechar))) break;
+      if (*escape     && !strncmp(c, (char *) escape,     strlen((char *) escape)))     break;
+      /* Passed as is to LIKE, where they still are pattern chars */
+      if (*c == '%' || *c == '_' || *c == '\\') break;
+      if (*c < 0x20 || *c >= 0x7E) break;
+      buffer_add(prefix, *c);
+    }
+  }
+
+  xmlFree(content);
+  xmlFree(wildcard);
+  xmlFree(singlechar);
+  xmlFree(escape);
+
+  if (!prefix->use) {
+    buffer_free(prefix);
+    return NULL;
+  }
+
+  range = buffer_init();
+  buffer_add(range, '"');
+  buffer_copy(range, column);
+  buffer_add_str(range, "\" COLLATE \"C\" >= ");
+  ows_psql_param_str(o, range, prefix->buf);
+
+  /* Upper bound: prefix with its last char incremented */
+  prefix->buf[prefix->use - 1]++;
+  buffer_add_str(range, " AND \"");
+  buffer_copy(range, column);
+  buffer_add_str(range, "\" COLLATE \"C\" < ");
+  ows_psql_param_str(o, range, prefix->buf);
+
+  buffer_free(prefix);
+
+  return range;
+}
+
+
+/*
+ * Predicate leaf: SQL is written by the usual functions, and what the
+ * optimizer needs to know about the predicate is kept aside
+ */
+static fe_node *fe_node_predicate(ows * o, buffer * typename, filter_encoding * fe, xmlNodePtr n)
+{
+  fe_node *node;
+  buffer *sql, *column;
+  enum ows_psql_type_code type;
+  xmlNodePtr a, b;
+  xmlChar *content;
+
+  node = fe_node_init(FE_NODE_PREDICATE);
+
+  sql = fe->sql;
+  fe->sql = buffer_init();
+  if (fe_is_spatial_op((char *) n->name)) fe->sql = fe_spatial_op(o, typename, fe, n);
+  else                                    fe->sql = fe_comparison_op(o, typename, fe, n);
+  node->sql = fe->sql;
+  fe->sql = sql;
+
+  if (fe->error_code != FE_NO_ERROR) return node;
+
+  a = fe_node_element(n->children);
+  b = a ? fe_node_element(a->next) : NULL;
+
+  if (fe_is_spatial_op((char *) n->name)) {
+    node->predicate = FE_PREDICATE_SPATIAL;
+    node->cost = 8;
+
+    if (!strcmp((char *) n->name, "BBOX")) {
+      node->predicate = FE_PREDICATE_BBOX;
+      node->cost = 4;
+      node->bbox = fe->envelope;
+      fe->envelope = NULL;
+
+      if (a && !strcmp((char *) a->name, "PropertyName")) {
+        content = xmlNodeGetContent(a);
+        node->column = buffer_from_str((char *) content);
+        xmlFree(content);
+      }
+    }
+
+    return node;
+  }
+
+  node->cost = 2;
+
+  /* PropertyName = Literal */
+  if (    !strcmp((char *) n->name, "PropertyIsEqualTo") && fe_node_match_case(n)
+       && a && b && !fe_node_element(b->next)
+       && !strcmp((char *) a->name, "PropertyName") && !strcmp((char *) b->name, "Literal")
+       && !fe_node_element(b->children)) {
+
+    column = buffer_init();
+    buffer_add(column, '"');
+    column = fe_property_name(o, typename, fe, column, a, false, false);
+    buffer_add_str(column, "\" = ");
+
+    if (column->use > 4 && node->sql->use > column->use
+        && !strncmp(node->sql->buf, column->buf, column->use)) {
+      node->predicate = FE_PREDICATE_EQUAL;
+      node->value = buffer_from_str(node->sql->buf + column->use);
+      buffer_pop(column, 3);
+      node->column = column;
+      node->cost = 1;
+    } else buffer_free(column);
+  }
+
+  /* Case sensitive LIKE on a text column */
+  else if (    !strcmp((char *) n->name, "PropertyIsLike") && fe_node_match_case(n)
+            && a && b && !strcmp((char *) a->name, "PropertyName")) {
+    node->cost = 3;
+
+    column = buffer_init();
+    column = fe_property_name(o, typename, fe, column, a, false, false);
+    type = ows_psql_column_type(o, ows_layer_prefix_to_uri(o->layers, typename), column->buf);
+
+    if (column->use && (type == OWS_PSQL_TYPE_TEXT || type == OWS_PSQL_TYPE_VARCHAR)) {
+      node->value = fe_node_like_range(o, column, n, b);
+      if (node->value) node->predicate = FE_PREDICATE_LIKE;
+    }
+    buffer_free(column);
+  }
+
+  return node;
+}
+
+
+/*
+ * Build the filter tree from the XML filter
+ * Return NULL if the tree can't render the filter as the usual functions
+ * would (the filter is then written by them)
+ */
+static fe_node *fe_node_build(ows * o, buffer * typename, filter_encoding * fe, xmlNodePtr n)
+{
+  fe_node *node, *child, *last;
+  enum fe_node_type type, op;
+  bool is_and;
+
+  if (!n) return NULL;
+
+  if (fe_is_spatial_op((char *) n->name) || fe_is_comparison_op((char *) n->name))
+    return fe_node_predicate(o, typename, fe, n);
+
+  if (!fe_is_logical_op((char *) n->name)) return NULL;
+
+  if (!strcmp((char *) n->name, "Not")) {
+    node = fe_node_init(FE_NODE_NOT);
+    fe->in_not = true;
+    node->first = fe_node_build(o, typename, fe, fe_node_element(n->children));
+    fe->in_not = false;
+
+    if (!node->first) {
+      fe_node_free(node);
+      return NULL;
+    }
+    return node;
+  }
+
+  /*
+   * And and Or are reverted inside a Not, as fe_binary_logical_op does
+   * (operator is checked before each operand, as a nested Not resets in_not)
+   */
+  is_and = !strcmp((char *) n->name, "And");
+  node = fe_node_init(FE_NODE_AND);
+  type = FE_NODE_AND;
+
+  for (n = fe_node_element(n->children), last = NULL ; n ; n = fe_node_element(n->next)) {
+    if (last) {
+      op = (is_and != fe->in_not) ? FE_NODE_AND : FE_NODE_OR;
+      if (last == node->first) type = op;
+      else if (op != type) {
+        fe_node_free(node);
+        return NULL;
+      }
+    }
+
+    child = fe_node_build(o, typename, fe, n);
+    if (!child) {
+      fe_node_free(node);
+      return NULL;
+    }
+
+    if (last) last->next = child;
+    else node->first = child;
+    last = child;
+  }
+
+  if (!node->first) {
+    fe_node_free(node);
+    return NULL;
+  }
+
+  node->type = type;
+
+  return node;
+}
+
+
+/*
+ * Predicates are compared by their SQL text
+ * With bind_parameters each value is its own placeholder, so two
+ * predicates never compare equal and duplicates or absorption are then
+ * left as is (BBOX containment still applies, as it compares the boxes)
+ */
+static bool fe_node_equal(const fe_node * a, const fe_node * b)
+{
+  const fe_node *ca, *cb;
+
+  if (a->type != b->type) return false;
+  if (a->type == FE_NODE_PREDICATE) return !strcmp(a->sql->buf, b->sql->buf);
+
+  for (ca = a->first, cb = b->first ; ca && cb ; ca = ca->next, cb = cb->next)
+    if (!fe_node_equal(ca, cb)) return false;
+
+  return !ca && !cb;
+}
+
+
+/*
+ * True if one of the operands of n is equal to c
+ */
+static bool fe_node_has_operand(const fe_node * n, const fe_node * c)
+{
+  const fe_node *o;
+
+  for (o = n->first ; o ; o = o->next)
+    if (fe_node_equal(o, c)) return true;
+
+  return false;
+}
+
+
+static bool fe_node_bbox_contains(const ows_bbox * a, const ows_bbox * b)
+{
+  return a->srs->srid == b->srs->srid
+         && a->xmin <= b->xmin && a->ymin <= b->ymin
+         && a->xmax >= b->xmax && a->ymax >= b->ymax;
+}
+
+
+/*
+ * Check if an operand of a And (or Or) is redundant with another one:
+ * - same predicate twice
+ * - absorption: A And (A Or B) is A, A Or (A And B) is A
+ * - BBOX on the same column: And keeps the inner one, Or the outer one
+ */
+static bool fe_node_redundant(const fe_node * n, const fe_node * c, const fe_node * other)
+{
+  if (fe_node_equal(c, other)) return true;
+
+  if (c->type != FE_NODE_PREDICATE && c->type != n->type && c->type != FE_NODE_NOT
+      && fe_node_has_operand(c, other))
+    return true;
+
+  if (    c->predicate == FE_PREDICATE_BBOX && other->predicate == FE_PREDICATE_BBOX
+       && c->column && other->column && buffer_cmp(c->column, other->column->buf)
+       && c->bbox && other->bbox) {
+    if (n->type == FE_NODE_AND) return fe_node_bbox_contains(c->bbox, other->bbox);
+    else                        return fe_node_bbox_contains(other->bbox, c->bbox);
+  }
+
+  return false;
+}
+
+
+/*
+ * Fold equalities on a same column into a single IN predicate
+ * (planned by PostgreSQL as = ANY(array))
+ */
+static void fe_node_fold_in(fe_node * n)
+{
+  fe_node *c, *e, *prev, *next;
+
+  for (c = n->first ; c ; c = c->next) {
+    if (c->predicate != FE_PREDICATE_EQUAL) continue;
+
+    for (prev = c, e = c->next ; e ; e = next) {
+      next = e->next;
+
+      if (e->predicate != FE_PREDICATE_EQUAL || !buffer_cmp(e->column, c->column->buf)) {
+        prev = e;
+        continue;
+      }
+
+      if (c->predicate == FE_PREDICATE_EQUAL) {
+        buffer_empty(c->sql);
+        buffer_copy(c->sql, c->column);
+        buffer_add_str(c->sql, " IN (");
+        buffer_copy(c->sql, c->value);
+        buffer_add(c->sql, ')');
+        c->predicate = FE_PREDICATE_OTHER;
+      }
+
+      /* Insert value before the closing bracket */
+      buffer_pop(c->sql, 1);
+      buffer_add_str(c->sql, ", ");
+      buffer_copy(c->sql, e->value);
+      buffer_add(c->sql, ')');
+
+      prev->next = next;
+      e->next = NULL;
+      fe_node_free(e);
+    }
+  }
+}
+
+
+/*
+ * Rewrite a filter tree, return its new root
+ */
+static fe_node *fe_node_optimize(fe_node * n)
+{
+  fe_node *c, *o, *prev, *next, *sorted, **p;
+  buffer *sql;
+  bool redundant;
+
+  if (n->type == FE_NODE_PREDICATE) {
+    /* LIKE with a literal prefix: index usable range first */
+    if (n->predicate == FE_PREDICATE_LIKE) {
+      sql = buffer_from_str("(");
+      buffer_copy(sql, n->value);
+      buffer_add_str(sql, " AND ");
+      buffer_copy(sql, n->sql);
+      buffer_add(sql, ')');
+      buffer_free(n->sql);
+      n->sql = sql;
+      n->predicate = FE_PREDICATE_OTHER;
+    }
+    return n;
+  }
+
+  /* Operands first */
+  for (prev = NULL, c = n->first ; c ; prev = c, c = c->next) {
+    next = c->next;
+    c = fe_node_optimize(c);
+    c->next = next;
+    if (prev) prev->next = c;
+    else n->first = c;
+  }
+
+  /* Not(Not(A)) is A */
+  if (n->type == FE_NODE_NOT) {
+    if (n->first->type != FE_NODE_NOT) {
+      n->cost = n->first->cost;
+      return n;
+    }
+    c = n->first->first;
+    n->first->first = NULL;
+    fe_node_free(n);
+    return c;
+  }
+
+  /* Flatten nested And (or Or) */
+  for (prev = NULL, c = n->first ; c ; ) {
+    if (c->type != n->type) {
+      prev = c;
+      c = c->next;
+      continue;
+    }
+
+    for (o = c->first ; o->next ; o = o->next);
+    o->next = c->next;
+    if (prev) prev->next = c->first;
+    else n->first = c->first;
+    next = c->first;
+    c->first = NULL;
+    c->next = NULL;
+    fe_node_free(c);
+    c = next;
+  }
+
+  /* Remove redundant operands */
+  for (prev = NULL, c = n->first ; c ; c = next) {
+    next = c->next;
+
+    for (redundant = false, o = n->first ; o && !redundant ; o = o->next)
+      if (o != c) redundant = fe_node_redundant(n, c, o);
+
+    if (!redundant) {
+      prev = c;
+      continue;
+    }
+
+    if (prev) prev->next = next;
+    else n->first = next;
+    c->next = NULL;
+    fe_node_free(c);
+  }
+
+  if (n->type == FE_NODE_OR) fe_node_fold_in(n);
+
+  /* A single operand left */
+  if (!n->first->next) {
+    c = n->first;
+    n->first = NULL;
+    fe_node_free(n);
+    return c;
+  }
+
+  /* Cheapest operands first (stable) */
+  for (sorted = NULL, n->cost = 0, c = n->first ; c ; c = next) {
+    next = c->next;
+    n->cost += c->cost;
+    for (p = &sorted ; *p && (*p)->cost <= c->cost ; p = &(*p)->next);
+    c->next = *p;
+    *p = c;
+  }
+  n->first = sorted;
+
+  return n;
+}
+
+
+static void fe_node_to_sql(const fe_node * n, buffer * sql)
+{
+  const fe_node *c;
+
+  if (n->type == FE_NODE_PREDICATE) {
+    buffer_copy(sql, n->sql);
+    return;
+  }
+
+  if (n->type == FE_NODE_NOT) {
+    buffer_add_str(sql, "not(");
+    fe_node_to_sql(n->first, sql);
+    buffer_add_str(sql, ")");
+    return;
+  }
+
+  buffer_add_str(sql, "(");
+  for (c = n->first ; c ; c = c->next) {
+    fe_node_to_sql(c, sql);
+    if (c->next) buffer_add_str(sql, n->type == FE_NODE_AND ? " AND " : " OR ");
+  }
+  buffer_add_str(sql, ")");
+}
+
+
+/*
+ * Write an optimized filter into fe->sql
+ * Return false if the filter can't be handled this way, in which case
+ * it's still to be written by the usual functions (fe is left as found)
+ */
+bool fe_optimized_filter(ows * o, buffer * typename, filter_encoding * fe, xmlNodePtr n)
+{
+  fe_node *tree;
+
+  assert(o && typename && fe && n);
+
+  tree = fe_node_build(o, typename, fe, n);
+
+  if (!tree || fe->error_code != FE_NO_ERROR) {
+    if (tree) fe_node_free(tree);
+    fe->error_code = FE_NO_ERROR;
+    fe->in_not = false;
+    return false;
+  }
+
+  tree = fe_node_optimize(tree);
+  fe_node_to_sql(tree, fe->sql);
+  fe_node_free(tree);
+
+  return true;
+}
@@ -217,7 +217,8 @@ buffer *fe_envelope(ows * o, buffer * typename, filter_encoding * fe, buffer *en
   list_free(coord_max);
 
   ows_bbox_to_query(o, bbox, envelope);
-  ows_bbox_free(bbox);
+  if (fe->envelope) ows_bbox_free(fe->envelope);
+  fe->envelope = bbox;
   if (s) ows_srs_free(s);
 
   return envelope;
@@ -316,9 +317,9 @@ static buffer *fe_spatial_functions(ows * o, buffer * typename, filter_encoding
     if (srid != ows_srs_get_srid_from_layer(o, layer_name))
       buffer_add_str(fe->sql, "ST_Transform(");
 
-    buffer_add_str(fe->sql, "ST_SetSRID('");
-    buffer_copy(fe->sql, geom);
-    buffer_add_str(fe->sql, "'::geometry,");
+    buffer_add_str(fe->sql, "ST_SetSRID(");
+    ows_psql_param_geometry(o, fe->sql, geom->buf);
+    buffer_add_str(fe->sql, "::geometry,");
     buffer_add_int(fe->sql, srid);
     buffer_add(fe->sql, ')');
     buffer_free(geom);
@@ -339,87 +340,161 @@ static buffer *fe_spatial_functions(ows * o, buffer * typename, filter_encoding
 }
 
 
+/*
+ * Convert a distance into meters, according to its units
+ * (units are not strictly defined in Filter Encoding specification)
+ * Return a negative value if units or distance are not valid
+ */
+static double fe_distance_meters(const char *units, const char *content)
+{
+  double d;
+
+  if (!units || !content || !check_regexp(content, "^[ ]*[0-9]+([.][0-9]+)?([eE][-+]?[0-9]+)?[ ]*$"))
+    return -1.0;
+
+  d = atof(content);
+
+  if (    !strcmp(units, "meters") || !strcmp(units, "#metre") || !strcmp(units, "m")
+       || !strcmp(units, "urn:ogc:def:uom:EPSG::9001"))
+    return d;
+  if (    !strcmp(units, "kilometers") || !strcmp(units, "#kilometre") || !strcmp(units, "km")
+       || !strcmp(units, "urn:ogc:def:uom:EPSG::9036"))
+    return d * 1000.0;
+  if (    !strcmp(units, "feet") || !strcmp(units, "#foot") || !strcmp(units, "ft")
+       || !strcmp(units, "urn:ogc:def:uom:EPSG::9002"))
+    return d * 0.3048;
+  if (    !strcmp(units, "miles") || !strcmp(units, "#mile") || !strcmp(units, "mi")
+       || !strcmp(units, "urn:ogc:def:uom:EPSG::9093"))
+    return d * 1609.344;
+
+  return -1.0;
+}
+
+
 /*
  * DWithin and Beyond operators : test if a geometry A is within (or beyond)
  * a specified distance of a geometry B
+ * Projected layer: ST_DWithin against the column itself, the distance
+ * being converted into the layer linear unit
+ * Geographic layer: && prefilter against the geometry expanded by the distance
+ * (in degrees, widened with latitude), then exact check on geography
+ * Projected layer whose unit is unknown: exact check on geography only
  */
 static buffer *fe_distance_functions(ows * o, buffer * typename, filter_encoding * fe, xmlNodePtr n)
 {
   xmlChar *content, *units;
-  buffer *tmp, *op, *sql, *layer_name;
-  float km;
+  buffer *property, *sql, *geom, *layer_name;
+  ows_srs *layer_srs;
+  int srid, layer_srid;
+  double meters, unit;
+  bool beyond, geographic;
 
   assert(o);
   assert(typename);
   assert(fe);
   assert(n);
 
-  tmp = NULL;
-  op = buffer_init();
-
   layer_name = ows_layer_prefix_to_uri(o->layers, typename);
-
-  if (!strcmp((char *) n->name, "Beyond"))  buffer_add_str(op, " > ");
-  if (!strcmp((char *) n->name, "DWithin")) buffer_add_str(op, " < ");
-
-  buffer_add_str(fe->sql, "ST_Distance(");
-  if (!ows_srs_meter_units(o, layer_name))
-    buffer_add_str(fe->sql, "ST_Transform(");
+  layer_srid = ows_srs_get_srid_from_layer(o, layer_name);
+  beyond = !strcmp((char *) n->name, "Beyond");
 
   n = n->children;
   while (n->type != XML_ELEMENT_NODE) n = n->next; /* Jump to next element if spaces */
 
-  buffer_add(fe->sql, '"');
-  fe->sql = fe_property_name(o, typename, fe, fe->sql, n, true, true);
-  buffer_add(fe->sql, '"');
-
-  if (!ows_srs_meter_units(o, layer_name))
-    buffer_add_str(fe->sql, ", 4326)::geography");
-
-  buffer_add_str(fe->sql, "),('");
+  property = buffer_init();
+  buffer_add(property, '"');
+  property = fe_property_name(o, typename, fe, property, n, true, true);
+  buffer_add(property, '"');
 
   n = n->next;
-
   while (n->type != XML_ELEMENT_NODE) n = n->next;
 
-  if (!ows_srs_meter_units(o, layer_name))
-    buffer_add_str(fe->sql, "ST_Transform(");
-
-  /* display the geometry */
   sql = ows_psql_gml_to_sql(o, n, NULL);
-  if (sql) {
-    buffer_copy(fe->sql, sql);
-    buffer_free(sql);
-  } else fe->error_code = FE_ERROR_GEOMETRY;
-
-  if (!ows_srs_meter_units(o, layer_name))
-    buffer_add_str(fe->sql, ", 4326)::geography");
+  if (!sql) {
+    fe->error_code = FE_ERROR_GEOMETRY;
+    buffer_free(property);
+    return fe->sql;
+  }
 
-  buffer_add_str(fe->sql, "'))");
+  /* Constant geometry, in the layer srid */
+  srid = ows_psql_geometry_srid(o, sql->buf);
+  geom = buffer_init();
+  if (srid != layer_srid) buffer_add_str(geom, "ST_Transform(");
+  ows_psql_param_geometry(o, geom, sql->buf);
+  buffer_add_str(geom, "::geometry");
+  if (srid != layer_srid) {
+    buffer_add(geom, ',');
+    buffer_add_int(geom, layer_srid);
+    buffer_add(geom, ')');
+  }
+  buffer_free(sql);
 
   n = n->next;
-
   while (n->type != XML_ELEMENT_NODE) n = n->next;
 
   units = xmlGetProp(n, (xmlChar *) "units");
-  buffer_copy(fe->sql, op);
   content = xmlNodeGetContent(n->children);
+  meters = fe_distance_meters((char *) units, (char *) content);
+  xmlFree(content);
+  xmlFree(units);
 
-  /* units not strictly defined in Filter Encoding specification */
-  if (!strcmp((char *) units, "meters") || !strcmp((char *) units, "#metre"))
-    buffer_add_str(fe->sql, (char *) content);
-  else if (!strcmp((char *) units, "kilometers") || !strcmp((char *) units, "#kilometre")) {
-    km = atof((char *) content) * 1000.0;
-    tmp = buffer_ftoa((double) km);
-    buffer_copy(fe->sql, tmp);
-    buffer_free(tmp);
-  } else {
+  if (meters < 0.0) {
     fe->error_code = FE_ERROR_UNITS;
+    buffer_free(property);
+    buffer_free(geom);
+    return fe->sql;
   }
 
-  buffer_free(op);
-  xmlFree(content);
-  xmlFree(units);
+  layer_srs = ows_srs_init();
+  if (ows_srs_set_from_srid(o, layer_srs, layer_srid)) {
+    geographic = layer_srs->is_geographic;
+    unit = layer_srs->meters_per_unit;
+  } else {
+    geographic = !ows_srs_meter_units(o, layer_name);
+    unit = geographic ? 0.0 : 1.0;
+  }
+  ows_srs_free(layer_srs);
+
+  if (beyond) buffer_add_str(fe->sql, "NOT ");
+
+  if (!geographic && unit > 0.0) {
+    buffer_add_str(fe->sql, "ST_DWithin(");
+    buffer_copy(fe->sql, property);
+    buffer_add(fe->sql, ',');
+    buffer_copy(fe->sql, geom);
+    buffer_add(fe->sql, ',');
+    ows_psql_param_double(o, fe->sql, meters / unit);
+    buffer_add(fe->sql, ')');
+  } else {
+    buffer_add(fe->sql, '(');
+
+    /* Index prefilter, useless for Beyond (and in degrees) */
+    if (!beyond && geographic) {
+      /*
+       * A degree of longitude is 111320m * cos(lat), the widest expansion
+       * needed (a degree of latitude is at least 110574m)
+       */
+      buffer_copy(fe->sql, property);
+      buffer_add_str(fe->sql, " && (SELECT ST_Expand(b.e, ");
+      ows_psql_param_double(o, fe->sql, meters * 1.01);
+      buffer_add_str(fe->sql, " / (111320 * cos(radians(least(89, greatest(abs(ST_YMin(b.e)), abs(ST_YMax(b.e))) + ");
+      ows_psql_param_double(o, fe->sql, meters * 1.01 / 110574.0);
+      buffer_add_str(fe->sql, "))))) FROM (SELECT ");
+      buffer_copy(fe->sql, geom);
+      buffer_add_str(fe->sql, " AS e) AS b) AND ");
+    }
+
+    buffer_add_str(fe->sql, "ST_DWithin(ST_Transform(");
+    buffer_copy(fe->sql, property);
+    buffer_add_str(fe->sql, "::geometry, 4326)::geography, ST_Transform(");
+    buffer_copy(fe->sql, geom);
+    buffer_add_str(fe->sql, ", 4326)::geography,");
+    ows_psql_param_double(o, fe->sql, meters);
+    buffer_add_str(fe->sql, "))");
+  }
+
+  buffer_free(property);
+  buffer_free(geom);
 
   return fe->sql;
 }
@@ -427,7 +502,7 @@ static buffer *fe_distance_functions(ows * o, buffer * typename, filter_encoding
 
 static buffer *fe_bbox_layer(ows *o, buffer *typename, buffer *sql, buffer *propertyname, buffer *envelope)
 {
-  int srid = -1;
+  int srid = -1, layer_srid;
   bool transform = false;
 
   assert(propertyname);
@@ -441,6 +516,7 @@ static buffer *fe_bbox_layer(ows *o, buffer *typename, buffer *sql, buffer *prop
     srid = o->request->request.wfs->srs->srid;
     transform = true;
   }
+  layer_srid = ows_srs_get_srid_from_layer(o, ows_layer_prefix_to_uri(o->layers, typename));
 
   if (transform) buffer_add_str(sql, "ST_Transform(");
 
@@ -463,26 +539,15 @@ static buffer *fe_bbox_layer(ows *o, buffer *typename, buffer *sql, buffer *prop
     buffer_add(sql, ')');
   }
   buffer_add_str(sql, ") AND ");
-  if (transform) buffer_add_str(sql, "ST_Transform(");
 
+  /* Index filter on the column itself, with the envelope reprojected into the layer srid */
   buffer_add(sql, '"');
   buffer_copy(sql, propertyname);
   buffer_add(sql, '"');
 
-  if (transform) {
-    buffer_add(sql, ',');
-    buffer_add_int(sql, srid);
-    buffer_add(sql, ')');
-  }
-
   buffer_add_str(sql, " && ");
-  if (transform) buffer_add_str(sql, "ST_Transform(");
-  buffer_copy(sql, envelope);
-  if (transform) {
-    buffer_add(sql, ',');
-    buffer_add_int(sql, srid);
-    buffer_add(sql, ')');
-  }
+  if (transform && layer_srid > 0) ows_bbox_envelope_to_srid(envelope, layer_srid, sql);
+  else buffer_copy(sql, envelope);
   buffer_add_str(sql, ")");
 
   return sql;
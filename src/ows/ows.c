@@ -79,6 +79,8 @@ static ows *ows_init()
   o->pg = NULL;
   o->pg_dsn = buffer_init();
   o->output = stdout;
+  o->out = ows_output_init();
+  o->pipeline = list_init();
   o->config_file = NULL;
   o->mapfile = false;
   o->online_resource = buffer_init();
@@ -90,19 +92,40 @@ static ows *ows_init()
   o->db_encoding = buffer_init();
   o->layers = NULL;
   o->max_features = 0;
+  o->fetch_size = 1000;
+  o->statement_cache = 0;
+  o->statements = NULL;
+  o->srs_cache = NULL;
+  o->proj = NULL;
+  o->bulk_insert = 0;
+  o->stream_transaction = 0;
+  o->stream = NULL;
+  o->bind_parameters = false;
+  o->native_gml = false;
+  o->request_arena = false;
+  o->arena = NULL;
+  o->params = NULL;
   o->degree_precision = 6;
   o->meter_precision = 0;
   o->max_geobbox = NULL;
   o->display_bbox = true;
   o->estimated_extent = false;
+  o->bulk_introspection = false;
+  o->optimize_filter = false;
+  o->storage_snapshot = NULL;
+  o->extent_ttl = 0;
+  o->extent_delete = OWS_EXTENT_DELETE_KEEP;
   o->expose_pk = false;
   o->check_schema = true;
   o->check_valid_geom = true;
   o->metadata = NULL;
   o->contact = NULL;
   o->postgis_version = NULL;
-  o->schema_wfs_100 = NULL;
-  o->schema_wfs_110 = NULL;
+  o->schemas = NULL;
+  o->xml_ctxt = NULL;
+  o->capabilities_ttl = 0;
+  o->capabilities_wfs_100 = NULL;
+  o->capabilities_wfs_110 = NULL;
   o->wfs_default_version = ows_version_init();
   ows_version_set(o->wfs_default_version, 1, 1, 0);
 
@@ -179,6 +202,10 @@ void ows_flush(ows * o, FILE * output)
   }
 
   fprintf(output, "max_features: %d\n", o->max_features);
+  fprintf(output, "fetch_size: %d\n", o->fetch_size);
+  fprintf(output, "statement_cache: %d\n", o->statement_cache);
+  fprintf(output, "bulk_insert: %d\n", o->bulk_insert);
+  fprintf(output, "stream_transaction: %d\n", o->stream_transaction);
   fprintf(output, "degree_precision: %d\n", o->degree_precision);
   fprintf(output, "meter_precision: %d\n", o->meter_precision);
   fprintf(output, "expose_pk: %d\n", o->expose_pk?1:0);
@@ -190,11 +217,25 @@ void ows_flush(ows * o, FILE * output)
   }
   fprintf(output, "display_bbox: %d\n", o->display_bbox?1:0);
   fprintf(output, "estimated_extent: %d\n", o->estimated_extent?1:0);
+  fprintf(output, "bulk_introspection: %d\n", o->bulk_introspection?1:0);
+  fprintf(output, "optimize_filter: %d\n", o->optimize_filter?1:0);
+  fprintf(output, "bind_parameters: %d\n", o->bind_parameters?1:0);
+  fprintf(output, "native_gml: %d\n", o->native_gml?1:0);
+  fprintf(output, "request_arena: %d\n", o->request_arena?1:0);
+
+  if (o->storage_snapshot) {
+    fprintf(output, "storage_snapshot: ");
+    buffer_flush(o->storage_snapshot, output);
+    fprintf(output, "\n");
+  }
+  fprintf(output, "extent_ttl: %d\n", o->extent_ttl);
+  fprintf(output, "extent_delete: %d\n", o->extent_delete);
   fprintf(output, "check_schema: %d\n", o->check_schema?1:0);
   fprintf(output, "check_valid_geom: %d\n", o->check_valid_geom?1:0);
 
-  fprintf(output, "schema WFS 1.0: %d\n", o->schema_wfs_100?1:0);
-  fprintf(output, "schema WFS 1.1: %d\n", o->schema_wfs_110?1:0);
+  fprintf(output, "schema WFS 1.0: %d\n", ows_schema_find(o, WFS_SCHEMA_TYPE_100)?1:0);
+  fprintf(output, "schema WFS 1.1: %d\n", ows_schema_find(o, WFS_SCHEMA_TYPE_110)?1:0);
+  fprintf(output, "capabilities_ttl: %d\n", o->capabilities_ttl);
 }
 #endif
 
@@ -211,6 +252,13 @@ void ows_free(ows * o)
   if (o->online_resource)      buffer_free(o->online_resource);
   if (o->pg)                   PQfinish(o->pg);
   if (o->log_file)             buffer_free(o->log_file);
+  if (o->storage_snapshot)     buffer_free(o->storage_snapshot);
+  if (o->out)                  ows_output_free(o->out);
+  if (o->pipeline)             list_free(o->pipeline);
+  if (o->statements)           ows_psql_statements_free(o->statements);
+  if (o->srs_cache)            ows_srs_cache_free(o->srs_cache);
+  if (o->proj)                 ows_proj_free(o->proj);
+  if (o->params)               ows_psql_params_free(o->params);
   if (o->log)                  fclose(o->log);
   if (o->pg_dsn)               buffer_free(o->pg_dsn);
   if (o->cgi)                  array_free(o->cgi);
@@ -224,8 +272,11 @@ void ows_free(ows * o)
   if (o->db_encoding)          buffer_free(o->db_encoding);
   if (o->wfs_default_version)  ows_version_free(o->wfs_default_version);
   if (o->postgis_version)      ows_version_free(o->postgis_version);
-  if (o->schema_wfs_100)       xmlSchemaFree(o->schema_wfs_100);
-  if (o->schema_wfs_110)       xmlSchemaFree(o->schema_wfs_110);
+  if (o->schemas)              ows_schema_free(o->schemas);
+  if (o->xml_ctxt)             xmlFreeParserCtxt(o->xml_ctxt);
+  if (o->capabilities_wfs_100) wfs_capabilities_cache_free(o->capabilities_wfs_100);
+  if (o->capabilities_wfs_110) wfs_capabilities_cache_free(o->capabilities_wfs_110);
+  if (o->arena)                arena_free(o->arena);
 
   free(o);
   o = NULL;
@@ -266,6 +317,11 @@ void ows_usage(ows * o)
   fprintf(stdout, "FCGI support:      Yes\n");
 #else
   fprintf(stdout, "FCGI support:      No\n");
+#endif
+#if TINYOWS_PROJ
+  fprintf(stdout, "PROJ support:      Yes\n");
+#else
+  fprintf(stdout, "PROJ support:      No\n");
 #endif
   if (o->mapfile)
     fprintf(stdout, "Config File Path:  %s (Mapfile)\n", o->config_file->buf);
@@ -290,10 +346,30 @@ void ows_usage(ows * o)
 
   fprintf(stdout, "Display bbox:      %s\n", o->display_bbox?"Yes":"No");
   fprintf(stdout, "Estimated extent:  %s\n", o->estimated_extent?"Yes":"No");
+  if (o->extent_ttl > 0)
+    fprintf(stdout, "Extent cache:      %ds (%s on delete)\n", o->extent_ttl,
+            o->extent_delete == OWS_EXTENT_DELETE_RESET?"reset":"keep");
+  fprintf(stdout, "Bulk catalog:      %s\n", o->bulk_introspection?"Yes":"No");
+  if (o->storage_snapshot)
+    fprintf(stdout, "Storage snapshot:  %s\n", o->storage_snapshot->buf);
+  fprintf(stdout, "Optimize filter:   %s\n", o->optimize_filter?"Yes":"No");
+  fprintf(stdout, "Bind parameters:   %s\n", o->bind_parameters?"Yes":"No");
+  fprintf(stdout, "Native GML:        %s\n", o->native_gml?"Yes":"No");
+  fprintf(stdout, "Request arena:     %s\n", o->request_arena?"Yes":"No");
   fprintf(stdout, "Check schema:      %s\n", o->check_schema?"Yes":"No");
   fprintf(stdout, "Check valid geoms: %s\n", o->check_valid_geom?"Yes":"No");
   if (o->max_features)
     fprintf(stdout, "Max features:      %d\n", o->max_features);
+  if (o->capabilities_ttl > 0)
+    fprintf(stdout, "Capabilities TTL:  %ds\n", o->capabilities_ttl);
+  if (o->fetch_size > 0)
+    fprintf(stdout, "Fetch size:        %d\n", o->fetch_size);
+  if (o->statement_cache > 0)
+    fprintf(stdout, "Statement cache:   %d\n", o->statement_cache);
+  if (o->bulk_insert > 0)
+    fprintf(stdout, "Bulk insert:       %d\n", o->bulk_insert);
+  if (o->stream_transaction > 0)
+    fprintf(stdout, "Stream threshold:  %d bytes\n", o->stream_transaction);
 
   fprintf(stdout, "Available layers:\n");
   ows_layers_storage_flush(o, stdout);
@@ -368,13 +444,21 @@ int main(int argc, char *argv[])
   if (!o->exit) ows_layers_storage_fill(o);
   if (!o->exit) ows_log(o, 2, "== Filling Storage ==");
 
+  /* Read once the SRS used by layers */
+  if (!o->exit) ows_srs_cache_fill(o);
+
   o->init = false;
 
+  /* Containers of a request are then allocated in an arena */
+  if (!o->exit && o->request_arena) o->arena = arena_init(ARENA_CHUNK_SIZE);
+
 #if TINYOWS_FCGI
   if (!o->exit) ows_log(o, 2, "== FCGI START ==");
   while (FCGI_Accept() >= 0) {
 #endif
 
+    if (o->arena) arena_use(o->arena);
+
     query=NULL;
     if (!o->exit) query = cgi_getback_query(o);  /* Retrieve safely query string */
     if (!o->exit) ows_log(o, 4, query);          /* Log input query if asked */
@@ -437,9 +521,55 @@ int main(int argc, char *argv[])
       o->request=NULL;
     }
 
+    /* Placeholders don't outlive their request */
+    if (o->params) {
+      ows_psql_params_free(o->params);
+      o->params=NULL;
+    }
+
     /* We allocated memory only on post case */
     if (cgi_method_post() && query) free(query);
 
+    if (o->stream) {
+      cgi_stream_free(o->stream);
+      o->stream=NULL;
+    }
+
+    ows_output_flush(o);
+
+    /* Nothing allocated by the request must outlive it */
+    while (o->pipeline->first) PQclear(ows_psql_pipeline_result(o));
+
+#if TINYOWS_FCGI
+    /* Statements met by this request are ready for the next ones */
+    ows_psql_statements_prepare(o);
+#endif
+
+    if (o->cgi) {
+      array_free(o->cgi);
+      o->cgi = NULL;
+    }
+
+    if (o->psql_requests) {
+      list_free(o->psql_requests);
+      o->psql_requests = NULL;
+    }
+
+    if (o->metadata && o->metadata->type) {
+      buffer_free(o->metadata->type);
+      o->metadata->type = NULL;
+    }
+
+    if (o->metadata && o->metadata->versions) {
+      list_free(o->metadata->versions);
+      o->metadata->versions = NULL;
+    }
+
+    if (o->arena) {
+      arena_use(NULL);
+      arena_reset(o->arena);
+    }
+
 #if TINYOWS_FCGI
     fflush(stdout);
     o->exit = false;
@@ -447,6 +577,7 @@ int main(int argc, char *argv[])
   ows_log(o, 2, "== FCGI SHUTDOWN ==");
   OS_LibShutdown();
 #endif
+  ows_psql_statements_log(o);
   ows_log(o, 2, "== TINYOWS SHUTDOWN ==");
   ows_free(o);
 
@@ -153,17 +153,34 @@ bool ows_bbox_set_from_str(ows * o, ows_bbox * bb, const char *str, int srid,
  */
 ows_bbox *ows_bbox_boundaries(ows * o, list * from, list * where, ows_srs * srs)
 {
-  ows_bbox *bb;
   buffer *sql;
-  list *geom;
-  list_node *ln_from, *ln_where, *ln_geom;
   PGresult *res;
 
   assert(o && from && where && srs);
 
-  bb = ows_bbox_init();
+  sql = ows_bbox_boundaries_sql(o, from, where, srs);
+  if (!sql) return ows_bbox_init();
+
+  res = ows_psql_exec(o, sql->buf);
+  buffer_free(sql);
+
+  return ows_bbox_boundaries_result(res, srs);
+}
+
+
+/*
+ * SQL request computing the outerboundaries used by ows_bbox_boundaries
+ * Return NULL if from and where lists don't match
+ */
+buffer *ows_bbox_boundaries_sql(ows * o, list * from, list * where, ows_srs * srs)
+{
+  buffer *sql;
+  list *geom;
+  list_node *ln_from, *ln_where, *ln_geom;
+
+  assert(o && from && where && srs);
 
-  if (from->size != where->size) return bb;
+  if (from->size != where->size) return NULL;
 
   sql = buffer_init();
   /* Put into a buffer the SQL request calculating an extent */
@@ -198,8 +215,21 @@ ows_bbox *ows_bbox_boundaries(ows * o, list * from, list * where, ows_srs * srs)
 
   buffer_add_str(sql, " ) AS foo) AS g");
 
-  res = ows_psql_exec(o, sql->buf);
-  buffer_free(sql);
+  return sql;
+}
+
+
+/*
+ * Bbox from the result of the ows_bbox_boundaries_sql request
+ * (result is released)
+ */
+ows_bbox *ows_bbox_boundaries_result(PGresult * res, ows_srs * srs)
+{
+  ows_bbox *bb;
+
+  assert(res && srs);
+
+  bb = ows_bbox_init();
 
   if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 4) {
     PQclear(res);
@@ -219,20 +249,53 @@ ows_bbox *ows_bbox_boundaries(ows * o, list * from, list * where, ows_srs * srs)
 }
 
 
+/*
+ * Bbox bounds in easting, northing order (as ows_bbox_to_query writes them)
+ */
+static void ows_bbox_bounds(const ows_bbox * bb, double *x1, double *y1, double *x2, double *y2)
+{
+  if (bb->srs->honours_authority_axis_order && !bb->srs->is_axis_order_gis_friendly) {
+    *x1 = bb->ymin;
+    *y1 = bb->xmin;
+    *x2 = bb->ymax;
+    *y2 = bb->xmax;
+  } else {
+    *x1 = bb->xmin;
+    *y1 = bb->ymin;
+    *x2 = bb->xmax;
+    *y2 = bb->ymax;
+  }
+}
+
+
 /*
  * Transform a bbox from initial srid to another srid passed in parameter
+ * In process if PROJ is available, else by PostGIS
  */
 bool ows_bbox_transform(ows * o, ows_bbox * bb, int srid)
 {
   buffer *sql;
   PGresult *res;
+  double x1, y1, x2, y2;
 
   assert(o && bb);
 
+  ows_bbox_bounds(bb, &x1, &y1, &x2, &y2);
+  if (ows_proj_transform_bounds(o, bb->srs->srid, srid, &x1, &y1, &x2, &y2)) {
+    bb->xmin = x1;
+    bb->ymin = y1;
+    bb->xmax = x2;
+    bb->ymax = y2;
+
+    return ows_srs_set_from_srid(o, bb->srs, srid);
+  }
+
   sql = buffer_init();
-  buffer_add_str(sql, "SELECT xmin(g), ymin(g), xmax(g), ymax(g) FROM (SELECT ST_Transform(");
+  buffer_add_str(sql, "SELECT ST_XMin(g), ST_YMin(g), ST_XMax(g), ST_YMax(g) FROM (SELECT ST_Transform(");
   ows_bbox_to_query(o, bb, sql);
-  buffer_add_str(sql, ")) AS g ) AS foo");
+  buffer_add(sql, ',');
+  buffer_add_int(sql, srid);
+  buffer_add_str(sql, ") AS g) AS foo");
 
   res = ows_psql_exec(o, sql->buf);
   buffer_free(sql);
@@ -288,16 +351,22 @@ void ows_bbox_to_query(ows *o, ows_bbox *bbox, buffer *query)
 
   assert(o && bbox && query);
 
-  if (bbox->srs->honours_authority_axis_order && !bbox->srs->is_axis_order_gis_friendly) {
-    x1 = bbox->ymin;
-    y1 = bbox->xmin;
-    x2 = bbox->ymax;
-    y2 = bbox->xmax;
-  } else {
-    x1 = bbox->xmin;
-    y1 = bbox->ymin;
-    x2 = bbox->xmax;
-    y2 = bbox->ymax;
+  ows_bbox_bounds(bbox, &x1, &y1, &x2, &y2);
+
+  /* Same polygon, built from float8 parameters */
+  if (o->bind_parameters) {
+    buffer_add_str(query, "ST_MakeEnvelope(");
+    ows_psql_param_double(o, query, x1);
+    buffer_add(query, ',');
+    ows_psql_param_double(o, query, y1);
+    buffer_add(query, ',');
+    ows_psql_param_double(o, query, x2);
+    buffer_add(query, ',');
+    ows_psql_param_double(o, query, y2);
+    buffer_add(query, ',');
+    buffer_add_int(query, bbox->srs->srid);
+    buffer_add(query, ')');
+    return;
   }
 
   /* We use explicit POLYGON geometry rather than BBOX
@@ -330,6 +399,59 @@ void ows_bbox_to_query(ows *o, ows_bbox *bbox, buffer *query)
 }
 
 
+/*
+ * Write an envelope reprojected into srid, to be used with && against
+ * a geometry column stored in this srid (so that its index still applies)
+ * Edges are densified before reprojection and the result is padded,
+ * so the reprojected envelope covers the curved edges of the original one
+ * Computed once by PostgreSQL, as an uncorrelated subquery
+ */
+void ows_bbox_envelope_to_srid(const buffer * envelope, int srid, buffer * query)
+{
+  assert(envelope && query);
+
+  buffer_add_str(query, "(SELECT ST_Expand(t.g, greatest(ST_XMax(t.g) - ST_XMin(t.g), ST_YMax(t.g) - ST_YMin(t.g)) / 100)");
+  buffer_add_str(query, " FROM (SELECT ");
+  buffer_copy(query, envelope);
+  buffer_add_str(query, " AS e) AS b, ST_Transform(ST_Segmentize(b.e,");
+  buffer_add_str(query, " greatest(ST_XMax(b.e) - ST_XMin(b.e), ST_YMax(b.e) - ST_YMin(b.e), 1e-9) / 64), ");
+  buffer_add_int(query, srid);
+  buffer_add_str(query, ") AS t(g))");
+}
+
+
+/*
+ * Same envelope as ows_bbox_envelope_to_srid writes, but computed in
+ * process when PROJ is available (envelope is the bbox as a query)
+ */
+void ows_bbox_to_srid_query(ows * o, const ows_bbox * bb, const buffer * envelope, int srid, buffer * query)
+{
+  double x1, y1, x2, y2, pad;
+
+  assert(o && bb && envelope && query);
+
+  ows_bbox_bounds(bb, &x1, &y1, &x2, &y2);
+  if (!ows_proj_transform_bounds(o, bb->srs->srid, srid, &x1, &y1, &x2, &y2)) {
+    ows_bbox_envelope_to_srid(envelope, srid, query);
+    return;
+  }
+
+  pad = (x2 - x1 > y2 - y1 ? x2 - x1 : y2 - y1) / 100;
+
+  buffer_add_str(query, "ST_MakeEnvelope(");
+  ows_psql_param_double(o, query, x1 - pad);
+  buffer_add(query, ',');
+  ows_psql_param_double(o, query, y1 - pad);
+  buffer_add(query, ',');
+  ows_psql_param_double(o, query, x2 + pad);
+  buffer_add(query, ',');
+  ows_psql_param_double(o, query, y2 + pad);
+  buffer_add(query, ',');
+  buffer_add_int(query, srid);
+  buffer_add(query, ')');
+}
+
+
 #ifdef OWS_DEBUG
 /*
  * Flush bbox value to a file (mainly to debug purpose)
@@ -36,7 +36,7 @@
 static void ows_parse_config_tinyows(ows * o, xmlTextReaderPtr r)
 {
   xmlChar *a;
-  int precision, log_level;
+  int precision, log_level, fetch_size;
 
   assert(o);
   assert(r);
@@ -93,6 +93,85 @@ static void ows_parse_config_tinyows(ows * o, xmlTextReaderPtr r)
     xmlFree(a);
   }
 
+  a = xmlTextReaderGetAttribute(r, (xmlChar *) "bulk_introspection");
+  if (a) {
+    if (atoi((char *) a)) o->bulk_introspection = true;
+    xmlFree(a);
+  }
+
+  a = xmlTextReaderGetAttribute(r, (xmlChar *) "optimize_filter");
+  if (a) {
+    if (atoi((char *) a)) o->optimize_filter = true;
+    xmlFree(a);
+  }
+
+  a = xmlTextReaderGetAttribute(r, (xmlChar *) "bind_parameters");
+  if (a) {
+    if (atoi((char *) a)) o->bind_parameters = true;
+    xmlFree(a);
+  }
+
+  a = xmlTextReaderGetAttribute(r, (xmlChar *) "native_gml");
+  if (a) {
+    if (atoi((char *) a)) o->native_gml = true;
+    xmlFree(a);
+  }
+
+  a = xmlTextReaderGetAttribute(r, (xmlChar *) "request_arena");
+  if (a) {
+    if (atoi((char *) a)) o->request_arena = true;
+    xmlFree(a);
+  }
+
+  a = xmlTextReaderGetAttribute(r, (xmlChar *) "storage_snapshot");
+  if (a) {
+    o->storage_snapshot = buffer_from_str((char *) a);
+    xmlFree(a);
+  }
+
+  a = xmlTextReaderGetAttribute(r, (xmlChar *) "extent_ttl");
+  if (a) {
+    if (atoi((char *) a) > 0) o->extent_ttl = atoi((char *) a);
+    xmlFree(a);
+  }
+
+  a = xmlTextReaderGetAttribute(r, (xmlChar *) "extent_delete");
+  if (a) {
+    if (!strcmp((char *) a, "reset")) o->extent_delete = OWS_EXTENT_DELETE_RESET;
+    xmlFree(a);
+  }
+
+  a = xmlTextReaderGetAttribute(r, (xmlChar *) "capabilities_ttl");
+  if (a) {
+    if (atoi((char *) a) > 0) o->capabilities_ttl = atoi((char *) a);
+    xmlFree(a);
+  }
+
+  a = xmlTextReaderGetAttribute(r, (xmlChar *) "fetch_size");
+  if (a) {
+    fetch_size = atoi((char *) a);
+    if (fetch_size >= 0) o->fetch_size = fetch_size;
+    xmlFree(a);
+  }
+
+  a = xmlTextReaderGetAttribute(r, (xmlChar *) "statement_cache");
+  if (a) {
+    if (atoi((char *) a) > 0) o->statement_cache = atoi((char *) a);
+    xmlFree(a);
+  }
+
+  a = xmlTextReaderGetAttribute(r, (xmlChar *) "bulk_insert");
+  if (a) {
+    if (atoi((char *) a) > 0) o->bulk_insert = atoi((char *) a);
+    xmlFree(a);
+  }
+
+  a = xmlTextReaderGetAttribute(r, (xmlChar *) "stream_transaction");
+  if (a) {
+    if (atoi((char *) a) > 0) o->stream_transaction = atoi((char *) a);
+    xmlFree(a);
+  }
+
   a = xmlTextReaderGetAttribute(r, (xmlChar *) "check_schema");
   if (a) {
     if (!atoi((char *) a)) o->check_schema = false;
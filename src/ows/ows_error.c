@@ -82,22 +82,23 @@ void ows_error(ows * o, enum ows_error_code code, char *message, char *locator)
 #if TINYOWS_FCGI
   if ((o->init && FCGI_Accept() >= 0) || !o->init) {
 #endif
-    fprintf(o->output, "Content-Type: application/xml\n\n");
-    fprintf(o->output, "<?xml version='1.0' encoding='UTF-8'?>\n");
-    fprintf(o->output, "<ows:ExceptionReport\n");
-    fprintf(o->output, " xmlns='http://www.opengis.net/ows'\n");
-    fprintf(o->output, " xmlns:ows='http://www.opengis.net/ows'\n");
-    fprintf(o->output, " xmlns:xsi='http://www.w3.org/2001/XMLSchema-instance'\n");
-    fprintf(o->output, " xsi:schemaLocation='http://www.opengis.net/ows");
-    fprintf(o->output, " http://schemas.opengis.net/ows/1.0.0/owsExceptionReport.xsd'\n");
-    fprintf(o->output, " version='1.1.0' language='en'>\n");
-    fprintf(o->output, " <ows:Exception exceptionCode='%s' locator='%s'>\n",
-            ows_error_code_string(code), locator);
-    fprintf(o->output, "  <ows:ExceptionText>%s</ows:ExceptionText>\n", message);
-    fprintf(o->output, " </ows:Exception>\n");
-    fprintf(o->output, "</ows:ExceptionReport>\n");
+    ows_output_str(o, "Content-Type: application/xml\n\n");
+    ows_output_str(o, "<?xml version='1.0' encoding='UTF-8'?>\n");
+    ows_output_str(o, "<ows:ExceptionReport\n");
+    ows_output_str(o, " xmlns='http://www.opengis.net/ows'\n");
+    ows_output_str(o, " xmlns:ows='http://www.opengis.net/ows'\n");
+    ows_output_str(o, " xmlns:xsi='http://www.w3.org/2001/XMLSchema-instance'\n");
+    ows_output_str(o, " xsi:schemaLocation='http://www.opengis.net/ows");
+    ows_output_str(o, " http://schemas.opengis.net/ows/1.0.0/owsExceptionReport.xsd'\n");
+    ows_output_str(o, " version='1.1.0' language='en'>\n");
+    ows_output_printf(o, " <ows:Exception exceptionCode='%s' locator='%s'>\n",
+              ows_error_code_string(code), locator);
+    ows_output_printf(o, "  <ows:ExceptionText>%s</ows:ExceptionText>\n", message);
+    ows_output_str(o, " </ows:Exception>\n");
+    ows_output_str(o, "</ows:ExceptionReport>\n");
 
 #if TINYOWS_FCGI
+    ows_output_flush(o);
     fflush(o->output);
   }
 #endif
@@ -103,31 +103,42 @@ bool ows_geobbox_set(ows * o, ows_geobbox * g, double west, double east, double
 
 
 /*
- * Set a given geobbox from a bbox
+ * Set a given geobbox from EPSG:4326 bounds
  */
-bool ows_geobbox_set_from_bbox(ows * o, ows_geobbox * g, ows_bbox * bb)
+static bool ows_geobbox_set_from_bounds(ows * o, ows_geobbox * g, double xmin, double ymin, double xmax, double ymax)
 {
   double west, east, south, north;
 
   assert(g);
-  assert(bb);
 
-  if (bb->ymin < 0.0 && bb->ymax < 0.0) {
-    south = bb->ymax;
-    north = bb->ymin;
-    west = bb->xmax;
-    east = bb->xmin;
+  if (ymin < 0.0 && ymax < 0.0) {
+    south = ymax;
+    north = ymin;
+    west = xmax;
+    east = xmin;
   } else {
-    south = bb->ymin;
-    north = bb->ymax;
-    west = bb->xmin;
-    east = bb->xmax;
+    south = ymin;
+    north = ymax;
+    west = xmin;
+    east = xmax;
   }
 
   return ows_geobbox_set(o, g, west, east, south, north);
 }
 
 
+/*
+ * Set a given geobbox from a bbox
+ */
+bool ows_geobbox_set_from_bbox(ows * o, ows_geobbox * g, ows_bbox * bb)
+{
+  assert(g);
+  assert(bb);
+
+  return ows_geobbox_set_from_bounds(o, g, bb->xmin, bb->ymin, bb->xmax, bb->ymax);
+}
+
+
 /*
  * Set a given geobbox from a string like 'xmin,ymin,xmax,ymax'
  */
@@ -234,6 +245,79 @@ ows_geobbox *ows_geobbox_compute(ows * o, buffer * layer_name)
 }
 
 
+/*
+ * Widen a layer's geobbox so it covers a list of HexEWKB geometries
+ * Geometries without SRID are supposed to be in layer's SRID
+ * Return false if geometries extent can't be computed
+ */
+bool ows_geobbox_widen(ows * o, ows_geobbox * g, buffer * layer_name, const list * geoms)
+{
+  double xmin, ymin, xmax, ymax;
+  const list_node *ln;
+  buffer *sql;
+  PGresult *res;
+  int i;
+
+  assert(o);
+  assert(g);
+  assert(layer_name);
+  assert(geoms);
+
+  if (!geoms->first) return true;
+
+  sql = buffer_init();
+  buffer_add_str(sql, "SELECT ST_xmin(e), ST_ymin(e), ST_xmax(e), ST_ymax(e) FROM ");
+  buffer_add_str(sql, "(SELECT ST_Extent(ST_Transform(CASE WHEN ST_SRID(g) = 0 THEN ST_SetSRID(g, ");
+  buffer_add_int(sql, ows_srs_get_srid_from_layer(o, layer_name));
+  buffer_add_str(sql, ") ELSE g END, 4326)) AS e FROM unnest(ARRAY[");
+
+  for (ln = geoms->first ; ln ; ln = ln->next) {
+    buffer_add(sql, '\'');
+    buffer_copy(sql, ln->value);
+    buffer_add(sql, '\'');
+    if (ln->next) buffer_add(sql, ',');
+  }
+  buffer_add_str(sql, "]::geometry[]) AS v(g)) AS foo");
+
+  res = ows_psql_exec(o, sql->buf);
+  buffer_free(sql);
+
+  if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1) {
+    PQclear(res);
+    return false;
+  }
+
+  for (i = 0 ; i < 4 ; i++) {
+    if (PQgetisnull(res, 0, i)) {
+      PQclear(res);
+      return false;
+    }
+  }
+
+  xmin = atof(PQgetvalue(res, 0, 0));
+  ymin = atof(PQgetvalue(res, 0, 1));
+  xmax = atof(PQgetvalue(res, 0, 2));
+  ymax = atof(PQgetvalue(res, 0, 3));
+  PQclear(res);
+
+  /* Geobbox could have been stored with swapped corners */
+  if (g->east != DBL_MIN) {
+    if (g->west < xmin)  xmin = g->west;
+    if (g->east < xmin)  xmin = g->east;
+    if (g->west > xmax)  xmax = g->west;
+    if (g->east > xmax)  xmax = g->east;
+    if (g->south < ymin) ymin = g->south;
+    if (g->north < ymin) ymin = g->north;
+    if (g->south > ymax) ymax = g->south;
+    if (g->north > ymax) ymax = g->north;
+  }
+
+  ows_geobbox_set_from_bounds(o, g, xmin, ymin, xmax, ymax);
+
+  return true;
+}
+
+
 #ifdef OWS_DEBUG
 /*
  * Flush bbox value to a file (mainly to debug purpose)
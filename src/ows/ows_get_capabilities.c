@@ -39,18 +39,18 @@ void ows_get_capabilities_dcpt(const ows * o, const char * req)
   assert(o);
   assert(o->online_resource);
 
-  fprintf(o->output, "    <ows:DCP>\n");
-  fprintf(o->output, "     <ows:HTTP>\n");
-  fprintf(o->output, "      <ows:Get xlink:href=\"");
-  fprintf(o->output, "%s?%s\"/>\n", o->online_resource->buf, req);
-  fprintf(o->output, "     </ows:HTTP>\n");
-  fprintf(o->output, "    </ows:DCP>\n");
-  fprintf(o->output, "    <ows:DCP>\n");
-  fprintf(o->output, "     <ows:HTTP>\n");
-  fprintf(o->output, "      <ows:Post xlink:href=\"");
-  fprintf(o->output, "%s\"/>\n", o->online_resource->buf);
-  fprintf(o->output, "     </ows:HTTP>\n");
-  fprintf(o->output, "    </ows:DCP>\n");
+  ows_output_str(o, "    <ows:DCP>\n");
+  ows_output_str(o, "     <ows:HTTP>\n");
+  ows_output_str(o, "      <ows:Get xlink:href=\"");
+  ows_output_printf(o, "%s?%s\"/>\n", o->online_resource->buf, req);
+  ows_output_str(o, "     </ows:HTTP>\n");
+  ows_output_str(o, "    </ows:DCP>\n");
+  ows_output_str(o, "    <ows:DCP>\n");
+  ows_output_str(o, "     <ows:HTTP>\n");
+  ows_output_str(o, "      <ows:Post xlink:href=\"");
+  ows_output_printf(o, "%s\"/>\n", o->online_resource->buf);
+  ows_output_str(o, "     </ows:HTTP>\n");
+  ows_output_str(o, "    </ows:DCP>\n");
 }
 
 
@@ -70,33 +70,33 @@ void ows_service_metadata(const ows * o)
 
   ln = NULL;
 
-  fprintf(o->output, " <Service>\n");
-  fprintf(o->output, "  <Name>%s</Name>\n", o->metadata->name->buf);
-  fprintf(o->output, "  <Title>%s</Title>\n", o->metadata->title->buf);
+  ows_output_str(o, " <Service>\n");
+  ows_output_printf(o, "  <Name>%s</Name>\n", o->metadata->name->buf);
+  ows_output_printf(o, "  <Title>%s</Title>\n", o->metadata->title->buf);
 
   if (o->metadata->abstract)
-    fprintf(o->output, "  <Abstract>%s</Abstract>\n", o->metadata->abstract->buf);
+    ows_output_printf(o, "  <Abstract>%s</Abstract>\n", o->metadata->abstract->buf);
 
   if (o->metadata->keywords) {
-    fprintf(o->output, "  <Keywords>");
+    ows_output_str(o, "  <Keywords>");
 
     for (ln = o->metadata->keywords->first ; ln->next; ln = ln->next)
-      fprintf(o->output, "%s,", ln->value->buf);
+      ows_output_printf(o, "%s,", ln->value->buf);
 
-    fprintf(o->output, "%s</Keywords>\n", ln->value->buf);
+    ows_output_printf(o, "%s</Keywords>\n", ln->value->buf);
   }
 
-  fprintf(o->output, "  <OnlineResource>%s</OnlineResource>\n", o->online_resource->buf);
+  ows_output_printf(o, "  <OnlineResource>%s</OnlineResource>\n", o->online_resource->buf);
 
   if (o->metadata->fees)
-    fprintf(o->output, "  <Fees>%s</Fees>\n", o->metadata->fees->buf);
+    ows_output_printf(o, "  <Fees>%s</Fees>\n", o->metadata->fees->buf);
 
   if (o->metadata->access_constraints)
-    fprintf(o->output,
-            "  <AccessConstraints>%s</AccessConstraints>\n",
-            o->metadata->access_constraints->buf);
+    ows_output_printf(o,
+              "  <AccessConstraints>%s</AccessConstraints>\n",
+              o->metadata->access_constraints->buf);
 
-  fprintf(o->output, " </Service>\n");
+  ows_output_str(o, " </Service>\n");
 }
 
 
@@ -115,35 +115,35 @@ void ows_service_identification(const ows * o)
 
   ln = NULL;
 
-  fprintf(o->output, " <ows:ServiceIdentification>\n");
+  ows_output_str(o, " <ows:ServiceIdentification>\n");
 
   if (o->metadata->title)
-    fprintf(o->output, "  <ows:Title>%s</ows:Title>\n", o->metadata->title->buf);
+    ows_output_printf(o, "  <ows:Title>%s</ows:Title>\n", o->metadata->title->buf);
 
   if (o->metadata->abstract)
-    fprintf(o->output, "  <ows:Abstract>%s</ows:Abstract>\n", o->metadata->abstract->buf);
+    ows_output_printf(o, "  <ows:Abstract>%s</ows:Abstract>\n", o->metadata->abstract->buf);
 
   if (o->metadata->keywords) {
-    fprintf(o->output, "  <ows:Keywords>\n");
+    ows_output_str(o, "  <ows:Keywords>\n");
     for (ln = o->metadata->keywords->first ; ln ; ln = ln->next)
-      fprintf(o->output, "   <ows:Keyword>%s</ows:Keyword>\n", ln->value->buf);
-    fprintf(o->output, "  </ows:Keywords>\n");
+      ows_output_printf(o, "   <ows:Keyword>%s</ows:Keyword>\n", ln->value->buf);
+    ows_output_str(o, "  </ows:Keywords>\n");
   }
 
-  fprintf(o->output, "  <ows:ServiceType>%s</ows:ServiceType>\n", o->metadata->type->buf);
+  ows_output_printf(o, "  <ows:ServiceType>%s</ows:ServiceType>\n", o->metadata->type->buf);
   for (ln = o->metadata->versions->first ; ln ; ln = ln->next)
-    fprintf(o->output, "  <ows:ServiceTypeVersion>%s</ows:ServiceTypeVersion>\n", ln->value->buf);
+    ows_output_printf(o, "  <ows:ServiceTypeVersion>%s</ows:ServiceTypeVersion>\n", ln->value->buf);
 
 
   if (o->metadata->fees)
-    fprintf(o->output, "  <ows:Fees>%s</ows:Fees>\n", o->metadata->fees->buf);
+    ows_output_printf(o, "  <ows:Fees>%s</ows:Fees>\n", o->metadata->fees->buf);
 
   if (o->metadata->access_constraints)
-    fprintf(o->output,
-            "  <ows:AccessConstraints>%s</ows:AccessConstraints>\n",
-            o->metadata->access_constraints->buf);
+    ows_output_printf(o,
+              "  <ows:AccessConstraints>%s</ows:AccessConstraints>\n",
+              o->metadata->access_constraints->buf);
 
-  fprintf(o->output, " </ows:ServiceIdentification>\n");
+  ows_output_str(o, " </ows:ServiceIdentification>\n");
 }
 
 
@@ -158,22 +158,22 @@ void ows_service_provider(const ows * o)
 
   if (!o->contact) return;
 
-  fprintf(o->output, " <ows:ServiceProvider>\n");
+  ows_output_str(o, " <ows:ServiceProvider>\n");
 
   if (o->contact->name)
-    fprintf(o->output, "  <ows:ProviderName>%s</ows:ProviderName>\n", o->contact->name->buf);
+    ows_output_printf(o, "  <ows:ProviderName>%s</ows:ProviderName>\n", o->contact->name->buf);
   if (o->contact->site)
-    fprintf(o->output, "  <ows:ProviderSite xlink:href=\"%s\" />\n", o->contact->site->buf);
+    ows_output_printf(o, "  <ows:ProviderSite xlink:href=\"%s\" />\n", o->contact->site->buf);
 
-  fprintf(o->output, "  <ows:ServiceContact>\n");
+  ows_output_str(o, "  <ows:ServiceContact>\n");
 
   if (o->contact->indiv_name)
-    fprintf(o->output, "   <ows:IndividualName>%s</ows:IndividualName>\n",
-            o->contact->indiv_name->buf);
+    ows_output_printf(o, "   <ows:IndividualName>%s</ows:IndividualName>\n",
+              o->contact->indiv_name->buf);
 
   if (o->contact->position)
-    fprintf(o->output, "   <ows:PositionName>%s</ows:PositionName>\n",
-            o->contact->position->buf);
+    ows_output_printf(o, "   <ows:PositionName>%s</ows:PositionName>\n",
+              o->contact->position->buf);
 
   if (       o->contact->phone
              || o->contact->fax
@@ -186,19 +186,19 @@ void ows_service_provider(const ows * o)
              || o->contact->online_resource
              || o->contact->hours
              || o->contact->instructions) {
-    fprintf(o->output, "   <ows:ContactInfo>\n");
+    ows_output_str(o, "   <ows:ContactInfo>\n");
 
     if (o->contact->phone || o->contact->fax) {
-      fprintf(o->output, "    <ows:Phone>\n");
+      ows_output_str(o, "    <ows:Phone>\n");
 
       if (o->contact->phone)
-        fprintf(o->output, "     <ows:Voice>%s</ows:Voice>\n", o->contact->phone->buf);
+        ows_output_printf(o, "     <ows:Voice>%s</ows:Voice>\n", o->contact->phone->buf);
 
       if (o->contact->fax)
-        fprintf(o->output, "     <ows:Facsimile>%s</ows:Facsimile>\n",
-                o->contact->fax->buf);
+        ows_output_printf(o, "     <ows:Facsimile>%s</ows:Facsimile>\n",
+                  o->contact->fax->buf);
 
-      fprintf(o->output, "    </ows:Phone>\n");
+      ows_output_str(o, "    </ows:Phone>\n");
     }
 
     if (       o->contact->address
@@ -207,52 +207,52 @@ void ows_service_provider(const ows * o)
                || o->contact->state
                || o->contact->country
                || o->contact->email) {
-      fprintf(o->output, "    <ows:Address>\n");
+      ows_output_str(o, "    <ows:Address>\n");
 
       if (o->contact->address)
-        fprintf(o->output, "     <ows:DeliveryPoint>%s</ows:DeliveryPoint>\n",
-                o->contact->address->buf);
+        ows_output_printf(o, "     <ows:DeliveryPoint>%s</ows:DeliveryPoint>\n",
+                  o->contact->address->buf);
 
       if (o->contact->city)
-        fprintf(o->output, "     <ows:City>%s</ows:City>\n", o->contact->city->buf);
+        ows_output_printf(o, "     <ows:City>%s</ows:City>\n", o->contact->city->buf);
 
       if (o->contact->state)
-        fprintf(o->output, "     <ows:AdministrativeArea>%s</ows:AdministrativeArea>\n",
-                o->contact->state->buf);
+        ows_output_printf(o, "     <ows:AdministrativeArea>%s</ows:AdministrativeArea>\n",
+                  o->contact->state->buf);
 
       if (o->contact->postcode)
-        fprintf(o->output, "     <ows:PostalCode>%s</ows:PostalCode>\n",
-                o->contact->postcode->buf);
+        ows_output_printf(o, "     <ows:PostalCode>%s</ows:PostalCode>\n",
+                  o->contact->postcode->buf);
 
       if (o->contact->country)
-        fprintf(o->output, "     <ows:Country>%s</ows:Country>\n",
-                o->contact->country->buf);
+        ows_output_printf(o, "     <ows:Country>%s</ows:Country>\n",
+                  o->contact->country->buf);
 
       if (o->contact->email)
-        fprintf(o->output,
-                "    <ows:ElectronicMailAddress>%s</ows:ElectronicMailAddress>\n",
-                o->contact->email->buf);
+        ows_output_printf(o,
+                  "    <ows:ElectronicMailAddress>%s</ows:ElectronicMailAddress>\n",
+                  o->contact->email->buf);
 
-      fprintf(o->output, "    </ows:Address>\n");
+      ows_output_str(o, "    </ows:Address>\n");
     }
 
     if (o->contact->online_resource)
-      fprintf(o->output, "    <ows:OnlineResource xlink:href=\"%s\" />\n",
-              o->contact->online_resource->buf);
+      ows_output_printf(o, "    <ows:OnlineResource xlink:href=\"%s\" />\n",
+                o->contact->online_resource->buf);
 
     if (o->contact->hours)
-      fprintf(o->output, "    <ows:HoursOfService>%s</ows:HoursOfService>\n",
-              o->contact->hours->buf);
+      ows_output_printf(o, "    <ows:HoursOfService>%s</ows:HoursOfService>\n",
+                o->contact->hours->buf);
 
     if (o->contact->instructions)
-      fprintf(o->output, "    <ows:ContactInstructions>%s</ows:ContactInstructions>\n",
-              o->contact->instructions->buf);
+      ows_output_printf(o, "    <ows:ContactInstructions>%s</ows:ContactInstructions>\n",
+                o->contact->instructions->buf);
 
-    fprintf(o->output, "   </ows:ContactInfo>\n");
+    ows_output_str(o, "   </ows:ContactInfo>\n");
   }
 
-  fprintf(o->output, "  </ows:ServiceContact>\n");
-  fprintf(o->output, " </ows:ServiceProvider>\n");
+  ows_output_str(o, "  </ows:ServiceContact>\n");
+  ows_output_str(o, " </ows:ServiceProvider>\n");
 }
 
 
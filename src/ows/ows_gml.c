@@ -0,0 +1,726 @@
+/*
+  Copyright (c) <2007-2012> <Barbara Philippot - Olivier Courtin>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "ows.h"
+
+
+/*
+ * GML Simple Features (SF-0) geometries to EWKB, without a round trip
+ * to PostGIS. Produces the same geometry ST_GeomFromGML does; anything
+ * beyond SF-0 (curves, surfaces patches, xlink, nested srsName...)
+ * is left to ST_GeomFromGML, as is any GML it would reject.
+ * make check compares both on demo/tests/gml
+ */
+
+#define OWS_WKB_POINT              1
+#define OWS_WKB_LINESTRING         2
+#define OWS_WKB_POLYGON            3
+#define OWS_WKB_MULTIPOINT         4
+#define OWS_WKB_MULTILINESTRING    5
+#define OWS_WKB_MULTIPOLYGON       6
+#define OWS_WKB_GEOMETRYCOLLECTION 7
+#define OWS_WKB_RING               0   /* polygon ring, not a WKB type */
+
+#define OWS_WKB_ZFLAG    0x80000000U
+#define OWS_WKB_SRIDFLAG 0x20000000U
+
+typedef struct Ows_gml_geom {
+  int type;
+  double * coords;          /* x, y, z for each point */
+  int npoints;
+  int max;
+  struct Ows_gml_geom * first;    /* polygon rings, or collection members */
+  struct Ows_gml_geom * last;
+  struct Ows_gml_geom * next;
+} ows_gml_geom;
+
+typedef struct Ows_gml_state {
+  bool flip;                /* swap x and y */
+  int hasz;                 /* -1 until a point is read, then whether every point had a z */
+} ows_gml_state;
+
+
+static ows_gml_geom *ows_gml_geom_init(int type)
+{
+  ows_gml_geom *g;
+
+  g = malloc(sizeof(ows_gml_geom));
+  assert(g);
+
+  g->type = type;
+  g->coords = NULL;
+  g->npoints = g->max = 0;
+  g->first = g->last = g->next = NULL;
+
+  return g;
+}
+
+
+static void ows_gml_geom_free(ows_gml_geom * g)
+{
+  ows_gml_geom *c, *next;
+
+  for (c = g->first ; c ; c = next) {
+    next = c->next;
+    ows_gml_geom_free(c);
+  }
+
+  free(g->coords);
+  free(g);
+}
+
+
+static void ows_gml_geom_add(ows_gml_geom * g, ows_gml_geom * child)
+{
+  if (g->last) g->last->next = child;
+  else g->first = child;
+  g->last = child;
+}
+
+
+static void ows_gml_add_point(ows_gml_geom * g, ows_gml_state * st, const double *c, int dims)
+{
+  if (g->npoints == g->max) {
+    g->max = g->max ? g->max * 2 : 8;
+    g->coords = realloc(g->coords, g->max * 3 * sizeof(double));
+    assert(g->coords);
+  }
+
+  g->coords[g->npoints * 3]     = st->flip ? c[1] : c[0];
+  g->coords[g->npoints * 3 + 1] = st->flip ? c[0] : c[1];
+  g->coords[g->npoints * 3 + 2] = dims == 3 ? c[2] : 0.0;
+  g->npoints++;
+
+  if (dims != 3) st->hasz = 0;
+  else if (st->hasz == -1) st->hasz = 1;
+}
+
+
+/*
+ * Element in GML 3 or GML 3.2 namespace, with this local name
+ */
+static bool ows_gml_is(xmlNodePtr n, const char *name)
+{
+  return n->type == XML_ELEMENT_NODE && n->ns
+         && (    !strcmp((char *) n->ns->href, "http://www.opengis.net/gml")
+              || !strcmp((char *) n->ns->href, "http://www.opengis.net/gml/3.2"))
+         && !strcmp((char *) n->name, name);
+}
+
+
+/*
+ * First element among n and its next siblings
+ */
+static xmlNodePtr ows_gml_element(xmlNodePtr n)
+{
+  for ( ; n && n->type != XML_ELEMENT_NODE ; n = n->next);
+
+  return n;
+}
+
+
+/*
+ * Parse a number as ST_GeomFromGML would accept it
+ */
+static bool ows_gml_double(const char *s, size_t len, double *d)
+{
+  char tmp[64], *end;
+  size_t i;
+
+  if (!len || len >= sizeof(tmp)) return false;
+
+  for (i = 0 ; i < len ; i++) {
+    if (!isdigit((unsigned char) s[i]) && !strchr("+-.eE", s[i])) return false;
+    tmp[i] = s[i];
+  }
+  tmp[len] = '\0';
+
+  *d = strtod(tmp, &end);
+
+  return end == tmp + len;
+}
+
+
+/*
+ * srsDimension, from the element itself or an ancestor (0 if none)
+ */
+static int ows_gml_dimension(xmlNodePtr n)
+{
+  xmlChar *a;
+  int dims;
+
+  for ( ; n && n->type == XML_ELEMENT_NODE ; n = n->parent) {
+    a = xmlGetProp(n, (xmlChar *) "srsDimension");
+    if (!a) a = xmlGetProp(n, (xmlChar *) "dimension");   /* GML 3.1.0 */
+    if (a) {
+      dims = atoi((char *) a);
+      xmlFree(a);
+      return dims;
+    }
+  }
+
+  return 0;
+}
+
+
+/*
+ * gml:pos (a single point, 2 or 3 numbers) and gml:posList (srsDimension
+ * numbers by point, 2 if not stated), space separated numbers
+ * Return the number of points read, -1 on error
+ */
+static int ows_gml_parse_pos(xmlNodePtr n, ows_gml_geom * g, ows_gml_state * st, bool list)
+{
+  xmlChar *content;
+  const char *c, *start;
+  double *coords = NULL;
+  int dims, size, max, i;
+
+  dims = ows_gml_dimension(n);
+  if (dims && dims != 2 && dims != 3) return -1;
+
+  content = xmlNodeGetContent(n);
+  if (!content) return -1;
+
+  for (c = (char *) content, size = max = 0 ; ; size++) {
+    for ( ; isspace((unsigned char) *c) ; c++);
+    if (!*c) break;
+
+    if (size == max) {
+      max = max ? max * 2 : 16;
+      coords = realloc(coords, max * sizeof(double));
+      assert(coords);
+    }
+
+    for (start = c ; *c && !isspace((unsigned char) *c) ; c++);
+    if (!ows_gml_double(start, c - start, &coords[size])) {
+      size = -1;
+      break;
+    }
+  }
+
+  xmlFree(content);
+
+  if (!list && !dims && (size == 2 || size == 3)) dims = size;
+  if (list && !dims) dims = 2;
+
+  if (size < 0 || !dims || size % dims || (!list && size != dims)) {
+    free(coords);
+    return -1;
+  }
+
+  for (i = 0 ; i < size ; i += dims) ows_gml_add_point(g, st, coords + i, dims);
+  free(coords);
+
+  return size / dims;
+}
+
+
+/*
+ * GML 2 gml:coordinates, with its cs, ts and decimal attributes
+ */
+static int ows_gml_parse_coordinates(xmlNodePtr n, ows_gml_geom * g, ows_gml_state * st)
+{
+  xmlChar *content, *a;
+  const char *c, *start;
+  char cs = ',', ts = ' ';
+  double coord[3];
+  int i, points;
+  bool spaces;
+
+  a = xmlGetProp(n, (xmlChar *) "decimal");
+  if (a) {
+    if (strcmp((char *) a, ".")) {
+      xmlFree(a);
+      return -1;
+    }
+    xmlFree(a);
+  }
+
+  a = xmlGetProp(n, (xmlChar *) "cs");
+  if (a) {
+    if (strlen((char *) a) != 1) {
+      xmlFree(a);
+      return -1;
+    }
+    cs = a[0];
+    xmlFree(a);
+  }
+
+  a = xmlGetProp(n, (xmlChar *) "ts");
+  if (a) {
+    if (strlen((char *) a) != 1) {
+      xmlFree(a);
+      return -1;
+    }
+    ts = a[0];
+    xmlFree(a);
+  }
+
+  if (cs == ts || isspace((unsigned char) cs) || strchr("0123456789+-.eE", cs)
+      || strchr("0123456789+-.eE", ts)) return -1;
+
+  content = xmlNodeGetContent(n);
+  if (!content) return -1;
+
+  for (c = (char *) content ; isspace((unsigned char) *c) ; c++);
+
+  for (i = points = 0 ; *c ; ) {
+    for (start = c ; *c && strchr("0123456789+-.eE", *c) ; c++);
+    if (i == 3 || !ows_gml_double(start, c - start, &coord[i++])) {
+      points = -1;
+      break;
+    }
+
+    /* Spaces are allowed around separators */
+    for (spaces = false ; isspace((unsigned char) *c) ; c++) spaces = true;
+
+    if (*c == cs) {
+      for (c++ ; isspace((unsigned char) *c) ; c++);
+      continue;
+    }
+
+    if (*c && *c == ts) for (c++ ; isspace((unsigned char) *c) ; c++);
+    else if (*c && !(spaces && isspace((unsigned char) ts))) {
+      points = -1;
+      break;
+    }
+
+    /* End of a tuple */
+    if (i < 2) {
+      points = -1;
+      break;
+    }
+    ows_gml_add_point(g, st, coord, i);
+    points++;
+    i = 0;
+  }
+
+  if (i) points = -1;
+
+  xmlFree(content);
+
+  return points;
+}
+
+
+/*
+ * GML 2 gml:coord, with X, Y and optional Z children
+ */
+static int ows_gml_parse_coord(xmlNodePtr n, ows_gml_geom * g, ows_gml_state * st)
+{
+  static const char *names[] = { "X", "Y", "Z" };
+  xmlChar *content;
+  double coord[3];
+  int i;
+
+  for (n = ows_gml_element(n->children), i = 0 ; n ; n = ows_gml_element(n->next), i++) {
+    if (i == 3 || !ows_gml_is(n, names[i])) return -1;
+
+    content = xmlNodeGetContent(n);
+    if (!content) return -1;
+    if (!ows_gml_double((char *) content, strlen((char *) content), &coord[i])) {
+      xmlFree(content);
+      return -1;
+    }
+    xmlFree(content);
+  }
+
+  if (i < 2) return -1;
+  ows_gml_add_point(g, st, coord, i);
+
+  return 1;
+}
+
+
+/*
+ * Points of a Point, LineString or LinearRing
+ */
+static bool ows_gml_parse_points(xmlNodePtr n, ows_gml_geom * g, ows_gml_state * st)
+{
+  int points;
+
+  for (n = ows_gml_element(n->children) ; n ; n = ows_gml_element(n->next)) {
+
+         if (ows_gml_is(n, "posList"))     points = ows_gml_parse_pos(n, g, st, true);
+    else if (ows_gml_is(n, "pos"))         points = ows_gml_parse_pos(n, g, st, false);
+    else if (ows_gml_is(n, "coordinates")) points = ows_gml_parse_coordinates(n, g, st);
+    else if (ows_gml_is(n, "coord"))       points = ows_gml_parse_coord(n, g, st);
+    else points = -1;
+
+    if (points < 0) return false;
+  }
+
+  return true;
+}
+
+
+static bool ows_gml_ring_closed(const ows_gml_geom * g, bool hasz)
+{
+  const double *a, *b;
+
+  a = g->coords;
+  b = g->coords + (g->npoints - 1) * 3;
+
+  return a[0] == b[0] && a[1] == b[1] && (!hasz || a[2] == b[2]);
+}
+
+
+static ows_gml_geom *ows_gml_parse(xmlNodePtr n, ows_gml_state * st);
+
+
+/*
+ * Ring of a Polygon, from its exterior or interior element
+ */
+static bool ows_gml_parse_ring(xmlNodePtr n, ows_gml_geom * poly, ows_gml_state * st)
+{
+  ows_gml_geom *ring;
+
+  n = ows_gml_element(n->children);
+  if (!n || !ows_gml_is(n, "LinearRing") || ows_gml_element(n->next)) return false;
+
+  ring = ows_gml_geom_init(OWS_WKB_RING);
+  ows_gml_geom_add(poly, ring);
+
+  return ows_gml_parse_points(n, ring, st) && ring->npoints >= 4;
+}
+
+
+static bool ows_gml_parse_polygon(xmlNodePtr n, ows_gml_geom * poly, ows_gml_state * st)
+{
+  xmlNodePtr c;
+
+  c = ows_gml_element(n->children);
+  if (!c || !(ows_gml_is(c, "exterior") || ows_gml_is(c, "outerBoundaryIs"))) return false;
+  if (!ows_gml_parse_ring(c, poly, st)) return false;
+
+  for (c = ows_gml_element(c->next) ; c ; c = ows_gml_element(c->next)) {
+    if (!ows_gml_is(c, "interior") && !ows_gml_is(c, "innerBoundaryIs")) return false;
+    if (!ows_gml_parse_ring(c, poly, st)) return false;
+  }
+
+  return true;
+}
+
+
+/*
+ * Members of a collection, each one of the given type (or any type if 0)
+ * in a single member element, or several in a members element
+ */
+static bool ows_gml_parse_members(xmlNodePtr n, ows_gml_geom * coll, ows_gml_state * st,
+                                  const char *member, const char *members, int type)
+{
+  ows_gml_geom *g;
+  xmlNodePtr c, m;
+
+  for (c = ows_gml_element(n->children) ; c ; c = ows_gml_element(c->next)) {
+
+    if (ows_gml_is(c, member)) {
+      m = ows_gml_element(c->children);
+      if (!m || ows_gml_element(m->next)) return false;
+    } else if (members && ows_gml_is(c, members)) {
+      m = ows_gml_element(c->children);
+    } else return false;
+
+    for ( ; m ; m = ows_gml_element(m->next)) {
+      g = ows_gml_parse(m, st);
+      if (!g) return false;
+      ows_gml_geom_add(coll, g);
+      if (type && g->type != type) return false;
+      if (ows_gml_is(c, member)) break;
+    }
+  }
+
+  return true;
+}
+
+
+/*
+ * Parse a GML geometry element, NULL if not handled here
+ */
+static ows_gml_geom *ows_gml_parse(xmlNodePtr n, ows_gml_state * st)
+{
+  ows_gml_geom *g = NULL;
+  bool ok = false;
+
+  if (ows_gml_is(n, "Point")) {
+    g = ows_gml_geom_init(OWS_WKB_POINT);
+    ok = ows_gml_parse_points(n, g, st) && g->npoints == 1;
+
+  } else if (ows_gml_is(n, "LineString")) {
+    g = ows_gml_geom_init(OWS_WKB_LINESTRING);
+    ok = ows_gml_parse_points(n, g, st) && g->npoints >= 2;
+
+  } else if (ows_gml_is(n, "LinearRing")) {
+    /* As ST_GeomFromGML does, a single ring polygon */
+    g = ows_gml_geom_init(OWS_WKB_POLYGON);
+    ows_gml_geom_add(g, ows_gml_geom_init(OWS_WKB_RING));
+    ok = ows_gml_parse_points(n, g->first, st) && g->first->npoints >= 4;
+
+  } else if (ows_gml_is(n, "Polygon")) {
+    g = ows_gml_geom_init(OWS_WKB_POLYGON);
+    ok = ows_gml_parse_polygon(n, g, st);
+
+  } else if (ows_gml_is(n, "MultiPoint")) {
+    g = ows_gml_geom_init(OWS_WKB_MULTIPOINT);
+    ok = ows_gml_parse_members(n, g, st, "pointMember", "pointMembers", OWS_WKB_POINT);
+
+  } else if (ows_gml_is(n, "MultiLineString")) {
+    g = ows_gml_geom_init(OWS_WKB_MULTILINESTRING);
+    ok = ows_gml_parse_members(n, g, st, "lineStringMember", NULL, OWS_WKB_LINESTRING);
+
+  } else if (ows_gml_is(n, "MultiCurve")) {
+    g = ows_gml_geom_init(OWS_WKB_MULTILINESTRING);
+    ok = ows_gml_parse_members(n, g, st, "curveMember", "curveMembers", OWS_WKB_LINESTRING);
+
+  } else if (ows_gml_is(n, "MultiPolygon")) {
+    g = ows_gml_geom_init(OWS_WKB_MULTIPOLYGON);
+    ok = ows_gml_parse_members(n, g, st, "polygonMember", NULL, OWS_WKB_POLYGON);
+
+  } else if (ows_gml_is(n, "MultiSurface")) {
+    g = ows_gml_geom_init(OWS_WKB_MULTIPOLYGON);
+    ok = ows_gml_parse_members(n, g, st, "surfaceMember", "surfaceMembers", OWS_WKB_POLYGON);
+
+  } else if (ows_gml_is(n, "MultiGeometry")) {
+    g = ows_gml_geom_init(OWS_WKB_GEOMETRYCOLLECTION);
+    ok = ows_gml_parse_members(n, g, st, "geometryMember", "geometryMembers", 0);
+  }
+
+  if (!ok && g) {
+    ows_gml_geom_free(g);
+    g = NULL;
+  }
+
+  return g;
+}
+
+
+/*
+ * A srsName below the geometry element could imply a reprojection
+ */
+static bool ows_gml_nested_srs(xmlNodePtr n)
+{
+  for ( ; n ; n = n->next) {
+    if (n->type != XML_ELEMENT_NODE) continue;
+    if (xmlHasProp(n, (xmlChar *) "srsName") || ows_gml_nested_srs(n->children)) return true;
+  }
+
+  return false;
+}
+
+
+static bool ows_gml_rings_closed(const ows_gml_geom * g, bool hasz)
+{
+  const ows_gml_geom *c;
+
+  if (g->type == OWS_WKB_RING) return ows_gml_ring_closed(g, hasz);
+
+  for (c = g->first ; c ; c = c->next)
+    if (!ows_gml_rings_closed(c, hasz)) return false;
+
+  return true;
+}
+
+
+/*
+ * EWKB writers, little endian (NDR) and in hexadecimal as PostGIS outputs it
+ */
+static void ows_wkb_bytes(buffer * b, const unsigned char *bytes, int n)
+{
+  static const char hex[] = "0123456789ABCDEF";
+  int i;
+
+  for (i = 0 ; i < n ; i++) {
+    buffer_add(b, hex[bytes[i] >> 4]);
+    buffer_add(b, hex[bytes[i] & 0x0f]);
+  }
+}
+
+
+static void ows_wkb_uint(buffer * b, unsigned long u)
+{
+  unsigned char bytes[4];
+  int i;
+
+  for (i = 0 ; i < 4 ; i++, u >>= 8) bytes[i] = (unsigned char) (u & 0xff);
+  ows_wkb_bytes(b, bytes, 4);
+}
+
+
+static void ows_wkb_double(buffer * b, double d)
+{
+  unsigned long long u;
+  unsigned char bytes[8];
+  int i;
+
+  assert(sizeof(u) == sizeof(d));
+  memcpy(&u, &d, sizeof(d));
+  for (i = 0 ; i < 8 ; i++, u >>= 8) bytes[i] = (unsigned char) (u & 0xff);
+  ows_wkb_bytes(b, bytes, 8);
+}
+
+
+static void ows_wkb_points(buffer * b, const ows_gml_geom * g, bool hasz, bool count)
+{
+  int i;
+
+  if (count) ows_wkb_uint(b, g->npoints);
+
+  for (i = 0 ; i < g->npoints ; i++) {
+    ows_wkb_double(b, g->coords[i * 3]);
+    ows_wkb_double(b, g->coords[i * 3 + 1]);
+    if (hasz) ows_wkb_double(b, g->coords[i * 3 + 2]);
+  }
+}
+
+
+static void ows_wkb_geom(buffer * b, const ows_gml_geom * g, bool hasz, int srid)
+{
+  const ows_gml_geom *c;
+  unsigned long type;
+  int n;
+
+  type = g->type;
+  if (hasz) type |= OWS_WKB_ZFLAG;
+  if (srid > 0) type |= OWS_WKB_SRIDFLAG;
+
+  buffer_add_str(b, "01");
+  ows_wkb_uint(b, type);
+  if (srid > 0) ows_wkb_uint(b, srid);
+
+  if (g->type == OWS_WKB_POINT) {
+    ows_wkb_points(b, g, hasz, false);
+    return;
+  }
+
+  if (g->type == OWS_WKB_LINESTRING) {
+    ows_wkb_points(b, g, hasz, true);
+    return;
+  }
+
+  for (c = g->first, n = 0 ; c ; c = c->next) n++;
+  ows_wkb_uint(b, n);
+
+  for (c = g->first ; c ; c = c->next)
+    if (g->type == OWS_WKB_POLYGON) ows_wkb_points(b, c, hasz, true);
+    else ows_wkb_geom(b, c, hasz, 0);
+}
+
+
+/*
+ * Convert a GML geometry into hexadecimal EWKB, in srid
+ * Axis are swapped when flip is set
+ * Return NULL if the geometry has to be parsed by PostGIS instead
+ */
+buffer *ows_gml_to_ewkb(xmlNodePtr n, int srid, bool flip)
+{
+  ows_gml_state st;
+  ows_gml_geom *g;
+  buffer *ewkb;
+
+  assert(n);
+
+  if (ows_gml_nested_srs(n->children)) return NULL;
+
+  st.flip = flip;
+  st.hasz = -1;
+
+  g = ows_gml_parse(n, &st);
+  if (!g) return NULL;
+
+  if (!ows_gml_rings_closed(g, st.hasz > 0)) {
+    ows_gml_geom_free(g);
+    return NULL;
+  }
+
+  ewkb = buffer_init();
+  ows_wkb_geom(ewkb, g, st.hasz > 0, srid);
+  ows_gml_geom_free(g);
+
+  return ewkb;
+}
+
+
+static int ows_hex_byte(const char *hex)
+{
+  int i, v;
+
+  for (i = v = 0 ; i < 2 ; i++) {
+    v <<= 4;
+    if (hex[i] >= '0' && hex[i] <= '9')      v |= hex[i] - '0';
+    else if (hex[i] >= 'A' && hex[i] <= 'F') v |= hex[i] - 'A' + 10;
+    else if (hex[i] >= 'a' && hex[i] <= 'f') v |= hex[i] - 'a' + 10;
+    else return -1;
+  }
+
+  return v;
+}
+
+
+/*
+ * Read an unsigned int from hexadecimal WKB, in the given byte order
+ */
+static bool ows_hex_uint(const char *hex, bool ndr, unsigned long *u)
+{
+  int i, byte;
+
+  for (*u = 0, i = 0 ; i < 4 ; i++) {
+    byte = ows_hex_byte(hex + 2 * i);
+    if (byte < 0) return false;
+    if (ndr) *u |= (unsigned long) byte << (8 * i);
+    else     *u = (*u << 8) | byte;
+  }
+
+  return true;
+}
+
+
+/*
+ * SRID of an hexadecimal EWKB geometry (0 if none), -1 if not EWKB
+ */
+int ows_ewkb_srid(const char *hex)
+{
+  unsigned long type, srid;
+  size_t len;
+  int order;
+
+  assert(hex);
+
+  len = strlen(hex);
+  if (len < 10 || len % 2) return -1;
+  if (strspn(hex, "0123456789ABCDEFabcdef") != len) return -1;
+
+  order = ows_hex_byte(hex);
+  if (order != 0 && order != 1) return -1;
+
+  if (!ows_hex_uint(hex + 2, order == 1, &type)) return -1;
+  if (!(type & OWS_WKB_SRIDFLAG)) return 0;
+
+  if (len < 18 || !ows_hex_uint(hex + 10, order == 1, &srid)) return -1;
+
+  return (int) srid;
+}
@@ -26,6 +26,7 @@
 #include <assert.h>
 #include <limits.h>
 #include <string.h>
+#include <time.h>
 
 #include "ows.h"
 
@@ -36,12 +37,18 @@
 ows_layer_list *ows_layer_list_init()
 {
   ows_layer_list *ll;
+  int k;
 
   ll = malloc(sizeof(ows_layer_list));
   assert(ll);
 
   ll->first = NULL;
   ll->last = NULL;
+  ll->size = 0;
+  ll->layers = NULL;
+  ll->max = 0;
+  for (k = 0 ; k < OWS_LAYER_KEYS ; k++) ll->index[k] = NULL;
+  ll->buckets = 0;
   return ll;
 }
 
@@ -51,30 +58,223 @@ ows_layer_list *ows_layer_list_init()
  */
 void ows_layer_list_free(ows_layer_list * ll)
 {
+  int k;
+
   assert(ll);
 
   while (ll->first) ows_layer_node_free(ll, ll->first);
   ll->last = NULL;
+  for (k = 0 ; k < OWS_LAYER_KEYS ; k++) free(ll->index[k]);
+  free(ll->layers);
   free(ll);
   ll = NULL;
 }
 
 
+/*
+ * Name of a layer used as hash key
+ */
+static const buffer *ows_layer_key(const ows_layer * l, enum ows_layer_key key)
+{
+  if (key == OWS_LAYER_KEY_PREFIX) return l->name_prefix;
+  if (key == OWS_LAYER_KEY_NO_URI) return l->name_no_uri;
+  return l->name;
+}
+
+
+/*
+ * FNV-1a hash of a layer name
+ */
+static unsigned int ows_layer_hash(const char *name)
+{
+  unsigned int hash;
+
+  for (hash = 2166136261U ; *name ; name++) {
+    hash ^= (unsigned char) *name;
+    hash *= 16777619U;
+  }
+
+  return hash;
+}
+
+
+/*
+ * Put a layer handle into an index
+ * On duplicate names, the first added layer is kept, as linear scans did
+ */
+static void ows_layer_index_add(ows_layer_list * ll, enum ows_layer_key key, int id)
+{
+  const buffer *name, *b;
+  unsigned int i;
+  int *index;
+
+  name = ows_layer_key(ll->layers[id - 1], key);
+  if (!name) return;
+
+  index = ll->index[key];
+  for (i = ows_layer_hash(name->buf) & (ll->buckets - 1) ; index[i] ; i = (i + 1) & (ll->buckets - 1)) {
+    b = ows_layer_key(ll->layers[index[i] - 1], key);
+    if (!strcmp(b->buf, name->buf)) return;
+  }
+
+  index[i] = id;
+}
+
+
+/*
+ * Build again the indexes, with enough buckets for the layers
+ */
+static void ows_layer_index_build(ows_layer_list * ll)
+{
+  unsigned int buckets;
+  int k, id;
+
+  for (buckets = 16 ; buckets < 2 * ll->size ; buckets *= 2);
+  ll->buckets = buckets;
+
+  for (k = 0 ; k < OWS_LAYER_KEYS ; k++) {
+    free(ll->index[k]);
+    ll->index[k] = calloc(buckets, sizeof(int));
+    assert(ll->index[k]);
+
+    for (id = 1 ; id <= (int) ll->size ; id++)
+      ows_layer_index_add(ll, k, id);
+  }
+}
+
+
+/*
+ * Hash lookup of a layer by one of its names, NULL if not found
+ */
+static ows_layer *ows_layer_lookup(const ows_layer_list * ll, enum ows_layer_key key, const char *name)
+{
+  const buffer *b;
+  unsigned int i;
+  int *index;
+
+  if (!ll->buckets) return (ows_layer *) NULL;
+
+  index = ll->index[key];
+  for (i = ows_layer_hash(name) & (ll->buckets - 1) ; index[i] ; i = (i + 1) & (ll->buckets - 1)) {
+    b = ows_layer_key(ll->layers[index[i] - 1], key);
+    if (!strcmp(b->buf, name)) return ll->layers[index[i] - 1];
+  }
+
+  return (ows_layer *) NULL;
+}
+
+
 /*
  * Retrieve a Layer from a layer list or NULL if not found
  */
 ows_layer * ows_layer_get(const ows_layer_list * ll, const buffer * name)
 {
-  ows_layer_node *ln;
-
   assert(ll);
   assert(name);
 
-  for (ln = ll->first; ln ; ln = ln->next)
-    if (ln->layer->name && !strcmp(ln->layer->name->buf, name->buf))
-      return ln->layer;
+  return ows_layer_lookup(ll, OWS_LAYER_KEY_NAME, name->buf);
+}
 
-  return (ows_layer *) NULL;
+
+/*
+ * Retrieve a Layer from its prefixed name (e.g "tows:world") or NULL if not found
+ */
+ows_layer * ows_layer_get_by_prefix(const ows_layer_list * ll, const buffer * name_prefix)
+{
+  assert(ll);
+  assert(name_prefix);
+
+  return ows_layer_lookup(ll, OWS_LAYER_KEY_PREFIX, name_prefix->buf);
+}
+
+
+/*
+ * Retrieve a Layer from its name without uri (e.g "world") or NULL if not found
+ */
+ows_layer * ows_layer_get_by_no_uri(const ows_layer_list * ll, const buffer * name_no_uri)
+{
+  assert(ll);
+  assert(name_no_uri);
+
+  return ows_layer_lookup(ll, OWS_LAYER_KEY_NO_URI, name_no_uri->buf);
+}
+
+
+/*
+ * Retrieve a Layer from its handle or NULL if not found
+ */
+ows_layer * ows_layer_get_by_id(const ows_layer_list * ll, int id)
+{
+  assert(ll);
+
+  if (id < 1 || id > (int) ll->size) return (ows_layer *) NULL;
+
+  return ll->layers[id - 1];
+}
+
+
+/*
+ * Return layer's extent, computed on first use and then kept in cache
+ * for extent_ttl seconds (computed each time if extent_ttl is not set)
+ * Returned geobbox belongs to the layer, and is NULL for geometry-less layer
+ */
+ows_geobbox * ows_layer_extent(ows * o, ows_layer * l)
+{
+  time_t now;
+
+  assert(o);
+  assert(l);
+
+  now = time(NULL);
+
+  if (o->extent_ttl > 0 && l->extent_time && now - l->extent_time < o->extent_ttl)
+    return l->extent;
+
+  if (l->extent) ows_geobbox_free(l->extent);
+  l->extent = ows_geobbox_compute(o, l->name);
+  l->extent_time = now;
+
+  return l->extent;
+}
+
+
+/*
+ * Widen layer's cached extent with inserted or updated geometries
+ */
+void ows_layer_extent_widen(ows * o, buffer * layer_name, const list * geoms)
+{
+  ows_layer *l;
+
+  assert(o);
+  assert(layer_name);
+  assert(geoms);
+
+  l = ows_layer_get(o->layers, layer_name);
+
+  /* Nothing in cache, extent will be computed on next use */
+  if (!l || !l->extent || !l->extent_time) return;
+
+  if (!ows_geobbox_widen(o, l->extent, layer_name, geoms))
+    ows_layer_extent_reset(o, layer_name);
+}
+
+
+/*
+ * Drop layer's cached extent, so it will be computed again on next use
+ */
+void ows_layer_extent_reset(ows * o, buffer * layer_name)
+{
+  ows_layer *l;
+
+  assert(o);
+  assert(layer_name);
+
+  l = ows_layer_get(o->layers, layer_name);
+  if (!l) return;
+
+  if (l->extent) ows_geobbox_free(l->extent);
+  l->extent = NULL;
+  l->extent_time = 0;
 }
 
 
@@ -83,18 +283,14 @@ ows_layer * ows_layer_get(const ows_layer_list * ll, const buffer * name)
  */
 bool ows_layer_match_table(const ows * o, const buffer * name)
 {
-  ows_layer_node *ln;
+  ows_layer *l;
 
   assert(o);
   assert(name);
 
-  for (ln = o->layers->first; ln ; ln = ln->next)
-    if (ln->layer->name && !strcmp(ln->layer->name->buf, name->buf)) {
-      if (ln->layer->storage) return true;
-      else return false;
-    }
+  l = ows_layer_get(o->layers, name);
 
-  return false;
+  return l && l->storage;
 }
 
 
@@ -140,16 +336,14 @@ bool ows_layer_list_retrievable(const ows_layer_list * ll)
  */
 bool ows_layer_retrievable(const ows_layer_list * ll, const buffer * name)
 {
-  ows_layer_node *ln;
+  ows_layer *l;
 
   assert(ll);
   assert(name);
 
-  for (ln = ll->first; ln ; ln = ln->next)
-    if (ln->layer->name && !strcmp(ln->layer->name->buf, name->buf))
-      return ln->layer->retrievable;
+  l = ows_layer_get(ll, name);
 
-  return false;
+  return l ? l->retrievable : false;
 }
 
 
@@ -174,16 +368,14 @@ bool ows_layer_list_writable(const ows_layer_list * ll)
  */
 bool ows_layer_writable(const ows_layer_list * ll, const buffer * name)
 {
-  ows_layer_node *ln;
+  ows_layer *l;
 
   assert(ll);
   assert(name);
 
-  for (ln = ll->first; ln ; ln = ln->next)
-    if (ln->layer->name && !strcmp(ln->layer->name->buf, name->buf))
-      return ln->layer->writable;
+  l = ows_layer_get(ll, name);
 
-  return false;
+  return l ? l->writable : false;
 }
 
 
@@ -192,16 +384,10 @@ bool ows_layer_writable(const ows_layer_list * ll, const buffer * name)
  */
 bool ows_layer_in_list(const ows_layer_list * ll, buffer * name)
 {
-  ows_layer_node *ln;
-
   assert(ll);
   assert(name);
 
-  for (ln = ll->first; ln ; ln = ln->next)
-    if (ln->layer->name && !strcmp(ln->layer->name->buf, name->buf))
-      return true;
-
-  return false;
+  return ows_layer_get(ll, name) != NULL;
 }
 
 
@@ -326,14 +512,12 @@ list *ows_layer_list_prefix_to_uri(ows_layer_list * ll, list * layer_name_prefix
  */
 buffer *ows_layer_uri_to_prefix(ows_layer_list * ll, buffer * layer_name)
 {
-  ows_layer_node *ln;
+  ows_layer *l;
   assert(ll && layer_name);
 
-  for (ln = ll->first; ln ; ln = ln->next)
-    if (buffer_cmp(ln->layer->name, layer_name->buf))
-      return ln->layer->name_prefix;
-  
-  return (buffer *) NULL;
+  l = ows_layer_lookup(ll, OWS_LAYER_KEY_NAME, layer_name->buf);
+
+  return l ? l->name_prefix : (buffer *) NULL;
 }
 
 
@@ -342,14 +526,12 @@ buffer *ows_layer_uri_to_prefix(ows_layer_list * ll, buffer * layer_name)
  */
 buffer *ows_layer_prefix_to_uri(ows_layer_list * ll, buffer * layer_name_prefix)
 {
-  ows_layer_node *ln;
+  ows_layer *l;
   assert(ll && layer_name_prefix);
 
-  for (ln = ll->first; ln ; ln = ln->next)
-    if (buffer_cmp(ln->layer->name_prefix, layer_name_prefix->buf))
-      return ln->layer->name;
-  
-  return (buffer *) NULL;
+  l = ows_layer_lookup(ll, OWS_LAYER_KEY_PREFIX, layer_name_prefix->buf);
+
+  return l ? l->name : (buffer *) NULL;
 }
   
 
@@ -375,14 +557,12 @@ buffer *ows_layer_ns_prefix_to_ns_uri(ows_layer_list * ll, buffer * ns_prefix)
  */
 buffer *ows_layer_no_uri(ows_layer_list * ll, buffer * layer_name)
 {
-  ows_layer_node *ln;
+  ows_layer *l;
   assert(ll && layer_name);
 
-  for (ln = ll->first; ln ; ln = ln->next)
-    if (buffer_cmp(ln->layer->name, layer_name->buf))
-      return ln->layer->name_no_uri;
+  l = ows_layer_lookup(ll, OWS_LAYER_KEY_NAME, layer_name->buf);
 
-  return (buffer *) NULL;
+  return l ? l->name_no_uri : (buffer *) NULL;
 }
 
 
@@ -391,14 +571,12 @@ buffer *ows_layer_no_uri(ows_layer_list * ll, buffer * layer_name)
  */
 buffer *ows_layer_no_uri_to_uri(const ows_layer_list * ll, buffer * layer_name_no_uri)
 {
-  ows_layer_node *ln;
+  ows_layer *l;
   assert(ll && layer_name_no_uri);
 
-  for (ln = ll->first; ln ; ln = ln->next)
-    if (buffer_cmp(ln->layer->name_no_uri, layer_name_no_uri->buf))
-      return ln->layer->name;
+  l = ows_layer_lookup(ll, OWS_LAYER_KEY_NO_URI, layer_name_no_uri->buf);
 
-  return (buffer *) NULL;
+  return l ? l->name : (buffer *) NULL;
 }
 
 
@@ -407,14 +585,12 @@ buffer *ows_layer_no_uri_to_uri(const ows_layer_list * ll, buffer * layer_name_n
  */
 buffer *ows_layer_ns_prefix(ows_layer_list * ll, buffer * layer_name_prefix)
 {
-  ows_layer_node *ln;
+  ows_layer *l;
   assert(ll && layer_name_prefix);
 
-  for (ln = ll->first; ln ; ln = ln->next)
-    if (buffer_cmp(ln->layer->name_prefix, layer_name_prefix->buf))
-      return ln->layer->ns_prefix;
+  l = ows_layer_lookup(ll, OWS_LAYER_KEY_PREFIX, layer_name_prefix->buf);
 
-  return (buffer *) NULL;
+  return l ? l->ns_prefix : (buffer *) NULL;
 }
 
 
@@ -423,14 +599,12 @@ buffer *ows_layer_ns_prefix(ows_layer_list * ll, buffer * layer_name_prefix)
  */
 buffer *ows_layer_ns_uri(ows_layer_list * ll, buffer * layer_name_uri)
 {
-  ows_layer_node *ln;
+  ows_layer *l;
   assert(ll && layer_name_uri);
 
-  for (ln = ll->first; ln ; ln = ln->next)
-    if (buffer_cmp(ln->layer->name, layer_name_uri->buf))
-      return ln->layer->ns_uri;
+  l = ows_layer_lookup(ll, OWS_LAYER_KEY_NAME, layer_name_uri->buf);
 
-  return (buffer *) NULL;
+  return l ? l->ns_uri : (buffer *) NULL;
 }
 
 
@@ -440,6 +614,7 @@ buffer *ows_layer_ns_uri(ows_layer_list * ll, buffer * layer_name_uri)
 void ows_layer_list_add(ows_layer_list * ll, ows_layer * l)
 {
   ows_layer_node *ln = ows_layer_node_init();
+  int k;
   assert(ll && l);
 
   ln->layer = l;
@@ -452,6 +627,18 @@ void ows_layer_list_add(ows_layer_list * ll, ows_layer * l)
   }
   ll->last = ln;
   ll->last->next = NULL;
+
+  /* Register the layer, under a new handle */
+  if (ll->size == ll->max) {
+    ll->max = ll->max ? ll->max * 2 : 16;
+    ll->layers = realloc(ll->layers, ll->max * sizeof(ows_layer *));
+    assert(ll->layers);
+  }
+  ll->layers[ll->size++] = l;
+  l->id = ll->size;
+
+  if (2 * ll->size > ll->buckets) ows_layer_index_build(ll);
+  else for (k = 0 ; k < OWS_LAYER_KEYS ; k++) ows_layer_index_add(ll, k, l->id);
 }
 
 
@@ -531,6 +718,8 @@ ows_layer *ows_layer_init()
   l->writable = false;
   l->srid = NULL;
   l->geobbox = NULL;
+  l->extent = NULL;
+  l->extent_time = 0;
   l->exclude_items = NULL;
   l->include_items = NULL;
   l->pkey = NULL;
@@ -538,6 +727,7 @@ ows_layer *ows_layer_init()
   l->ns_prefix = buffer_init();
   l->ns_uri = buffer_init();
   l->storage = ows_layer_storage_init();
+  l->id = 0;
 
   return l;
 }
@@ -559,6 +749,7 @@ void ows_layer_free(ows_layer * l)
   if (l->gml_ns)        list_free(l->gml_ns);
   if (l->srid)          list_free(l->srid);
   if (l->geobbox)       ows_geobbox_free(l->geobbox);
+  if (l->extent)        ows_geobbox_free(l->extent);
   if (l->ns_uri)        buffer_free(l->ns_uri);
   if (l->ns_prefix)     buffer_free(l->ns_prefix);
   if (l->storage)       ows_layer_storage_free(l->storage);
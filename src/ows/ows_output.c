@@ -0,0 +1,230 @@
+/*
+  Copyright (c) <2007-2012> <Barbara Philippot - Olivier Courtin>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <assert.h>
+#include <string.h>
+
+#include "ows.h"
+
+
+/*
+ * Response writer: encoders append to a contiguous buffer, handed
+ * to o->output in large chunks when full and at explicit flush points
+ * (end of request, errors, before the stream is closed)
+ */
+ows_output *ows_output_init()
+{
+  ows_output *out;
+
+  out = malloc(sizeof(ows_output));
+  assert(out);
+
+  out->size = OWS_OUTPUT_SIZE;
+  out->use = 0;
+  out->capture = NULL;
+  out->buf = malloc(out->size);
+  assert(out->buf);
+
+  return out;
+}
+
+
+void ows_output_free(ows_output * out)
+{
+  assert(out);
+
+  free(out->buf);
+  free(out);
+}
+
+
+/*
+ * Write to the output stream, or to the capture buffer if any
+ */
+static void ows_output_write(const ows * o, const char *str, size_t n)
+{
+  if (o->out->capture) buffer_add_nstr(o->out->capture, str, n);
+  else                 fwrite(str, 1, n, o->output);
+}
+
+
+/*
+ * Hand the buffered response to the output stream
+ */
+void ows_output_flush(const ows * o)
+{
+  assert(o);
+  assert(o->out);
+
+  if (!o->out->use) return;
+
+  ows_output_write(o, o->out->buf, o->out->use);
+  o->out->use = 0;
+}
+
+
+/*
+ * Divert the response into a buffer rather than the output stream
+ * (i.e to keep a rendered document), NULL resumes writing to the stream
+ * Pending bytes go to the former target first
+ * Return the former capture buffer, if any
+ */
+buffer *ows_output_capture(const ows * o, buffer * b)
+{
+  buffer *previous;
+
+  assert(o);
+  assert(o->out);
+
+  ows_output_flush(o);
+  previous = o->out->capture;
+  o->out->capture = b;
+
+  return previous;
+}
+
+
+void ows_output_nstr(const ows * o, const char *str, size_t n)
+{
+  assert(o);
+  assert(str);
+
+  if (o->out->use + n > o->out->size) ows_output_flush(o);
+
+  /* Bigger than the whole buffer, written as is */
+  if (n > o->out->size) {
+    ows_output_write(o, str, n);
+    return;
+  }
+
+  memcpy(o->out->buf + o->out->use, str, n);
+  o->out->use += n;
+}
+
+
+void ows_output_str(const ows * o, const char *str)
+{
+  assert(str);
+
+  ows_output_nstr(o, str, strlen(str));
+}
+
+
+void ows_output_buffer(const ows * o, const buffer * b)
+{
+  assert(b);
+
+  ows_output_nstr(o, b->buf, b->use);
+}
+
+
+/*
+ * Append a string, encoding XML entities
+ */
+void ows_output_xml(const ows * o, const char *str)
+{
+  const char *s;
+
+  assert(o);
+  assert(str);
+
+  for (s = str ; *str ; str++) {
+    switch (*str) {
+      case '&':  ows_output_nstr(o, s, str - s); ows_output_nstr(o, "&amp;", 5);  break;
+      case '<':  ows_output_nstr(o, s, str - s); ows_output_nstr(o, "&lt;", 4);   break;
+      case '>':  ows_output_nstr(o, s, str - s); ows_output_nstr(o, "&gt;", 4);   break;
+      case '"':  ows_output_nstr(o, s, str - s); ows_output_nstr(o, "&quot;", 6); break;
+      case '\'': ows_output_nstr(o, s, str - s); ows_output_nstr(o, "&#39;", 5);  break;
+      default: continue;
+    }
+    s = str + 1;
+  }
+
+  ows_output_nstr(o, s, str - s);
+}
+
+
+void ows_output_int(const ows * o, int i)
+{
+  char digits[16];
+  unsigned int u;
+  int n = sizeof(digits);
+
+  assert(o);
+
+  u = (i < 0) ? 0U - (unsigned int) i : (unsigned int) i;
+  do {
+    digits[--n] = '0' + u % 10;
+    u /= 10;
+  } while (u);
+  if (i < 0) digits[--n] = '-';
+
+  ows_output_nstr(o, digits + n, sizeof(digits) - n);
+}
+
+
+/*
+ * Append a double with a given number of decimals (as "%.*f" does)
+ */
+void ows_output_double(const ows * o, int precision, double d)
+{
+  ows_output_printf(o, "%.*f", precision, d);
+}
+
+
+/*
+ * Formatted append, for the less common fragments
+ * Formatting is done straight into the buffer when there's room enough
+ */
+void ows_output_printf(const ows * o, const char *format, ...)
+{
+  va_list ap;
+  char *tmp;
+  int n;
+
+  assert(o);
+  assert(format);
+
+  va_start(ap, format);
+  n = vsnprintf(o->out->buf + o->out->use, o->out->size - o->out->use, format, ap);
+  va_end(ap);
+
+  if (n < 0) return;
+  if ((size_t) n < o->out->size - o->out->use) {
+    o->out->use += n;
+    return;
+  }
+
+  ows_output_flush(o);
+
+  tmp = malloc(n + 1);
+  assert(tmp);
+  va_start(ap, format);
+  vsnprintf(tmp, n + 1, format, ap);
+  va_end(ap);
+
+  ows_output_nstr(o, tmp, n);
+  free(tmp);
+}
@@ -0,0 +1,148 @@
+/*
+  Copyright (c) <2007-2012> <Barbara Philippot - Olivier Courtin>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "ows.h"
+
+#if TINYOWS_PROJ
+#include <proj.h>
+#endif
+
+
+/*
+ * Points added on each edge of bounds before reprojection
+ * (so curved edges are covered, as ST_Segmentize does on the SQL side)
+ */
+#define OWS_PROJ_DENSIFY 63
+
+
+/*
+ * Release cached coordinate operations
+ */
+void ows_proj_free(ows_proj * p)
+{
+  ows_proj *next;
+
+  for ( ; p ; p = next) {
+    next = p->next;
+#if TINYOWS_PROJ
+    if (p->pj) proj_destroy((PJ *) p->pj);
+#endif
+    free(p);
+  }
+}
+
+
+#if TINYOWS_PROJ
+/*
+ * Coordinate operation from a srid to another, created on first use then kept
+ * (a pair PROJ can't handle is kept too, with a NULL operation)
+ * Axis order is the PostGIS one: easting, northing
+ */
+static PJ *ows_proj_get(ows * o, int from, int to)
+{
+  ows_proj *p;
+  buffer *crs_from, *crs_to;
+  PJ *pj = NULL, *norm;
+
+  for (p = o->proj ; p ; p = p->next)
+    if (p->from == from && p->to == to) return (PJ *) p->pj;
+
+  crs_from = ows_srs_get_from_a_srid(o, from);
+  crs_to = ows_srs_get_from_a_srid(o, to);
+
+  if (crs_from->use && crs_to->use)
+    pj = proj_create_crs_to_crs(PJ_DEFAULT_CTX, crs_from->buf, crs_to->buf, NULL);
+
+  if (pj) {
+    norm = proj_normalize_for_visualization(PJ_DEFAULT_CTX, pj);
+    proj_destroy(pj);
+    pj = norm;
+  }
+
+  if (!pj) ows_log(o, 2, "PROJ can't transform this srid pair, PostGIS will");
+
+  buffer_free(crs_from);
+  buffer_free(crs_to);
+
+  p = malloc(sizeof(ows_proj));
+  assert(p);
+  p->from = from;
+  p->to = to;
+  p->pj = pj;
+  p->next = o->proj;
+  o->proj = p;
+
+  return pj;
+}
+#endif
+
+
+/*
+ * Reproject bounds (easting, northing order) from a srid to another,
+ * edges being densified, in process
+ * Return false if it can't be done without PostGIS
+ */
+bool ows_proj_transform_bounds(ows * o, int from, int to, double *xmin, double *ymin, double *xmax, double *ymax)
+{
+#if TINYOWS_PROJ
+  PJ *pj;
+  double b[4];
+
+  assert(o);
+  assert(xmin && ymin && xmax && ymax);
+
+  if (from <= 0 || to <= 0) return false;
+  if (from == to) return true;
+
+  pj = ows_proj_get(o, from, to);
+  if (!pj) return false;
+
+  if (!proj_trans_bounds(PJ_DEFAULT_CTX, pj, PJ_FWD, *xmin, *ymin, *xmax, *ymax,
+                         &b[0], &b[1], &b[2], &b[3], OWS_PROJ_DENSIFY)) return false;
+
+  *xmin = b[0];
+  *ymin = b[1];
+  *xmax = b[2];
+  *ymax = b[3];
+
+  return true;
+#else
+  (void) o;
+  (void) from;
+  (void) to;
+  (void) xmin;
+  (void) ymin;
+  (void) xmax;
+  (void) ymax;
+
+  return false;
+#endif
+}
+
+
+/*
+ * vim: expandtab sw=4 ts=4
+ */
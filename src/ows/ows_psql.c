@@ -35,16 +35,14 @@
  */
 buffer *ows_psql_id_column(ows * o, buffer * layer_name)
 {
-  ows_layer_node *ln = NULL;
+  ows_layer *l;
 
   assert(o);
   assert(o->layers);
   assert(layer_name);
 
-  for (ln = o->layers->first ; ln ; ln = ln->next)
-    if (ln->layer->name && ln->layer->storage
-        && !strcmp(ln->layer->name->buf, layer_name->buf))
-      return ln->layer->storage->pkey;
+  l = ows_layer_get(o->layers, layer_name);
+  if (l && l->storage) return l->storage->pkey;
 
   return NULL;
 }
@@ -52,8 +50,34 @@ buffer *ows_psql_id_column(ows * o, buffer * layer_name)
 
 /*
  * Execute an SQL request
+ * Placeholders written by ows_psql_param_* are bound to their values
  */
 PGresult * ows_psql_exec(ows *o, const char *sql)
+{
+  PGresult* res;
+  ows_psql_params *p;
+  buffer *bound;
+
+  assert(o);
+  assert(sql);
+  assert(o->pg);
+
+  if (!o->params) return ows_psql_exec_params(o, sql, NULL);
+
+  bound = buffer_init();
+  p = ows_psql_params_bind(o, sql, bound);
+  res = ows_psql_exec_params(o, bound->buf, p);
+  ows_psql_params_free(p);
+  buffer_free(bound);
+
+  return res;
+}
+
+
+/*
+ * Execute an SQL request with $n parameters (p could be NULL)
+ */
+PGresult * ows_psql_exec_params(ows *o, const char *sql, const ows_psql_params *p)
 {
   PGresult* res;
 
@@ -62,7 +86,10 @@ PGresult * ows_psql_exec(ows *o, const char *sql)
   assert(o->pg);
 
   ows_log(o, 8, sql);
-  res = PQexecParams(o->pg, sql, 0, NULL, NULL, NULL, NULL, 0);
+  if (p) res = PQexecParams(o->pg, sql, p->size, p->types, (const char * const *) p->values,
+                              p->lengths, p->formats, 0);
+  else   res = PQexecParams(o->pg, sql, 0, NULL, NULL, NULL, NULL, 0);
+
   if (strlen(PQresultErrorMessage(res)))
     ows_log(o, 1, PQresultErrorMessage(res));
 
@@ -70,21 +97,270 @@ PGresult * ows_psql_exec(ows *o, const char *sql)
 }
 
 
+/*
+ * Queue a statement in the pipeline: it's sent right away and its
+ * result is read back later, in order, with ows_psql_pipeline_result
+ * So several independent statements cost a single network round trip
+ * (statements are just executed in order if libpq can't pipeline)
+ */
+void ows_psql_pipeline_send(ows *o, const char *sql)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+  ows_psql_params *p;
+  buffer *bound;
+#endif
+
+  assert(o);
+  assert(sql);
+  assert(o->pg);
+
+#ifdef LIBPQ_HAS_PIPELINING
+  if (!o->pipeline->first && PQenterPipelineMode(o->pg) != 1)
+    ows_log(o, 1, "Unable to enter libpq pipeline mode");
+
+  if (PQpipelineStatus(o->pg) != PQ_PIPELINE_OFF) {
+    ows_log(o, 8, sql);
+
+    /* One sync per statement, so each one keeps its own implicit transaction */
+    if (!ows_psql_statement_send(o, sql)) {
+      bound = buffer_init();
+      p = ows_psql_params_bind(o, sql, bound);
+      if (PQsendQueryParams(o->pg, bound->buf, p->size, p->types, (const char * const *) p->values,
+                            p->lengths, p->formats, 0) != 1)
+        ows_log(o, 1, PQerrorMessage(o->pg));
+      ows_psql_params_free(p);
+      buffer_free(bound);
+    }
+
+    if (PQpipelineSync(o->pg) != 1)
+      ows_log(o, 1, PQerrorMessage(o->pg));
+  }
+#endif
+
+  list_add(o->pipeline, buffer_from_str(sql));
+}
+
+
+/*
+ * Return the result of the oldest statement queued in the pipeline
+ */
+PGresult * ows_psql_pipeline_result(ows *o)
+{
+  PGresult *res, *r;
+  list_node *ln;
+  int nulls;
+
+  assert(o);
+  assert(o->pipeline->first);
+
+  ln = o->pipeline->first;
+  o->pipeline->first = ln->next;
+  if (ln->next) ln->next->prev = NULL;
+  else o->pipeline->last = NULL;
+  o->pipeline->size--;
+
+#ifdef LIBPQ_HAS_PIPELINING
+  if (PQpipelineStatus(o->pg) != PQ_PIPELINE_OFF) {
+    /*
+     * Statement result, then NULL, then the sync point
+     * (if there's more than one result: first error, or last result, is kept)
+     */
+    for (res = NULL, nulls = 0 ; nulls < 2 ; ) {
+      r = PQgetResult(o->pg);
+      if (!r) {
+        nulls++;
+        continue;
+      }
+      nulls = 0;
+      if (PQresultStatus(r) == PGRES_PIPELINE_SYNC) {
+        PQclear(r);
+        break;
+      }
+      if (res && strlen(PQresultErrorMessage(res))) PQclear(r);
+      else {
+        if (res) PQclear(res);
+        res = r;
+      }
+    }
+
+    if (!res) res = PQmakeEmptyPGresult(o->pg, PGRES_FATAL_ERROR);
+    if (strlen(PQresultErrorMessage(res))) {
+      ows_log(o, 1, PQresultErrorMessage(res));
+      ows_psql_statement_failed(o, ln->value->buf, res);
+    }
+
+    if (!o->pipeline->first) PQexitPipelineMode(o->pg);
+    list_node_free(NULL, ln);
+
+    return res;
+  }
+#endif
+
+  res = ows_psql_statement_exec(o, ln->value->buf);
+  list_node_free(NULL, ln);
+
+  return res;
+}
+
+
+/*
+ * Fetch the next batch of rows from the server side cursor
+ */
+static PGresult * ows_psql_cursor_fetch(ows *o)
+{
+  PGresult *res;
+  buffer *fetch;
+
+  assert(o);
+
+  fetch = buffer_init();
+  buffer_add_str(fetch, "FETCH FORWARD ");
+  buffer_add_int(fetch, o->fetch_size);
+  buffer_add_str(fetch, " FROM tinyows_cursor");
+  res = ows_psql_exec(o, fetch->buf);
+  buffer_free(fetch);
+
+  return res;
+}
+
+
+/*
+ * Queue in the pipeline the statements opening a server side cursor
+ * on a SELECT request (or the request itself if fetch_size is not set)
+ * Its first result is then read with ows_psql_cursor_result
+ */
+void ows_psql_cursor_send(ows *o, const char *sql)
+{
+  buffer *declare;
+
+  assert(o);
+  assert(sql);
+
+  if (o->fetch_size <= 0) {
+    ows_psql_pipeline_send(o, sql);
+    return;
+  }
+
+  ows_psql_pipeline_send(o, "BEGIN");
+
+  declare = buffer_init();
+  buffer_add_str(declare, "DECLARE tinyows_cursor NO SCROLL CURSOR FOR ");
+  buffer_add_str(declare, sql);
+  ows_psql_pipeline_send(o, declare->buf);
+  buffer_empty(declare);
+
+  buffer_add_str(declare, "FETCH FORWARD ");
+  buffer_add_int(declare, o->fetch_size);
+  buffer_add_str(declare, " FROM tinyows_cursor");
+  ows_psql_pipeline_send(o, declare->buf);
+  buffer_free(declare);
+}
+
+
+/*
+ * Return the first batch of rows of a cursor queued by ows_psql_cursor_send
+ */
+PGresult * ows_psql_cursor_result(ows *o)
+{
+  PGresult *res, *fetch;
+
+  assert(o);
+
+  if (o->fetch_size <= 0) return ows_psql_pipeline_result(o);
+
+  PQclear(ows_psql_pipeline_result(o));
+  res = ows_psql_pipeline_result(o);
+  fetch = ows_psql_pipeline_result(o);
+
+  if (PQresultStatus(res) == PGRES_COMMAND_OK) {
+    PQclear(res);
+    res = fetch;
+  } else PQclear(fetch);
+
+  /* Caller handles the error status as for a plain execution */
+  if (PQresultStatus(res) != PGRES_TUPLES_OK) ows_psql_cursor_close(o);
+
+  return res;
+}
+
+
+/*
+ * Execute a SELECT request through a server side cursor
+ * Return the first batch of rows (fetch_size rows at most),
+ * next ones are retrieved with ows_psql_cursor_next
+ * If fetch_size is not set, the whole result is retrieved at once
+ */
+PGresult * ows_psql_cursor_open(ows *o, const char *sql)
+{
+  assert(o);
+  assert(sql);
+
+  ows_psql_cursor_send(o, sql);
+
+  return ows_psql_cursor_result(o);
+}
+
+
+/*
+ * Release the current batch of rows and fetch the next one
+ * Return NULL when the cursor is exhausted (and then closed)
+ */
+PGresult * ows_psql_cursor_next(ows *o, PGresult *res)
+{
+  assert(o);
+  assert(res);
+
+  if (o->fetch_size <= 0) {
+    PQclear(res);
+    return NULL;
+  }
+
+  /* A partial batch means there's nothing more to fetch */
+  if (PQntuples(res) < o->fetch_size) {
+    PQclear(res);
+    ows_psql_cursor_close(o);
+    return NULL;
+  }
+  PQclear(res);
+
+  res = ows_psql_cursor_fetch(o);
+  if (PQresultStatus(res) != PGRES_TUPLES_OK || !PQntuples(res)) {
+    PQclear(res);
+    ows_psql_cursor_close(o);
+    return NULL;
+  }
+
+  return res;
+}
+
+
+/*
+ * Close the server side cursor and end the related transaction
+ */
+void ows_psql_cursor_close(ows *o)
+{
+  assert(o);
+
+  if (o->fetch_size <= 0) return;
+
+  /* Transaction could have been aborted, COMMIT then acts as ROLLBACK */
+  PQclear(ows_psql_exec(o, "COMMIT"));
+}
+
+
 /*
  * Return geometry columns from the table matching layer name
  */
 list *ows_psql_geometry_column(ows * o, buffer * layer_name)
 {
-  ows_layer_node *ln = NULL;
+  ows_layer *l;
 
   assert(o);
   assert(o->layers);
   assert(layer_name);
 
-  for (ln = o->layers->first ; ln ; ln = ln->next)
-    if (ln->layer->name && ln->layer->storage
-        && !strcmp(ln->layer->name->buf, layer_name->buf))
-      return ln->layer->storage->geom_columns;
+  l = ows_layer_get(o->layers, layer_name);
+  if (l && l->storage) return l->storage->geom_columns;
 
   return NULL;
 }
@@ -95,16 +371,14 @@ list *ows_psql_geometry_column(ows * o, buffer * layer_name)
  */
 buffer *ows_psql_schema_name(ows * o, buffer * layer_name)
 {
-  ows_layer_node *ln = NULL;
+  ows_layer *l;
 
   assert(o);
   assert(o->layers);
   assert(layer_name);
 
-  for (ln = o->layers->first ; ln ; ln = ln->next)
-    if (ln->layer->name && ln->layer->storage
-        && !strcmp(ln->layer->name->buf, layer_name->buf))
-      return ln->layer->storage->schema;
+  l = ows_layer_get(o->layers, layer_name);
+  if (l && l->storage) return l->storage->schema;
 
   return NULL;
 }
@@ -115,45 +389,84 @@ buffer *ows_psql_schema_name(ows * o, buffer * layer_name)
  */
 buffer *ows_psql_table_name(ows * o, buffer * layer_name)
 {
-  ows_layer_node *ln = NULL;
+  ows_layer *l;
 
   assert(o);
   assert(o->layers);
   assert(layer_name);
 
-  for (ln = o->layers->first ; ln ; ln = ln->next)
-    if (ln->layer->name && ln->layer->storage
-        && !strcmp(ln->layer->name->buf, layer_name->buf))
-      return ln->layer->storage->table;
+  l = ows_layer_get(o->layers, layer_name);
+  if (l && l->storage) return l->storage->table;
 
   return NULL;
 }
 
 
 /*
- * Check if a given WKT geometry is or not valid
+ * Check at once the validity of geometries (WKT or hexadecimal EWKB)
+ * Return the position of the first invalid one (from 1), 0 if all valid
+ * A failed request makes the first one invalid
  */
-bool ows_psql_is_geometry_valid(ows * o, buffer * geom)
+int ows_psql_geometries_invalid(ows * o, list * geoms)
 {
-  buffer *sql;
+  buffer *sql, *array;
+  list_node *ln;
   PGresult *res;
-  bool ret = false;
+  char *c;
+  int invalid;
 
   assert(o);
-  assert(geom);
+  assert(geoms);
+
+  if (!geoms->first) return 0;
+
+  array = buffer_init();
+  buffer_add(array, '{');
+  for (ln = geoms->first ; ln ; ln = ln->next) {
+    if (ln != geoms->first) buffer_add(array, ',');
+    buffer_add(array, '"');
+    for (c = ln->value->buf ; *c ; c++) {
+      if (*c == '"' || *c == '\\') buffer_add(array, '\\');
+      buffer_add(array, *c);
+    }
+    buffer_add(array, '"');
+  }
+  buffer_add(array, '}');
 
-  sql = buffer_init();
-  buffer_add_str(sql, "SELECT ST_isvalid(ST_geometryfromtext('");
-  buffer_copy(sql, geom);
-  buffer_add_str(sql, "', -1));");
+  sql = buffer_from_str("SELECT u.i FROM unnest(CAST(");
+  ows_psql_param_str(o, sql, array->buf);
+  buffer_add_str(sql, " AS geometry[])) WITH ORDINALITY AS u(g, i)");
+  buffer_add_str(sql, " WHERE ST_IsValid(u.g) IS NOT TRUE ORDER BY u.i LIMIT 1");
 
   res = ows_psql_exec(o, sql->buf);
+  buffer_free(array);
   buffer_free(sql);
 
-  if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1
-      && (char) PQgetvalue(res, 0, 0)[0] ==  't') ret = true;
+  if (PQresultStatus(res) != PGRES_TUPLES_OK) invalid = 1;
+  else if (PQntuples(res) == 1) invalid = atoi(PQgetvalue(res, 0, 0));
+  else invalid = 0;
 
   PQclear(res);
+  return invalid;
+}
+
+
+/*
+ * Check if a given WKT geometry is or not valid
+ */
+bool ows_psql_is_geometry_valid(ows * o, buffer * geom)
+{
+  list *geoms;
+  bool ret;
+
+  assert(o);
+  assert(geom);
+
+  geoms = list_init();
+  list_add_by_copy(geoms, geom);
+  ret = !ows_psql_geometries_invalid(o, geoms);
+  list_free(geoms);
+
   return ret;
 }
 
@@ -163,17 +476,15 @@ bool ows_psql_is_geometry_valid(ows * o, buffer * geom)
  */
 bool ows_psql_is_geometry_column(ows * o, buffer * layer_name, buffer * column)
 {
-  ows_layer_node *ln;
+  ows_layer *l;
 
   assert(o);
   assert(o->layers);
   assert(layer_name);
   assert(column);
 
-  for (ln = o->layers->first ; ln ; ln = ln->next)
-    if (ln->layer->name && ln->layer->storage
-        && !strcmp(ln->layer->name->buf, layer_name->buf))
-      return in_list(ln->layer->storage->geom_columns, column);
+  l = ows_layer_get(o->layers, layer_name);
+  if (l && l->storage) return in_list(l->storage->geom_columns, column);
 
   return false;
 }
@@ -184,16 +495,14 @@ bool ows_psql_is_geometry_column(ows * o, buffer * layer_name, buffer * column)
  */
 list *ows_psql_not_null_properties(ows * o, buffer * layer_name)
 {
-  ows_layer_node *ln;
+  ows_layer *l;
 
   assert(o);
   assert(o->layers);
   assert(layer_name);
 
-  for (ln = o->layers->first ; ln ; ln = ln->next)
-    if (ln->layer->name && ln->layer->storage
-        && !strcmp(ln->layer->name->buf, layer_name->buf))
-      return ln->layer->storage->not_null_columns;
+  l = ows_layer_get(o->layers, layer_name);
+  if (l && l->storage) return l->storage->not_null_columns;
 
   return NULL;
 }
@@ -372,16 +681,14 @@ buffer *ows_psql_column_character_maximum_length(ows * o, buffer * column_name,
  */
 array *ows_psql_describe_table(ows * o, buffer * layer_name)
 {
-  ows_layer_node *ln = NULL;
+  ows_layer *l;
 
   assert(o);
   assert(o->layers);
   assert(layer_name);
 
-  for (ln = o->layers->first ; ln ; ln = ln->next)
-    if (ln->layer->name && ln->layer->storage
-        && !strcmp(ln->layer->name->buf, layer_name->buf))
-      return ln->layer->storage->attributes;
+  l = ows_layer_get(o->layers, layer_name);
+  if (l && l->storage) return l->storage->attributes;
 
   return NULL;
 }
@@ -423,18 +730,46 @@ ows_version * ows_psql_postgis_version(ows *o)
 /*
  * TODO
  */
-bool ows_psql_is_numeric(buffer * type)
+bool ows_psql_is_numeric(enum ows_psql_type_code code)
 {
-  assert(type);
+  switch (code) {
+    case OWS_PSQL_TYPE_INT2:
+    case OWS_PSQL_TYPE_INT4:
+    case OWS_PSQL_TYPE_INT8:
+    case OWS_PSQL_TYPE_FLOAT4:
+    case OWS_PSQL_TYPE_FLOAT8:
+    case OWS_PSQL_TYPE_NUMERIC:
+      return true;
+    default:
+      return false;
+  }
+}
 
-  if (buffer_cmp(type, "int2")) return true;
-  if (buffer_cmp(type, "int4")) return true;
-  if (buffer_cmp(type, "int8")) return true;
-  if (buffer_cmp(type, "float4")) return true;
-  if (buffer_cmp(type, "float8")) return true;
-  if (buffer_ncmp(type, "numeric", 7)) return true;
 
-  return false;
+/*
+ * Resolve a PostgreSQL type name into a type code
+ */
+enum ows_psql_type_code ows_psql_type_code(const buffer * type)
+{
+  assert(type);
+
+  if (buffer_cmp(type, "bool")) return OWS_PSQL_TYPE_BOOL;
+  if (buffer_cmp(type, "int2")) return OWS_PSQL_TYPE_INT2;
+  if (buffer_cmp(type, "int4")) return OWS_PSQL_TYPE_INT4;
+  if (buffer_cmp(type, "int8")) return OWS_PSQL_TYPE_INT8;
+  if (buffer_cmp(type, "float4")) return OWS_PSQL_TYPE_FLOAT4;
+  if (buffer_cmp(type, "float8")) return OWS_PSQL_TYPE_FLOAT8;
+  if (buffer_ncmp(type, "numeric", 7)) return OWS_PSQL_TYPE_NUMERIC;
+  if (buffer_cmp(type, "text")) return OWS_PSQL_TYPE_TEXT;
+  if (buffer_cmp(type, "varchar")) return OWS_PSQL_TYPE_VARCHAR;
+  if (buffer_ncmp(type, "char", 4) || buffer_ncmp(type, "varchar", 7)) return OWS_PSQL_TYPE_CHAR;
+  if (buffer_cmp(type, "hstore")) return OWS_PSQL_TYPE_HSTORE;
+  if (buffer_cmp(type, "date")) return OWS_PSQL_TYPE_DATE;
+  if (    buffer_cmp(type, "timestamp")
+       || buffer_cmp(type, "timestamptz")
+       || buffer_cmp(type, "datetime")) return OWS_PSQL_TYPE_TIMESTAMP;
+
+  return OWS_PSQL_TYPE_OTHER;
 }
 
 
@@ -507,23 +842,55 @@ buffer *ows_psql_timestamp_to_xml_time(char *timestamp)
 }
 
 
+/*
+ * Return the type code of the property passed in parameter
+ * (OWS_PSQL_TYPE_OTHER if the property is unknown)
+ * Codes of a layer are resolved once, and then kept with its storage
+ */
+enum ows_psql_type_code ows_psql_column_type(ows * o, buffer * layer_name, const char *property)
+{
+  ows_layer_storage *s;
+  array_node *an;
+  ows_layer *l;
+  int i;
+
+  assert(o);
+  assert(o->layers);
+  assert(layer_name);
+  assert(property);
+
+  l = ows_layer_get(o->layers, layer_name);
+  if (!l || !l->storage) return OWS_PSQL_TYPE_OTHER;
+  s = l->storage;
+
+  if (!s->attributes_type) {
+    s->attributes_type = malloc((s->attributes->size ? s->attributes->size : 1) * sizeof(enum ows_psql_type_code));
+    assert(s->attributes_type);
+
+    for (i = 0, an = s->attributes->first ; an ; an = an->next, i++)
+      s->attributes_type[i] = ows_psql_type_code(an->value);
+  }
+
+  i = array_index(s->attributes, property);
+
+  return i == -1 ? OWS_PSQL_TYPE_OTHER : s->attributes_type[i];
+}
+
+
 /*
  * Return the type of the property passed in parameter
  */
 buffer *ows_psql_type(ows * o, buffer * layer_name, buffer * property)
 {
-  ows_layer_node *ln;
+  ows_layer *l;
 
   assert(o);
   assert(o->layers);
   assert(layer_name);
   assert(property);
 
-  for (ln = o->layers->first ; ln ; ln = ln->next) {
-    if (ln->layer->name && ln->layer->storage
-        && !strcmp(ln->layer->name->buf, layer_name->buf))
-      return array_get(ln->layer->storage->attributes, property->buf);
-  }
+  l = ows_layer_get(o->layers, layer_name);
+  if (l && l->storage) return array_get(l->storage->attributes, property->buf);
 
   return NULL;
 }
@@ -534,7 +901,7 @@ buffer *ows_psql_type(ows * o, buffer * layer_name, buffer * property)
  */
 buffer *ows_psql_generate_id(ows * o, buffer * layer_name)
 {
-  ows_layer_node *ln;
+  ows_layer *l;
   buffer * id, *sql_id;
   FILE *fp;
   PGresult * res;
@@ -546,21 +913,18 @@ buffer *ows_psql_generate_id(ows * o, buffer * layer_name)
   assert(layer_name);
 
   /* Retrieve layer node pointer */
-  for (ln = o->layers->first ; ln ; ln = ln->next) {
-    if (ln->layer->name && ln->layer->storage
-        && !strcmp(ln->layer->name->buf, layer_name->buf)) break;
-  }
-  assert(ln);
+  l = ows_layer_get(o->layers, layer_name);
+  assert(l && l->storage);
 
   id = buffer_init();
 
   /* If PK have a sequence in PostgreSQL database,
    * retrieve next available sequence value
    */
-  if (ln->layer->storage->pkey_sequence) {
+  if (l->storage->pkey_sequence) {
     sql_id = buffer_init();
     buffer_add_str(sql_id, "SELECT nextval('");
-    buffer_copy(sql_id, ln->layer->storage->pkey_sequence);
+    buffer_copy(sql_id, l->storage->pkey_sequence);
     buffer_add_str(sql_id, "');");
     res = ows_psql_exec(o, sql_id->buf);
     buffer_free(sql_id);
@@ -578,10 +942,10 @@ buffer *ows_psql_generate_id(ows * o, buffer * layer_name)
   /* If PK have a DEFAULT in PostgreSQL database,
    * retrieve next available DEFAULT value
    */
-  if (ln->layer->storage->pkey_default) {
+  if (l->storage->pkey_default) {
     sql_id = buffer_init();
     buffer_add_str(sql_id, "SELECT ");
-    buffer_copy(sql_id, ln->layer->storage->pkey_default);
+    buffer_copy(sql_id, l->storage->pkey_default);
     buffer_add_str(sql_id, ";");
     res = ows_psql_exec(o, sql_id->buf);
     buffer_free(sql_id);
@@ -635,6 +999,63 @@ buffer *ows_psql_generate_id(ows * o, buffer * layer_name)
 }
 
 
+/*
+ * Generate n new ids for a layer, with a single request
+ * when PK has a sequence or a DEFAULT (otherwise as ows_psql_generate_id)
+ */
+list *ows_psql_generate_ids(ows * o, buffer * layer_name, int n)
+{
+  ows_layer *l;
+  buffer *sql;
+  list *ids;
+  PGresult *res;
+  int i;
+
+  assert(o);
+  assert(o->layers);
+  assert(layer_name);
+
+  l = ows_layer_get(o->layers, layer_name);
+  assert(l && l->storage);
+
+  ids = list_init();
+  if (n <= 0) return ids;
+
+  if (l->storage->pkey_sequence || l->storage->pkey_default) {
+    sql = buffer_init();
+    if (l->storage->pkey_sequence) {
+      /* Ordered, so ids are given as one by one nextval would */
+      buffer_add_str(sql, "SELECT nextval('");
+      buffer_copy(sql, l->storage->pkey_sequence);
+      buffer_add_str(sql, "') FROM generate_series(1, ");
+      buffer_add_int(sql, n);
+      buffer_add_str(sql, ") ORDER BY 1");
+    } else {
+      buffer_add_str(sql, "SELECT ");
+      buffer_copy(sql, l->storage->pkey_default);
+      buffer_add_str(sql, " FROM generate_series(1, ");
+      buffer_add_int(sql, n);
+      buffer_add(sql, ')');
+    }
+
+    res = ows_psql_exec(o, sql->buf);
+    buffer_free(sql);
+
+    if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == n)
+      for (i = 0 ; i < n ; i++)
+        list_add_str(ids, PQgetvalue(res, i, 0));
+    PQclear(res);
+
+    if ((int) ids->size == n) return ids;
+  }
+
+  for (i = (int) ids->size ; i < n ; i++)
+    list_add(ids, ows_psql_generate_id(o, layer_name));
+
+  return ids;
+}
+
+
 /*
  * Return the number of rows returned by the specified requests
  */
@@ -727,16 +1148,63 @@ static xmlNodePtr ows_psql_recursive_parse_gml(ows * o, xmlNodePtr n, xmlNodePtr
 }
 
 
+/*
+ * Check if geometry is valid, if asked to
+ * (or only stage it, when a later check is done on all staged ones)
+ * Return result (NULL if not valid), sql is freed
+ */
+static buffer *ows_psql_gml_check_valid(ows * o, buffer * result, buffer * sql, list * staged)
+{
+  PGresult *res;
+
+  if (o->check_valid_geom && staged) list_add_by_copy(staged, result);
+  else if (o->check_valid_geom) {
+
+    buffer_empty(sql);
+    buffer_add_str(sql, "SELECT ST_IsValid('");
+    buffer_add_str(sql, result->buf);
+    buffer_add_str(sql, "')");
+
+    res = ows_psql_exec(o, sql->buf);
+
+    if (    PQresultStatus(res) != PGRES_TUPLES_OK
+         || PQntuples(res) != 1
+         || (char) PQgetvalue(res, 0, 0)[0] !=  't') {
+      buffer_free(sql);
+      buffer_free(result);
+      PQclear(res);
+      return NULL;
+    }
+    PQclear(res);
+  }
+
+  buffer_free(sql);
+
+  return result;
+}
+
+
 /*
  * Transform a GML geometry to PostGIS EWKT
  * Return NULL on error
  */
 buffer * ows_psql_gml_to_sql(ows * o, xmlNodePtr n, const ows_srs* parent_srs)
+{
+  return ows_psql_gml_to_sql_staged(o, n, parent_srs, NULL);
+}
+
+
+/*
+ * Same as ows_psql_gml_to_sql, but validity is only checked later,
+ * with ows_psql_geometries_invalid over staged (if not NULL)
+ */
+buffer * ows_psql_gml_to_sql_staged(ows * o, xmlNodePtr n, const ows_srs* parent_srs, list * staged)
 {
   PGresult *res;
   xmlNodePtr g;
-  buffer *result, *sql, *gml;
+  buffer *result = NULL, *sql, *gml;
   ows_srs* srs_geom = NULL;
+  bool flip;
 
   assert(o);
   assert(n);
@@ -758,11 +1226,25 @@ buffer * ows_psql_gml_to_sql(ows * o, xmlNodePtr n, const ows_srs* parent_srs)
     xmlFree(attr);
   }
 
+  /* Parsed in process when possible, with the same srid and axis order */
+  if (o->native_gml && ows_version_get(o->postgis_version) >= 200) {
+    if (srs_geom) flip = srs_geom->honours_authority_axis_order && !srs_geom->is_axis_order_gis_friendly;
+    else flip = parent_srs && parent_srs->honours_authority_axis_order
+                && !parent_srs->is_axis_order_gis_friendly;
+
+    result = ows_gml_to_ewkb(g, srs_geom ? srs_geom->srid : (parent_srs ? parent_srs->srid : 0), flip);
+  }
+
+  sql = buffer_init();
+  if (result) {
+    if (srs_geom) ows_srs_free(srs_geom);
+    return ows_psql_gml_check_valid(o, result, sql, staged);
+  }
+
   /* Retrieve the sub doc and launch GML parse via PostGIS */
   gml = buffer_init();
   cgi_add_xml_into_buffer(gml, g);
 
-  sql = buffer_init();
   buffer_add_str(sql, "SELECT ");
   if (srs_geom == NULL && parent_srs != NULL &&
       parent_srs->honours_authority_axis_order &&
@@ -805,30 +1287,7 @@ buffer * ows_psql_gml_to_sql(ows * o, xmlNodePtr n, const ows_srs* parent_srs)
   buffer_add_str(result, PQgetvalue(res, 0, 0));
   PQclear(res);
 
-  /* Check if geometry is valid */
-  if (o->check_valid_geom) {
-
-    buffer_empty(sql);
-    buffer_add_str(sql, "SELECT ST_IsValid('");
-    buffer_add_str(sql, result->buf);
-    buffer_add_str(sql, "')");
-
-    res = ows_psql_exec(o, sql->buf);
-
-    if (    PQresultStatus(res) != PGRES_TUPLES_OK
-         || PQntuples(res) != 1
-         || (char) PQgetvalue(res, 0, 0)[0] !=  't') {
-      buffer_free(sql);
-      buffer_free(result);
-      PQclear(res);
-      return NULL;
-    }
-    PQclear(res);
-  }
-
-  buffer_free(sql);
-
-  return result;
+  return ows_psql_gml_check_valid(o, result, sql, staged);
 }
 
 
@@ -868,6 +1327,10 @@ int ows_psql_geometry_srid(ows *o, const char *geom)
   assert(o->pg);
   assert(geom);
 
+  /* Read from the EWKB header, with no need to ask PostGIS */
+  srid = ows_ewkb_srid(geom);
+  if (srid >= 0) return srid;
+
   sql = buffer_from_str("SELECT ST_SRID('");
   buffer_add_str(sql, geom);
   buffer_add_str(sql, "'::geometry)");
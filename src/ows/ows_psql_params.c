@@ -0,0 +1,342 @@
+/*
+  Copyright (c) <2007-2012> <Barbara Philippot - Olivier Courtin>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+
+#include "ows.h"
+
+
+/*
+ * Parameters vector, as libpq wants it
+ */
+ows_psql_params *ows_psql_params_init()
+{
+  ows_psql_params *p;
+
+  p = malloc(sizeof(ows_psql_params));
+  assert(p);
+
+  p->values = NULL;
+  p->lengths = NULL;
+  p->formats = NULL;
+  p->types = NULL;
+  p->size = 0;
+  p->max = 0;
+
+  return p;
+}
+
+
+void ows_psql_params_free(ows_psql_params * p)
+{
+  assert(p);
+
+  ows_psql_params_truncate(p, 0);
+  free(p->values);
+  free(p->lengths);
+  free(p->formats);
+  free(p->types);
+  free(p);
+}
+
+
+/*
+ * Drop the last parameters, keeping only the first size ones
+ */
+void ows_psql_params_truncate(ows_psql_params * p, int size)
+{
+  assert(p);
+  assert(size >= 0);
+
+  for ( ; p->size > size ; p->size--) free(p->values[p->size - 1]);
+}
+
+
+/*
+ * Append a parameter (value is copied, length is only used with binary format)
+ * Return its number, as used in $n
+ */
+int ows_psql_params_add(ows_psql_params * p, const char *value, int length, int format, Oid type)
+{
+  assert(p);
+  assert(value);
+
+  if (p->size == p->max) {
+    p->max = p->max ? p->max * 2 : 8;
+    p->values = realloc(p->values, p->max * sizeof(char *));
+    p->lengths = realloc(p->lengths, p->max * sizeof(int));
+    p->formats = realloc(p->formats, p->max * sizeof(int));
+    p->types = realloc(p->types, p->max * sizeof(Oid));
+    assert(p->values && p->lengths && p->formats && p->types);
+  }
+
+  if (format) {
+    p->values[p->size] = malloc(length);
+    assert(p->values[p->size]);
+    memcpy(p->values[p->size], value, length);
+  } else {
+    p->values[p->size] = malloc(strlen(value) + 1);
+    assert(p->values[p->size]);
+    strcpy(p->values[p->size], value);
+    length = 0;
+  }
+
+  p->lengths[p->size] = length;
+  p->formats[p->size] = format;
+  p->types[p->size] = type;
+
+  return ++p->size;
+}
+
+
+/*
+ * Type PostgreSQL would give to a numeric literal
+ * (unknown if value is not a number, the server then infers it)
+ */
+Oid ows_psql_numeric_type(const char *value)
+{
+  const char *c;
+  char *end;
+  long long l;
+
+  assert(value);
+
+  c = value;
+  if (*c == '-' || *c == '+') c++;
+  if (!*c) return OWS_PSQL_OID_UNKNOWN;
+
+  for ( ; isdigit((unsigned char) *c) ; c++);
+  if (!*c) {
+    errno = 0;
+    l = strtoll(value, NULL, 10);
+    if (errno == ERANGE) return OWS_PSQL_OID_NUMERIC;
+    if (l > 2147483647LL || l < -2147483647LL) return OWS_PSQL_OID_INT8;
+    return OWS_PSQL_OID_INT4;
+  }
+
+  /* No inf or nan there, as SQL has no such literals */
+  for (c = value ; *c ; c++)
+    if (isalpha((unsigned char) *c) && *c != 'e' && *c != 'E') return OWS_PSQL_OID_UNKNOWN;
+
+  strtod(value, &end);
+  if (end != value && !*end) return OWS_PSQL_OID_NUMERIC;
+
+  return OWS_PSQL_OID_UNKNOWN;
+}
+
+
+/*
+ * Write a placeholder into sql, bound at execution to the value
+ * The request parameters live until the end of the request,
+ * so a placeholder can be copied from a SQL fragment to another
+ */
+static void ows_psql_param_marker(ows * o, buffer * sql, const char *value, int length,
+                                  int format, Oid type)
+{
+  if (!o->params) o->params = ows_psql_params_init();
+
+  buffer_add_str(sql, "$?");
+  buffer_add_int(sql, ows_psql_params_add(o->params, value, length, format, type));
+}
+
+
+/*
+ * Write a client string value into sql, as a quoted literal
+ * or as a parameter (type left to the server)
+ */
+void ows_psql_param_str(ows * o, buffer * sql, const char *value)
+{
+  char *escaped;
+
+  assert(o);
+  assert(sql);
+  assert(value);
+
+  if (o->bind_parameters) {
+    ows_psql_param_marker(o, sql, value, 0, 0, OWS_PSQL_OID_UNKNOWN);
+    return;
+  }
+
+  buffer_add(sql, '\'');
+  escaped = ows_psql_escape_string(o, value);
+  if (escaped) {
+    buffer_add_str(sql, escaped);
+    free(escaped);
+  }
+  buffer_add(sql, '\'');
+}
+
+
+/*
+ * Write a client numeric value into sql, as an unquoted literal
+ * or as a parameter typed as the literal would be
+ */
+void ows_psql_param_numeric(ows * o, buffer * sql, const char *value)
+{
+  char *escaped;
+
+  assert(o);
+  assert(sql);
+  assert(value);
+
+  if (o->bind_parameters) {
+    ows_psql_param_marker(o, sql, value, 0, 0, ows_psql_numeric_type(value));
+    return;
+  }
+
+  escaped = ows_psql_escape_string(o, value);
+  if (escaped) {
+    buffer_add_str(sql, escaped);
+    free(escaped);
+  }
+}
+
+
+/*
+ * Write a double into sql, as text or as a binary float8 parameter
+ * (so with no loss of precision)
+ */
+void ows_psql_param_double(ows * o, buffer * sql, double d)
+{
+  unsigned long long u;
+  char value[8];
+  int i;
+
+  assert(o);
+  assert(sql);
+
+  if (!o->bind_parameters) {
+    buffer_add_double(sql, d);
+    return;
+  }
+
+  /* float8 binary format is the IEEE 754 double, in network byte order */
+  assert(sizeof(u) == sizeof(d));
+  memcpy(&u, &d, sizeof(d));
+  for (i = 7 ; i >= 0 ; i--, u >>= 8) value[i] = (char) (u & 0xff);
+
+  ows_psql_param_marker(o, sql, value, 8, 1, OWS_PSQL_OID_FLOAT8);
+}
+
+
+/*
+ * Write an hexadecimal EWKB geometry into sql, as a quoted literal
+ * or as a binary parameter (type left to the server, as the column
+ * or the cast the caller writes)
+ */
+void ows_psql_param_geometry(ows * o, buffer * sql, const char *hex)
+{
+  char *wkb;
+  size_t i, len;
+  unsigned int byte;
+
+  assert(o);
+  assert(sql);
+  assert(hex);
+
+  len = strlen(hex);
+  if (!o->bind_parameters || len % 2 || strspn(hex, "0123456789ABCDEFabcdef") != len) {
+    buffer_add(sql, '\'');
+    buffer_add_str(sql, hex);
+    buffer_add(sql, '\'');
+    return;
+  }
+
+  wkb = malloc(len / 2 + 1);
+  assert(wkb);
+  for (i = 0 ; i < len / 2 ; i++) {
+    sscanf(hex + 2 * i, "%2x", &byte);
+    wkb[i] = (char) byte;
+  }
+
+  ows_psql_param_marker(o, sql, wkb, (int) (len / 2), 1, OWS_PSQL_OID_UNKNOWN);
+  free(wkb);
+}
+
+
+/*
+ * Number the placeholders of a request as $1, $2... and collect
+ * the matching values (a placeholder used twice gets the same number)
+ * Quoted strings and identifiers are copied as is
+ */
+ows_psql_params *ows_psql_params_bind(ows * o, const char *sql, buffer * bound)
+{
+  ows_psql_params *p;
+  const char *c, *start;
+  char *end, quote;
+  int *numbers, k;
+  bool escapes;
+
+  assert(o);
+  assert(sql);
+  assert(bound);
+
+  p = ows_psql_params_init();
+
+  if (!o->params || !strstr(sql, "$?")) {
+    buffer_add_str(bound, sql);
+    return p;
+  }
+
+  numbers = calloc(o->params->size + 1, sizeof(int));
+  assert(numbers);
+
+  for (c = sql ; *c ; ) {
+
+    if (*c == '\'' || *c == '"') {
+      quote = *c;
+      escapes = (quote == '\'' && c > sql && (c[-1] == 'E' || c[-1] == 'e'));
+      for (start = c++ ; *c ; c++) {
+        if (escapes && *c == '\\' && c[1]) c++;
+        else if (*c == quote && c[1] == quote) c++;
+        else if (*c == quote) break;
+      }
+      if (*c) c++;
+      buffer_add_nstr(bound, start, c - start);
+      continue;
+    }
+
+    if (*c == '$' && c[1] == '?' && isdigit((unsigned char) c[2])) {
+      k = (int) strtol(c + 2, &end, 10);
+      if (k >= 1 && k <= o->params->size) {
+        if (!numbers[k])
+          numbers[k] = ows_psql_params_add(p, o->params->values[k - 1], o->params->lengths[k - 1],
+                                           o->params->formats[k - 1], o->params->types[k - 1]);
+        buffer_add(bound, '$');
+        buffer_add_int(bound, numbers[k]);
+        c = end;
+        continue;
+      }
+    }
+
+    buffer_add(bound, *c++);
+  }
+
+  free(numbers);
+
+  return p;
+}
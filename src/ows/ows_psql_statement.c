@@ -0,0 +1,501 @@
+/*
+  Copyright (c) <2007-2012> <Barbara Philippot - Olivier Courtin>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "ows.h"
+
+
+/*
+ * Prepared statements cache
+ * A statement is identified by its SQL text once literals are replaced by
+ * parameters, so by layer, output format, properties and filter shape,
+ * and by its parameters types
+ * A request first seen is executed as is, its statement is prepared
+ * between requests, on an idle connection (so a statement that can't be
+ * prepared never makes a request fail, nor aborts its transaction)
+ * The least recently used statement is deallocated when the cache is full
+ */
+ows_psql_statements *ows_psql_statements_init(int max)
+{
+  ows_psql_statements *s;
+
+  assert(max > 0);
+
+  s = malloc(sizeof(ows_psql_statements));
+  assert(s);
+
+  s->entries = malloc(max * sizeof(ows_psql_statement));
+  assert(s->entries);
+
+  s->size = 0;
+  s->max = max;
+  s->stale = NULL;
+  s->stale_size = 0;
+  s->next_id = 0;
+  s->clock = 0;
+  s->hits = s->misses = s->evictions = 0;
+
+  return s;
+}
+
+
+void ows_psql_statements_free(ows_psql_statements * s)
+{
+  int i;
+
+  assert(s);
+
+  for (i = 0 ; i < s->size ; i++) {
+    buffer_free(s->entries[i].sql);
+    free(s->entries[i].types);
+  }
+  free(s->entries);
+  free(s->stale);
+  free(s);
+}
+
+
+/*
+ * Log cache statistics
+ */
+void ows_psql_statements_log(ows * o)
+{
+  char msg[128];
+
+  assert(o);
+
+  if (!o->statements) return;
+
+  snprintf(msg, sizeof(msg), "Statement cache: %lu hits, %lu misses, %lu evictions",
+           o->statements->hits, o->statements->misses, o->statements->evictions);
+  ows_log(o, 2, msg);
+}
+
+
+/*
+ * Replace numeric and string literals of a SELECT (or DECLARE) request
+ * by parameters, typed as PostgreSQL would type the literal itself
+ * Parameters are appended to p, after the ones already bound
+ * Anything following an ORDER BY is kept as is (1 could be a column number)
+ * Return NULL if the request is not worth preparing (p is then left as is)
+ */
+static buffer *ows_psql_params_extract(const char *sql, ows_psql_params * p)
+{
+  buffer *out, *value;
+  const char *c, *start;
+  bool ident, real, complete;
+  int size;
+
+  assert(sql);
+  assert(p);
+
+  if (strncmp(sql, "SELECT ", 7) && strncmp(sql, "DECLARE ", 8)) return NULL;
+
+  out = buffer_init();
+  value = buffer_init();
+  size = p->size;
+
+  for (c = sql, ident = false, complete = true ; *c ; ) {
+
+    /* Quoted identifier */
+    if (*c == '"') {
+      for (start = c++ ; *c && *c != '"' ; c++);
+      if (*c) c++;
+      buffer_add_nstr(out, start, c - start);
+      ident = true;
+      continue;
+    }
+
+    /* Prefixed string literal (as E''), kept inline */
+    if (*c == '\'' && ident) {
+      for (start = c++ ; *c ; c++) {
+        if (*c == '\\' && c[1]) c++;
+        else if (*c == '\'' && c[1] == '\'') c++;
+        else if (*c == '\'') break;
+      }
+      if (*c) c++;
+      buffer_add_nstr(out, start, c - start);
+      continue;
+    }
+
+    /* String literal */
+    if (*c == '\'') {
+      buffer_empty(value);
+      for (c++ ; *c ; c++) {
+        if (*c == '\'' && c[1] == '\'') c++;
+        else if (*c == '\'') break;
+        buffer_add(value, *c);
+      }
+      if (!*c) {
+        complete = false;
+        break;
+      }
+      c++;
+      buffer_add(out, '$');
+      buffer_add_int(out, ows_psql_params_add(p, value->buf, 0, 0, OWS_PSQL_OID_UNKNOWN));
+      continue;
+    }
+
+    /* Numeric literal, not part of an identifier */
+    if ((isdigit((unsigned char) *c) || (*c == '.' && isdigit((unsigned char) c[1]))) && !ident) {
+      buffer_empty(value);
+      for (real = false ; isdigit((unsigned char) *c) || *c == '.' ; c++) {
+        if (*c == '.') real = true;
+        buffer_add(value, *c);
+      }
+      if ((*c == 'e' || *c == 'E')
+          && (isdigit((unsigned char) c[1])
+              || ((c[1] == '-' || c[1] == '+') && isdigit((unsigned char) c[2])))) {
+        real = true;
+        buffer_add(value, *c++);
+        buffer_add(value, *c++);
+        for ( ; isdigit((unsigned char) *c) ; c++) buffer_add(value, *c);
+      }
+      buffer_add(out, '$');
+      buffer_add_int(out, ows_psql_params_add(p, value->buf, 0, 0,
+                                              real ? OWS_PSQL_OID_NUMERIC : ows_psql_numeric_type(value->buf)));
+      ident = true;
+      continue;
+    }
+
+    if (!ident && !strncmp(c, "ORDER BY", 8)) {
+      buffer_add_str(out, c);
+      break;
+    }
+
+    ident = isalnum((unsigned char) *c) || *c == '_' || *c == '$';
+    buffer_add(out, *c++);
+  }
+
+  buffer_free(value);
+
+  /* Unterminated string, or over libpq protocol limit */
+  if (!complete || p->size > 65535) {
+    buffer_free(out);
+    ows_psql_params_truncate(p, size);
+    return NULL;
+  }
+
+  return out;
+}
+
+
+static void ows_psql_statement_name(int id, char *name, size_t size)
+{
+  snprintf(name, size, "tinyows_stmt_%d", id);
+}
+
+
+/*
+ * Return the cached statement matching a request, if any
+ * Parameters types are part of the match: a same request shape could
+ * come with an int4, int8 or numeric literal
+ */
+static ows_psql_statement *ows_psql_statement_lookup(ows_psql_statements * s, const buffer * sql,
+                                                     const ows_psql_params * p)
+{
+  ows_psql_statement *st;
+  int i;
+
+  for (i = 0 ; i < s->size ; i++) {
+    st = &s->entries[i];
+    if (st->sql->use != sql->use || st->params != p->size || strcmp(st->sql->buf, sql->buf)) continue;
+    if (p->size && memcmp(st->types, p->types, p->size * sizeof(Oid))) continue;
+
+    st->used = ++s->clock;
+    return st;
+  }
+
+  return NULL;
+}
+
+
+/*
+ * Remove a statement from the cache
+ * Its server side counterpart, if any, is deallocated between requests
+ */
+static void ows_psql_statement_remove(ows_psql_statements * s, ows_psql_statement * st)
+{
+  if (st->state == OWS_PSQL_STATEMENT_PREPARED) {
+    s->stale = realloc(s->stale, (s->stale_size + 1) * sizeof(int));
+    assert(s->stale);
+    s->stale[s->stale_size++] = st->id;
+  }
+
+  buffer_free(st->sql);
+  free(st->types);
+  *st = s->entries[--s->size];
+}
+
+
+/*
+ * Statement text, for arena_heap
+ */
+static void *ows_psql_statement_sql_init(void)
+{
+  return buffer_init();
+}
+
+
+/*
+ * Add a pending statement into the cache,
+ * evicting the least recently used one if full
+ */
+static ows_psql_statement *ows_psql_statement_add(ows_psql_statements * s, const buffer * sql,
+                                                  const ows_psql_params * p)
+{
+  ows_psql_statement *st;
+  int i;
+
+  if (s->size == s->max) {
+    for (st = &s->entries[0], i = 1 ; i < s->size ; i++)
+      if (s->entries[i].used < st->used) st = &s->entries[i];
+
+    ows_psql_statement_remove(s, st);
+    s->evictions++;
+  }
+
+  st = &s->entries[s->size++];
+
+  st->sql = arena_heap(ows_psql_statement_sql_init);
+  buffer_copy(st->sql, sql);
+
+  st->params = p->size;
+  st->types = malloc((p->size ? p->size : 1) * sizeof(Oid));
+  assert(st->types);
+  if (p->size) memcpy(st->types, p->types, p->size * sizeof(Oid));
+
+  st->id = s->next_id++;
+  st->used = ++s->clock;
+  st->state = OWS_PSQL_STATEMENT_PENDING;
+
+  return st;
+}
+
+
+/*
+ * Statement text of a request: placeholders bound, then literals extracted
+ * Return NULL if the request is not worth preparing
+ */
+static buffer *ows_psql_statement_sql(ows * o, const char *sql, ows_psql_params ** p)
+{
+  buffer *bound, *stmt;
+
+  bound = buffer_init();
+  *p = ows_psql_params_bind(o, sql, bound);
+  stmt = ows_psql_params_extract(bound->buf, *p);
+  buffer_free(bound);
+
+  if (!stmt) {
+    ows_psql_params_free(*p);
+    *p = NULL;
+  }
+
+  return stmt;
+}
+
+
+/*
+ * Whether a request failed because its prepared statement
+ * is missing on the server side (invalid_sql_statement_name)
+ */
+static bool ows_psql_statement_missing(const PGresult * res)
+{
+  const char *state;
+
+  state = PQresultErrorField(res, PG_DIAG_SQLSTATE);
+
+  return state && !strcmp(state, "26000");
+}
+
+
+/*
+ * Drop a request from the cache once its execution failed because its
+ * prepared statement is missing on the server side
+ * Any other failure comes from the request itself: statement is kept
+ */
+void ows_psql_statement_failed(ows * o, const char *sql, const PGresult * res)
+{
+  ows_psql_statement *st;
+  ows_psql_params *p;
+  buffer *stmt;
+
+  assert(o);
+  assert(sql);
+  assert(res);
+
+  if (!o->statements || !ows_psql_statement_missing(res)) return;
+
+  stmt = ows_psql_statement_sql(o, sql, &p);
+  if (!stmt) return;
+
+  st = ows_psql_statement_lookup(o->statements, stmt, p);
+  if (st) {
+    /* Nothing left to deallocate */
+    st->state = OWS_PSQL_STATEMENT_PENDING;
+    ows_psql_statement_remove(o->statements, st);
+  }
+
+  buffer_free(stmt);
+  ows_psql_params_free(p);
+}
+
+
+/*
+ * Lookup or add a request into the cache
+ * Return the prepared statement to execute the request with,
+ * or NULL if the request is to be executed as is
+ */
+static ows_psql_params *ows_psql_statement_get(ows * o, const char *sql, char *name)
+{
+  ows_psql_statement *st;
+  ows_psql_params *p;
+  buffer *stmt;
+
+  if (o->statement_cache <= 0) return NULL;
+
+  stmt = ows_psql_statement_sql(o, sql, &p);
+  if (!stmt) return NULL;
+
+  if (!o->statements) o->statements = ows_psql_statements_init(o->statement_cache);
+
+  st = ows_psql_statement_lookup(o->statements, stmt, p);
+  if (!st) st = ows_psql_statement_add(o->statements, stmt, p);
+  buffer_free(stmt);
+
+  if (st->state != OWS_PSQL_STATEMENT_PREPARED) {
+    o->statements->misses++;
+    ows_psql_params_free(p);
+    return NULL;
+  }
+
+  o->statements->hits++;
+  ows_psql_statement_name(st->id, name, 64);
+
+  return p;
+}
+
+
+/*
+ * Execute a request through its prepared statement, if the cache has one
+ */
+PGresult *ows_psql_statement_exec(ows * o, const char *sql)
+{
+  ows_psql_params *p;
+  PGresult *res;
+  char name[64];
+
+  assert(o);
+  assert(sql);
+
+  p = ows_psql_statement_get(o, sql, name);
+  if (!p) return ows_psql_exec(o, sql);
+
+  ows_log(o, 8, sql);
+  res = PQexecPrepared(o->pg, name, p->size, (const char * const *) p->values,
+                       p->lengths, p->formats, 0);
+  ows_psql_params_free(p);
+
+  if (strlen(PQresultErrorMessage(res))) {
+    ows_log(o, 1, PQresultErrorMessage(res));
+    ows_psql_statement_failed(o, sql, res);
+  }
+
+  return res;
+}
+
+
+/*
+ * Bring the server side in line with the cache: deallocate evicted
+ * statements and prepare pending ones
+ * Done between requests, and only on an idle connection
+ */
+void ows_psql_statements_prepare(ows * o)
+{
+  ows_psql_statements *s;
+  ows_psql_statement *st;
+  PGresult *res;
+  buffer *sql;
+  char name[64];
+  int i;
+
+  assert(o);
+
+  s = o->statements;
+  if (!s || !o->pg || PQtransactionStatus(o->pg) != PQTRANS_IDLE) return;
+
+  for (i = 0 ; i < s->stale_size ; i++) {
+    ows_psql_statement_name(s->stale[i], name, sizeof(name));
+    sql = buffer_from_str("DEALLOCATE ");
+    buffer_add_str(sql, name);
+    PQclear(PQexec(o->pg, sql->buf));
+    buffer_free(sql);
+  }
+  s->stale_size = 0;
+
+  for (i = 0 ; i < s->size ; i++) {
+    st = &s->entries[i];
+    if (st->state != OWS_PSQL_STATEMENT_PENDING) continue;
+
+    ows_psql_statement_name(st->id, name, sizeof(name));
+    res = PQprepare(o->pg, name, st->sql->buf, st->params, st->types);
+
+    /* Request can't be prepared: it will always be executed as is */
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+      ows_log(o, 1, PQresultErrorMessage(res));
+      st->state = OWS_PSQL_STATEMENT_FAILED;
+    } else st->state = OWS_PSQL_STATEMENT_PREPARED;
+    PQclear(res);
+  }
+}
+
+
+#ifdef LIBPQ_HAS_PIPELINING
+/*
+ * Send in the pipeline a request through its prepared statement
+ * Return false if the cache has none, the request is then not sent
+ */
+bool ows_psql_statement_send(ows * o, const char *sql)
+{
+  ows_psql_params *p;
+  char name[64];
+
+  assert(o);
+  assert(sql);
+
+  p = ows_psql_statement_get(o, sql, name);
+  if (!p) return false;
+
+  /* Errors show up when the result is read */
+  if (PQsendQueryPrepared(o->pg, name, p->size, (const char * const *) p->values,
+                          p->lengths, p->formats, 0) != 1)
+    ows_log(o, 1, PQerrorMessage(o->pg));
+  ows_psql_params_free(p);
+
+  return true;
+}
+#endif
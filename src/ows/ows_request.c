@@ -26,6 +26,7 @@
 #include <assert.h>
 #include <string.h>
 #include <ctype.h>
+#include <libxml/xmlIO.h>
 #include <libxml/xmlschemas.h>
 #include <libxml/xmlschemastypes.h>
 
@@ -45,6 +46,8 @@ ows_request *ows_request_init()
   or->version = NULL;
   or->service = OWS_SERVICE_UNKNOWN;
   or->method = OWS_METHOD_UNKNOWN;
+  or->doc = NULL;
+  or->doc_valid = false;
   or->request.wfs = NULL;
 
   return or;
@@ -59,6 +62,7 @@ void ows_request_free(ows_request * or)
   assert(or);
 
   if (or->version) ows_version_free(or->version);
+  if (or->doc) xmlFreeDoc(or->doc);
 
   switch (or->service) {
     case WFS:
@@ -118,14 +122,68 @@ static void libxml2_callback  (void * ctx, const char * msg, ...)
 }
 
 
-static xmlSchemaPtr ows_generate_schema(const ows *o, buffer * xml_schema, bool schema_is_file)
+/*
+ * Layers schemas imported by the WFS schema are described in process,
+ * instead of being fetched from our own online resource
+ * (libxml2 input callbacks are global, so is the ows they use)
+ */
+static ows *ows_schema_describe_owner = NULL;
+
+
+static int ows_schema_describe_match(const char *uri)
+{
+  return ows_schema_describe_owner && uri
+         && !strncmp(uri, OWS_SCHEMA_DESCRIBE_URI, strlen(OWS_SCHEMA_DESCRIBE_URI));
+}
+
+
+static void *ows_schema_describe_open(const char *uri)
 {
+  cgi_stream *s;
+  buffer *b, *schema;
+  list *typename;
+
+  b = buffer_from_str(uri + strlen(OWS_SCHEMA_DESCRIBE_URI));
+  typename = list_explode(',', b);
+  buffer_free(b);
+
+  schema = wfs_describe_schema(ows_schema_describe_owner, typename);
+  if (!schema) return NULL;
+
+  /* Read as an already fully received input */
+  s = malloc(sizeof(cgi_stream));
+  assert(s);
+  s->head = schema;
+  s->head_read = 0;
+  s->left = 0;
+
+  return s;
+}
+
+
+static int ows_schema_describe_close(void *ctx)
+{
+  cgi_stream_free((cgi_stream *) ctx);
+  return 0;
+}
+
+
+static xmlSchemaPtr ows_generate_schema(ows *o, buffer * xml_schema, bool schema_is_file)
+{
+  static bool describe_registered = false;
+
   xmlSchemaParserCtxtPtr ctxt;
   xmlSchemaPtr schema = NULL;
 
   assert(o);
   assert(xml_schema);
 
+  if (!describe_registered) {
+    xmlRegisterInputCallbacks(ows_schema_describe_match, ows_schema_describe_open,
+                              cgi_stream_read, ows_schema_describe_close);
+    describe_registered = true;
+  }
+
   /* Open XML Schema File */
   if (schema_is_file) ctxt = xmlSchemaNewParserCtxt(xml_schema->buf);
   else                ctxt = xmlSchemaNewMemParserCtxt(xml_schema->buf, xml_schema->use);
@@ -135,7 +193,9 @@ static xmlSchemaPtr ows_generate_schema(const ows *o, buffer * xml_schema, bool
                            (xmlSchemaValidityWarningFunc) libxml2_callback,
                            (void *) o);
 
+  ows_schema_describe_owner = o;
   schema = xmlSchemaParse(ctxt);
+  ows_schema_describe_owner = NULL;
   xmlSchemaFreeParserCtxt(ctxt);
 
   /* If XML Schema hasn't been rightly loaded */
@@ -149,55 +209,155 @@ static xmlSchemaPtr ows_generate_schema(const ows *o, buffer * xml_schema, bool
 
 
 /*
- * Valid an xml string against an XML schema
+ * Release the compiled schemas cache, with their validation contexts
  */
-int ows_schema_validation(ows *o, buffer *xml_schema, buffer *xml, bool schema_is_file, enum ows_schema_type schema_type)
+void ows_schema_free(ows_schema * s)
+{
+  ows_schema *next;
+
+  for ( ; s ; s = next) {
+    next = s->next;
+    while (s->size) xmlSchemaFreeValidCtxt(s->ctxts[--s->size]);
+    free(s->ctxts);
+    xmlSchemaFree(s->schema);
+    free(s);
+  }
+}
+
+
+/*
+ * Cached schema of a given type, NULL if not compiled yet
+ */
+ows_schema *ows_schema_find(const ows * o, enum ows_schema_type schema_type)
+{
+  ows_schema *s;
+
+  assert(o);
+
+  for (s = o->schemas ; s ; s = s->next)
+    if (s->type == schema_type) return s;
+
+  return NULL;
+}
+
+
+/*
+ * Compiled WFS schema, generated on first use then kept
+ * (xml_schema is not needed, and could be NULL, once cached)
+ */
+xmlSchemaPtr ows_schema_get(ows * o, buffer * xml_schema, bool schema_is_file, enum ows_schema_type schema_type)
 {
   xmlSchemaPtr schema;
-  xmlSchemaValidCtxtPtr schema_ctx;
-  xmlDocPtr doc;
-  int ret = -1;
-  bool schema_generate = true;
+  ows_schema *s;
 
   assert(o);
-  assert(xml);
-  assert(xml_schema);
 
-  doc = xmlParseMemory(xml->buf, xml->use);
-  if (!doc) return ret;
-  if (!ows_libxml_check_namespace(o, doc->children)) {
-    xmlFreeDoc(doc);
-    return ret;
-  }
+  s = ows_schema_find(o, schema_type);
+  if (s) return s->schema;
+  if (!xml_schema) return NULL;
 
-  if (schema_type == WFS_SCHEMA_TYPE_100 && o->schema_wfs_100) {
-    schema_generate = false;
-    schema = o->schema_wfs_100;
-  } else if (schema_type == WFS_SCHEMA_TYPE_110 && o->schema_wfs_110) {
-    schema_generate = false;
-    schema = o->schema_wfs_110;
-  }
+  schema = ows_generate_schema(o, xml_schema, schema_is_file);
+  if (!schema) return NULL;
 
-  if (schema_generate) schema = ows_generate_schema(o, xml_schema, schema_is_file);
-  if (!schema) {
-    xmlFreeDoc(doc);
-    return ret;
-  }
+  s = malloc(sizeof(ows_schema));
+  assert(s);
+  s->type = schema_type;
+  s->schema = schema;
+  s->ctxts = malloc(OWS_SCHEMA_POOL_MAX * sizeof(xmlSchemaValidCtxtPtr));
+  assert(s->ctxts);
+  s->size = 0;
+  s->next = o->schemas;
+  o->schemas = s;
+
+  return schema;
+}
+
+
+/*
+ * Validation context of a WFS schema, errors going to the log
+ * Taken from the pool if one is free, give it back with ows_schema_valid_ctxt_release
+ * Return NULL if the schema can't be loaded
+ */
+xmlSchemaValidCtxtPtr ows_schema_valid_ctxt(ows * o, buffer * xml_schema, bool schema_is_file,
+                                            enum ows_schema_type schema_type)
+{
+  xmlSchemaPtr schema;
+  xmlSchemaValidCtxtPtr schema_ctx;
+  ows_schema *s;
+
+  schema = ows_schema_get(o, xml_schema, schema_is_file, schema_type);
+  if (!schema) return NULL;
+
+  s = ows_schema_find(o, schema_type);
+  if (s->size) return s->ctxts[--s->size];
 
   schema_ctx = xmlSchemaNewValidCtxt(schema);
-  xmlSchemaSetValidErrors(schema_ctx,
-                          (xmlSchemaValidityErrorFunc) libxml2_callback,
-                          (xmlSchemaValidityWarningFunc) libxml2_callback, (void *) o);
+  if (schema_ctx)
+    xmlSchemaSetValidErrors(schema_ctx,
+                            (xmlSchemaValidityErrorFunc) libxml2_callback,
+                            (xmlSchemaValidityWarningFunc) libxml2_callback, (void *) o);
+
+  return schema_ctx;
+}
+
+
+/*
+ * Give a validation context back to its schema pool
+ */
+void ows_schema_valid_ctxt_release(ows * o, xmlSchemaValidCtxtPtr schema_ctx, enum ows_schema_type schema_type)
+{
+  ows_schema *s;
+
+  assert(o);
+  assert(schema_ctx);
+
+  s = ows_schema_find(o, schema_type);
+  if (s && s->size < OWS_SCHEMA_POOL_MAX) s->ctxts[s->size++] = schema_ctx;
+  else xmlSchemaFreeValidCtxt(schema_ctx);
+}
+
+
+/*
+ * Valid an xml document against an XML schema
+ */
+int ows_schema_validation_doc(ows *o, buffer *xml_schema, xmlDocPtr doc, bool schema_is_file,
+                              enum ows_schema_type schema_type)
+{
+  xmlSchemaValidCtxtPtr schema_ctx;
+  int ret = -1;
+
+  assert(o);
+  assert(doc);
+
+  if (!ows_libxml_check_namespace(o, doc->children)) return ret;
+
+  schema_ctx = ows_schema_valid_ctxt(o, xml_schema, schema_is_file, schema_type);
   if (schema_ctx) {
     ret = xmlSchemaValidateDoc(schema_ctx, doc); /* validation */
-    xmlSchemaFreeValidCtxt(schema_ctx);
+    ows_schema_valid_ctxt_release(o, schema_ctx, schema_type);
   }
-  xmlFreeDoc(doc);
 
-  if (schema_generate) {
-    if (schema_type == WFS_SCHEMA_TYPE_100) o->schema_wfs_100 = schema;
-    else if (schema_type == WFS_SCHEMA_TYPE_110) o->schema_wfs_110 = schema;
-  }
+  return ret;
+}
+
+
+/*
+ * Valid an xml string against an XML schema
+ */
+int ows_schema_validation(ows *o, buffer *xml_schema, buffer *xml, bool schema_is_file, enum ows_schema_type schema_type)
+{
+  xmlDocPtr doc;
+  int ret;
+
+  assert(o);
+  assert(xml);
+  assert(xml_schema);
+
+  doc = xmlParseMemory(xml->buf, xml->use);
+  if (!doc) return -1;
+
+  ret = ows_schema_validation_doc(o, xml_schema, doc, schema_is_file, schema_type);
+  xmlFreeDoc(doc);
 
   return ret;
 }
@@ -263,10 +423,11 @@ static ows_version *ows_request_check_version(ows * o, ows_request * or, const a
 void ows_request_check(ows * o, ows_request * or, const array * cgi, const char *query)
 {
   list_node *srid;
-  buffer *typename, *xmlstring, *schema, *b=NULL;
+  buffer *typename, *schema, *b=NULL;
   ows_layer_node *ln = NULL;
   bool srsname = false;
   int valid = 0;
+  enum ows_schema_type schema_type;
 
   assert(o && or && cgi && query);
 
@@ -389,24 +550,20 @@ void ows_request_check(ows * o, ows_request * or, const array * cgi, const char
                                || !strcmp(getenv("CONTENT_TYPE"), "text/plain")))
        || (!cgi_method_post() && !cgi_method_get() && query[0] == '<') /* Unit test command line use case */ ) {
 
-    if (or->service == WFS && o->check_schema) {
-      xmlstring = buffer_from_str(query);
-
-      if (ows_version_get(or->version) == 100) {
-        schema = wfs_generate_schema(o, or->version);
-        valid = ows_schema_validation(o, schema, xmlstring, false, WFS_SCHEMA_TYPE_100);
-      } else {
-        schema = wfs_generate_schema(o, or->version);
-        valid = ows_schema_validation(o, schema, xmlstring, false, WFS_SCHEMA_TYPE_110);
-      }
+    /* A streamed Transaction is validated while read */
+    if (or->service == WFS && o->check_schema && !o->stream && or->doc) {
+      schema_type = (ows_version_get(or->version) == 100) ? WFS_SCHEMA_TYPE_100 : WFS_SCHEMA_TYPE_110;
 
-      buffer_free(schema);
-      buffer_free(xmlstring);
+      /* Schema text is only needed to compile it, the first time */
+      schema = ows_schema_find(o, schema_type) ? NULL : wfs_generate_schema(o, or->version);
+      valid = ows_schema_validation_doc(o, schema, or->doc, false, schema_type);
+      if (schema) buffer_free(schema);
 
       if (valid != 0) {
         ows_error(o, OWS_ERROR_INVALID_PARAMETER_VALUE, "XML request isn't valid", "request");
         return;
       }
+      or->doc_valid = true;
     }
   }
 }
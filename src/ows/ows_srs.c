@@ -47,6 +47,7 @@ ows_srs *ows_srs_init()
   c->is_geographic = true;
   c->honours_authority_axis_order = false;
   c->is_axis_order_gis_friendly = false;
+  c->meters_per_unit = 0.0;
   c->is_long = false;
 
   return c;
@@ -64,6 +65,7 @@ ows_srs *ows_srs_copy(ows_srs * d, ows_srs * s)
   d->is_geographic = s->is_geographic;
   d->honours_authority_axis_order = s->honours_authority_axis_order;
   d->is_axis_order_gis_friendly = s->is_axis_order_gis_friendly;
+  d->meters_per_unit = s->meters_per_unit;
   d->is_long = s->is_long;
 
   return d;
@@ -113,6 +115,8 @@ void ows_srs_flush(ows_srs * c, FILE * output)
   else
     fprintf(output, " is_axis_order_gis_friendly: false\n]\n");
 
+  fprintf(output, " meters_per_unit: %g\n", c->meters_per_unit);
+
   if (c->is_long)
     fprintf(output, " is_long: true\n]\n");
   else
@@ -179,6 +183,250 @@ static void ows_srs_set_is_geographic_and_is_axis_order_gis_friendly_from_def(
     }
 }
 
+/*
+ * Set s->meters_per_unit for a projected CRS, from the last (so the
+ * coordinate system one) UNIT of its horizontal srtext, else from
+ * +to_meter or +units of its proj4text
+ */
+static void ows_srs_set_unit_from_def(ows_srs * s, const char *proj4text, const char *srtext)
+{
+  static const struct {
+    const char *name;
+    double meters;
+  } units[] = {
+    {"m", 1.0}, {"km", 1000.0}, {"dm", 0.1}, {"cm", 0.01}, {"mm", 0.001},
+    {"ft", 0.3048}, {"us-ft", 1200.0 / 3937.0}, {"yd", 0.9144}, {"us-yd", 3600.0 / 3937.0},
+    {"mi", 1609.344}, {"us-mi", 6336000.0 / 3937.0}, {"in", 0.0254}, {"us-in", 100.0 / 3937.0},
+    {"ch", 20.1168}, {"us-ch", 79200.0 / 3937.0}, {"link", 0.201168}, {"fath", 1.8288},
+    {"kmi", 1852.0}, {NULL, 0.0}
+  };
+  const char *c, *end, *unit;
+  size_t len;
+  int i;
+
+  s->meters_per_unit = 0.0;
+  if (s->is_geographic) return;
+
+  if (srtext && srtext[0] != '\0') {
+    end = strstr(srtext, ",VERT_CS[");
+    if (!end) end = srtext + strlen(srtext);
+
+    for (unit = NULL, c = srtext ; (c = strstr(c, "UNIT[\"")) && c < end ; c++) unit = c;
+
+    /* UNIT["name",factor */
+    if (unit) {
+      for (c = unit + 6 ; *c && *c != '"' ; c++);
+      if (*c == '"' && c[1] == ',') s->meters_per_unit = atof(c + 2);
+    }
+  }
+
+  if (s->meters_per_unit > 0.0 || !proj4text) return;
+
+  c = strstr(proj4text, "+to_meter=");
+  if (c) {
+    s->meters_per_unit = atof(c + 10);
+    return;
+  }
+
+  c = strstr(proj4text, "+units=");
+  if (!c) return;
+  c += 7;
+  len = strcspn(c, " ");
+
+  for (i = 0 ; units[i].name ; i++)
+    if (strlen(units[i].name) == len && !strncmp(c, units[i].name, len)) {
+      s->meters_per_unit = units[i].meters;
+      return;
+    }
+}
+
+/*
+ * SRS cache: spatial_ref_sys rows are read once, then kept
+ * for the whole process (ordered by srid)
+ */
+#define OWS_SRS_SELECT "SELECT srid, auth_name, auth_srid, proj4text, srtext FROM spatial_ref_sys WHERE "
+
+
+void ows_srs_cache_free(ows_srs_cache * c)
+{
+  assert(c);
+
+  while (c->size) ows_srs_free(c->entries[--c->size]);
+  free(c->entries);
+  free(c);
+}
+
+
+/*
+ * Position of a srid into the cache, or where it should be inserted
+ */
+static int ows_srs_cache_index(const ows_srs_cache * c, int srid)
+{
+  int lo, hi, mid;
+
+  for (lo = 0, hi = c->size ; lo < hi ; ) {
+    mid = (lo + hi) / 2;
+    if (c->entries[mid]->srid < srid) lo = mid + 1;
+    else hi = mid;
+  }
+
+  return lo;
+}
+
+
+static ows_srs *ows_srs_cache_get(const ows * o, int srid)
+{
+  int i;
+
+  if (!o->srs_cache) return NULL;
+
+  i = ows_srs_cache_index(o->srs_cache, srid);
+  if (i < o->srs_cache->size && o->srs_cache->entries[i]->srid == srid)
+    return o->srs_cache->entries[i];
+
+  return NULL;
+}
+
+
+/*
+ * Cache entry, for arena_heap
+ */
+static void *ows_srs_cache_entry_init(void)
+{
+  return ows_srs_init();
+}
+
+
+/*
+ * Keep a row from OWS_SRS_SELECT into the cache
+ */
+static ows_srs *ows_srs_cache_add(ows * o, PGresult * res, int row)
+{
+  ows_srs_cache *c;
+  ows_srs *s;
+  int i, srid;
+
+  if (!o->srs_cache) {
+    o->srs_cache = malloc(sizeof(ows_srs_cache));
+    assert(o->srs_cache);
+    o->srs_cache->entries = NULL;
+    o->srs_cache->size = o->srs_cache->max = 0;
+  }
+  c = o->srs_cache;
+
+  srid = atoi(PQgetvalue(res, row, 0));
+  i = ows_srs_cache_index(c, srid);
+  if (i < c->size && c->entries[i]->srid == srid) return c->entries[i];
+
+  s = arena_heap(ows_srs_cache_entry_init);
+
+  s->srid = srid;
+  buffer_add_str(s->auth_name, PQgetvalue(res, row, 1));
+  s->auth_srid = atoi(PQgetvalue(res, row, 2));
+  ows_srs_set_is_geographic_and_is_axis_order_gis_friendly_from_def(s,
+      PQgetvalue(res, row, 3), PQgetvalue(res, row, 4));
+  ows_srs_set_unit_from_def(s, PQgetvalue(res, row, 3), PQgetvalue(res, row, 4));
+
+  if (c->size == c->max) {
+    c->max = c->max ? c->max * 2 : 16;
+    c->entries = realloc(c->entries, c->max * sizeof(ows_srs *));
+    assert(c->entries);
+  }
+
+  memmove(c->entries + i + 1, c->entries + i, (c->size - i) * sizeof(ows_srs *));
+  c->entries[i] = s;
+  c->size++;
+
+  return s;
+}
+
+
+/*
+ * Cached srs of a srid, read from spatial_ref_sys if needed
+ * Return NULL if srid is not handled
+ */
+static ows_srs *ows_srs_cache_fetch(ows * o, int srid)
+{
+  PGresult *res;
+  buffer *sql;
+  ows_srs *s;
+
+  s = ows_srs_cache_get(o, srid);
+  if (s) return s;
+
+  sql = buffer_from_str(OWS_SRS_SELECT "srid = ");
+  buffer_add_int(sql, srid);
+
+  res = ows_psql_exec(o, sql->buf);
+  buffer_free(sql);
+
+  /* If query dont return exactly 1 result, it mean projection not handled */
+  if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1)
+    s = ows_srs_cache_add(o, res, 0);
+
+  PQclear(res);
+  return s;
+}
+
+
+/*
+ * Read at once the srs used by layers (storage and configured ones)
+ * Others are read on their first use
+ */
+void ows_srs_cache_fill(ows * o)
+{
+  ows_layer_node *ln;
+  list_node *l;
+  PGresult *res;
+  buffer *sql;
+  int i;
+
+  assert(o);
+  assert(o->layers);
+
+  sql = buffer_from_str(OWS_SRS_SELECT "srid IN (4326");
+
+  for (ln = o->layers->first ; ln ; ln = ln->next) {
+    if (ln->layer->storage && ln->layer->storage->srid > 0) {
+      buffer_add(sql, ',');
+      buffer_add_int(sql, ln->layer->storage->srid);
+    }
+
+    if (ln->layer->srid)
+      for (l = ln->layer->srid->first ; l ; l = l->next)
+        if (atoi(l->value->buf) > 0) {
+          buffer_add(sql, ',');
+          buffer_add_int(sql, atoi(l->value->buf));
+        }
+  }
+  buffer_add(sql, ')');
+
+  res = ows_psql_exec(o, sql->buf);
+  buffer_free(sql);
+
+  if (PQresultStatus(res) == PGRES_TUPLES_OK)
+    for (i = 0 ; i < PQntuples(res) ; i++) ows_srs_cache_add(o, res, i);
+
+  PQclear(res);
+}
+
+
+/*
+ * Fill the srs structure from a cached one
+ * (context of use fields are left as they are)
+ */
+static void ows_srs_set_from_cache(ows_srs * s, const ows_srs * c)
+{
+  s->srid = c->srid;
+  buffer_empty(s->auth_name);
+  buffer_copy(s->auth_name, c->auth_name);
+  s->auth_srid = c->auth_srid;
+  s->is_geographic = c->is_geographic;
+  s->is_axis_order_gis_friendly = c->is_axis_order_gis_friendly;
+  s->meters_per_unit = c->meters_per_unit;
+}
+
+
 /*
  * Set projection value into srs structure
  */
@@ -186,41 +434,39 @@ bool ows_srs_set(ows * o, ows_srs * s, const buffer * auth_name, int auth_srid)
 {
   PGresult *res;
   buffer *sql;
-  const char* proj4text;
-  const char* srtext;
+  ows_srs *c = NULL;
+  int i;
 
   assert(o);
   assert(s);
   assert(o->pg);
   assert(auth_name);
 
-  sql = buffer_init();
-  buffer_add_str(sql, "SELECT srid, proj4text, srtext "
-                      "FROM spatial_ref_sys WHERE auth_name='");
-  buffer_copy(sql, auth_name);
-  buffer_add_str(sql, "' AND auth_srid=");
-  buffer_add_int(sql, auth_srid);
-
-  res = ows_psql_exec(o, sql->buf);
-  buffer_free(sql);
+  for (i = 0 ; o->srs_cache && i < o->srs_cache->size ; i++)
+    if (    o->srs_cache->entries[i]->auth_srid == auth_srid
+         && buffer_cmp(o->srs_cache->entries[i]->auth_name, auth_name->buf)) {
+      c = o->srs_cache->entries[i];
+      break;
+    }
 
-  /* If query dont return exactly 1 result, it means projection is not handled */
-  if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1) {
-    PQclear(res);
-    return false;
-  }
+  if (!c) {
+    sql = buffer_from_str(OWS_SRS_SELECT "auth_name='");
+    buffer_copy(sql, auth_name);
+    buffer_add_str(sql, "' AND auth_srid=");
+    buffer_add_int(sql, auth_srid);
 
-  buffer_empty(s->auth_name);
-  buffer_copy(s->auth_name, auth_name);
-  s->auth_srid = auth_srid;
+    res = ows_psql_exec(o, sql->buf);
+    buffer_free(sql);
 
-  s->srid = atoi(PQgetvalue(res, 0, 0));
+    /* If query dont return exactly 1 result, it means projection is not handled */
+    if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1)
+      c = ows_srs_cache_add(o, res, 0);
 
-  proj4text = PQgetvalue(res, 0, 1);
-  srtext = PQgetvalue(res, 0, 2);
-  ows_srs_set_is_geographic_and_is_axis_order_gis_friendly_from_def(s, proj4text, srtext);
+    PQclear(res);
+    if (!c) return false;
+  }
 
-  PQclear(res);
+  ows_srs_set_from_cache(s, c);
   return true;
 }
 
@@ -240,6 +486,7 @@ bool ows_srs_set_geobbox(ows * o, ows_srs * s)
   s->auth_srid = 4326;
   s->is_geographic = true;
   s->is_axis_order_gis_friendly = false;
+  s->meters_per_unit = 0.0;
 
   return true;
 }
@@ -250,10 +497,7 @@ bool ows_srs_set_geobbox(ows * o, ows_srs * s)
  */
 bool ows_srs_set_from_srid(ows * o, ows_srs * s, int srid)
 {
-  PGresult *res;
-  buffer *sql;
-  const char *proj4text;
-  const char *srtext;
+  ows_srs *c;
 
   assert(o);
   assert(s);
@@ -265,34 +509,15 @@ bool ows_srs_set_from_srid(ows * o, ows_srs * s, int srid)
     s->is_geographic = true;
     s->honours_authority_axis_order = false;
     s->is_axis_order_gis_friendly = false;
+    s->meters_per_unit = 0.0;
 
     return true;
   }
 
-  sql = buffer_init();
-  buffer_add_str(sql, "SELECT auth_name, auth_srid, proj4text, srtext "
-                      "FROM spatial_ref_sys WHERE srid = '");
-  buffer_add_int(sql, srid);
-  buffer_add_str(sql, "'");
-
-  res = ows_psql_exec(o, sql->buf);
-  buffer_free(sql);
-
-  /* If query dont return exactly 1 result, it mean projection not handled */
-  if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1) {
-    PQclear(res);
-    return false;
-  }
-
-  buffer_add_str(s->auth_name, PQgetvalue(res, 0, 0));
-  s->auth_srid = atoi(PQgetvalue(res, 0, 1));
-  s->srid = srid;
-
-  proj4text = PQgetvalue(res, 0, 2);
-  srtext = PQgetvalue(res, 0, 3);
-  ows_srs_set_is_geographic_and_is_axis_order_gis_friendly_from_def(s, proj4text, srtext);
+  c = ows_srs_cache_fetch(o, srid);
+  if (!c) return false;
 
-  PQclear(res);
+  ows_srs_set_from_cache(s, c);
   return true;
 }
 
@@ -360,14 +585,13 @@ bool ows_srs_set_from_srsname(ows * o, ows_srs * s, const char *srsname)
  */
 bool ows_srs_meter_units(ows * o, buffer * layer_name)
 {
-  ows_layer_node * ln;
+  ows_layer * l;
 
   assert(o);
   assert(layer_name);
 
-  for (ln = o->layers->first ; ln ; ln = ln->next)
-    if (ln->layer->name && ln->layer->storage && !strcmp(ln->layer->name->buf, layer_name->buf))
-      return !ln->layer->storage->is_geographic;
+  l = ows_layer_get(o->layers, layer_name);
+  if (l && l->storage) return !l->storage->is_geographic;
 
   assert(0); /* Should not happen */
   return false;
@@ -379,14 +603,13 @@ bool ows_srs_meter_units(ows * o, buffer * layer_name)
  */
 int ows_srs_get_srid_from_layer(ows * o, buffer * layer_name)
 {
-  ows_layer_node * ln;
+  ows_layer * l;
 
   assert(o);
   assert(layer_name);
 
-  for (ln = o->layers->first ; ln ; ln = ln->next)
-    if (ln->layer->name && ln->layer->storage && !strcmp(ln->layer->name->buf, layer_name->buf))
-      return ln->layer->storage->srid;
+  l = ows_layer_get(o->layers, layer_name);
+  if (l && l->storage) return l->storage->srid;
 
   return -1;
 }
@@ -423,30 +646,19 @@ list *ows_srs_get_from_srid(ows * o, list * l)
 buffer *ows_srs_get_from_a_srid(ows * o, int srid)
 {
   buffer *b;
-  buffer *sql;
-  PGresult *res;
+  ows_srs *c;
 
   assert(o);
 
-  sql = buffer_init();
-  buffer_add_str(sql, "SELECT auth_name||':'||auth_srid AS srs ");
-  buffer_add_str(sql, "FROM spatial_ref_sys ");
-  buffer_add_str(sql, "WHERE srid=");
-  buffer_add_int(sql, srid);
-
-  res = ows_psql_exec(o, sql->buf);
-  buffer_free(sql);
-
   b = buffer_init();
 
-  if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1) {
-    PQclear(res);
-    return b;
-  }
+  /* as auth_name||':'||auth_srid, so nothing if auth_name is NULL */
+  c = ows_srs_cache_fetch(o, srid);
+  if (!c || !c->auth_name->use) return b;
 
-  buffer_add_str(b, PQgetvalue(res, 0, 0));
-
-  PQclear(res);
+  buffer_copy(b, c->auth_name);
+  buffer_add(b, ':');
+  buffer_add_int(b, c->auth_srid);
 
   return b;
 }
@@ -45,6 +45,7 @@ ows_layer_storage * ows_layer_storage_init()
   storage->pkey_sequence = NULL;
   storage->pkey_default = NULL;
   storage->attributes = array_init();
+  storage->attributes_type = NULL;
   storage->not_null_columns = NULL;
 
   return storage;
@@ -62,6 +63,7 @@ void ows_layer_storage_free(ows_layer_storage * storage)
   if (storage->pkey_default)     buffer_free(storage->pkey_default);
   if (storage->geom_columns)     list_free(storage->geom_columns);
   if (storage->attributes)       array_free(storage->attributes);
+  if (storage->attributes_type)  free(storage->attributes_type);
   if (storage->not_null_columns) list_free(storage->not_null_columns);
 
   free(storage);
@@ -476,7 +478,315 @@ void ows_layers_storage_flush(ows * o, FILE * output)
 }
 
 
-void ows_layers_storage_fill(ows * o)
+/*
+ * Bulk introspection: every catalog query returns schema and table
+ * as its first two columns, sorted with C collation, so rows related
+ * to a given table are found back with a binary search
+ */
+static void ows_storage_bulk_tables(ows * o, buffer * sql)
+{
+  ows_layer_node *ln;
+  bool first = true;
+
+  assert(o);
+  assert(sql);
+
+  buffer_add_str(sql, "WITH l(s, t) AS (SELECT DISTINCT * FROM (VALUES ");
+  for (ln = o->layers->first ; ln ; ln = ln->next) {
+    if (!first) buffer_add_str(sql, ", ");
+    buffer_add_str(sql, "('");
+    buffer_copy(sql, ln->layer->storage->schema);
+    buffer_add_str(sql, "', '");
+    buffer_copy(sql, ln->layer->storage->table);
+    buffer_add_str(sql, "')");
+    first = false;
+  }
+  buffer_add_str(sql, ") AS v) ");
+}
+
+
+static int ows_storage_bulk_cmp(PGresult * res, int row, const ows_layer_storage * storage)
+{
+  int cmp;
+
+  cmp = strcmp(storage->schema->buf, PQgetvalue(res, row, 0));
+  if (cmp) return cmp;
+
+  return strcmp(storage->table->buf, PQgetvalue(res, row, 1));
+}
+
+
+/*
+ * Set [first, end[ to the rows of res related to the storage table
+ * Return false if there's no such row
+ */
+static bool ows_storage_bulk_find(PGresult * res, const ows_layer_storage * storage, int *first, int *end)
+{
+  int lo, hi, mid;
+
+  assert(res);
+  assert(storage);
+
+  for (lo = 0, hi = PQntuples(res) ; lo < hi ; ) {
+    mid = lo + (hi - lo) / 2;
+    if (ows_storage_bulk_cmp(res, mid, storage) > 0) lo = mid + 1;
+    else hi = mid;
+  }
+
+  for (hi = lo ; hi < PQntuples(res) && !ows_storage_bulk_cmp(res, hi, storage) ; hi++);
+  *first = lo;
+  *end = hi;
+
+  return lo < hi;
+}
+
+
+/*
+ * Fill a layer storage from bulk introspection results
+ * res_geom: schema, table, column, srid, type, kind (1 geometry, 2 geography), metric srs
+ * res_attr: schema, table, column, type, attnum, not null, pkey, default
+ */
+static void ows_storage_bulk_fill_layer(ows * o, ows_layer * l, PGresult * res_geom, PGresult * res_attr)
+{
+  int i, j, first, end, g_first, g_end, kind, pkeys;
+  char *name;
+  buffer *b, *t;
+
+  assert(o);
+  assert(l);
+  assert(l->storage);
+
+  /* Geometry columns come before geography ones, the last kind found sets the SRID */
+  ows_storage_bulk_find(res_geom, l->storage, &g_first, &g_end);
+  for (i = g_first, kind = 0 ; i < g_end ; i++) {
+    name = PQgetvalue(res_geom, i, 2);
+    if (l->include_items && !in_list_str(l->include_items, name)) continue;
+    if (l->exclude_items && in_list_str(l->exclude_items, name)) continue;
+
+    if (atoi(PQgetvalue(res_geom, i, 5)) != kind) {
+      kind = atoi(PQgetvalue(res_geom, i, 5));
+      l->storage->srid = atoi(PQgetvalue(res_geom, i, 3));
+      l->storage->is_geographic = PQgetvalue(res_geom, i, 6)[0] != 't';
+    }
+    list_add_str(l->storage->geom_columns, name);
+  }
+
+  ows_storage_bulk_find(res_attr, l->storage, &first, &end);
+
+  /* Layer could have no Pkey indeed... (An SQL view for example) */
+  for (i = first, pkeys = 0 ; i < end ; i++)
+    if (PQgetvalue(res_attr, i, 6)[0] == 't') pkeys++;
+
+  if (l->pkey) {
+    /*TODO check the column (l->pkey) in the table */
+    l->storage->pkey = buffer_init();
+    buffer_copy(l->storage->pkey, l->pkey);
+  } else if (pkeys == 1) {
+    for (i = first ; PQgetvalue(res_attr, i, 6)[0] != 't' ; i++);
+    l->storage->pkey = buffer_from_str(PQgetvalue(res_attr, i, 2));
+  }
+
+  for (i = first ; l->storage->pkey && i < end ; i++) {
+    if (!buffer_cmp(l->storage->pkey, PQgetvalue(res_attr, i, 2))) continue;
+    if (strlen(PQgetvalue(res_attr, i, 7)) > 0)
+      l->storage->pkey_default = buffer_from_str(PQgetvalue(res_attr, i, 7));
+    break;
+  }
+
+  for (i = first ; i < end ; i++) {
+    name = PQgetvalue(res_attr, i, 2);
+
+    if (atoi(PQgetvalue(res_attr, i, 4)) > 0 && PQgetvalue(res_attr, i, 5)[0] == 't') {
+      if (!l->storage->not_null_columns) l->storage->not_null_columns = list_init();
+      list_add_str(l->storage->not_null_columns, name);
+    }
+
+    if (l->include_items) {
+      if (!in_list_str(l->include_items, name)
+          && !(l->include_items->first && l->storage->pkey && buffer_cmp(l->storage->pkey, name)))
+        continue;
+    } else if (atoi(PQgetvalue(res_attr, i, 4)) <= 0) continue;
+
+    b = buffer_from_str(name);
+    t = buffer_from_str(PQgetvalue(res_attr, i, 3));
+
+    /* If the column is a geometry, get its real geometry type */
+    if (buffer_cmp(t, "geometry")) {
+      for (j = g_first ; j < g_end ; j++)
+        if (atoi(PQgetvalue(res_geom, j, 5)) == 1 && !strcmp(PQgetvalue(res_geom, j, 2), name)) break;
+
+      if (j == g_end) {
+        buffer_free(b);
+        buffer_free(t);
+        ows_error(o, OWS_ERROR_REQUEST_SQL_FAILED,
+                  "Unable to access geometry_columns table, try Populate_Geometry_Columns()", "fill_attributes");
+        return;
+      }
+
+      buffer_empty(t);
+      buffer_add_str(t, PQgetvalue(res_geom, j, 4));
+    }
+
+    array_add(l->storage->attributes, b, t);
+  }
+}
+
+
+/*
+ * Retrieve pkey sequences of all filled layers in a single query
+ */
+static void ows_storage_bulk_fill_sequences(ows * o)
+{
+  ows_layer_node *ln;
+  buffer *sql;
+  PGresult *res;
+  int i;
+
+  assert(o);
+
+  sql = buffer_init();
+  buffer_add_str(sql, "SELECT pg_get_serial_sequence(v.s || '.\"' || v.t || '\"', v.c) FROM (VALUES ");
+  for (i = 0, ln = o->layers->first ; ln ; ln = ln->next) {
+    if (!ln->layer->storage || !ln->layer->storage->pkey) continue;
+    if (i) buffer_add_str(sql, ", ");
+    buffer_add_str(sql, "(");
+    buffer_add_int(sql, i++);
+    buffer_add_str(sql, ", '");
+    buffer_copy(sql, ln->layer->storage->schema);
+    buffer_add_str(sql, "', '");
+    buffer_copy(sql, ln->layer->storage->table);
+    buffer_add_str(sql, "', '");
+    buffer_copy(sql, ln->layer->storage->pkey);
+    buffer_add_str(sql, "')");
+  }
+  buffer_add_str(sql, ") AS v(i, s, t, c) ORDER BY v.i");
+
+  if (!i) {
+    buffer_free(sql);
+    return;
+  }
+
+  res = ows_psql_exec(o, sql->buf);
+  buffer_free(sql);
+
+  if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != i) {
+    PQclear(res);
+    ows_error(o, OWS_ERROR_REQUEST_SQL_FAILED,
+              "Unable to use pg_get_serial_sequence.", "pkey_sequence retrieve");
+    return;
+  }
+
+  /* Even if no sequence found, this function return an empty row
+   * so we must check that result string returned > 0 char
+   */
+  for (i = 0, ln = o->layers->first ; ln ; ln = ln->next) {
+    if (!ln->layer->storage || !ln->layer->storage->pkey) continue;
+
+    if (ln->layer->pkey_sequence) {
+      ln->layer->storage->pkey_sequence = buffer_init();
+      buffer_copy(ln->layer->storage->pkey_sequence, ln->layer->pkey_sequence);
+    } else if (strlen(PQgetvalue(res, i, 0)) > 0)
+      ln->layer->storage->pkey_sequence = buffer_from_str(PQgetvalue(res, i, 0));
+    i++;
+  }
+
+  PQclear(res);
+}
+
+
+/*
+ * Fill all layers storage with a handful of set-based catalog queries,
+ * rather than several queries per layer
+ */
+static void ows_layers_storage_bulk_fill(ows * o)
+{
+  PGresult *res_geom, *res_attr, *res_t;
+  ows_layer_node *ln;
+  buffer *sql;
+  int first, end;
+
+  assert(o);
+  assert(o->layers);
+
+  if (!o->layers->first) return;
+
+  sql = buffer_init();
+  ows_storage_bulk_tables(o, sql);
+  buffer_add_str(sql, "SELECT g.f_table_schema::text, g.f_table_name::text, g.f_geometry_column::text, g.srid, g.type, 1,");
+  buffer_add_str(sql, " EXISTS (SELECT 1 FROM spatial_ref_sys s WHERE s.srid = g.srid AND s.proj4text LIKE '%units=m%')");
+  buffer_add_str(sql, " FROM geometry_columns g, l WHERE g.f_table_schema = l.s AND g.f_table_name = l.t");
+  buffer_add_str(sql, " UNION ALL ");
+  buffer_add_str(sql, "SELECT g.f_table_schema::text, g.f_table_name::text, g.f_geography_column::text, g.srid, g.type, 2,");
+  buffer_add_str(sql, " EXISTS (SELECT 1 FROM spatial_ref_sys s WHERE s.srid = g.srid AND s.proj4text LIKE '%units=m%')");
+  buffer_add_str(sql, " FROM geography_columns g, l WHERE g.f_table_schema = l.s AND g.f_table_name = l.t");
+  buffer_add_str(sql, " ORDER BY 1 COLLATE \"C\", 2 COLLATE \"C\", 6");
+  res_geom = ows_psql_exec(o, sql->buf);
+
+  if (PQresultStatus(res_geom) != PGRES_TUPLES_OK) {
+    PQclear(res_geom);
+    buffer_free(sql);
+    ows_error(o, OWS_ERROR_REQUEST_SQL_FAILED, "Unable to access geometry_columns table.", "bulk storage fill");
+    return;
+  }
+
+  /* Pkey detection is restricted to owned tables, as information_schema does */
+  buffer_empty(sql);
+  ows_storage_bulk_tables(o, sql);
+  buffer_add_str(sql, "SELECT n.nspname::text, c.relname::text, a.attname::text, t.typname::text, a.attnum, a.attnotnull,");
+  buffer_add_str(sql, " pg_has_role(c.relowner, 'USAGE') AND EXISTS (SELECT 1 FROM pg_constraint k");
+  buffer_add_str(sql, " WHERE k.conrelid = c.oid AND k.contype = 'p' AND a.attnum = ANY (k.conkey)),");
+  buffer_add_str(sql, " pg_get_expr(d.adbin, d.adrelid)");
+  buffer_add_str(sql, " FROM l JOIN pg_namespace n ON n.nspname = l.s");
+  buffer_add_str(sql, " JOIN pg_class c ON c.relnamespace = n.oid AND c.relname = l.t");
+  buffer_add_str(sql, " JOIN pg_attribute a ON a.attrelid = c.oid JOIN pg_type t ON a.atttypid = t.oid");
+  buffer_add_str(sql, " LEFT JOIN pg_attrdef d ON d.adrelid = a.attrelid AND d.adnum = a.attnum");
+  buffer_add_str(sql, " ORDER BY 1 COLLATE \"C\", 2 COLLATE \"C\", a.attnum");
+  res_attr = ows_psql_exec(o, sql->buf);
+
+  if (PQresultStatus(res_attr) != PGRES_TUPLES_OK) {
+    PQclear(res_geom);
+    PQclear(res_attr);
+    buffer_free(sql);
+    ows_error(o, OWS_ERROR_REQUEST_SQL_FAILED, "Unable to access pg_* tables.", "bulk storage fill");
+    return;
+  }
+
+  buffer_empty(sql);
+  ows_storage_bulk_tables(o, sql);
+  buffer_add_str(sql, "SELECT table_schema::text, table_name::text FROM information_schema.tables, l");
+  buffer_add_str(sql, " WHERE table_schema = l.s AND table_name = l.t ORDER BY 1 COLLATE \"C\", 2 COLLATE \"C\"");
+  res_t = ows_psql_exec(o, sql->buf);
+  buffer_free(sql);
+
+  if (PQresultStatus(res_t) != PGRES_TUPLES_OK) {
+    PQclear(res_geom);
+    PQclear(res_attr);
+    PQclear(res_t);
+    ows_error(o, OWS_ERROR_REQUEST_SQL_FAILED, "Unable to access information_schema.tables.", "bulk storage fill");
+    return;
+  }
+
+  for (ln = o->layers->first ; ln ; ln = ln->next) {
+    if (   !ows_storage_bulk_find(res_geom, ln->layer->storage, &first, &end)
+        && !ows_storage_bulk_find(res_t, ln->layer->storage, &first, &end)) {
+      ows_layer_storage_free(ln->layer->storage);
+      ln->layer->storage = NULL;
+      continue;
+    }
+
+    ows_storage_bulk_fill_layer(o, ln->layer, res_geom, res_attr);
+    if (o->exit) break;
+  }
+
+  PQclear(res_geom);
+  PQclear(res_attr);
+  PQclear(res_t);
+
+  if (!o->exit) ows_storage_bulk_fill_sequences(o);
+}
+
+
+static void ows_layers_storage_introspect(ows * o)
 {
   PGresult *res, *res_g;
   ows_layer_node *ln;
@@ -487,6 +797,11 @@ void ows_layers_storage_fill(ows * o)
   assert(o);
   assert(o->layers);
 
+  if (o->bulk_introspection) {
+    ows_layers_storage_bulk_fill(o);
+    return;
+  }
+
   sql = buffer_init();
   buffer_add_str(sql, "SELECT DISTINCT f_table_schema, f_table_name FROM geometry_columns");
   res = ows_psql_exec(o, sql->buf);
@@ -548,3 +863,29 @@ void ows_layers_storage_fill(ows * o)
   PQclear(res);
   PQclear(res_g);
 }
+
+
+/*
+ * Fill all layers storage, from the snapshot file if one is
+ * configured and still valid, rebuilding it otherwise
+ */
+void ows_layers_storage_fill(ows * o)
+{
+  buffer *fingerprint = NULL;
+
+  assert(o);
+  assert(o->layers);
+
+  if (o->storage_snapshot) {
+    fingerprint = ows_storage_snapshot_fingerprint(o);
+    if (fingerprint && ows_storage_snapshot_load(o, fingerprint)) {
+      buffer_free(fingerprint);
+      return;
+    }
+  }
+
+  ows_layers_storage_introspect(o);
+
+  if (fingerprint && !o->exit) ows_storage_snapshot_save(o, fingerprint);
+  if (fingerprint) buffer_free(fingerprint);
+}
@@ -0,0 +1,481 @@
+/*
+  Copyright (c) <2007-2012> <Barbara Philippot - Olivier Courtin>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "ows.h"
+
+
+/*
+ * Layer storage snapshot file layout (native byte order):
+ *   "TOWS" version:u32 key:u64 layers:u32
+ *   for each layer, in config order:
+ *     present:u32 [schema table srid:i32 is_geographic:u32 geom_columns
+ *                  pkey pkey_sequence pkey_default attributes not_null_columns]
+ * Strings are u32 length + bytes (OWS_SNAPSHOT_NULL for a NULL buffer),
+ * lists are u32 count + strings, arrays u32 count + key/value strings.
+ */
+#define OWS_SNAPSHOT_MAGIC   "TOWS"
+#define OWS_SNAPSHOT_VERSION 1
+#define OWS_SNAPSHOT_NULL    0xFFFFFFFFU
+
+
+typedef struct {
+  const unsigned char *p;
+  const unsigned char *end;
+} ows_snapshot_reader;
+
+
+static uint64_t ows_snapshot_hash_str(uint64_t hash, const char *str, size_t len)
+{
+  size_t i;
+
+  /* FNV-1a, each string is terminated to avoid ambiguous concatenations */
+  for (i = 0 ; i < len ; i++) {
+    hash ^= (unsigned char) str[i];
+    hash *= 1099511628211ULL;
+  }
+  hash ^= 0xFF;
+  hash *= 1099511628211ULL;
+
+  return hash;
+}
+
+
+static uint64_t ows_snapshot_hash_list(uint64_t hash, const list * l)
+{
+  list_node *ln;
+
+  if (!l) return ows_snapshot_hash_str(hash, "", 0);
+
+  for (ln = l->first ; ln ; ln = ln->next)
+    hash = ows_snapshot_hash_str(hash, ln->value->buf, ln->value->use);
+
+  return ows_snapshot_hash_str(hash, "", 0);
+}
+
+
+/*
+ * Hash of the layers config the storage is built from
+ * Taken before introspection, which drops the storage of missing tables
+ */
+static uint64_t ows_snapshot_layers_hash(const ows * o)
+{
+  ows_layer_node *ln;
+  ows_layer *l;
+  uint64_t hash = 14695981039346656037ULL;
+
+  for (ln = o->layers->first ; ln ; ln = ln->next) {
+    l = ln->layer;
+    if (l->storage) {
+      hash = ows_snapshot_hash_str(hash, l->storage->schema->buf, l->storage->schema->use);
+      hash = ows_snapshot_hash_str(hash, l->storage->table->buf, l->storage->table->use);
+    } else hash = ows_snapshot_hash_str(hash, "", 0);
+    hash = ows_snapshot_hash_list(hash, l->include_items);
+    hash = ows_snapshot_hash_list(hash, l->exclude_items);
+    hash = ows_snapshot_hash_str(hash, l->pkey ? l->pkey->buf : "", l->pkey ? l->pkey->use : 0);
+    hash = ows_snapshot_hash_str(hash, l->pkey_sequence ? l->pkey_sequence->buf : "",
+                                 l->pkey_sequence ? l->pkey_sequence->use : 0);
+  }
+
+  return hash;
+}
+
+
+/*
+ * Storage fingerprint: changes as soon as a DDL statement touches
+ * a relation, a column, a constraint or a default value, as soon as
+ * spatial_ref_sys rows change (layers is_geographic comes from them)
+ * or as soon as the layers config changes
+ */
+buffer *ows_storage_snapshot_fingerprint(ows * o)
+{
+  PGresult *res;
+  buffer *fp;
+  char layers[20];
+
+  assert(o);
+
+  res = ows_psql_exec(o, "SELECT current_database()"
+                      " || ':' || (SELECT count(*) || ':' || coalesce(max(xmin::text::bigint), 0) FROM pg_class)"
+                      " || ':' || (SELECT count(*) || ':' || coalesce(max(xmin::text::bigint), 0) FROM pg_attribute)"
+                      " || ':' || (SELECT count(*) || ':' || coalesce(max(xmin::text::bigint), 0) FROM pg_constraint)"
+                      " || ':' || (SELECT count(*) || ':' || coalesce(max(xmin::text::bigint), 0) FROM pg_attrdef)"
+                      " || ':' || (SELECT count(*) || ':' || coalesce(max(xmin::text::bigint), 0) FROM spatial_ref_sys)");
+
+  if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1) {
+    PQclear(res);
+    return NULL;
+  }
+
+  fp = buffer_from_str(PQgetvalue(res, 0, 0));
+  PQclear(res);
+
+  sprintf(layers, ":%016llx", (unsigned long long) ows_snapshot_layers_hash(o));
+  buffer_add_str(fp, layers);
+
+  return fp;
+}
+
+
+/*
+ * Snapshot key: the storage fingerprint and the database
+ */
+static uint64_t ows_snapshot_key(const ows * o, const buffer * fingerprint)
+{
+  uint64_t hash = 14695981039346656037ULL;
+
+  hash = ows_snapshot_hash_str(hash, fingerprint->buf, fingerprint->use);
+  hash = ows_snapshot_hash_str(hash, o->pg_dsn->buf, o->pg_dsn->use);
+
+  return hash;
+}
+
+
+static void ows_snapshot_write_u32(FILE * f, uint32_t v)
+{
+  fwrite(&v, sizeof(v), 1, f);
+}
+
+
+static void ows_snapshot_write_buffer(FILE * f, const buffer * b)
+{
+  if (!b) {
+    ows_snapshot_write_u32(f, OWS_SNAPSHOT_NULL);
+    return;
+  }
+
+  ows_snapshot_write_u32(f, (uint32_t) b->use);
+  fwrite(b->buf, 1, b->use, f);
+}
+
+
+static void ows_snapshot_write_list(FILE * f, const list * l)
+{
+  list_node *ln;
+
+  if (!l) {
+    ows_snapshot_write_u32(f, OWS_SNAPSHOT_NULL);
+    return;
+  }
+
+  ows_snapshot_write_u32(f, (uint32_t) l->size);
+  for (ln = l->first ; ln ; ln = ln->next)
+    ows_snapshot_write_buffer(f, ln->value);
+}
+
+
+static void ows_snapshot_write_array(FILE * f, const array * a)
+{
+  array_node *an;
+  uint32_t size;
+
+  for (size = 0, an = a->first ; an ; an = an->next) size++;
+
+  ows_snapshot_write_u32(f, size);
+  for (an = a->first ; an ; an = an->next) {
+    ows_snapshot_write_buffer(f, an->key);
+    ows_snapshot_write_buffer(f, an->value);
+  }
+}
+
+
+/*
+ * Write layers storage into the snapshot file
+ * File is written aside then renamed, so concurrent workers
+ * never read a partial snapshot
+ */
+void ows_storage_snapshot_save(ows * o, const buffer * fingerprint)
+{
+  ows_layer_node *ln;
+  ows_layer_storage *s;
+  buffer *path;
+  uint64_t key;
+  uint32_t size;
+  bool error;
+  FILE *f;
+
+  assert(o);
+  assert(o->storage_snapshot);
+  assert(fingerprint);
+
+  path = buffer_init();
+  buffer_copy(path, o->storage_snapshot);
+  buffer_add_str(path, ".tmp");
+#ifndef _WIN32
+  buffer_add(path, '.');
+  buffer_add_int(path, (int) getpid());
+#endif
+
+  f = fopen(path->buf, "wb");
+  if (!f) {
+    ows_log(o, 1, "Unable to write layer storage snapshot");
+    buffer_free(path);
+    return;
+  }
+
+  for (size = 0, ln = o->layers->first ; ln ; ln = ln->next) size++;
+  key = ows_snapshot_key(o, fingerprint);
+
+  fwrite(OWS_SNAPSHOT_MAGIC, 1, 4, f);
+  ows_snapshot_write_u32(f, OWS_SNAPSHOT_VERSION);
+  fwrite(&key, sizeof(key), 1, f);
+  ows_snapshot_write_u32(f, size);
+
+  for (ln = o->layers->first ; ln ; ln = ln->next) {
+    s = ln->layer->storage;
+    ows_snapshot_write_u32(f, s ? 1 : 0);
+    if (!s) continue;
+
+    ows_snapshot_write_buffer(f, s->schema);
+    ows_snapshot_write_buffer(f, s->table);
+    ows_snapshot_write_u32(f, (uint32_t) s->srid);
+    ows_snapshot_write_u32(f, s->is_geographic ? 1 : 0);
+    ows_snapshot_write_list(f, s->geom_columns);
+    ows_snapshot_write_buffer(f, s->pkey);
+    ows_snapshot_write_buffer(f, s->pkey_sequence);
+    ows_snapshot_write_buffer(f, s->pkey_default);
+    ows_snapshot_write_array(f, s->attributes);
+    ows_snapshot_write_list(f, s->not_null_columns);
+  }
+
+  error = ferror(f) ? true : false;
+  if (fclose(f)) error = true;
+
+  if (error || rename(path->buf, o->storage_snapshot->buf)) {
+    ows_log(o, 1, "Unable to write layer storage snapshot");
+    remove(path->buf);
+  }
+
+  buffer_free(path);
+}
+
+
+static bool ows_snapshot_read_u32(ows_snapshot_reader * r, uint32_t * v)
+{
+  if (r->end - r->p < (long) sizeof(*v)) return false;
+
+  memcpy(v, r->p, sizeof(*v));
+  r->p += sizeof(*v);
+
+  return true;
+}
+
+
+/*
+ * Read a string, *b is set to NULL for a NULL buffer
+ */
+static bool ows_snapshot_read_buffer(ows_snapshot_reader * r, buffer ** b)
+{
+  uint32_t len;
+
+  *b = NULL;
+  if (!ows_snapshot_read_u32(r, &len)) return false;
+  if (len == OWS_SNAPSHOT_NULL) return true;
+  if ((uint32_t) (r->end - r->p) < len) return false;
+
+  *b = buffer_init();
+  buffer_add_nstr(*b, (const char *) r->p, len);
+  r->p += len;
+
+  return true;
+}
+
+
+static bool ows_snapshot_read_list(ows_snapshot_reader * r, list ** l)
+{
+  uint32_t size, i;
+  buffer *b;
+
+  *l = NULL;
+  if (!ows_snapshot_read_u32(r, &size)) return false;
+  if (size == OWS_SNAPSHOT_NULL) return true;
+
+  *l = list_init();
+  for (i = 0 ; i < size ; i++) {
+    if (!ows_snapshot_read_buffer(r, &b) || !b) return false;
+    list_add(*l, b);
+  }
+
+  return true;
+}
+
+
+static bool ows_snapshot_read_storage(ows_snapshot_reader * r, ows_layer_storage * s)
+{
+  uint32_t size, i, v;
+  buffer *key, *value;
+
+  buffer_free(s->schema);
+  buffer_free(s->table);
+  list_free(s->geom_columns);
+  s->schema = s->table = NULL;
+  s->geom_columns = NULL;
+
+  if (!ows_snapshot_read_buffer(r, &s->schema) || !s->schema) return false;
+  if (!ows_snapshot_read_buffer(r, &s->table) || !s->table) return false;
+  if (!ows_snapshot_read_u32(r, &v)) return false;
+  s->srid = (int32_t) v;
+  if (!ows_snapshot_read_u32(r, &v)) return false;
+  s->is_geographic = v ? true : false;
+  if (!ows_snapshot_read_list(r, &s->geom_columns) || !s->geom_columns) return false;
+  if (!ows_snapshot_read_buffer(r, &s->pkey)) return false;
+  if (!ows_snapshot_read_buffer(r, &s->pkey_sequence)) return false;
+  if (!ows_snapshot_read_buffer(r, &s->pkey_default)) return false;
+
+  if (!ows_snapshot_read_u32(r, &size)) return false;
+  for (i = 0 ; i < size ; i++) {
+    if (!ows_snapshot_read_buffer(r, &key) || !key) return false;
+    if (!ows_snapshot_read_buffer(r, &value) || !value) {
+      buffer_free(key);
+      return false;
+    }
+    array_add(s->attributes, key, value);
+  }
+
+  return ows_snapshot_read_list(r, &s->not_null_columns);
+}
+
+
+/*
+ * Fill layers storage from a mapped snapshot
+ * Layers are left untouched if the snapshot doesn't match
+ */
+static bool ows_snapshot_read(ows * o, const buffer * fingerprint, ows_snapshot_reader * r)
+{
+  ows_layer_storage **storages;
+  ows_layer_node *ln;
+  uint32_t version, size, present, i;
+  uint64_t key;
+  bool ok = true;
+
+  if (r->end - r->p < 4 || memcmp(r->p, OWS_SNAPSHOT_MAGIC, 4)) return false;
+  r->p += 4;
+
+  if (!ows_snapshot_read_u32(r, &version) || version != OWS_SNAPSHOT_VERSION) return false;
+  if (r->end - r->p < (long) sizeof(key)) return false;
+  memcpy(&key, r->p, sizeof(key));
+  r->p += sizeof(key);
+  if (key != ows_snapshot_key(o, fingerprint)) return false;
+
+  for (i = 0, ln = o->layers->first ; ln ; ln = ln->next) i++;
+  if (!ows_snapshot_read_u32(r, &size) || size != i) return false;
+
+  storages = calloc(size ? size : 1, sizeof(ows_layer_storage *));
+  assert(storages);
+
+  for (i = 0, ln = o->layers->first ; ok && ln ; ln = ln->next, i++) {
+    if (!ows_snapshot_read_u32(r, &present)) ok = false;
+    else if (present) {
+      storages[i] = ows_layer_storage_init();
+      ok = ows_snapshot_read_storage(r, storages[i])
+           && ln->layer->storage
+           && buffer_cmp(storages[i]->schema, ln->layer->storage->schema->buf)
+           && buffer_cmp(storages[i]->table, ln->layer->storage->table->buf);
+    }
+  }
+
+  for (i = 0, ln = o->layers->first ; ln ; ln = ln->next, i++) {
+    if (!ok) {
+      if (storages[i]) ows_layer_storage_free(storages[i]);
+      continue;
+    }
+    ows_layer_storage_free(ln->layer->storage);
+    ln->layer->storage = storages[i];
+  }
+
+  free(storages);
+
+  return ok;
+}
+
+
+/*
+ * Fill layers storage from the snapshot file if it's still valid
+ * against the given catalog fingerprint
+ */
+bool ows_storage_snapshot_load(ows * o, const buffer * fingerprint)
+{
+  ows_snapshot_reader r;
+  bool ok;
+#ifndef _WIN32
+  struct stat st;
+  void *map;
+  int fd;
+#else
+  buffer *content;
+  char chunk[8192];
+  size_t n;
+  FILE *f;
+#endif
+
+  assert(o);
+  assert(o->storage_snapshot);
+  assert(fingerprint);
+
+#ifndef _WIN32
+  fd = open(o->storage_snapshot->buf, O_RDONLY);
+  if (fd == -1) return false;
+
+  if (fstat(fd, &st) || st.st_size == 0) {
+    close(fd);
+    return false;
+  }
+
+  map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return false;
+
+  r.p = map;
+  r.end = r.p + st.st_size;
+  ok = ows_snapshot_read(o, fingerprint, &r);
+  munmap(map, st.st_size);
+#else
+  f = fopen(o->storage_snapshot->buf, "rb");
+  if (!f) return false;
+
+  content = buffer_init();
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    buffer_add_nstr(content, chunk, n);
+  fclose(f);
+
+  r.p = (const unsigned char *) content->buf;
+  r.end = r.p + content->use;
+  ok = ows_snapshot_read(o, fingerprint, &r);
+  buffer_free(content);
+#endif
+
+  return ok;
+}
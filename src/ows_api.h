@@ -21,14 +21,24 @@
 */
 
 
+void arena_free (arena * a);
+void *arena_heap (void *(*alloc) (void));
+arena *arena_init (size_t chunk_size);
+void *arena_malloc (size_t size);
+void *arena_realloc (void *p, size_t size);
+void arena_release (void *p);
+void arena_reset (arena * a);
+arena *arena_use (arena * a);
 void array_add (array * a, buffer * key, buffer * value);
 void array_flush (const array * a, FILE * output);
 void array_free (array * a);
 buffer *array_get (const array * a, const char *key);
 buffer *array_get_key(const array * a, const char *value);
+int array_index (const array * a, const char *key);
 array *array_init ();
 bool array_is_key (const array * a, const char *key);
 bool array_is_value (const array * a, const char *value);
+unsigned int array_key_hash (const char *key);
 alist *alist_init();
 void alist_free(alist * al);
 void alist_add(alist * al, buffer * key, buffer * value);
@@ -62,9 +72,14 @@ long int buffer_rchr(const buffer * buf, char c);
 buffer *buffer_encode_xml_entities_str(const char *str);
 buffer *buffer_encode_json_str(const char *str);
 buffer *cgi_add_xml_into_buffer (buffer * element, xmlNodePtr n);
+void cgi_add_xml_ns (xmlNodePtr n);
 char *cgi_getback_query (ows * o);
+void cgi_stream_free (cgi_stream * s);
+int cgi_stream_read (void * ctx, char * buf, int len);
 bool cgi_method_get ();
 bool cgi_method_post ();
+bool cgi_kvp_key_char (char c);
+bool cgi_kvp_value_char (char c, bool filter);
 array *cgi_parse_kvp (ows * o, char *query);
 array *cgi_parse_xml (ows * o, char *query);
 bool check_regexp (const char *str_request, const char *str_regex);
@@ -74,6 +89,7 @@ void fe_error (ows * o, filter_encoding * fe);
 buffer *fe_expression (ows * o, buffer * typename, filter_encoding * fe, buffer * sql, xmlNodePtr n);
 buffer *fe_feature_id (ows * o, buffer * typename, filter_encoding * fe, xmlNodePtr n);
 filter_encoding *fe_filter (ows * o, filter_encoding * fe, buffer * typename, buffer * xmlchar);
+filter_encoding *fe_filter_node (ows * o, filter_encoding * fe, buffer * typename, xmlNodePtr filter);
 void fe_filter_capabilities_100 (const ows * o);
 void fe_filter_capabilities_110 (const ows * o);
 buffer *fe_function (ows * o, buffer * typename, filter_encoding * fe, buffer * sql, xmlNodePtr n);
@@ -83,6 +99,7 @@ bool fe_is_spatial_op (char *name);
 buffer *fe_kvp_bbox (ows * o, wfs_request * wr, buffer * layer_name, ows_bbox * bbox);
 buffer *fe_kvp_featureid (ows * o, wfs_request * wr, buffer * layer_name, list * fid);
 buffer *fe_logical_op (ows * o, buffer * typename, filter_encoding * fe, xmlNodePtr n);
+bool fe_optimized_filter (ows * o, buffer * typename, filter_encoding * fe, xmlNodePtr n);
 void fe_node_flush (xmlNodePtr node, FILE * output);
 buffer *fe_property_name (ows * o, buffer * typename, filter_encoding * fe, buffer * sql, xmlNodePtr n, bool check_geom_column, bool mandatory);
 buffer *fe_spatial_op (ows * o, buffer * typename, filter_encoding * fe, xmlNodePtr n);
@@ -118,6 +135,10 @@ mlist *mlist_init ();
 void mlist_node_free (mlist * ml, mlist_node * mln);
 mlist_node *mlist_node_init ();
 ows_bbox *ows_bbox_boundaries (ows * o, list * from, list * where, ows_srs * srs);
+ows_bbox *ows_bbox_boundaries_result (PGresult * res, ows_srs * srs);
+buffer *ows_bbox_boundaries_sql (ows * o, list * from, list * where, ows_srs * srs);
+void ows_bbox_envelope_to_srid(const buffer * envelope, int srid, buffer * query);
+void ows_bbox_to_srid_query(ows * o, const ows_bbox * bb, const buffer * envelope, int srid, buffer * query);
 void ows_bbox_flush (const ows_bbox * b, FILE * output);
 void ows_bbox_free (ows_bbox * b);
 ows_bbox *ows_bbox_init ();
@@ -130,6 +151,7 @@ void ows_contact_flush (ows_contact * contact, FILE * output);
 void ows_contact_free (ows_contact * contact);
 ows_contact *ows_contact_init ();
 void ows_error (ows * o, enum ows_error_code code, char *message, char *locator);
+int ows_ewkb_srid(const char *hex);
 void ows_flush (ows * o, FILE * output);
 void ows_free (ows * o);
 ows_geobbox *ows_geobbox_compute (ows * o, buffer * layer_name);
@@ -139,8 +161,10 @@ ows_geobbox *ows_geobbox_init ();
 ows_geobbox *ows_geobbox_copy(ows_geobbox *g);
 bool ows_geobbox_set (ows * o, ows_geobbox * g, double west, double east, double south, double north);
 bool ows_geobbox_set_from_bbox (ows * o, ows_geobbox * g, ows_bbox * bb);
+bool ows_geobbox_widen (ows * o, ows_geobbox * g, buffer * layer_name, const list * geoms);
 ows_geobbox *ows_geobbox_set_from_str (ows * o, ows_geobbox * g, char *str);
 void ows_get_capabilities_dcpt (const ows * o, const char * req);
+buffer *ows_gml_to_ewkb(xmlNodePtr n, int srid, bool flip);
 void ows_layer_flush (ows_layer * l, FILE * output);
 void ows_layer_free (ows_layer * l);
 bool ows_layer_in_list (const ows_layer_list * ll, buffer * name);
@@ -162,6 +186,9 @@ list *ows_layer_list_prefix_to_uri(ows_layer_list * ll, list * layer_name_prefix
 list *ows_layer_list_ns_prefix (ows_layer_list * ll, list * layer_name_prefix);
 bool ows_layer_list_retrievable (const ows_layer_list * ll);
 bool ows_layer_list_writable (const ows_layer_list * ll);
+ows_geobbox *ows_layer_extent (ows * o, ows_layer * l);
+void ows_layer_extent_reset (ows * o, buffer * layer_name);
+void ows_layer_extent_widen (ows * o, buffer * layer_name, const list * geoms);
 bool ows_layer_match_table (const ows * o, const buffer * name);
 void ows_layer_node_free (ows_layer_list * ll, ows_layer_node * ln);
 ows_layer_node *ows_layer_node_init ();
@@ -173,9 +200,45 @@ void ows_metadata_fill (ows * o, array * cgi);
 void ows_metadata_flush (ows_meta * metadata, FILE * output);
 void ows_metadata_free (ows_meta * metadata);
 ows_meta *ows_metadata_init ();
+void ows_output_buffer (const ows * o, const buffer * b);
+buffer *ows_output_capture (const ows * o, buffer * b);
+void ows_output_double (const ows * o, int precision, double d);
+void ows_output_flush (const ows * o);
+void ows_output_free (ows_output * out);
+ows_output *ows_output_init ();
+void ows_output_int (const ows * o, int i);
+void ows_output_nstr (const ows * o, const char *str, size_t n);
+void ows_output_printf (const ows * o, const char *format, ...);
+void ows_output_str (const ows * o, const char *str);
+void ows_output_xml (const ows * o, const char *str);
 void ows_parse_config (ows * o, const char *filename);
 ows_version * ows_psql_postgis_version(ows *o);
 PGresult * ows_psql_exec(ows *o, const char *sql);
+PGresult * ows_psql_exec_params(ows *o, const char *sql, const ows_psql_params *p);
+PGresult * ows_psql_cursor_open(ows *o, const char *sql);
+PGresult * ows_psql_cursor_result(ows *o);
+void ows_psql_cursor_send(ows *o, const char *sql);
+PGresult * ows_psql_pipeline_result(ows *o);
+void ows_psql_pipeline_send(ows *o, const char *sql);
+PGresult * ows_psql_cursor_next(ows *o, PGresult *res);
+Oid ows_psql_numeric_type(const char *value);
+void ows_psql_param_double(ows * o, buffer * sql, double d);
+void ows_psql_param_geometry(ows * o, buffer * sql, const char *hex);
+void ows_psql_param_numeric(ows * o, buffer * sql, const char *value);
+void ows_psql_param_str(ows * o, buffer * sql, const char *value);
+int ows_psql_params_add(ows_psql_params * p, const char *value, int length, int format, Oid type);
+ows_psql_params *ows_psql_params_bind(ows * o, const char *sql, buffer * bound);
+void ows_psql_params_free(ows_psql_params * p);
+ows_psql_params *ows_psql_params_init();
+void ows_psql_params_truncate(ows_psql_params * p, int size);
+PGresult *ows_psql_statement_exec(ows * o, const char *sql);
+void ows_psql_statement_failed(ows * o, const char *sql, const PGresult * res);
+bool ows_psql_statement_send(ows * o, const char *sql);
+void ows_psql_statements_free(ows_psql_statements * s);
+ows_psql_statements *ows_psql_statements_init(int max);
+void ows_psql_statements_log(ows * o);
+void ows_psql_statements_prepare(ows * o);
+void ows_psql_cursor_close(ows *o);
 buffer *ows_psql_column_name (ows * o, buffer * layer_name, int number);
 array *ows_psql_describe_table (ows * o, buffer * layer_name);
 list *ows_psql_geometry_column (ows * o, buffer * layer_name);
@@ -186,22 +249,33 @@ buffer *ows_psql_column_constraint_name(ows * o, buffer * column_name, buffer *
 list *ows_psql_column_check_constraint(ows * o, buffer * constraint_name);
 buffer *ows_psql_column_character_maximum_length(ows * o, buffer * column_name, buffer * table_name);
 bool ows_psql_is_geometry_column (ows * o, buffer * layer_name, buffer * column);
+int ows_psql_geometries_invalid(ows * o, list * geoms);
 bool ows_psql_is_geometry_valid(ows * o, buffer * geom);
 list *ows_psql_not_null_properties (ows * o, buffer * layer_name);
 buffer *ows_psql_timestamp_to_xml_time (char *timestamp);
 char *ows_psql_to_xsd (buffer * type, enum wfs_format format);
-bool ows_psql_is_numeric(buffer * type);
+bool ows_psql_is_numeric(enum ows_psql_type_code code);
 buffer *ows_psql_type (ows * o, buffer * layer_name, buffer * property);
+enum ows_psql_type_code ows_psql_type_code(const buffer * type);
+enum ows_psql_type_code ows_psql_column_type(ows * o, buffer * layer_name, const char *property);
 buffer *ows_psql_generate_id (ows * o, buffer * layer_name);
+list *ows_psql_generate_ids(ows * o, buffer * layer_name, int n);
 int ows_psql_number_features(ows * o, list * from, list * where);
 buffer * ows_psql_gml_to_sql(ows * o, xmlNodePtr n, const ows_srs* parent_srs);
+buffer * ows_psql_gml_to_sql_staged(ows * o, xmlNodePtr n, const ows_srs* parent_srs, list * staged);
 char *ows_psql_escape_string(ows *o, const char *content);
 int ows_psql_geometry_srid(ows *o, const char *geom);
 void ows_request_check (ows * o, ows_request * or, const array * cgi, const char *query);
 void ows_request_flush (ows_request * or, FILE * output);
 void ows_request_free (ows_request * or);
 ows_request *ows_request_init ();
+xmlSchemaPtr ows_schema_get (ows * o, buffer * xml_schema, bool schema_is_file, enum ows_schema_type schema_type);
+xmlSchemaValidCtxtPtr ows_schema_valid_ctxt (ows * o, buffer * xml_schema, bool schema_is_file, enum ows_schema_type schema_type);
+void ows_schema_valid_ctxt_release (ows * o, xmlSchemaValidCtxtPtr schema_ctx, enum ows_schema_type schema_type);
+ows_schema *ows_schema_find (const ows * o, enum ows_schema_type schema_type);
+void ows_schema_free (ows_schema * s);
 int ows_schema_validation (ows * o, buffer * xml_schema, buffer * xml, bool schema_is_file, enum ows_schema_type schema_type);
+int ows_schema_validation_doc (ows * o, buffer * xml_schema, xmlDocPtr doc, bool schema_is_file, enum ows_schema_type schema_type);
 void ows_service_identification (const ows * o);
 void ows_service_metadata (const ows * o);
 void ows_service_provider (const ows * o);
@@ -217,6 +291,10 @@ bool ows_srs_set_geobbox(ows * o, ows_srs * s);
 bool ows_srs_set (ows * o, ows_srs * c, const buffer * auth_name, int auth_srid);
 bool ows_srs_set_from_srid (ows * o, ows_srs * s, int srid);
 bool ows_srs_set_from_srsname(ows * o, ows_srs * s, const char *srsname);
+void ows_srs_cache_fill (ows * o);
+void ows_proj_free (ows_proj * p);
+bool ows_proj_transform_bounds (ows * o, int from, int to, double *xmin, double *ymin, double *xmax, double *ymax);
+void ows_srs_cache_free (ows_srs_cache * c);
 void ows_usage (ows * o);
 void ows_version_flush (ows_version * v, FILE * output);
 void ows_version_free (ows_version * v);
@@ -229,11 +307,17 @@ void wfs (ows * o, wfs_request * wf);
 void wfs_delete (ows * o, wfs_request * wr);
 void wfs_describe_feature_type (ows * o, wfs_request * wr);
 buffer * wfs_generate_schema(ows * o, ows_version * version);
+buffer * wfs_describe_schema(ows * o, list * typename);
 void wfs_error (ows * o, wfs_request * wf, enum wfs_error_code code, char *message, char *locator);
 void wfs_get_capabilities (ows * o, wfs_request * wr);
+void wfs_capabilities_cache_free (wfs_capabilities_cache * c);
+void wfs_capabilities_cache_reset (ows * o);
 void wfs_get_feature (ows * o, wfs_request * wr);
-void wfs_gml_feature_member (ows * o, wfs_request * wr, buffer * layer_name, list * properties, PGresult * res);
-void wfs_parse_operation (ows * o, wfs_request * wr, buffer * op);
+void wfs_gml_feature_member (ows * o, const wfs_gml_plan * plan, PGresult * res);
+void wfs_gml_plan_free (wfs_gml_plan * plan);
+wfs_gml_plan *wfs_gml_plan_init (ows * o, wfs_request * wr, buffer * layer_name, list * properties, PGresult * res);
+void wfs_parse_operation (ows * o, wfs_request * wr);
+void wfs_parse_operation_stream (ows * o, wfs_request * wr);
 void wfs_request_check (ows * o, wfs_request * wr, const array * cgi);
 void wfs_request_flush (wfs_request * wr, FILE * output);
 buffer *wfs_request_remove_prop_ns_prefix(ows * o, buffer * prop, list * layer_name);
@@ -244,7 +328,13 @@ void ows_layer_storage_free(ows_layer_storage * storage);
 void ows_layer_storage_flush(ows_layer_storage * storage, FILE * output);
 void ows_layers_storage_fill(ows * o);
 ows_layer * ows_layer_get(const ows_layer_list * ll, const buffer * name);
+ows_layer * ows_layer_get_by_id(const ows_layer_list * ll, int id);
+ows_layer * ows_layer_get_by_no_uri(const ows_layer_list * ll, const buffer * name_no_uri);
+ows_layer * ows_layer_get_by_prefix(const ows_layer_list * ll, const buffer * name_prefix);
 void ows_layers_storage_flush(ows * o, FILE * output);
+buffer *ows_storage_snapshot_fingerprint(ows * o);
+bool ows_storage_snapshot_load(ows * o, const buffer * fingerprint);
+void ows_storage_snapshot_save(ows * o, const buffer * fingerprint);
 void ows_log(ows *o, int log_level, const char *log);
 void ows_parse_config_mapfile(ows *o, const char *filename);
 bool ows_libxml_check_namespace(ows *o, xmlNodePtr n);
@@ -26,10 +26,29 @@
 
 #include <stdbool.h>
 #include <stdio.h>    /* FILE prototype */
+#include <time.h>     /* time_t */
 
 
 /* ========= Structures ========= */
 
+typedef struct Arena_chunk {
+  struct Arena_chunk * next;
+  size_t size;              /* bytes available after the chunk head */
+  size_t use;
+} arena_chunk;
+
+typedef struct Arena {
+  arena_chunk * chunks;     /* allocations are bumped from the first one */
+  size_t chunk_size;
+} arena;
+
+typedef struct Arena_header {
+  arena * owner;            /* NULL for an heap allocation */
+  size_t size;
+} arena_header;
+
+#define ARENA_CHUNK_SIZE   65536
+
 #define BUFFER_SIZE_INIT   256
 
 typedef struct Buffer {
@@ -72,9 +91,16 @@ typedef struct Alist_node {
   struct Alist_node * next;
 } alist_node;
 
+/* Containers get a hash index of their keys from this size */
+#define ARRAY_INDEX_MIN 16
+
 typedef struct Alist {
   alist_node * first;
   alist_node * last;
+  unsigned int size;
+  alist_node ** nodes;      /* by position, once indexed */
+  int * index;              /* open addressing table of positions (from 1) */
+  unsigned int buckets;
 } alist;
 
 
@@ -87,11 +113,32 @@ typedef struct Array_node {
 typedef struct Array {
   array_node * first;
   array_node * last;
+  unsigned int size;
+  array_node ** nodes;      /* by position, once indexed */
+  int * index;              /* open addressing table of positions (from 1) */
+  unsigned int buckets;
 } array;
 
 
 /* ========= OWS Common ========= */
 
+enum ows_psql_type_code {
+  OWS_PSQL_TYPE_OTHER,
+  OWS_PSQL_TYPE_BOOL,
+  OWS_PSQL_TYPE_INT2,
+  OWS_PSQL_TYPE_INT4,
+  OWS_PSQL_TYPE_INT8,
+  OWS_PSQL_TYPE_FLOAT4,
+  OWS_PSQL_TYPE_FLOAT8,
+  OWS_PSQL_TYPE_NUMERIC,   /* numeric, whatever its precision */
+  OWS_PSQL_TYPE_TEXT,
+  OWS_PSQL_TYPE_VARCHAR,
+  OWS_PSQL_TYPE_CHAR,      /* any other char or varchar like type */
+  OWS_PSQL_TYPE_HSTORE,
+  OWS_PSQL_TYPE_DATE,
+  OWS_PSQL_TYPE_TIMESTAMP  /* timestamp, timestamptz or datetime */
+};
+
 typedef struct Ows_layer_storage {
   buffer * schema;
   buffer * table;
@@ -105,6 +152,7 @@ typedef struct Ows_layer_storage {
                             whose base is geographic), false for a projected
                             CRS (or a compound CRS whose base is projected) */
   array * attributes;
+  enum ows_psql_type_code * attributes_type;  /* by attribute position, resolved on first use */
 } ows_layer_storage;
 
 typedef struct Ows_srs {
@@ -120,6 +168,8 @@ typedef struct Ows_srs {
                                         projected CRS, such as EPSG:32631)
                                         false for example for EPSG:4326 (WGS 84),
                                         EPSG:2393 (KKJ / Finland Uniform Coordinate System) */
+  double meters_per_unit;            /* linear unit of a projected CRS, in meters
+                                        (0 if unknown, or for a geographic CRS) */
 
   /* The two below fields are not properties of the SRS, but of its context
    * of use. */
@@ -130,6 +180,19 @@ typedef struct Ows_srs {
                                         be exported as a long URN */
 } ows_srs;
 
+typedef struct Ows_proj {
+  int from;
+  int to;
+  void * pj;                /* PROJ operation, NULL if PROJ can't do it */
+  struct Ows_proj * next;
+} ows_proj;
+
+typedef struct Ows_srs_cache {
+  ows_srs ** entries;       /* spatial_ref_sys rows already read, sorted by srid */
+  int size;
+  int max;
+} ows_srs_cache;
+
 
 typedef struct Ows_bbox {
   double xmin;
@@ -182,6 +245,8 @@ typedef struct Ows_layer {
   bool writable;
   list * srid;
   ows_geobbox * geobbox;
+  ows_geobbox * extent;     /* computed geobbox, kept in cache when extent_ttl is set */
+  time_t extent_time;       /* when extent was computed, 0 means not computed yet */
   buffer * abstract;
   list * keywords;
   list * exclude_items;
@@ -193,6 +258,7 @@ typedef struct Ows_layer {
   buffer * ns_uri;          /* value of the "ns_uri" attribute in the config, e.g. "http://www.tinyows.org/" */
   buffer * encoding;
   ows_layer_storage * storage;
+  int id;                   /* handle in the layer's list, from 1 (0 if not in a list) */
 } ows_layer;
 
 typedef struct Ows_layer_node {
@@ -201,10 +267,21 @@ typedef struct Ows_layer_node {
   struct Ows_layer_node * prev;
 } ows_layer_node;
 
+enum ows_layer_key {
+  OWS_LAYER_KEY_NAME,
+  OWS_LAYER_KEY_PREFIX,
+  OWS_LAYER_KEY_NO_URI,
+  OWS_LAYER_KEYS
+};
+
 typedef struct Ows_layer_list {
   ows_layer_node * first;
   ows_layer_node * last;
   unsigned int size;
+  ows_layer ** layers;          /* by handle, layers[id - 1] */
+  unsigned int max;
+  int * index[OWS_LAYER_KEYS];  /* open addressing tables of handles, one by key */
+  unsigned int buckets;         /* power of 2, at least twice the size */
 } ows_layer_list;
 
 
@@ -237,6 +314,11 @@ typedef struct Ows_contact {
   buffer * instructions;
 } ows_contact;
 
+enum ows_extent_delete {
+  OWS_EXTENT_DELETE_KEEP,   /* cached extent still covers remaining features */
+  OWS_EXTENT_DELETE_RESET   /* cached extent is computed again on next use */
+};
+
 enum ows_service {
   WMS,
   WFS,
@@ -318,8 +400,36 @@ typedef struct Wfs_request {
   int delete_results;
   int update_results;
 
+  alist * extent_geoms;     /* layer name -> inserted or updated geometries */
+  list * extent_reset;      /* layers whose cached extent is no more reliable */
+  list * valid_geoms;       /* geometries of the operation, validity still to check */
+
 } wfs_request;
 
+#define WFS_VALID_GEOMS_BATCH 256  /* streamed Insert geometries checked at once */
+
+enum wfs_gml_value {
+  WFS_GML_VALUE_SKIP,
+  WFS_GML_VALUE_RAW,
+  WFS_GML_VALUE_TEXT,
+  WFS_GML_VALUE_TIME,
+  WFS_GML_VALUE_BOOL
+};
+
+typedef struct Wfs_gml_column {
+  enum wfs_gml_value value;
+  buffer * open;            /* property start tag, indented */
+  buffer * close;           /* property end tag and newline */
+} wfs_gml_column;
+
+typedef struct Wfs_gml_plan {
+  int id_column;            /* -1 if there's no fid to display */
+  buffer * member_open;     /* feature start tag, up to the fid value */
+  buffer * member_close;
+  int nb_fields;
+  wfs_gml_column * columns; /* indexed as the result columns */
+} wfs_gml_plan;
+
 
 /* ========= FE ========= */
 
@@ -343,9 +453,38 @@ typedef struct Filter_encoding {
   bool in_not;
   bool is_numeric;
   buffer * sql;
+  ows_bbox * envelope;      /* last envelope parsed */
   enum fe_error_code error_code;
 } filter_encoding;
 
+enum fe_node_type {
+  FE_NODE_AND,
+  FE_NODE_OR,
+  FE_NODE_NOT,
+  FE_NODE_PREDICATE
+};
+
+enum fe_predicate {
+  FE_PREDICATE_OTHER,
+  FE_PREDICATE_EQUAL,       /* column = value */
+  FE_PREDICATE_LIKE,        /* value holds the prefix range condition */
+  FE_PREDICATE_BBOX,
+  FE_PREDICATE_SPATIAL
+};
+
+/* Filter tree, optimized before being written as SQL */
+typedef struct Fe_node {
+  enum fe_node_type type;
+  enum fe_predicate predicate;
+  buffer * sql;             /* predicate as SQL */
+  buffer * column;
+  buffer * value;
+  ows_bbox * bbox;
+  int cost;
+  struct Fe_node * first;   /* operands */
+  struct Fe_node * next;
+} fe_node;
+
 
 /* ========= OWS Request & Main ========= */
 
@@ -353,6 +492,8 @@ typedef struct Ows_request {
   ows_version * version;
   enum ows_method method;
   enum ows_service service;
+  xmlDocPtr doc;            /* XML request, parsed once */
+  bool doc_valid;           /* doc validated against the WFS schema */
   union {
     wfs_request * wfs;
   } request;
@@ -363,6 +504,82 @@ typedef struct Ows_request {
 
 #define OWS_MAX_DOUBLE 1e15  /* %f vs %g */
 
+#define OWS_OUTPUT_SIZE 65536
+
+typedef struct Ows_output {
+  char * buf;
+  size_t use;
+  size_t size;
+  buffer * capture;  /* when set, response is written there rather than to o->output */
+} ows_output;
+
+#define OWS_SCHEMA_POOL_MAX 4  /* validation contexts kept by schema */
+#define OWS_SCHEMA_DESCRIBE_URI "tinyows:DescribeFeatureType?typename="
+
+typedef struct Ows_schema {
+  enum ows_schema_type type;
+  xmlSchemaPtr schema;      /* compiled once, with the layers schemas */
+  xmlSchemaValidCtxtPtr * ctxts; /* validation contexts ready to be reused */
+  int size;
+  struct Ows_schema * next;
+} ows_schema;
+
+typedef struct Cgi_stream {
+  buffer * head;            /* input already read, given back first */
+  size_t head_read;
+  size_t left;              /* input still to read */
+} cgi_stream;
+
+/* Same types PostgreSQL gives to the literals */
+#define OWS_PSQL_OID_UNKNOWN 0
+#define OWS_PSQL_OID_INT4    23
+#define OWS_PSQL_OID_INT8    20
+#define OWS_PSQL_OID_FLOAT8  701
+#define OWS_PSQL_OID_NUMERIC 1700
+
+typedef struct Ows_psql_params {
+  char ** values;           /* text, or binary when format is 1 */
+  int * lengths;
+  int * formats;
+  Oid * types;
+  int size;
+  int max;
+} ows_psql_params;
+
+enum ows_psql_statement_state {
+  OWS_PSQL_STATEMENT_PENDING,   /* not prepared yet (seen in pipeline mode) */
+  OWS_PSQL_STATEMENT_PREPARED,  /* exists on the server side */
+  OWS_PSQL_STATEMENT_FAILED     /* can't be prepared, request executed as is */
+};
+
+typedef struct Ows_psql_statement {
+  buffer * sql;             /* request, literals replaced by parameters */
+  int id;                   /* prepared as tinyows_stmt_<id> */
+  unsigned long used;       /* LRU clock value of the last use */
+  enum ows_psql_statement_state state;
+  Oid * types;              /* parameters types, to prepare a pending statement */
+  int params;
+} ows_psql_statement;
+
+typedef struct Ows_psql_statements {
+  ows_psql_statement * entries;
+  int size;
+  int max;
+  int * stale;              /* ids of evicted statements, still to deallocate */
+  int stale_size;
+  int next_id;
+  unsigned long clock;
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long evictions;
+} ows_psql_statements;
+
+typedef struct Wfs_capabilities_cache {
+  buffer * doc;             /* rendered document, without HTTP headers */
+  buffer * etag;
+  time_t time;              /* when doc was rendered, 0 means not valid */
+} wfs_capabilities_cache;
+
 typedef struct Ows {
   bool init;
   bool exit;
@@ -380,6 +597,20 @@ typedef struct Ows {
   buffer * log_file;
 
   FILE* output;
+  ows_output * out;         /* response buffer, written to output when flushed */
+  int stream_transaction;   /* min POST size of a Transaction read as a stream, 0 to disable */
+  cgi_stream * stream;      /* POST input of the current streamed Transaction */
+  list * pipeline;          /* statements sent, whose results are not read yet */
+  int statement_cache;      /* max prepared statements, 0 to disable */
+  ows_psql_statements * statements;
+  ows_srs_cache * srs_cache; /* kept for the process life */
+  ows_proj * proj;          /* coordinate operations, by srid pair */
+  int bulk_insert;          /* max rows of a Transaction INSERT, 0 to disable */
+  bool bind_parameters;     /* client values sent as parameters, not in SQL text */
+  bool native_gml;          /* GML geometries parsed in process, not by PostGIS */
+  bool request_arena;       /* containers of a request allocated in an arena */
+  arena * arena;            /* reset after each request, NULL if disabled */
+  ows_psql_params * params; /* values of the current request placeholders */
 
   ows_meta * metadata;
   ows_contact * contact;
@@ -388,11 +619,17 @@ typedef struct Ows {
   int meter_precision;
 
   int max_features;
+  int fetch_size;
   ows_geobbox * max_geobbox;
 
   bool display_bbox;
   bool expose_pk;
   bool estimated_extent;
+  bool bulk_introspection;
+  bool optimize_filter;
+  buffer * storage_snapshot;
+  int extent_ttl;
+  enum ows_extent_delete extent_delete;
 
   bool check_schema;
   bool check_valid_geom;
@@ -404,8 +641,12 @@ typedef struct Ows {
   ows_version * wfs_default_version;
   ows_version * postgis_version;
 
-  xmlSchemaPtr  schema_wfs_100;
-  xmlSchemaPtr  schema_wfs_110;
+  ows_schema * schemas;      /* compiled schemas, kept for the process life */
+  xmlParserCtxtPtr xml_ctxt; /* reused from a request to another, with its dictionary */
+
+  int capabilities_ttl;
+  wfs_capabilities_cache * capabilities_wfs_100;
+  wfs_capabilities_cache * capabilities_wfs_110;
 } ows;
 
 #endif /* OWS_STRUCT_H */
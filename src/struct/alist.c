@@ -40,11 +40,15 @@ alist *alist_init()
 {
   alist *al = NULL;
 
-  al = malloc(sizeof(alist));
+  al = arena_malloc(sizeof(alist));
   assert(al);
 
   al->first = NULL;
   al->last = NULL;
+  al->size = 0;
+  al->nodes = NULL;
+  al->index = NULL;
+  al->buckets = 0;
 
   return al;
 }
@@ -66,15 +70,81 @@ void alist_free(alist * al)
 
     buffer_free(an_to_free->key);
     list_free(an_to_free->value);
-    free(an_to_free);
+    arena_release(an_to_free);
     an_to_free = NULL;
   }
 
-  free(al);
+  arena_release(al->nodes);
+  arena_release(al->index);
+  arena_release(al);
   al = NULL;
 }
 
 
+/*
+ * Put the node at a given position into the index
+ */
+static void alist_index_add(alist * al, int pos)
+{
+  unsigned int i, mask;
+
+  mask = al->buckets - 1;
+  for (i = array_key_hash(al->nodes[pos]->key->buf) & mask ; al->index[i] ; i = (i + 1) & mask);
+
+  al->index[i] = pos + 1;
+}
+
+
+/*
+ * Build again the index, with enough buckets for the alist size
+ */
+static void alist_index_build(alist * al)
+{
+  alist_node *an;
+  int pos;
+
+  for (al->buckets = 2 * ARRAY_INDEX_MIN ; al->buckets < 2 * al->size ; al->buckets *= 2);
+
+  arena_release(al->index);
+  al->index = arena_malloc(al->buckets * sizeof(int));
+  al->nodes = arena_realloc(al->nodes, al->buckets / 2 * sizeof(alist_node *));
+  assert(al->index && al->nodes);
+  memset(al->index, 0, al->buckets * sizeof(int));
+
+  for (pos = 0, an = al->first ; an ; an = an->next, pos++) {
+    al->nodes[pos] = an;
+    alist_index_add(al, pos);
+  }
+}
+
+
+/*
+ * Retrieve the node of a key, NULL if not found
+ */
+static alist_node *alist_node_get(const alist * al, const char *key)
+{
+  alist_node *an;
+  unsigned int i, mask;
+  size_t ks;
+
+  if (al->index) {
+    mask = al->buckets - 1;
+    for (i = array_key_hash(key) & mask ; al->index[i] ; i = (i + 1) & mask)
+      if (buffer_case_cmp(al->nodes[al->index[i] - 1]->key, key))
+        return al->nodes[al->index[i] - 1];
+
+    return NULL;
+  }
+
+  for (ks = strlen(key), an = al->first ; an ; an = an->next)
+    if (ks == an->key->use)
+      if (buffer_case_cmp(an->key, key))
+        return an;
+
+  return NULL;
+}
+
+
 /*
  * Add a given buffer to the end of an alist entry
  * if key exist, value is add to the list
@@ -88,8 +158,10 @@ void alist_add(alist * al, buffer * key, buffer * value)
   assert(key);
   assert(value);
 
-  if (!alist_is_key(al, key->buf)) {
-    an = malloc(sizeof(alist_node));
+  an = alist_node_get(al, key->buf);
+
+  if (!an) {
+    an = arena_malloc(sizeof(alist_node));
     assert(an);
 
     an->key = key;
@@ -100,10 +172,15 @@ void alist_add(alist * al, buffer * key, buffer * value)
 
     al->last = an;
     al->last->next = NULL;
-  } else {
-    for (an = al->first ; an ; an = an->next)
-      if (buffer_case_cmp(an->key, key->buf))
-        break;
+
+    /* Index is only worth it on large alists */
+    if (++al->size >= ARRAY_INDEX_MIN) {
+      if (!al->index || 2 * al->size > al->buckets) alist_index_build(al);
+      else {
+        al->nodes[al->size - 1] = an;
+        alist_index_add(al, al->size - 1);
+      }
+    }
   }
 
   list_add(an->value, value);
@@ -115,18 +192,10 @@ void alist_add(alist * al, buffer * key, buffer * value)
  */
 bool alist_is_key(const alist * al, const char *key)
 {
-  alist_node *an;
-  size_t ks;
-
   assert(al);
   assert(key);
 
-  for (ks = strlen(key), an = al->first ; an ; an = an->next)
-    if (ks == an->key->use)
-      if (buffer_case_cmp(an->key, key))
-        return true;
-
-  return false;
+  return alist_node_get(al, key) != NULL;
 }
 
 
@@ -138,17 +207,11 @@ bool alist_is_key(const alist * al, const char *key)
 list *alist_get(const alist * al, const char *key)
 {
   alist_node *an;
-  size_t ks;
 
   assert(al);
   assert(key);
 
-  for (ks = strlen(key), an = al->first ; an ; an = an->next) {
-    if (ks == an->key->use)
-      if (buffer_case_cmp(an->key, key))
-        break;
-  }
-
+  an = alist_node_get(al, key);
   assert(an);
 
   return an->value;
@@ -0,0 +1,289 @@
+/*
+  Copyright (c) <2007-2012> <Barbara Philippot - Olivier Courtin>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+
+#include <stdlib.h>
+#include <string.h>             /* memcpy */
+#include <assert.h>
+
+#include "../ows/ows.h"
+
+/*
+ * Arena is a region allocator for struct containers (buffer, list...)
+ * Allocations are bumped from large chunks, and released all at once
+ * with arena_reset, so what a request forgot to free is reclaimed too
+ * With no current arena, containers are allocated on the heap as usual
+ */
+
+#define ARENA_ALIGN(n) (((n) + sizeof(arena_header) - 1) / sizeof(arena_header) * sizeof(arena_header))
+#define ARENA_CHUNK_HEAD ARENA_ALIGN(sizeof(arena_chunk))
+#define ARENA_DATA(c) ((char *) (c) + ARENA_CHUNK_HEAD)
+
+static arena *arena_current = NULL;
+
+
+/*
+ * Initialize an arena, allocating by chunks of chunk_size bytes
+ */
+arena *arena_init(size_t chunk_size)
+{
+  arena *a;
+
+  assert(chunk_size > 0);
+
+  a = malloc(sizeof(arena));
+  assert(a);
+
+  a->chunks = NULL;
+  a->chunk_size = chunk_size;
+
+  return a;
+}
+
+
+/*
+ * Free an arena and everything allocated in it
+ */
+void arena_free(arena * a)
+{
+  arena_chunk *c;
+
+  assert(a);
+
+  if (arena_current == a) arena_current = NULL;
+
+  while (a->chunks) {
+    c = a->chunks;
+    a->chunks = c->next;
+    free(c);
+  }
+
+  free(a);
+}
+
+
+/*
+ * Release everything allocated in an arena at once
+ * The first standard chunk is kept for the next use
+ */
+void arena_reset(arena * a)
+{
+  arena_chunk *c, *keep = NULL;
+
+  assert(a);
+
+  while (a->chunks) {
+    c = a->chunks;
+    a->chunks = c->next;
+
+    if (!keep && c->size == a->chunk_size) keep = c;
+    else free(c);
+  }
+
+  if (keep) {
+    keep->next = NULL;
+    keep->use = 0;
+  }
+  a->chunks = keep;
+}
+
+
+/*
+ * Set the arena containers are allocated from (NULL for the heap)
+ * Return the previous one, to be restored
+ */
+arena *arena_use(arena * a)
+{
+  arena *previous = arena_current;
+
+  arena_current = a;
+
+  return previous;
+}
+
+
+/*
+ * Run a container allocation on the heap, out of the current arena
+ * Process wide caches (prepared statements, SRS, capabilities) outlive
+ * the request, while the request arena is reset once it is done: what
+ * they keep must be allocated this way. Containers grow where they
+ * were first allocated, so the heap keeps them afterwards
+ */
+void *arena_heap(void *(*alloc) (void))
+{
+  arena *previous;
+  void *p;
+
+  assert(alloc);
+
+  previous = arena_use(NULL);
+  p = alloc();
+  arena_use(previous);
+
+  return p;
+}
+
+
+/*
+ * Allocate size bytes into a given arena
+ * Large allocations get their own chunk, behind the current one
+ */
+static void *arena_bump(arena * a, size_t size)
+{
+  arena_chunk *c;
+  arena_header *h;
+  size_t need;
+
+  need = sizeof(arena_header) + ARENA_ALIGN(size);
+
+  if (!a->chunks || a->chunks->size - a->chunks->use < need) {
+
+    if (need > a->chunk_size / 4) {
+      c = malloc(ARENA_CHUNK_HEAD + need);
+      assert(c);
+      c->size = c->use = need;
+
+      if (a->chunks) {
+        c->next = a->chunks->next;
+        a->chunks->next = c;
+      } else {
+        c->next = NULL;
+        a->chunks = c;
+        a->chunks->use = need;
+      }
+
+      h = (arena_header *) ARENA_DATA(c);
+      h->owner = a;
+      h->size = size;
+
+      return (char *) h + sizeof(arena_header);
+    }
+
+    c = malloc(ARENA_CHUNK_HEAD + a->chunk_size);
+    assert(c);
+    c->size = a->chunk_size;
+    c->use = 0;
+    c->next = a->chunks;
+    a->chunks = c;
+  }
+
+  h = (arena_header *) (ARENA_DATA(a->chunks) + a->chunks->use);
+  h->owner = a;
+  h->size = size;
+  a->chunks->use += need;
+
+  return (char *) h + sizeof(arena_header);
+}
+
+
+/*
+ * Check if p is the last allocation bumped from the current chunk
+ */
+static bool arena_is_last(const arena * a, const void *p, size_t size)
+{
+  return a->chunks && (const char *) p + ARENA_ALIGN(size) == ARENA_DATA(a->chunks) + a->chunks->use;
+}
+
+
+/*
+ * Allocate size bytes from the current arena, or from the heap
+ */
+void *arena_malloc(size_t size)
+{
+  arena_header *h;
+
+  if (arena_current) return arena_bump(arena_current, size);
+
+  h = malloc(sizeof(arena_header) + size);
+  assert(h);
+  h->owner = NULL;
+  h->size = size;
+
+  return (char *) h + sizeof(arena_header);
+}
+
+
+/*
+ * Resize an allocation, which stays where it was allocated
+ * (heap or arena), whatever the current arena is
+ */
+void *arena_realloc(void *p, size_t size)
+{
+  arena_header *h;
+  arena *a;
+  void *q;
+
+  if (!p) return arena_malloc(size);
+
+  h = (arena_header *) ((char *) p - sizeof(arena_header));
+
+  if (!h->owner) {
+    h = realloc(h, sizeof(arena_header) + size);
+    assert(h);
+    h->size = size;
+    return (char *) h + sizeof(arena_header);
+  }
+
+  a = h->owner;
+  if (size <= h->size) return p;
+
+  /* Last allocation grows in place when the chunk allows it */
+  if (arena_is_last(a, p, h->size)
+      && a->chunks->size - a->chunks->use >= ARENA_ALIGN(size) - ARENA_ALIGN(h->size)) {
+    a->chunks->use += ARENA_ALIGN(size) - ARENA_ALIGN(h->size);
+    h->size = size;
+    return p;
+  }
+
+  q = arena_bump(a, size);
+  memcpy(q, p, h->size);
+  arena_release(p);
+
+  return q;
+}
+
+
+/*
+ * Release an allocation: heap memory is freed, arena memory is only
+ * taken back if it was the last allocation (else on arena_reset)
+ */
+void arena_release(void *p)
+{
+  arena_header *h;
+
+  if (!p) return;
+
+  h = (arena_header *) ((char *) p - sizeof(arena_header));
+
+  if (!h->owner) {
+    free(h);
+    return;
+  }
+
+  if (arena_is_last(h->owner, p, h->size))
+    h->owner->chunks->use -= sizeof(arena_header) + ARENA_ALIGN(h->size);
+}
+
+
+/*
+ * vim: expandtab sw=4 ts=4
+ */
@@ -25,6 +25,7 @@
 #include <stdio.h>              /* FILE */
 #include <string.h>             /* strncmp */
 #include <limits.h>
+#include <ctype.h>
 #include <assert.h>
 
 #include "../ows/ows.h"
@@ -37,11 +38,15 @@ array *array_init()
 {
   array *arr = NULL;
 
-  arr = malloc(sizeof(array));
+  arr = arena_malloc(sizeof(array));
   assert(arr);
 
   arr->first = NULL;
   arr->last = NULL;
+  arr->size = 0;
+  arr->nodes = NULL;
+  arr->index = NULL;
+  arr->buckets = 0;
 
   return arr;
 }
@@ -63,15 +68,77 @@ void array_free(array * a)
 
     buffer_free(an_to_free->key);
     buffer_free(an_to_free->value);
-    free(an_to_free);
+    arena_release(an_to_free);
     an_to_free = NULL;
   }
 
-  free(a);
+  arena_release(a->nodes);
+  arena_release(a->index);
+  arena_release(a);
   a = NULL;
 }
 
 
+/*
+ * FNV-1a hash of a key, case insensitive as keys lookups are
+ */
+unsigned int array_key_hash(const char *key)
+{
+  unsigned int hash;
+
+  assert(key);
+
+  for (hash = 2166136261U ; *key ; key++) {
+    hash ^= (unsigned char) toupper((unsigned char) *key);
+    hash *= 16777619U;
+  }
+
+  return hash;
+}
+
+
+/*
+ * Put the node at a given position into the index
+ * On duplicate keys, the first one is kept as linear lookups did
+ */
+static void array_index_add(array * a, int pos)
+{
+  unsigned int i, mask;
+  buffer *key;
+
+  mask = a->buckets - 1;
+  key = a->nodes[pos]->key;
+
+  for (i = array_key_hash(key->buf) & mask ; a->index[i] ; i = (i + 1) & mask)
+    if (buffer_case_cmp(a->nodes[a->index[i] - 1]->key, key->buf)) return;
+
+  a->index[i] = pos + 1;
+}
+
+
+/*
+ * Build again the index, with enough buckets for the array size
+ */
+static void array_index_build(array * a)
+{
+  array_node *an;
+  int pos;
+
+  for (a->buckets = 2 * ARRAY_INDEX_MIN ; a->buckets < 2 * a->size ; a->buckets *= 2);
+
+  arena_release(a->index);
+  a->index = arena_malloc(a->buckets * sizeof(int));
+  a->nodes = arena_realloc(a->nodes, a->buckets / 2 * sizeof(array_node *));
+  assert(a->index && a->nodes);
+  memset(a->index, 0, a->buckets * sizeof(int));
+
+  for (pos = 0, an = a->first ; an ; an = an->next, pos++) {
+    a->nodes[pos] = an;
+    array_index_add(a, pos);
+  }
+}
+
+
 /*
  * Add a given buffer to the end of an array
  * Carefull key and value are passed by reference
@@ -85,7 +152,7 @@ void array_add(array * a, buffer * key, buffer * value)
   assert(key);
   assert(value);
 
-  an = malloc(sizeof(array_node));
+  an = arena_malloc(sizeof(array_node));
   assert(an);
 
   an->key = key;
@@ -96,26 +163,58 @@ void array_add(array * a, buffer * key, buffer * value)
 
   a->last = an;
   a->last->next = NULL;
+
+  /* Index is only worth it on large arrays */
+  if (++a->size < ARRAY_INDEX_MIN) return;
+
+  if (!a->index || 2 * a->size > a->buckets) array_index_build(a);
+  else {
+    a->nodes[a->size - 1] = an;
+    array_index_add(a, a->size - 1);
+  }
 }
 
 
 /*
- * Check if a given key string is or not in the array
+ * Return the position of a key in the array (from 0), -1 if not found
  */
-bool array_is_key(const array * a, const char *key)
+int array_index(const array * a, const char *key)
 {
   array_node *an;
+  unsigned int i, mask;
   size_t ks;
+  int pos;
 
   assert(a);
   assert(key);
 
-  for (ks = strlen(key), an = a->first ; an ; an = an->next)
+  if (a->index) {
+    mask = a->buckets - 1;
+    for (i = array_key_hash(key) & mask ; a->index[i] ; i = (i + 1) & mask)
+      if (buffer_case_cmp(a->nodes[a->index[i] - 1]->key, key))
+        return a->index[i] - 1;
+
+    return -1;
+  }
+
+  for (ks = strlen(key), pos = 0, an = a->first ; an ; an = an->next, pos++)
     if (ks == an->key->use)
       if (buffer_case_cmp(an->key, key))
-        return true;
+        return pos;
 
-  return false;
+  return -1;
+}
+
+
+/*
+ * Check if a given key string is or not in the array
+ */
+bool array_is_key(const array * a, const char *key)
+{
+  assert(a);
+  assert(key);
+
+  return array_index(a, key) != -1;
 }
 
 
@@ -148,10 +247,17 @@ buffer *array_get(const array * a, const char *key)
 {
   array_node *an;
   size_t ks;
+  int pos;
 
   assert(a);
   assert(key);
 
+  if (a->index) {
+    pos = array_index(a, key);
+    assert(pos != -1);
+    return a->nodes[pos]->value;
+  }
+
   for (ks = strlen(key), an = a->first ; an ; an = an->next) {
     if (ks == an->key->use)
       if (buffer_case_cmp(an->key, key))
@@ -45,7 +45,7 @@ static void buffer_realloc(buffer * buf)
 {
   assert(buf);
 
-  buf->buf = realloc(buf->buf, buf->realloc * sizeof(char));
+  buf->buf = arena_realloc(buf->buf, buf->realloc * sizeof(char));
   assert(buf->buf);
 
   buf->size = buf->realloc;
@@ -62,10 +62,10 @@ buffer *buffer_init()
 {
   buffer *buf;
 
-  buf = malloc(sizeof(buffer));
+  buf = arena_malloc(sizeof(buffer));
   assert(buf);
 
-  buf->buf = malloc(BUFFER_SIZE_INIT * sizeof(char));
+  buf->buf = arena_malloc(BUFFER_SIZE_INIT * sizeof(char));
   assert(buf->buf);
 
   buf->size = BUFFER_SIZE_INIT;
@@ -85,10 +85,10 @@ void buffer_free(buffer * buf)
   assert(buf);
   assert(buf->buf);
 
-  free(buf->buf);
+  arena_release(buf->buf);
   buf->buf = NULL;
 
-  free(buf);
+  arena_release(buf);
   buf = NULL;
 }
 
@@ -0,0 +1,86 @@
+/*
+  Copyright (c) <2007-2012> <Barbara Philippot - Olivier Courtin>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "../ows/ows.h"
+
+
+#define CGI_KVP_KEY    1
+#define CGI_KVP_VALUE  2
+#define CGI_KVP_FILTER 4
+
+/*
+ * Characters allowed in a KVP request, indexed by byte value
+ * Built from the former regular expressions, evaluated byte per byte
+ * in C locale (as tinyows never calls setlocale):
+ *   key:    [A-Za-zà-ÿ]
+ *   value:  [A-Za-zà-ÿ0-9.\=;,():/\*_ \-]
+ *   filter: [A-Za-zà-ÿ0-9.#\,():/_<> %"'=\*!\-]|\[|\]
+ */
+static const unsigned char cgi_kvp_table[256] = {
+  /* 0x00 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0x10 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0x20 */ 6, 4, 4, 4, 0, 4, 0, 4, 6, 6, 6, 0, 6, 6, 6, 6,
+  /* 0x30 */ 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 2, 4, 6, 4, 0,
+  /* 0x40 */ 0, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  /* 0x50 */ 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 4, 6, 4, 0, 6,
+  /* 0x60 */ 0, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  /* 0x70 */ 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 0, 0, 0, 0, 0,
+  /* 0x80 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0x90 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0xA0 */ 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  /* 0xB0 */ 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  /* 0xC0 */ 7, 7, 7, 7, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0xD0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0xE0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0xF0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+
+/*
+ * Check if a character is allowed inside a KVP key
+ */
+bool cgi_kvp_key_char(char c)
+{
+  return (cgi_kvp_table[(unsigned char) c] & CGI_KVP_KEY) != 0;
+}
+
+
+/*
+ * Check if a character is allowed inside a KVP value
+ * Filter values allow some more characters (XML markup)
+ */
+bool cgi_kvp_value_char(char c, bool filter)
+{
+  unsigned char t = cgi_kvp_table[(unsigned char) c];
+
+  return (t & CGI_KVP_VALUE) || (filter && (t & CGI_KVP_FILTER));
+}
+
+
+/*
+ * vim: expandtab sw=4 ts=4
+ */
@@ -36,6 +36,12 @@
 #define CGI_QUERY_MAX 1000000
 
 
+/*
+ * Max names kept in the XML parser dictionary, shared by requests
+ */
+#define CGI_XML_DICT_MAX 100000
+
+
 /*
  * Return true if this cgi call was using a GET request, false otherwise
  */
@@ -62,12 +68,110 @@ bool cgi_method_post()
 }
 
 
+/*
+ * Read POST input up to the end of the root element start tag
+ * (XML declaration, comments and DOCTYPE are skipped)
+ * Return false if not found within max bytes
+ */
+static bool cgi_read_root_tag(buffer * head, size_t max)
+{
+  long int start = -1;
+  char quote = 0;
+  int c;
+
+  while (head->use < max && (c = fgetc(stdin)) != EOF) {
+    buffer_add(head, (char) c);
+
+    if (quote) {
+      if (c == quote) quote = 0;
+    } else if (start < 0) {
+      if (c == '<') start = head->use - 1;
+    } else if ((c == '"' || c == '\'') && strncmp(head->buf + start, "<!--", 4)) {
+      quote = (char) c;
+    } else if (c == '>') {
+      if (head->buf[start + 1] == '?') {
+        if (head->buf[head->use - 2] == '?') start = -1;
+      } else if (!strncmp(head->buf + start, "<!--", 4)) {
+        if (head->use - start >= 7 && !strncmp(head->buf + head->use - 3, "-->", 3)) start = -1;
+      } else if (head->buf[start + 1] == '!') start = -1;
+      else return true;
+    }
+  }
+
+  return false;
+}
+
+
+/*
+ * Check that the root element read is a not empty Transaction
+ */
+static bool cgi_root_is_transaction(const buffer * head)
+{
+  const char *c, *name;
+  size_t len;
+
+  c = strrchr(head->buf, '<');
+  if (!c || head->use < 2 || head->buf[head->use - 2] == '/') return false;
+
+  for (name = ++c ; *c && !isspace((unsigned char) *c) && *c != '>' ; c++)
+    if (*c == ':') name = c + 1;
+
+  len = c - name;
+  return len == strlen("Transaction") && !strncmp(name, "Transaction", len);
+}
+
+
+/*
+ * Give streamed input back to libxml2: what was already read, then the rest
+ */
+int cgi_stream_read(void * ctx, char * buf, int len)
+{
+  cgi_stream *s;
+  size_t n;
+
+  s = (cgi_stream *) ctx;
+  assert(s);
+
+  if (s->head_read < s->head->use) {
+    n = s->head->use - s->head_read;
+    if (n > (size_t) len) n = len;
+    memcpy(buf, s->head->buf + s->head_read, n);
+    s->head_read += n;
+    return (int) n;
+  }
+
+  if (!s->left) return 0;
+
+  n = (size_t) len < s->left ? (size_t) len : s->left;
+  n = fread(buf, 1, n, stdin);
+  if (ferror(stdin)) return -1;
+  s->left -= n;
+  if (!n) s->left = 0;
+
+  return (int) n;
+}
+
+
+void cgi_stream_free(cgi_stream * s)
+{
+  assert(s);
+
+  buffer_free(s->head);
+  free(s);
+}
+
+
 /*
  * Return the string sent by CGI
+ *
+ * A large enough POST Transaction is not read at once: only its root
+ * element is returned (as an empty one), operations being read later
+ * as a stream from o->stream
  */
 char *cgi_getback_query(ows * o)
 {
   char *query;
+  buffer *head;
   int query_size = 0;
   size_t s;
 
@@ -75,13 +179,32 @@ char *cgi_getback_query(ows * o)
   else if (cgi_method_post()) {
     query_size = atoi(getenv("CONTENT_LENGTH"));
 
+    head = buffer_init();
+    if (    o->stream_transaction > 0 && query_size >= o->stream_transaction
+         && cgi_read_root_tag(head, query_size) && cgi_root_is_transaction(head)) {
+      o->stream = malloc(sizeof(cgi_stream));
+      assert(o->stream);
+      o->stream->head = head;
+      o->stream->head_read = 0;
+      o->stream->left = query_size - head->use;
+
+      query = malloc(head->use + 2);
+      assert(query);
+      memcpy(query, head->buf, head->use - 1);
+      strcpy(query + head->use - 1, "/>");
+      return query;
+    }
+
     query = malloc(sizeof(char) * query_size + 1);
     if (!query) {
+      buffer_free(head);
       ows_error(o, OWS_ERROR_REQUEST_HTTP, "Error on QUERY input - Memory allocation", "request");
       return NULL;
     }
-    s = fread(query, query_size, 1, stdin);
+    memcpy(query, head->buf, head->use);
+    s = fread(query + head->use, query_size - head->use, 1, stdin);
     (void)s;
+    buffer_free(head);
     if (ferror(stdin)) {
       ows_error(o, OWS_ERROR_REQUEST_HTTP, "Error on QUERY input", "request");
       return NULL;
@@ -163,7 +286,7 @@ array *cgi_parse_kvp(ows * o, char *query)
   buffer *key;
   buffer *val;
   array *arr;
-  char string[2];
+  bool in_filter;
 
   assert(o);
   assert(query);
@@ -172,6 +295,7 @@ array *cgi_parse_kvp(ows * o, char *query)
   val = buffer_init();
   arr = array_init();
   in_key = true;
+  in_filter = false;
 
   cgi_unescape_url(query);
   cgi_remove_crlf(query);
@@ -182,6 +306,7 @@ array *cgi_parse_kvp(ows * o, char *query)
     if (query[i] == '&') {
 
       in_key = true;
+      in_filter = false;
 
       array_add(arr, key, val);
       key = buffer_init();
@@ -189,20 +314,17 @@ array *cgi_parse_kvp(ows * o, char *query)
 
     } else if (query[i] == '=') {
       /* char '=' inside filter key mustn't be taken into account */
-      if ((!buffer_case_cmp(key, "filter") || !buffer_case_cmp(key, "outputformat")) && buffer_cmp(val, ""))
+      if ((!buffer_case_cmp(key, "filter") || !buffer_case_cmp(key, "outputformat")) && buffer_cmp(val, "")) {
         in_key = false;
-      else buffer_add(val, query[i]);
+        in_filter = buffer_cmp(key, "filter");
+      } else buffer_add(val, query[i]);
     }
     /* Check characters'CGI request */
     else {
-      /* to check the regular expression, argument must be a string, not a char */
-      string[0] = query[i];
-      string[1] = '\0';
-
       if (in_key) {
 
         /* if word is key, only letters are allowed */
-        if (check_regexp(string, "[A-Za-zà-ÿ]"))
+        if (cgi_kvp_key_char(query[i]))
           buffer_add(key, tolower(query[i]));
         else {
           buffer_free(key);
@@ -214,8 +336,7 @@ array *cgi_parse_kvp(ows * o, char *query)
         }
       } else {
         /* if word is filter key, more characters are allowed */
-        if (                                 check_regexp(string, "[A-Za-zà-ÿ0-9.\\=;,():/\\*_ \\-]")
-                                             || (buffer_cmp(key, "filter") && check_regexp(string, "[A-Za-zà-ÿ0-9.#\\,():/_<> %\"\'=\\*!\\-]|\\[|\\]")))
+        if (cgi_kvp_value_char(query[i], in_filter))
           buffer_add(val, query[i]);
         else {
           buffer_free(key);
@@ -396,28 +517,42 @@ static buffer *cgi_add_into_buffer(buffer * b, xmlNodePtr n, bool need_comma)
 
 
 /*
- * Add the whole xml element into the buffer
+ * Declare on the element all the namespaces in its scope
  */
-buffer *cgi_add_xml_into_buffer(buffer * element, xmlNodePtr n)
+void cgi_add_xml_ns(xmlNodePtr n)
 {
-  xmlBufferPtr buf;
   xmlNsPtr * ns;
   int i;
 
-  assert(element);
   assert(n);
 
   ns = xmlGetNsList(n->doc, n);
+  if (!ns) return;
 
   for (i = 0 ; ns[i] ; i++)
     xmlNewNs(n, ns[i]->href, ns[i]->prefix);
 
+  xmlFree(ns);
+}
+
+
+/*
+ * Add the whole xml element into the buffer
+ */
+buffer *cgi_add_xml_into_buffer(buffer * element, xmlNodePtr n)
+{
+  xmlBufferPtr buf;
+
+  assert(element);
+  assert(n);
+
+  cgi_add_xml_ns(n);
+
   buf = xmlBufferCreate();
   xmlNodeDump(buf, n->doc, n, 0, 0);
   buffer_add_str(element, (char *) buf->content);
 
   xmlBufferFree(buf);
-  xmlFree(ns);
 
   return element;
 }
@@ -433,11 +568,13 @@ static bool is_node_ns_wfs(xmlNodePtr n)
 
 /*
  * Parse the XML request and return an array key/value
+ * The document is kept by the request, for validation and operations
  */
 array *cgi_parse_xml(ows * o, char *query)
 {
-  buffer *key, *val, *operations, *prop, *filter, *typename;
+  buffer *key, *val, *prop, *filter, *typename;
   bool prop_need_comma, typ_need_comma;
+  int operations;
   xmlDocPtr xmldoc;
   xmlAttr *att;
   array *arr, *o_ns;
@@ -449,18 +586,24 @@ array *cgi_parse_xml(ows * o, char *query)
 
   prop_need_comma = typ_need_comma = false;
   lock_error = unknown_error = false;
+  operations = 0;
 
-  xmldoc = xmlParseMemory(query, strlen(query));
+  /* Parser context (and so its names dictionary) is reused, up to a limit */
+  if (o->xml_ctxt && xmlDictSize(o->xml_ctxt->dict) > CGI_XML_DICT_MAX) {
+    xmlFreeParserCtxt(o->xml_ctxt);
+    o->xml_ctxt = NULL;
+  }
+  if (!o->xml_ctxt) o->xml_ctxt = xmlNewParserCtxt();
+  xmldoc = o->xml_ctxt ? xmlCtxtReadMemory(o->xml_ctxt, query, strlen(query), NULL, NULL, 0) : NULL;
+  o->request->doc = xmldoc;
 
   if (!xmldoc || !(n = xmlDocGetRootElement(xmldoc))) {
-    xmlFreeDoc(xmldoc);
     ows_error(o, OWS_ERROR_INVALID_PARAMETER_VALUE, "XML isn't valid", "request");
     return NULL;
   }
 
   arr = array_init();
 
-  operations = buffer_init();
   prop = buffer_init();;
   filter = buffer_init();
   typename = buffer_init();
@@ -516,8 +659,9 @@ array *cgi_parse_xml(ows * o, char *query)
                     || !strcmp((char *) n->name, "Delete")
                     || !strcmp((char *) n->name, "Update"))) {
 
-      if (!operations->use) buffer_add_str(operations, "<operations>");
-      operations = cgi_add_xml_into_buffer(operations, n); /* Add the whole xml operation to the buffer */
+      /* Operation is kept into the document, with the namespaces it would have alone */
+      cgi_add_xml_ns(n);
+      operations++;
     }
     /* if node name match 'Query', parse the children elements */
     else if (is_node_ns_wfs(n) && !strcmp((char *) n->name, "Query")) {
@@ -559,9 +703,11 @@ array *cgi_parse_xml(ows * o, char *query)
   }
 
   /* operations */
-  if (operations->use) {
-    buffer_add_str(operations, "</operations>");
-    arr = cgi_add_buffer(arr, operations, "operations");
+  if (operations) {
+    key = buffer_from_str("operations");
+    val = buffer_init();
+    buffer_add_int(val, operations);
+    array_add(arr, key, val);
   }
 
   /* propertyname */
@@ -584,13 +730,10 @@ array *cgi_parse_xml(ows * o, char *query)
   if (typename->use) arr = cgi_add_buffer(arr, typename, "typename");
 
   buffer_free(prop);
-  buffer_free(operations);
   buffer_free(filter);
   buffer_free(typename);
   array_free(o_ns);
 
-  xmlFreeDoc(xmldoc);
-
   if (lock_error) {
     array_free(arr);
     ows_error(o, OWS_ERROR_INVALID_PARAMETER_VALUE, "LockID is not implemented", "request");
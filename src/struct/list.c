@@ -37,7 +37,7 @@ list *list_init()
 {
   list *l = NULL;
 
-  l = malloc(sizeof(list));
+  l = arena_malloc(sizeof(list));
   assert(l);
 
   l->first = NULL;
@@ -58,7 +58,7 @@ void list_free(list * l)
   while (l->first) list_node_free(l, l->first);
 
   l->last = NULL;
-  free(l);
+  arena_release(l);
   l = NULL;
 }
 
@@ -220,7 +220,7 @@ list_node *list_node_init()
 {
   list_node *ln;
 
-  ln = malloc(sizeof(list_node));
+  ln = arena_malloc(sizeof(list_node));
   assert(ln);
 
   ln->value = NULL;
@@ -248,7 +248,7 @@ void list_node_free(list * l, list_node * ln)
 
   if (ln->value) buffer_free(ln->value);
 
-  free(ln);
+  arena_release(ln);
   ln = NULL;
 }
 
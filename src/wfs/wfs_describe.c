@@ -53,12 +53,12 @@ static void wfs_complex_type(ows * o, wfs_request * wr, buffer * layer_name)
   layer_name = ows_layer_prefix_to_uri(o->layers, layer_name);
   mandatory_prop = ows_psql_not_null_properties(o, layer_name);
 
-  fprintf(o->output, "<xs:complexType name='");
-  buffer_flush(ows_layer_no_uri(o->layers, layer_name), o->output);
-  fprintf(o->output, "Type'>\n");
-  fprintf(o->output, " <xs:complexContent>\n");
-  fprintf(o->output, "  <xs:extension base='gml:AbstractFeatureType'>\n");
-  fprintf(o->output, "   <xs:sequence>\n");
+  ows_output_str(o, "<xs:complexType name='");
+  ows_output_buffer(o, ows_layer_no_uri(o->layers, layer_name));
+  ows_output_str(o, "Type'>\n");
+  ows_output_str(o, " <xs:complexContent>\n");
+  ows_output_str(o, "  <xs:extension base='gml:AbstractFeatureType'>\n");
+  ows_output_str(o, "   <xs:sequence>\n");
 
   table = ows_psql_describe_table(o, layer_name);
   id_name = ows_psql_id_column(o, layer_name);
@@ -78,7 +78,7 @@ static void wfs_complex_type(ows * o, wfs_request * wr, buffer * layer_name)
         continue;
       }
 
-      fprintf(o->output, "    <xs:element ref='gml:%s'/>\n", an->key->buf);
+      ows_output_printf(o, "    <xs:element ref='gml:%s'/>\n", an->key->buf);
       continue;
     }
 
@@ -99,61 +99,61 @@ static void wfs_complex_type(ows * o, wfs_request * wr, buffer * layer_name)
       /* Read string constraint from database and convert to gml restrictions*/
       constraint_name = ows_psql_column_constraint_name(o, an->key, table_name);
       if(strcmp(constraint_name->buf, "")) {
-        fprintf(o->output, "    <xs:element name ='%s' ", an->key->buf);
+        ows_output_printf(o, "    <xs:element name ='%s' ", an->key->buf);
         if (mandatory_prop && in_list(mandatory_prop, an->key))
-          fprintf(o->output, "nillable='false' minOccurs='1' ");
+          ows_output_str(o, "nillable='false' minOccurs='1' ");
         else
-          fprintf(o->output, "nillable='true' minOccurs='0' ");
-        fprintf(o->output, "maxOccurs='1'>\n");
+          ows_output_str(o, "nillable='true' minOccurs='0' ");
+        ows_output_str(o, "maxOccurs='1'>\n");
 
-        fprintf(o->output, "<xs:simpleType><xs:restriction base='string'>");
+        ows_output_str(o, "<xs:simpleType><xs:restriction base='string'>");
         check_constraints = ows_psql_column_check_constraint(o, constraint_name);
         for (ln = check_constraints->first ; ln ; ln = ln->next) {
-          fprintf(o->output, "<xs:enumeration value='%s'/>", ln->value->buf);
+          ows_output_printf(o, "<xs:enumeration value='%s'/>", ln->value->buf);
         }
-        fprintf(o->output, "</xs:restriction></xs:simpleType></xs:element>");
+        ows_output_str(o, "</xs:restriction></xs:simpleType></xs:element>");
       } else {
         character_maximum_length = ows_psql_column_character_maximum_length(o, an->key, table_name);
         if(strcmp(character_maximum_length->buf, "")) {
-          fprintf(o->output, "    <xs:element name ='%s' ", an->key->buf);
+          ows_output_printf(o, "    <xs:element name ='%s' ", an->key->buf);
           if (mandatory_prop && in_list(mandatory_prop, an->key))
-            fprintf(o->output, "nillable='false' minOccurs='1' ");
+            ows_output_str(o, "nillable='false' minOccurs='1' ");
           else
-            fprintf(o->output, "nillable='true' minOccurs='0' ");
-          fprintf(o->output, "maxOccurs='1'>\n");
-          fprintf(o->output, "<xs:simpleType><xs:restriction base='string'>");
-          fprintf(o->output, "<xs:maxLength value='%s'/>", character_maximum_length->buf);
-          fprintf(o->output, "</xs:restriction></xs:simpleType></xs:element>");
+            ows_output_str(o, "nillable='true' minOccurs='0' ");
+          ows_output_str(o, "maxOccurs='1'>\n");
+          ows_output_str(o, "<xs:simpleType><xs:restriction base='string'>");
+          ows_output_printf(o, "<xs:maxLength value='%s'/>", character_maximum_length->buf);
+          ows_output_str(o, "</xs:restriction></xs:simpleType></xs:element>");
         } else {
-          fprintf(o->output, "    <xs:element name ='%s' type='%s' ",
-                  an->key->buf, ows_psql_to_xsd(an->value, o->request->request.wfs->format));
+          ows_output_printf(o, "    <xs:element name ='%s' type='%s' ",
+                    an->key->buf, ows_psql_to_xsd(an->value, o->request->request.wfs->format));
 
           if (mandatory_prop && in_list(mandatory_prop, an->key))
-            fprintf(o->output, "nillable='false' minOccurs='1' ");
+            ows_output_str(o, "nillable='false' minOccurs='1' ");
           else
-            fprintf(o->output, "nillable='true' minOccurs='0' ");
-          fprintf(o->output, "maxOccurs='1'/>\n");
+            ows_output_str(o, "nillable='true' minOccurs='0' ");
+          ows_output_str(o, "maxOccurs='1'/>\n");
         }
         buffer_free(character_maximum_length);
       }
       buffer_free(constraint_name);
     } else {
-      fprintf(o->output, "    <xs:element name ='%s' type='%s' ",
-              an->key->buf, ows_psql_to_xsd(an->value, o->request->request.wfs->format));
+      ows_output_printf(o, "    <xs:element name ='%s' type='%s' ",
+                an->key->buf, ows_psql_to_xsd(an->value, o->request->request.wfs->format));
 
       if (mandatory_prop && in_list(mandatory_prop, an->key))
-        fprintf(o->output, "nillable='false' minOccurs='1' ");
+        ows_output_str(o, "nillable='false' minOccurs='1' ");
       else
-        fprintf(o->output, "nillable='true' minOccurs='0' ");
+        ows_output_str(o, "nillable='true' minOccurs='0' ");
 
-      fprintf(o->output, "maxOccurs='1'/>\n");
+      ows_output_str(o, "maxOccurs='1'/>\n");
     }
   }
 
-  fprintf(o->output, "   </xs:sequence>\n");
-  fprintf(o->output, "  </xs:extension>\n");
-  fprintf(o->output, " </xs:complexContent>\n");
-  fprintf(o->output, "</xs:complexType>\n");
+  ows_output_str(o, "   </xs:sequence>\n");
+  ows_output_str(o, "  </xs:extension>\n");
+  ows_output_str(o, " </xs:complexContent>\n");
+  ows_output_str(o, "</xs:complexType>\n");
 }
 
 
@@ -182,11 +182,11 @@ void wfs_describe_feature_type(ows * o, wfs_request * wr)
   }
 
   if (wr->format == WFS_GML212 || wr->format == WFS_XML_SCHEMA)
-    fprintf(o->output, "Content-Type: text/xml; subtype=gml/2.1.2;\n\n");
+    ows_output_str(o, "Content-Type: text/xml; subtype=gml/2.1.2;\n\n");
   else if (wr->format == WFS_GML311)
-    fprintf(o->output, "Content-Type: text/xml; subtype=gml/3.1.1;\n\n");
+    ows_output_str(o, "Content-Type: text/xml; subtype=gml/3.1.1;\n\n");
 
-  fprintf(o->output, "<?xml version='1.0' encoding='%s'?>\n", o->encoding->buf);
+  ows_output_printf(o, "<?xml version='1.0' encoding='%s'?>\n", o->encoding->buf);
    
   if (buffer_cmp(ns_prefix->last->value, "gml"))
     list_pop(ns_prefix);
@@ -194,9 +194,9 @@ void wfs_describe_feature_type(ows * o, wfs_request * wr)
 
   /* if all layers belong to different prefixes, import the matching namespaces */
   if (ns_prefix->first->next) {
-    fprintf(o->output, "<xs:schema xmlns:xs='http://www.w3.org/2001/XMLSchema'");
-    fprintf(o->output, " xmlns='http://www.w3.org/2001/XMLSchema'");
-    fprintf(o->output, " elementFormDefault='qualified'> ");
+    ows_output_str(o, "<xs:schema xmlns:xs='http://www.w3.org/2001/XMLSchema'");
+    ows_output_str(o, " xmlns='http://www.w3.org/2001/XMLSchema'");
+    ows_output_str(o, " elementFormDefault='qualified'> ");
 
     for (elemt = ns_prefix->first ; elemt ; elemt = elemt->next) {
       if (buffer_cmp(elemt->value, "gml")) {
@@ -209,62 +209,62 @@ void wfs_describe_feature_type(ows * o, wfs_request * wr)
           continue;
       }
 
-      fprintf(o->output, "<xs:import namespace='%s' ", namespace->buf);
-      fprintf(o->output, "schemaLocation='%s?service=WFS&amp;version=",
-              o->online_resource->buf);
+      ows_output_printf(o, "<xs:import namespace='%s' ", namespace->buf);
+      ows_output_printf(o, "schemaLocation='%s?service=WFS&amp;version=",
+                o->online_resource->buf);
 
       if (wfs_version == 100)
-        fprintf(o->output, "1.0.0&amp;request=DescribeFeatureType&amp;typename=");
+        ows_output_str(o, "1.0.0&amp;request=DescribeFeatureType&amp;typename=");
       else
-        fprintf(o->output, "1.1.0&amp;request=DescribeFeatureType&amp;typename=");
+        ows_output_str(o, "1.1.0&amp;request=DescribeFeatureType&amp;typename=");
 
       /* print the describeFeatureType request with typenames for each prefix */
       typ = ows_layer_list_by_ns_prefix(o->layers, wr->typename, elemt->value);
 
       for (ln = typ->first ; ln ; ln = ln->next) {
-        fprintf(o->output, "%s", ln->value->buf);
+        ows_output_str(o, ln->value->buf);
 
-        if (ln->next) fprintf(o->output, ",");
+        if (ln->next) ows_output_str(o, ",");
       }
 
       list_free(typ);
-      fprintf(o->output, "' />\n\n");
+      ows_output_str(o, "' />\n\n");
     }
 
-    fprintf(o->output, "</xs:schema>\n");
+    ows_output_str(o, "</xs:schema>\n");
   }
   /* if all layers belong to the same prefix, print the xsd schema describing features */
   else {
     namespace = ows_layer_ns_prefix_to_ns_uri(o->layers, ns_prefix->first->value);
-    fprintf(o->output, "<xs:schema targetNamespace='%s' ", namespace->buf);
-    fprintf(o->output, "xmlns:%s='%s' ", ns_prefix->first->value->buf, namespace->buf);
-    fprintf(o->output, "xmlns:ogc='http://www.opengis.net/ogc' ");
-    fprintf(o->output, "xmlns:xs='http://www.w3.org/2001/XMLSchema' ");
-    fprintf(o->output, "xmlns='http://www.w3.org/2001/XMLSchema' ");
-    fprintf(o->output, "xmlns:gml='http://www.opengis.net/gml' ");
-    fprintf(o->output, "elementFormDefault='qualified' ");
+    ows_output_printf(o, "<xs:schema targetNamespace='%s' ", namespace->buf);
+    ows_output_printf(o, "xmlns:%s='%s' ", ns_prefix->first->value->buf, namespace->buf);
+    ows_output_str(o, "xmlns:ogc='http://www.opengis.net/ogc' ");
+    ows_output_str(o, "xmlns:xs='http://www.w3.org/2001/XMLSchema' ");
+    ows_output_str(o, "xmlns='http://www.w3.org/2001/XMLSchema' ");
+    ows_output_str(o, "xmlns:gml='http://www.opengis.net/gml' ");
+    ows_output_str(o, "elementFormDefault='qualified' ");
 
-    if (wfs_version == 100) fprintf(o->output, "version='1.0'>\n");
-    else                    fprintf(o->output, "version='1.1'>\n");
+    if (wfs_version == 100) ows_output_str(o, "version='1.0'>\n");
+    else                    ows_output_str(o, "version='1.1'>\n");
 
-    fprintf(o->output, "<xs:import namespace='http://www.opengis.net/gml'");
+    ows_output_str(o, "<xs:import namespace='http://www.opengis.net/gml'");
 
     if (wfs_version == 100)
-      fprintf(o->output, " schemaLocation='http://schemas.opengis.net/gml/2.1.2/feature.xsd'/>\n");
+      ows_output_str(o, " schemaLocation='http://schemas.opengis.net/gml/2.1.2/feature.xsd'/>\n");
     else
-      fprintf(o->output, " schemaLocation='http://schemas.opengis.net/gml/3.1.1/base/gml.xsd'/>\n");
+      ows_output_str(o, " schemaLocation='http://schemas.opengis.net/gml/3.1.1/base/gml.xsd'/>\n");
 
     /* Describe each feature type specified in the request */
     for (elemt = wr->typename->first ; elemt ; elemt = elemt->next) {
-      fprintf(o->output, "<xs:element name='");
-      buffer_flush(ows_layer_no_uri(o->layers, ows_layer_prefix_to_uri(o->layers, elemt->value)), o->output);
-      fprintf(o->output, "' type='");
-      buffer_flush(elemt->value, o->output);
-      fprintf(o->output, "Type' substitutionGroup='gml:_Feature' />\n");
+      ows_output_str(o, "<xs:element name='");
+      ows_output_buffer(o, ows_layer_no_uri(o->layers, ows_layer_prefix_to_uri(o->layers, elemt->value)));
+      ows_output_str(o, "' type='");
+      ows_output_buffer(o, elemt->value);
+      ows_output_str(o, "Type' substitutionGroup='gml:_Feature' />\n");
       wfs_complex_type(o, wr, elemt->value);
     }
 
-    fprintf(o->output, "</xs:schema>");
+    ows_output_str(o, "</xs:schema>");
   }
 
   list_free(ns_prefix);
@@ -323,22 +323,15 @@ buffer * wfs_generate_schema(ows * o, ows_version * version)
     buffer_copy(schema, namespace);
     buffer_add_str(schema, "' schemaLocation='");
 
-    buffer_copy(schema, o->online_resource);
-    buffer_add_str(schema, "?service=WFS&amp;request=DescribeFeatureType");
+    /* Described in process, see wfs_describe_schema */
+    buffer_add_str(schema, OWS_SCHEMA_DESCRIBE_URI);
 
-    if (elemt->next || elemt != ns_prefix->first) {
-      buffer_add_str(schema, "&amp;Typename=");
-
-      typename = ows_layer_list_by_ns_prefix(o->layers, layers_name_prefix, elemt->value);
-      for (t = typename->first ; t ; t = t->next) {
-        buffer_copy(schema, t->value);
-        if (t->next) buffer_add(schema, ',');
-      }
-      list_free(typename);
+    typename = ows_layer_list_by_ns_prefix(o->layers, layers_name_prefix, elemt->value);
+    for (t = typename->first ; t ; t = t->next) {
+      buffer_copy(schema, t->value);
+      if (t->next) buffer_add(schema, ',');
     }
-
-    if (wfs_version == 100) buffer_add_str(schema, "&amp;version=1.0.0");
-    else                    buffer_add_str(schema, "&amp;version=1.1.0");
+    list_free(typename);
 
     buffer_add_str(schema, "'/>\n");
   }
@@ -350,3 +343,48 @@ buffer * wfs_generate_schema(ows * o, ows_version * version)
 
   return schema;
 }
+
+
+/*
+ * Render the schema of some typenames, as DescribeFeatureType would,
+ * into a buffer (typename list is then owned)
+ * Used to compile the schema validating Insert operations
+ * Return NULL if the schema can't be described
+ */
+buffer * wfs_describe_schema(ows * o, list * typename)
+{
+  wfs_request *wr, *current;
+  buffer *schema, *previous;
+  char *body;
+
+  assert(o && o->request && typename);
+
+  wr = wfs_request_init();
+  wr->request = WFS_DESCRIBE_FEATURE_TYPE;
+  wr->typename = typename;
+  wr->format = (ows_version_get(o->request->version) == 100) ? WFS_GML212 : WFS_GML311;
+
+  schema = buffer_init();
+  previous = ows_output_capture(o, schema);
+
+  current = o->request->request.wfs;
+  o->request->request.wfs = wr;
+  wfs_describe_feature_type(o, wr);
+  o->request->request.wfs = current;
+
+  ows_output_capture(o, previous);
+  wfs_request_free(wr);
+
+  /* Error was logged, the schema compilation will fail on it */
+  if (o->exit) {
+    o->exit = false;
+    buffer_free(schema);
+    return NULL;
+  }
+
+  /* Skip HTTP headers */
+  body = strstr(schema->buf, "\n\n");
+  if (body) buffer_shift(schema, body - schema->buf + 2);
+
+  return schema;
+}
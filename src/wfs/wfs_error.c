@@ -75,17 +75,17 @@ static void wfs_error_100(ows * o, wfs_request * wf, enum wfs_error_code code, c
 
   ows_log(o, 1, message);
 
-  fprintf(o->output, "<?xml version=\"1.0\" encoding=\"%s\"?>\n", o->encoding->buf);
-  fprintf(o->output, "<ServiceExceptionReport\n");
-  fprintf(o->output, " xmlns=\"http://www.opengis.net/ogc\"\n");
-  fprintf(o->output, " xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n");
-  fprintf(o->output, " xsi:schemaLocation=\"http://www.opengis.net/ogc");
-  fprintf(o->output, " http://schemas.opengis.net/wms/1.1.1/OGC-exception.xsd\"\n");
-  fprintf(o->output, "version=\"1.2.0\">\n");
-  fprintf(o->output, "<ServiceException code=\"%s\"", wfs_error_code_string(code));
-  fprintf(o->output, " locator=\"%s\">\n%s", locator, message);
-  fprintf(o->output, "</ServiceException>\n");
-  fprintf(o->output, "</ServiceExceptionReport>\n");
+  ows_output_printf(o, "<?xml version=\"1.0\" encoding=\"%s\"?>\n", o->encoding->buf);
+  ows_output_str(o, "<ServiceExceptionReport\n");
+  ows_output_str(o, " xmlns=\"http://www.opengis.net/ogc\"\n");
+  ows_output_str(o, " xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n");
+  ows_output_str(o, " xsi:schemaLocation=\"http://www.opengis.net/ogc");
+  ows_output_str(o, " http://schemas.opengis.net/wms/1.1.1/OGC-exception.xsd\"\n");
+  ows_output_str(o, "version=\"1.2.0\">\n");
+  ows_output_printf(o, "<ServiceException code=\"%s\"", wfs_error_code_string(code));
+  ows_output_printf(o, " locator=\"%s\">\n%s", locator, message);
+  ows_output_str(o, "</ServiceException>\n");
+  ows_output_str(o, "</ServiceExceptionReport>\n");
 }
 
 
@@ -104,17 +104,17 @@ static void wfs_error_110(ows * o, wfs_request * wf, enum wfs_error_code code, c
 
   ows_log(o, 1, message);
 
-  fprintf(o->output, "<?xml version='1.0' encoding='UTF-8'?>\n");
-  fprintf(o->output, "<ExceptionReport\n");
-  fprintf(o->output, " xmlns='http://www.opengis.net/ows'\n");
-  fprintf(o->output, " xmlns:xsi='http://www.w3.org/2001/XMLSchema-instance'\n");
-  fprintf(o->output, " xsi:schemaLocation='http://www.opengis.net/ows");
-  fprintf(o->output, " http://schemas.opengis.net/ows/1.0.0/owsExceptionReport.xsd'\n");
-  fprintf(o->output, " version='1.0.0' language='en'>\n");
-  fprintf(o->output, " <Exception exceptionCode='%s' locator='%s'>\n", wfs_error_code_string(code), locator);
-  fprintf(o->output, "  <ExceptionText>%s</ExceptionText>\n", message);
-  fprintf(o->output, " </Exception>\n");
-  fprintf(o->output, "</ExceptionReport>\n");
+  ows_output_str(o, "<?xml version='1.0' encoding='UTF-8'?>\n");
+  ows_output_str(o, "<ExceptionReport\n");
+  ows_output_str(o, " xmlns='http://www.opengis.net/ows'\n");
+  ows_output_str(o, " xmlns:xsi='http://www.w3.org/2001/XMLSchema-instance'\n");
+  ows_output_str(o, " xsi:schemaLocation='http://www.opengis.net/ows");
+  ows_output_str(o, " http://schemas.opengis.net/ows/1.0.0/owsExceptionReport.xsd'\n");
+  ows_output_str(o, " version='1.0.0' language='en'>\n");
+  ows_output_printf(o, " <Exception exceptionCode='%s' locator='%s'>\n", wfs_error_code_string(code), locator);
+  ows_output_printf(o, "  <ExceptionText>%s</ExceptionText>\n", message);
+  ows_output_str(o, " </Exception>\n");
+  ows_output_str(o, "</ExceptionReport>\n");
 }
 
 
@@ -131,7 +131,7 @@ void wfs_error(ows * o, wfs_request * wf, enum wfs_error_code code, char *messag
   assert(locator);
 
   version = ows_version_get(o->request->version);
-  fprintf(o->output, "Content-Type: application/xml\n\n");
+  ows_output_str(o, "Content-Type: application/xml\n\n");
 
   switch (version) {
     case 100:
@@ -26,6 +26,8 @@
 #include <assert.h>
 #include <float.h>
 #include <math.h>
+#include <string.h>
+#include <time.h>
 
 #include "../ows/ows.h"
 
@@ -41,18 +43,18 @@ static void wfs_get_capabilities_dcpt_100(const ows * o, char * req)
   assert(o);
   assert(o->online_resource);
 
-  fprintf(o->output, "    <DCPType>\n");
-  fprintf(o->output, "     <HTTP>\n");
-  fprintf(o->output, "      <Get onlineResource=\"");
-  fprintf(o->output, "%s?%s\"/>\n", o->online_resource->buf, req);
-  fprintf(o->output, "     </HTTP>\n");
-  fprintf(o->output, "    </DCPType>\n");
-  fprintf(o->output, "    <DCPType>\n");
-  fprintf(o->output, "     <HTTP>\n");
-  fprintf(o->output, "      <Post onlineResource=\"");
-  fprintf(o->output, "%s\"/>\n", o->online_resource->buf);
-  fprintf(o->output, "     </HTTP>\n");
-  fprintf(o->output, "    </DCPType>\n");
+  ows_output_str(o, "    <DCPType>\n");
+  ows_output_str(o, "     <HTTP>\n");
+  ows_output_str(o, "      <Get onlineResource=\"");
+  ows_output_printf(o, "%s?%s\"/>\n", o->online_resource->buf, req);
+  ows_output_str(o, "     </HTTP>\n");
+  ows_output_str(o, "    </DCPType>\n");
+  ows_output_str(o, "    <DCPType>\n");
+  ows_output_str(o, "     <HTTP>\n");
+  ows_output_str(o, "      <Post onlineResource=\"");
+  ows_output_printf(o, "%s\"/>\n", o->online_resource->buf);
+  ows_output_str(o, "     </HTTP>\n");
+  ows_output_str(o, "    </DCPType>\n");
 }
 
 
@@ -65,13 +67,13 @@ static void wfs_gml_object_type(ows * o, char *type)
   assert(o);
   assert(type);
 
-  fprintf(o->output, "  <GMLObjectType>\n");
-  fprintf(o->output, "   <Name>gml:%s</Name>\n", type);
-  fprintf(o->output, "   <OutputFormats>\n");
-  fprintf(o->output, "    <Format>text/xml; subtype=gml/2.1.2</Format>\n");
-  fprintf(o->output, "    <Format>text/xml; subtype=gml/3.1.1</Format>\n");
-  fprintf(o->output, "   </OutputFormats>\n");
-  fprintf(o->output, "  </GMLObjectType>\n");
+  ows_output_str(o, "  <GMLObjectType>\n");
+  ows_output_printf(o, "   <Name>gml:%s</Name>\n", type);
+  ows_output_str(o, "   <OutputFormats>\n");
+  ows_output_str(o, "    <Format>text/xml; subtype=gml/2.1.2</Format>\n");
+  ows_output_str(o, "    <Format>text/xml; subtype=gml/3.1.1</Format>\n");
+  ows_output_str(o, "   </OutputFormats>\n");
+  ows_output_str(o, "  </GMLObjectType>\n");
 }
 
 
@@ -84,7 +86,7 @@ static void wfs_gml_object_type_list(ows * o)
 {
   assert(o);
 
-  fprintf(o->output, " <SupportsGMLObjectTypeList>\n");
+  ows_output_str(o, " <SupportsGMLObjectTypeList>\n");
   wfs_gml_object_type(o, "AbstractGMLFeatureType");
   wfs_gml_object_type(o, "PointType");
   wfs_gml_object_type(o, "LineStringType");
@@ -92,7 +94,7 @@ static void wfs_gml_object_type_list(ows * o)
   wfs_gml_object_type(o, "MultiPointType");
   wfs_gml_object_type(o, "MultiLineStringType");
   wfs_gml_object_type(o, "MultiPolygonType");
-  fprintf(o->output, " </SupportsGMLObjectTypeList>\n");
+  ows_output_str(o, " </SupportsGMLObjectTypeList>\n");
 }
 
 
@@ -104,28 +106,28 @@ static void wfs_capability(ows * o)
 {
   assert(o);
 
-  fprintf(o->output, " <Capability>\n");
-  fprintf(o->output, "  <Request>\n");
-  fprintf(o->output, "   <GetCapabilities>\n");
+  ows_output_str(o, " <Capability>\n");
+  ows_output_str(o, "  <Request>\n");
+  ows_output_str(o, "   <GetCapabilities>\n");
   wfs_get_capabilities_dcpt_100(o, "");
-  fprintf(o->output, "   </GetCapabilities>\n");
-  fprintf(o->output, "   <DescribeFeatureType>\n");
-  fprintf(o->output, "     <SchemaDescriptionLanguage>\n");
-  fprintf(o->output, "        <XMLSCHEMA/>\n");
-  fprintf(o->output, "     </SchemaDescriptionLanguage>\n");
+  ows_output_str(o, "   </GetCapabilities>\n");
+  ows_output_str(o, "   <DescribeFeatureType>\n");
+  ows_output_str(o, "     <SchemaDescriptionLanguage>\n");
+  ows_output_str(o, "        <XMLSCHEMA/>\n");
+  ows_output_str(o, "     </SchemaDescriptionLanguage>\n");
   wfs_get_capabilities_dcpt_100(o, "");
-  fprintf(o->output, "   </DescribeFeatureType>\n");
-  fprintf(o->output, "   <GetFeature>\n");
-  fprintf(o->output, "<ResultFormat>\n");
-  fprintf(o->output, "<GML2/>\n");
-  fprintf(o->output, "</ResultFormat>\n");
+  ows_output_str(o, "   </DescribeFeatureType>\n");
+  ows_output_str(o, "   <GetFeature>\n");
+  ows_output_str(o, "<ResultFormat>\n");
+  ows_output_str(o, "<GML2/>\n");
+  ows_output_str(o, "</ResultFormat>\n");
   wfs_get_capabilities_dcpt_100(o, "");
-  fprintf(o->output, "   </GetFeature>\n");
-  fprintf(o->output, "   <Transaction>\n");
+  ows_output_str(o, "   </GetFeature>\n");
+  ows_output_str(o, "   <Transaction>\n");
   wfs_get_capabilities_dcpt_100(o, "");
-  fprintf(o->output, "   </Transaction>\n");
-  fprintf(o->output, "  </Request>\n");
-  fprintf(o->output, " </Capability>\n");
+  ows_output_str(o, "   </Transaction>\n");
+  ows_output_str(o, "  </Request>\n");
+  ows_output_str(o, " </Capability>\n");
 }
 
 
@@ -137,66 +139,66 @@ static void wfs_operations_metadata(ows * o)
 {
   assert(o);
 
-  fprintf(o->output, " <ows:OperationsMetadata>\n");
-  fprintf(o->output, "  <ows:Operation name='GetCapabilities'>\n");
+  ows_output_str(o, " <ows:OperationsMetadata>\n");
+  ows_output_str(o, "  <ows:Operation name='GetCapabilities'>\n");
   ows_get_capabilities_dcpt(o, "");
-  fprintf(o->output, "  <ows:Parameter name='AcceptVersions'>\n");
-  fprintf(o->output, "  <ows:Value>1.1.0</ows:Value>\n");
-  fprintf(o->output, "  <ows:Value>1.0.0</ows:Value>\n");
-  fprintf(o->output, "  </ows:Parameter>\n");
-  fprintf(o->output, "  <ows:Parameter name='AcceptFormats'>\n");
-  fprintf(o->output, "  <ows:Value>text/xml</ows:Value>\n");
-  fprintf(o->output, "  </ows:Parameter>\n");
-  fprintf(o->output, "  <ows:Parameter name='Sections'>\n");
-  fprintf(o->output, "  <ows:Value>ServiceIdentification</ows:Value>\n");
-  fprintf(o->output, "  <ows:Value>ServiceProvider</ows:Value>\n");
-  fprintf(o->output, "  <ows:Value>OperationsMetadata</ows:Value>\n");
-  fprintf(o->output, "  <ows:Value>FeatureTypeList</ows:Value>\n");
-  fprintf(o->output, "  <ows:Value>ServesGMLObjectTypeList</ows:Value>\n");
-  fprintf(o->output, "  <ows:Value>SupportsGMLObjectTypeList</ows:Value>\n");
-  fprintf(o->output, "  </ows:Parameter>\n");
-  fprintf(o->output, "   </ows:Operation>\n");
-  fprintf(o->output, "   <ows:Operation name='DescribeFeatureType'>\n");
+  ows_output_str(o, "  <ows:Parameter name='AcceptVersions'>\n");
+  ows_output_str(o, "  <ows:Value>1.1.0</ows:Value>\n");
+  ows_output_str(o, "  <ows:Value>1.0.0</ows:Value>\n");
+  ows_output_str(o, "  </ows:Parameter>\n");
+  ows_output_str(o, "  <ows:Parameter name='AcceptFormats'>\n");
+  ows_output_str(o, "  <ows:Value>text/xml</ows:Value>\n");
+  ows_output_str(o, "  </ows:Parameter>\n");
+  ows_output_str(o, "  <ows:Parameter name='Sections'>\n");
+  ows_output_str(o, "  <ows:Value>ServiceIdentification</ows:Value>\n");
+  ows_output_str(o, "  <ows:Value>ServiceProvider</ows:Value>\n");
+  ows_output_str(o, "  <ows:Value>OperationsMetadata</ows:Value>\n");
+  ows_output_str(o, "  <ows:Value>FeatureTypeList</ows:Value>\n");
+  ows_output_str(o, "  <ows:Value>ServesGMLObjectTypeList</ows:Value>\n");
+  ows_output_str(o, "  <ows:Value>SupportsGMLObjectTypeList</ows:Value>\n");
+  ows_output_str(o, "  </ows:Parameter>\n");
+  ows_output_str(o, "   </ows:Operation>\n");
+  ows_output_str(o, "   <ows:Operation name='DescribeFeatureType'>\n");
   ows_get_capabilities_dcpt(o, "");
-  fprintf(o->output, "  <ows:Parameter name='outputFormat'>\n");
-  fprintf(o->output, "  <ows:Value>text/xml; subtype=gml/3.1.1</ows:Value>\n");
-  fprintf(o->output, "  <ows:Value>text/xml; subtype=gml/2.1.2</ows:Value>\n");
-  fprintf(o->output, "  </ows:Parameter>\n");
-  fprintf(o->output, "   </ows:Operation>\n");
-  fprintf(o->output, "   <ows:Operation name='GetFeature'>\n");
+  ows_output_str(o, "  <ows:Parameter name='outputFormat'>\n");
+  ows_output_str(o, "  <ows:Value>text/xml; subtype=gml/3.1.1</ows:Value>\n");
+  ows_output_str(o, "  <ows:Value>text/xml; subtype=gml/2.1.2</ows:Value>\n");
+  ows_output_str(o, "  </ows:Parameter>\n");
+  ows_output_str(o, "   </ows:Operation>\n");
+  ows_output_str(o, "   <ows:Operation name='GetFeature'>\n");
   ows_get_capabilities_dcpt(o, "");
-  fprintf(o->output, "  <ows:Parameter name='resultType'>\n");
-  fprintf(o->output, "  <ows:Value>results</ows:Value>\n");
-  fprintf(o->output, "  <ows:Value>hits</ows:Value>\n");
-  fprintf(o->output, "  </ows:Parameter>\n");
-  fprintf(o->output, "  <ows:Parameter name='outputFormat'>\n");
-  fprintf(o->output, "  <ows:Value>text/xml; subtype=gml/3.1.1</ows:Value>\n");
-  fprintf(o->output, "  <ows:Value>text/xml; subtype=gml/2.1.2</ows:Value>\n");
-  fprintf(o->output, "  <ows:Value>application/json</ows:Value>\n");
-  fprintf(o->output, "  </ows:Parameter>\n");
-  fprintf(o->output, "   </ows:Operation>\n");
-  fprintf(o->output, "   <ows:Operation name='Transaction'>\n");
+  ows_output_str(o, "  <ows:Parameter name='resultType'>\n");
+  ows_output_str(o, "  <ows:Value>results</ows:Value>\n");
+  ows_output_str(o, "  <ows:Value>hits</ows:Value>\n");
+  ows_output_str(o, "  </ows:Parameter>\n");
+  ows_output_str(o, "  <ows:Parameter name='outputFormat'>\n");
+  ows_output_str(o, "  <ows:Value>text/xml; subtype=gml/3.1.1</ows:Value>\n");
+  ows_output_str(o, "  <ows:Value>text/xml; subtype=gml/2.1.2</ows:Value>\n");
+  ows_output_str(o, "  <ows:Value>application/json</ows:Value>\n");
+  ows_output_str(o, "  </ows:Parameter>\n");
+  ows_output_str(o, "   </ows:Operation>\n");
+  ows_output_str(o, "   <ows:Operation name='Transaction'>\n");
   ows_get_capabilities_dcpt(o, "");
-  fprintf(o->output, "    <ows:Parameter name='inputFormat'>\n");
-  fprintf(o->output, "     <ows:Value>text/xml; subtype=gml/3.1.1</ows:Value>\n");
-  fprintf(o->output, "    </ows:Parameter>\n");
-  fprintf(o->output, "    <ows:Parameter name='idgen'>\n");
-  fprintf(o->output, "     <ows:Value>GenerateNew</ows:Value>\n");
-  fprintf(o->output, "     <ows:Value>UseExisting</ows:Value>\n");
-  fprintf(o->output, "    </ows:Parameter>\n");
-  fprintf(o->output, "   </ows:Operation>\n");
+  ows_output_str(o, "    <ows:Parameter name='inputFormat'>\n");
+  ows_output_str(o, "     <ows:Value>text/xml; subtype=gml/3.1.1</ows:Value>\n");
+  ows_output_str(o, "    </ows:Parameter>\n");
+  ows_output_str(o, "    <ows:Parameter name='idgen'>\n");
+  ows_output_str(o, "     <ows:Value>GenerateNew</ows:Value>\n");
+  ows_output_str(o, "     <ows:Value>UseExisting</ows:Value>\n");
+  ows_output_str(o, "    </ows:Parameter>\n");
+  ows_output_str(o, "   </ows:Operation>\n");
   if (o->max_features) {
-    fprintf(o->output, "   <ows:Constraint name='DefaultMaxFeatures'>\n");
-    fprintf(o->output, "    <ows:Value>%d</ows:Value>\n", o->max_features);
-    fprintf(o->output, "   </ows:Constraint>\n");
+    ows_output_str(o, "   <ows:Constraint name='DefaultMaxFeatures'>\n");
+    ows_output_printf(o, "    <ows:Value>%d</ows:Value>\n", o->max_features);
+    ows_output_str(o, "   </ows:Constraint>\n");
   }
-  fprintf(o->output, "   <ows:Constraint name='LocalTraverseXLinkScope'>\n");
-  fprintf(o->output, "    <ows:Value>0</ows:Value>\n");
-  fprintf(o->output, "   </ows:Constraint>\n");
-  fprintf(o->output, "   <ows:Constraint name='RemoteTraverseXLinkScope'>\n");
-  fprintf(o->output, "    <ows:Value>0</ows:Value>\n");
-  fprintf(o->output, "   </ows:Constraint>\n");
-  fprintf(o->output, " </ows:OperationsMetadata>\n");
+  ows_output_str(o, "   <ows:Constraint name='LocalTraverseXLinkScope'>\n");
+  ows_output_str(o, "    <ows:Value>0</ows:Value>\n");
+  ows_output_str(o, "   </ows:Constraint>\n");
+  ows_output_str(o, "   <ows:Constraint name='RemoteTraverseXLinkScope'>\n");
+  ows_output_str(o, "    <ows:Value>0</ows:Value>\n");
+  ows_output_str(o, "   </ows:Constraint>\n");
+  ows_output_str(o, " </ows:OperationsMetadata>\n");
 }
 
 
@@ -218,32 +220,32 @@ static void wfs_feature_type_list(ows * o)
   writable = false;
   retrievable = false;
 
-  fprintf(o->output, " <FeatureTypeList>\n");
+  ows_output_str(o, " <FeatureTypeList>\n");
 
   /* print global operations */
 
   if (    ows_layer_list_retrievable(o->layers)
           || ows_layer_list_writable(o->layers))
-    fprintf(o->output, "  <Operations>\n");
+    ows_output_str(o, "  <Operations>\n");
 
   if (ows_layer_list_retrievable(o->layers)) {
     if (ows_version_get(o->request->version) == 100)
-      fprintf(o->output, "   <Query/>\n");
+      ows_output_str(o, "   <Query/>\n");
     else if (ows_version_get(o->request->version) == 110)
-      fprintf(o->output, " <Operation>Query</Operation>\n");
+      ows_output_str(o, " <Operation>Query</Operation>\n");
 
     retrievable = true;
   }
 
   if (ows_layer_list_writable(o->layers)) {
     if (ows_version_get(o->request->version) == 100) {
-      fprintf(o->output, "   <Insert/>\n");
-      fprintf(o->output, "   <Update/>\n");
-      fprintf(o->output, "   <Delete/>\n");
+      ows_output_str(o, "   <Insert/>\n");
+      ows_output_str(o, "   <Update/>\n");
+      ows_output_str(o, "   <Delete/>\n");
     } else if (ows_version_get(o->request->version) == 110) {
-      fprintf(o->output, "   <Operation>Insert</Operation>\n");
-      fprintf(o->output, "   <Operation>Update</Operation>\n");
-      fprintf(o->output, "   <Operation>Delete</Operation>\n");
+      ows_output_str(o, "   <Operation>Insert</Operation>\n");
+      ows_output_str(o, "   <Operation>Update</Operation>\n");
+      ows_output_str(o, "   <Operation>Delete</Operation>\n");
     }
 
     writable = true;
@@ -251,60 +253,60 @@ static void wfs_feature_type_list(ows * o)
 
   if (    ows_layer_list_retrievable(o->layers)
           || ows_layer_list_writable(o->layers))
-    fprintf(o->output, "  </Operations>\n");
+    ows_output_str(o, "  </Operations>\n");
 
   for (ln = o->layers->first ; ln ; ln = ln->next) {
     /* print each feature type */
     if (ows_layer_match_table(o, ln->layer->name)) {
 
-      fprintf(o->output, "<FeatureType xmlns:%s=\"%s\">\n",
-              ln->layer->ns_prefix->buf, ln->layer->ns_uri->buf);
+      ows_output_printf(o, "<FeatureType xmlns:%s=\"%s\">\n",
+                ln->layer->ns_prefix->buf, ln->layer->ns_uri->buf);
 
       /* name */
       if (ln->layer->name) {
-        for (s = 0; s < ln->layer->depth; s++) fprintf(o->output, " ");
+        for (s = 0; s < ln->layer->depth; s++) ows_output_str(o, " ");
 
-        fprintf(o->output, " <Name>");
-        buffer_flush(ows_layer_uri_to_prefix(o->layers, ln->layer->name), o->output);
-        fprintf(o->output, "</Name>\n");
+        ows_output_str(o, " <Name>");
+        ows_output_buffer(o, ows_layer_uri_to_prefix(o->layers, ln->layer->name));
+        ows_output_str(o, "</Name>\n");
       }
 
       /* title */
       if (ln->layer->title) {
-        for (s = 0; s < ln->layer->depth; s++) fprintf(o->output, " ");
+        for (s = 0; s < ln->layer->depth; s++) ows_output_str(o, " ");
 
-        fprintf(o->output, " <Title>");
-        buffer_flush(ln->layer->title, o->output);
-        fprintf(o->output, "</Title>\n");
+        ows_output_str(o, " <Title>");
+        ows_output_buffer(o, ln->layer->title);
+        ows_output_str(o, "</Title>\n");
       }
 
       /* abstract */
       if (ln->layer->abstract) {
-        for (s = 0; s < ln->layer->depth; s++) fprintf(o->output, " ");
+        for (s = 0; s < ln->layer->depth; s++) ows_output_str(o, " ");
 
-        fprintf(o->output, " <Abstract>");
-        buffer_flush(ln->layer->abstract, o->output);
-        fprintf(o->output, "</Abstract>\n");
+        ows_output_str(o, " <Abstract>");
+        ows_output_buffer(o, ln->layer->abstract);
+        ows_output_str(o, "</Abstract>\n");
       }
 
       /* keywords */
       if (ln->layer->keywords) {
-        for (s = 0; s < ln->layer->depth; s++) fprintf(o->output, " ");
+        for (s = 0; s < ln->layer->depth; s++) ows_output_str(o, " ");
 
-        fprintf(o->output, " <Keywords>");
+        ows_output_str(o, " <Keywords>");
 
         for (keyword = ln->layer->keywords->first ; keyword ; keyword = keyword->next) {
           if (ows_version_get(o->request->version) == 100) {
-            fprintf(o->output, "%s", keyword->value->buf);
-            if (keyword->next) fprintf(o->output, ",");
+            ows_output_str(o, keyword->value->buf);
+            if (keyword->next) ows_output_str(o, ",");
           } else if (ows_version_get(o->request->version) == 110) {
-            fprintf(o->output, "  <Keyword>");
-            fprintf(o->output, "%s", keyword->value->buf);
-            fprintf(o->output, "</Keyword>");
+            ows_output_str(o, "  <Keyword>");
+            ows_output_str(o, keyword->value->buf);
+            ows_output_str(o, "</Keyword>");
           }
         }
 
-        fprintf(o->output, "</Keywords>\n");
+        ows_output_str(o, "</Keywords>\n");
       }
 
       /* SRS */
@@ -319,25 +321,25 @@ static void wfs_feature_type_list(ows * o)
 
           if (srs && srs->use) {
             if (ows_version_get(o->request->version) == 100) {
-              fprintf(o->output, " <SRS>");
-              buffer_flush(srs, o->output);
-              fprintf(o->output, "</SRS>\n");
+              ows_output_str(o, " <SRS>");
+              ows_output_buffer(o, srs);
+              ows_output_str(o, "</SRS>\n");
             } else if (ows_version_get(o->request->version) == 110) {
-              fprintf(o->output, " <DefaultSRS>urn:ogc:def:crs:EPSG::%s</DefaultSRS>\n", srid->buf);
+              ows_output_printf(o, " <DefaultSRS>urn:ogc:def:crs:EPSG::%s</DefaultSRS>\n", srid->buf);
 
               if (ln->layer->srid) {
                 for (l_srid = ln->layer->srid->first; l_srid; l_srid = l_srid->next) {
                   if (!buffer_cmp(srid, l_srid->value->buf)) {
-                    fprintf(o->output, " <OtherSRS>urn:ogc:def:crs:EPSG::%s</OtherSRS>\n", l_srid->value->buf);
+                    ows_output_printf(o, " <OtherSRS>urn:ogc:def:crs:EPSG::%s</OtherSRS>\n", l_srid->value->buf);
                   }
                 }
               }
             }
           } else {
             if (ows_version_get(o->request->version) == 100)
-              fprintf(o->output, " <SRS></SRS>\n");
+              ows_output_str(o, " <SRS></SRS>\n");
             else if (ows_version_get(o->request->version) == 110)
-              fprintf(o->output, " <NoSRS/>");
+              ows_output_str(o, " <NoSRS/>");
           }
 
           buffer_free(srid);
@@ -347,33 +349,34 @@ static void wfs_feature_type_list(ows * o)
 
       /* Operations */
       if (retrievable != ln->layer->retrievable || writable != ln->layer->writable) {
-        fprintf(o->output, "  <Operations>\n");
+        ows_output_str(o, "  <Operations>\n");
 
         if (retrievable == false && ln->layer->retrievable == true) {
           if (ows_version_get(o->request->version) == 100)
-            fprintf(o->output, "   <Query/>\n");
+            ows_output_str(o, "   <Query/>\n");
           else if (ows_version_get(o->request->version) == 110)
-            fprintf(o->output, "   <Operation>Query</Operation>\n");
+            ows_output_str(o, "   <Operation>Query</Operation>\n");
         }
 
         if (writable == false && ln->layer->writable == true) {
           if (ows_version_get(o->request->version) == 100) {
-            fprintf(o->output, "   <Insert/>\n");
-            fprintf(o->output, "   <Update/>\n");
-            fprintf(o->output, "   <Delete/>\n");
+            ows_output_str(o, "   <Insert/>\n");
+            ows_output_str(o, "   <Update/>\n");
+            ows_output_str(o, "   <Delete/>\n");
           } else if (ows_version_get(o->request->version) == 110) {
-            fprintf(o->output, "   <Operation>Insert</Operation>\n");
-            fprintf(o->output, "   <Operation>Update</Operation>\n");
-            fprintf(o->output, "   <Operation>Delete</Operation>\n");
+            ows_output_str(o, "   <Operation>Insert</Operation>\n");
+            ows_output_str(o, "   <Operation>Update</Operation>\n");
+            ows_output_str(o, "   <Operation>Delete</Operation>\n");
           }
         }
 
-        fprintf(o->output, "  </Operations>\n");
+        ows_output_str(o, "  </Operations>\n");
       }
 
       /* Boundaries */
       if (!ln->layer->geobbox) {
-        gb = ows_geobbox_compute(o, ln->layer->name);
+        gb = ows_layer_extent(o, ln->layer);
+        if (gb) gb = ows_geobbox_copy(gb);
       } else {
         gb = ows_geobbox_init();
         gb->west = ln->layer->geobbox->west;
@@ -384,62 +387,62 @@ static void wfs_feature_type_list(ows * o)
 
       if( gb )
       {
-          for (s = 0; s < ln->layer->depth; s++) fprintf(o->output, " ");
+          for (s = 0; s < ln->layer->depth; s++) ows_output_str(o, " ");
 
           if (ows_version_get(o->request->version) == 100)
-            fprintf(o->output, " <LatLongBoundingBox");
+            ows_output_str(o, " <LatLongBoundingBox");
           else if (ows_version_get(o->request->version) == 110)
-            fprintf(o->output, " <ows:WGS84BoundingBox>");
+            ows_output_str(o, " <ows:WGS84BoundingBox>");
 
           if (gb->east != DBL_MIN) {
             if (ows_version_get(o->request->version) == 100) {
               if (gb->west < gb->east)
-                fprintf(o->output, " minx='%.*f'", o->degree_precision, gb->west);
+                ows_output_printf(o, " minx='%.*f'", o->degree_precision, gb->west);
               else
-                fprintf(o->output, " minx='%.*f'", o->degree_precision, gb->east);
+                ows_output_printf(o, " minx='%.*f'", o->degree_precision, gb->east);
 
               if (gb->north < gb->south)
-                fprintf(o->output, " miny='%.*f'", o->degree_precision, gb->north);
+                ows_output_printf(o, " miny='%.*f'", o->degree_precision, gb->north);
               else
-                fprintf(o->output, " miny='%.*f'", o->degree_precision, gb->south);
+                ows_output_printf(o, " miny='%.*f'", o->degree_precision, gb->south);
 
               if (gb->west < gb->east)
-                fprintf(o->output, " maxx='%.*f'", o->degree_precision, gb->east);
+                ows_output_printf(o, " maxx='%.*f'", o->degree_precision, gb->east);
               else
-                fprintf(o->output, " maxx='%.*f'", o->degree_precision, gb->west);
+                ows_output_printf(o, " maxx='%.*f'", o->degree_precision, gb->west);
 
               if (gb->north < gb->south)
-                fprintf(o->output, " maxy='%.*f'", o->degree_precision, gb->south);
+                ows_output_printf(o, " maxy='%.*f'", o->degree_precision, gb->south);
               else
-                fprintf(o->output, " maxy='%.*f'", o->degree_precision, gb->north);
+                ows_output_printf(o, " maxy='%.*f'", o->degree_precision, gb->north);
 
-              fprintf(o->output, " />\n");
+              ows_output_str(o, " />\n");
             } else if (ows_version_get(o->request->version) == 110) {
-              fprintf(o->output, " <ows:LowerCorner>%.*f %.*f</ows:LowerCorner>",
-                      o->degree_precision, gb->west, o->degree_precision, gb->south);
-              fprintf(o->output, " <ows:UpperCorner>%.*f %.*f</ows:UpperCorner>",
-                      o->degree_precision, gb->east, o->degree_precision, gb->north);
+              ows_output_printf(o, " <ows:LowerCorner>%.*f %.*f</ows:LowerCorner>",
+                        o->degree_precision, gb->west, o->degree_precision, gb->south);
+              ows_output_printf(o, " <ows:UpperCorner>%.*f %.*f</ows:UpperCorner>",
+                        o->degree_precision, gb->east, o->degree_precision, gb->north);
             }
           } else {
             if (ows_version_get(o->request->version) == 100) {
-              fprintf(o->output, " minx='0' miny='0' maxx='0' maxy='0'/>\n");
+              ows_output_str(o, " minx='0' miny='0' maxx='0' maxy='0'/>\n");
             } else if (ows_version_get(o->request->version) == 110) {
-              fprintf(o->output, " <ows:LowerCorner>0 0</ows:LowerCorner>");
-              fprintf(o->output, " <ows:UpperCorner>0 0</ows:UpperCorner>");
+              ows_output_str(o, " <ows:LowerCorner>0 0</ows:LowerCorner>");
+              ows_output_str(o, " <ows:UpperCorner>0 0</ows:UpperCorner>");
             }
           }
 
           if (ows_version_get(o->request->version) == 110)
-            fprintf(o->output, " </ows:WGS84BoundingBox>\n");
+            ows_output_str(o, " </ows:WGS84BoundingBox>\n");
 
           ows_geobbox_free(gb);
       }
 
-      fprintf(o->output, "</FeatureType>\n");
+      ows_output_str(o, "</FeatureType>\n");
     }
   }
 
-  fprintf(o->output, " </FeatureTypeList>\n");
+  ows_output_str(o, " </FeatureTypeList>\n");
 }
 
 
@@ -453,22 +456,17 @@ static void wfs_get_capabilities_110(ows * o, wfs_request * wr)
   assert(o);
   assert(wr);
 
-  if (wr->format == WFS_TEXT_XML)
-    fprintf(o->output, "Content-Type: text/xml\n\n");
-  else
-    fprintf(o->output, "Content-Type: application/xml\n\n");
-
-  fprintf(o->output, "<?xml version='1.0' encoding='%s'?>\n", o->encoding->buf);
-  fprintf(o->output, "<WFS_Capabilities");
-  fprintf(o->output, " version='1.1.0' updateSequence='0'\n");
-  fprintf(o->output, "  xmlns='http://www.opengis.net/wfs'\n");
-  fprintf(o->output, "  xmlns:xsi='http://www.w3.org/2001/XMLSchema-instance'\n");
-  fprintf(o->output, "  xmlns:ogc='http://www.opengis.net/ogc'\n");
-  fprintf(o->output, "  xmlns:gml='http://www.opengis.net/gml'\n");
-  fprintf(o->output, "  xmlns:ows='http://www.opengis.net/ows'\n");
-  fprintf(o->output, "  xmlns:xlink='http://www.w3.org/1999/xlink'\n");
-  fprintf(o->output, "  xsi:schemaLocation='http://www.opengis.net/wfs\n");
-  fprintf(o->output, "  http://schemas.opengis.net/wfs/1.1.0/wfs.xsd' >\n");
+  ows_output_printf(o, "<?xml version='1.0' encoding='%s'?>\n", o->encoding->buf);
+  ows_output_str(o, "<WFS_Capabilities");
+  ows_output_str(o, " version='1.1.0' updateSequence='0'\n");
+  ows_output_str(o, "  xmlns='http://www.opengis.net/wfs'\n");
+  ows_output_str(o, "  xmlns:xsi='http://www.w3.org/2001/XMLSchema-instance'\n");
+  ows_output_str(o, "  xmlns:ogc='http://www.opengis.net/ogc'\n");
+  ows_output_str(o, "  xmlns:gml='http://www.opengis.net/gml'\n");
+  ows_output_str(o, "  xmlns:ows='http://www.opengis.net/ows'\n");
+  ows_output_str(o, "  xmlns:xlink='http://www.w3.org/1999/xlink'\n");
+  ows_output_str(o, "  xsi:schemaLocation='http://www.opengis.net/wfs\n");
+  ows_output_str(o, "  http://schemas.opengis.net/wfs/1.1.0/wfs.xsd' >\n");
 
   name = buffer_init();
 
@@ -530,8 +528,7 @@ static void wfs_get_capabilities_110(ows * o, wfs_request * wr)
      are supported by the wfs */
   fe_filter_capabilities_110(o);
 
-  fprintf(o->output, "</WFS_Capabilities>\n");
-  fclose(o->output);
+  ows_output_str(o, "</WFS_Capabilities>\n");
 
   buffer_free(name);
 }
@@ -545,15 +542,14 @@ static void wfs_get_capabilities_100(ows * o, wfs_request * wr)
   assert(o);
   assert(wr);
 
-  fprintf(o->output, "Content-Type: application/xml\n\n");
-  fprintf(o->output, "<?xml version='1.0' encoding='%s'?>\n", o->encoding->buf);
-  fprintf(o->output, "<WFS_Capabilities\n");
-  fprintf(o->output, "version='1.0.0' updateSequence='0'\n");
-  fprintf(o->output, " xmlns='http://www.opengis.net/wfs'\n");
-  fprintf(o->output, " xmlns:xsi='http://www.w3.org/2001/XMLSchema-instance'\n");
-  fprintf(o->output, " xmlns:ogc='http://www.opengis.net/ogc'\n");
-  fprintf(o->output, " xsi:schemaLocation='http://www.opengis.net/wfs\n");
-  fprintf(o->output, " http://schemas.opengis.net/wfs/1.0.0/WFS-capabilities.xsd' >\n");
+  ows_output_printf(o, "<?xml version='1.0' encoding='%s'?>\n", o->encoding->buf);
+  ows_output_str(o, "<WFS_Capabilities\n");
+  ows_output_str(o, "version='1.0.0' updateSequence='0'\n");
+  ows_output_str(o, " xmlns='http://www.opengis.net/wfs'\n");
+  ows_output_str(o, " xmlns:xsi='http://www.w3.org/2001/XMLSchema-instance'\n");
+  ows_output_str(o, " xmlns:ogc='http://www.opengis.net/ogc'\n");
+  ows_output_str(o, " xsi:schemaLocation='http://www.opengis.net/wfs\n");
+  ows_output_str(o, " http://schemas.opengis.net/wfs/1.0.0/WFS-capabilities.xsd' >\n");
 
   /* Service Section : provides information about the service iself */
   ows_service_metadata(o);
@@ -570,8 +566,135 @@ static void wfs_get_capabilities_100(ows * o, wfs_request * wr)
      are supported by the wfs */
   fe_filter_capabilities_100(o);
 
-  fprintf(o->output, "</WFS_Capabilities>\n");
-  fclose(o->output);
+  ows_output_str(o, "</WFS_Capabilities>\n");
+}
+
+
+/*
+ * Initialize a capabilities cache structure, for arena_heap
+ */
+static void *wfs_capabilities_cache_init(void)
+{
+  wfs_capabilities_cache *c;
+
+  c = malloc(sizeof(wfs_capabilities_cache));
+  assert(c);
+
+  c->doc = buffer_init();
+  c->etag = buffer_init();
+  c->time = 0;
+
+  return c;
+}
+
+
+/*
+ * Free a capabilities cache structure
+ */
+void wfs_capabilities_cache_free(wfs_capabilities_cache * c)
+{
+  assert(c);
+
+  buffer_free(c->doc);
+  buffer_free(c->etag);
+  free(c);
+  c = NULL;
+}
+
+
+/*
+ * Invalidate rendered capabilities documents
+ * (i.e when layers extent changed)
+ */
+void wfs_capabilities_cache_reset(ows * o)
+{
+  assert(o);
+
+  if (o->capabilities_wfs_100) o->capabilities_wfs_100->time = 0;
+  if (o->capabilities_wfs_110) o->capabilities_wfs_110->time = 0;
+}
+
+
+/*
+ * Render capabilities body into the cache
+ * Return false if the document can't be cached
+ */
+static bool wfs_capabilities_cache_render(ows * o, wfs_request * wr, wfs_capabilities_cache * c, int version)
+{
+  buffer *previous;
+  unsigned long long hash;
+  char etag[20];
+  size_t n;
+
+  assert(o);
+  assert(wr);
+  assert(c);
+
+  buffer_empty(c->doc);
+  previous = ows_output_capture(o, c->doc);
+
+  if (version == 100) wfs_get_capabilities_100(o, wr);
+  else                wfs_get_capabilities_110(o, wr);
+
+  ows_output_capture(o, previous);
+
+  /* Something went wrong, document is sent as is but not kept */
+  if (o->exit) {
+    c->time = 0;
+    return false;
+  }
+
+  /* FNV-1a hash of the document */
+  for (hash = 14695981039346656037ULL, n = 0 ; n < c->doc->use ; n++) {
+    hash ^= (unsigned char) c->doc->buf[n];
+    hash *= 1099511628211ULL;
+  }
+
+  sprintf(etag, "\"%016llx\"", hash);
+  buffer_empty(c->etag);
+  buffer_add_str(c->etag, etag);
+  c->time = time(NULL);
+
+  return true;
+}
+
+
+/*
+ * Write capabilities from the cache, rendering it first if needed
+ */
+static void wfs_get_capabilities_cached(ows * o, wfs_request * wr, int version, const char *content_type)
+{
+  wfs_capabilities_cache **c;
+  char *etag;
+
+  assert(o);
+  assert(wr);
+  assert(content_type);
+
+  c = (version == 100) ? &o->capabilities_wfs_100 : &o->capabilities_wfs_110;
+  if (!*c) *c = arena_heap(wfs_capabilities_cache_init);
+
+  if (!(*c)->time || time(NULL) - (*c)->time >= o->capabilities_ttl) {
+    if (!wfs_capabilities_cache_render(o, wr, *c, version)) {
+      /* Error report already holds its own headers */
+      ows_output_buffer(o, (*c)->doc);
+      buffer_empty((*c)->doc);
+      return;
+    }
+  }
+
+  /* Client already owns this document */
+  etag = getenv("HTTP_IF_NONE_MATCH");
+  if (etag && strstr(etag, (*c)->etag->buf)) {
+    ows_output_str(o, "Status: 304 Not Modified\n");
+    ows_output_printf(o, "ETag: %s\n\n", (*c)->etag->buf);
+    return;
+  }
+
+  ows_output_printf(o, "Content-Type: %s\n", content_type);
+  ows_output_printf(o, "Content-Length: %lu\n", (unsigned long) (*c)->doc->use);
+  ows_output_printf(o, "ETag: %s\n\n", (*c)->etag->buf);
+  ows_output_buffer(o, (*c)->doc);
 }
 
 
@@ -581,11 +704,27 @@ static void wfs_get_capabilities_100(ows * o, wfs_request * wr)
 void wfs_get_capabilities(ows * o, wfs_request * wr)
 {
   int version;
+  char *content_type;
 
   assert(o);
   assert(wr);
 
   version = ows_version_get(o->request->version);
+  if (version != 100 && version != 110) return;
+
+  if (version == 110 && wr->format == WFS_TEXT_XML) content_type = "text/xml";
+  else                                              content_type = "application/xml";
+
+  /* Only whole documents are kept in cache */
+  if (o->capabilities_ttl > 0
+      && (!wr->sections || buffer_case_cmp(wr->sections->first->value, "all"))) {
+    wfs_get_capabilities_cached(o, wr, version, content_type);
+    ows_output_flush(o);
+    fclose(o->output);
+    return;
+  }
+
+  ows_output_printf(o, "Content-Type: %s\n\n", content_type);
 
   switch (version) {
     case 100:
@@ -595,6 +734,9 @@ void wfs_get_capabilities(ows * o, wfs_request * wr)
       wfs_get_capabilities_110(o, wr);
       break;
   }
+
+  ows_output_flush(o);
+  fclose(o->output);
 }
 
 
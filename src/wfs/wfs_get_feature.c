@@ -48,183 +48,237 @@ static void wfs_gml_bounded_by(ows * o, wfs_request * wr, double xmin, double ym
 
   if (!srs->srid || srs->srid == -1 || (xmin == ymin && xmax == ymax && xmin == xmax)) {
     if (ows_version_get(o->request->version) == 100)
-      fprintf(o->output, "<gml:boundedBy><gml:null>missing</gml:null></gml:boundedBy>\n");
+      ows_output_str(o, "<gml:boundedBy><gml:null>missing</gml:null></gml:boundedBy>\n");
     else return; /* No Null boundedBy in WFS 1.1.0 SF-0 */
 
   } else {
-    fprintf(o->output, "<gml:boundedBy>\n");
+    ows_output_str(o, "<gml:boundedBy>\n");
 
     if (wr->format == WFS_GML212) {
-      fprintf(o->output, "  <gml:Box srsName=\"");
-      if (strcmp(srs->auth_name->buf, "EPSG")) fprintf(o->output, "%s:", srs->auth_name->buf);
-      else if (srs->is_long) fprintf(o->output, "urn:ogc:def:crs:EPSG::");
-      else fprintf(o->output, "EPSG:");
-      fprintf(o->output, "%d\">", srs->srid);
+      ows_output_str(o, "  <gml:Box srsName=\"");
+      if (strcmp(srs->auth_name->buf, "EPSG")) ows_output_printf(o, "%s:", srs->auth_name->buf);
+      else if (srs->is_long) ows_output_str(o, "urn:ogc:def:crs:EPSG::");
+      else ows_output_str(o, "EPSG:");
+      ows_output_printf(o, "%d\">", srs->srid);
 
       if (fabs(xmin) > OWS_MAX_DOUBLE || fabs(ymin) > OWS_MAX_DOUBLE ||
           fabs(xmax) > OWS_MAX_DOUBLE || fabs(ymax) > OWS_MAX_DOUBLE)
-        fprintf(o->output, "<gml:coordinates decimal=\".\" cs=\",\" ts=\" \">%g,%g %g,%g</gml:coordinates>",
-                xmin, ymin, xmax, ymax);
-      else fprintf(o->output, "<gml:coordinates decimal=\".\" cs=\",\" ts=\" \">%.*f,%.*f %.*f,%.*f</gml:coordinates>",
-                     precision, xmin, precision, ymin, precision, xmax, precision, ymax);
-      fprintf(o->output, "</gml:Box>\n");
+        ows_output_printf(o, "<gml:coordinates decimal=\".\" cs=\",\" ts=\" \">%g,%g %g,%g</gml:coordinates>",
+                  xmin, ymin, xmax, ymax);
+      else ows_output_printf(o, "<gml:coordinates decimal=\".\" cs=\",\" ts=\" \">%.*f,%.*f %.*f,%.*f</gml:coordinates>",
+                       precision, xmin, precision, ymin, precision, xmax, precision, ymax);
+      ows_output_str(o, "</gml:Box>\n");
 
     } else if (wr->format == WFS_GML311) {
-      fprintf(o->output, "  <gml:Envelope srsName=\"");
-      if (strcmp(srs->auth_name->buf, "EPSG")) fprintf(o->output, "%s:", srs->auth_name->buf);
-      else if (srs->is_long) fprintf(o->output, "urn:ogc:def:crs:EPSG::");
-      else fprintf(o->output, "EPSG:");
-      fprintf(o->output, "%d\">", srs->srid);
+      ows_output_str(o, "  <gml:Envelope srsName=\"");
+      if (strcmp(srs->auth_name->buf, "EPSG")) ows_output_printf(o, "%s:", srs->auth_name->buf);
+      else if (srs->is_long) ows_output_str(o, "urn:ogc:def:crs:EPSG::");
+      else ows_output_str(o, "EPSG:");
+      ows_output_printf(o, "%d\">", srs->srid);
 
       if (srs->honours_authority_axis_order && !srs->is_axis_order_gis_friendly) {
         if (fabs(xmin) > OWS_MAX_DOUBLE || fabs(ymin) > OWS_MAX_DOUBLE ||
             fabs(xmax) > OWS_MAX_DOUBLE || fabs(ymax) > OWS_MAX_DOUBLE) {
-          fprintf(o->output, "<gml:lowerCorner>%g %g</gml:lowerCorner>", ymin, xmin);
-          fprintf(o->output, "<gml:upperCorner>%g %g</gml:upperCorner>", ymax, xmax);
+          ows_output_printf(o, "<gml:lowerCorner>%g %g</gml:lowerCorner>", ymin, xmin);
+          ows_output_printf(o, "<gml:upperCorner>%g %g</gml:upperCorner>", ymax, xmax);
         } else {
-          fprintf(o->output, "<gml:lowerCorner>%.*f %.*f</gml:lowerCorner>", precision, ymin, precision, xmin);
-          fprintf(o->output, "<gml:upperCorner>%.*f %.*f</gml:upperCorner>", precision, ymax, precision, xmax);
+          ows_output_printf(o, "<gml:lowerCorner>%.*f %.*f</gml:lowerCorner>", precision, ymin, precision, xmin);
+          ows_output_printf(o, "<gml:upperCorner>%.*f %.*f</gml:upperCorner>", precision, ymax, precision, xmax);
         }
       } else {
         if (fabs(xmin) > OWS_MAX_DOUBLE || fabs(ymin) > OWS_MAX_DOUBLE ||
             fabs(xmax) > OWS_MAX_DOUBLE || fabs(ymax) > OWS_MAX_DOUBLE) {
-          fprintf(o->output, "<gml:lowerCorner>%g %g</gml:lowerCorner>", xmin, ymin);
-          fprintf(o->output, "<gml:upperCorner>%g %g</gml:upperCorner>", xmax, ymax);
+          ows_output_printf(o, "<gml:lowerCorner>%g %g</gml:lowerCorner>", xmin, ymin);
+          ows_output_printf(o, "<gml:upperCorner>%g %g</gml:upperCorner>", xmax, ymax);
         } else {
-          fprintf(o->output, "<gml:lowerCorner>%.*f %.*f</gml:lowerCorner>", precision, xmin, precision, ymin);
-          fprintf(o->output, "<gml:upperCorner>%.*f %.*f</gml:upperCorner>", precision, xmax, precision, ymax);
+          ows_output_printf(o, "<gml:lowerCorner>%.*f %.*f</gml:lowerCorner>", precision, xmin, precision, ymin);
+          ows_output_printf(o, "<gml:upperCorner>%.*f %.*f</gml:upperCorner>", precision, xmax, precision, ymax);
         }
       }
-      fprintf(o->output, "</gml:Envelope>\n");
+      ows_output_str(o, "</gml:Envelope>\n");
     }
 
-    fprintf(o->output, "</gml:boundedBy>\n");
+    ows_output_str(o, "</gml:boundedBy>\n");
   }
 }
 
 
 /*
- * Display the properties of one feature
+ * Build the GML render plan of a layer: what to do with each
+ * column of the result, and the tags to write, are resolved once
+ * so the rows loop doesn't look up layers or compare type names anymore
  */
-void wfs_gml_display_feature(ows * o, wfs_request * wr,
-                             buffer * layer_name, buffer * prefix,
-                             char * prop_name, buffer * prop_type, char * value)
+wfs_gml_plan *wfs_gml_plan_init(ows * o, wfs_request * wr, buffer * layer_name, list * properties, PGresult * res)
 {
-  buffer *time, *pkey, *value_encoded, *prop_name_buffer;
-  bool gml_ns = false;
-  assert(layer_name && prop_name);
-  assert(prop_type);
-  assert(prefix);
-  assert(value);
-  assert(layer_name && prop_name && prop_type && prefix && value && wr && o);
+  wfs_gml_plan *plan;
+  wfs_gml_column *c;
+  buffer *id_name, *ns_prefix, *prefixed;
+  ows_layer *l;
+  list *not_null;
+  char *name;
+  int j;
 
-  pkey = ows_psql_id_column(o, layer_name); /* CAUTION: pkey could be NULL ! */
+  assert(o && wr && res && layer_name);
+
+  /* CAUTION: Properties could be NULL ! */
 
-  /* No Pkey display in GML (default behaviour) */
-  if (pkey && pkey->buf && !strcmp(prop_name, pkey->buf) && !o->expose_pk) return;
+  plan = malloc(sizeof(wfs_gml_plan));
+  assert(plan);
+
+  l = ows_layer_get(o->layers, layer_name);
+  id_name = ows_psql_id_column(o, layer_name);
+  ns_prefix = ows_layer_ns_prefix(o->layers, ows_layer_uri_to_prefix(o->layers, layer_name));
+  prefixed = ows_layer_uri_to_prefix(o->layers, layer_name);
+  not_null = ows_psql_not_null_properties(o, layer_name);
 
-  /* Avoid to expose elements from gml_exclude_items */
-  prop_name_buffer = buffer_from_str(prop_name);
+  /* print layer's name and id according to GML version */
+  plan->member_open = buffer_from_str("  <gml:featureMember>\n   <");
+  buffer_copy(plan->member_open, prefixed);
+
+  /* CAUTION: We could imagine layer without PK ! */
+  plan->id_column = (id_name && id_name->use) ? PQfnumber(res, id_name->buf) : -1;
+  if (plan->id_column != -1) {
+    buffer_add_str(plan->member_open, wr->format == WFS_GML311 ? " gml:id=\"" : " fid=\"");
+    buffer_copy(plan->member_open, ows_layer_no_uri(o->layers, layer_name));
+    buffer_add(plan->member_open, '.');
+  } else buffer_add_str(plan->member_open, ">\n");
+
+  plan->member_close = buffer_from_str("   </");
+  buffer_copy(plan->member_close, prefixed);
+  buffer_add_str(plan->member_close, ">\n  </gml:featureMember>\n");
+
+  plan->nb_fields = PQnfields(res);
+  plan->columns = malloc(sizeof(wfs_gml_column) * (plan->nb_fields ? plan->nb_fields : 1));
+  assert(plan->columns);
+
+  for (j = 0 ; j < plan->nb_fields ; j++) {
+    c = &plan->columns[j];
+    c->value = WFS_GML_VALUE_SKIP;
+    c->open = c->close = NULL;
+    name = PQfname(res, j);
+
+    if (    properties
+         && !in_list_str(properties, name)
+         && !buffer_cmp(properties->first->value, "*")
+         && !(not_null && in_list_str(not_null, name))
+         && !(l->gml_ns && in_list_str(l->gml_ns, name))) continue;
+
+    /* No Pkey display in GML (default behaviour) */
+    if (id_name && id_name->buf && !strcmp(name, id_name->buf) && !o->expose_pk) continue;
+
+    /* Avoid to expose elements from gml_exclude_items */
+    if (l->exclude_items && in_list_str(l->exclude_items, name)) continue;
+
+    /* PSQL date and boolean must be transformed into GML format */
+    switch (ows_psql_column_type(o, layer_name, name)) {
+      case OWS_PSQL_TYPE_TIMESTAMP:
+      case OWS_PSQL_TYPE_DATE:    c->value = WFS_GML_VALUE_TIME; break;
+      case OWS_PSQL_TYPE_BOOL:    c->value = WFS_GML_VALUE_BOOL; break;
+      case OWS_PSQL_TYPE_TEXT:
+      case OWS_PSQL_TYPE_VARCHAR:
+      case OWS_PSQL_TYPE_CHAR:
+      case OWS_PSQL_TYPE_HSTORE:  c->value = WFS_GML_VALUE_TEXT; break;
+      default:                    c->value = WFS_GML_VALUE_RAW;
+    }
+
+    /* We have to check if we use gml ns or not */
+    c->open = buffer_from_str("   <");
+    c->close = buffer_from_str("</");
+    if (l->gml_ns && in_list_str(l->gml_ns, name)) {
+      buffer_add_str(c->open, "gml");
+      buffer_add_str(c->close, "gml");
+    } else {
+      buffer_copy(c->open, ns_prefix);
+      buffer_copy(c->close, ns_prefix);
+    }
+    buffer_add(c->open, ':');
+    buffer_add_str(c->open, name);
+    buffer_add(c->open, '>');
+    buffer_add(c->close, ':');
+    buffer_add_str(c->close, name);
+    buffer_add_str(c->close, ">\n");
+  }
+
+  return plan;
+}
+
+
+void wfs_gml_plan_free(wfs_gml_plan * plan)
+{
+  int j;
+
+  assert(plan);
+
+  for (j = 0 ; j < plan->nb_fields ; j++) {
+    if (plan->columns[j].open)  buffer_free(plan->columns[j].open);
+    if (plan->columns[j].close) buffer_free(plan->columns[j].close);
+  }
 
-  if ((ows_layer_get(o->layers, layer_name))->exclude_items
-       && in_list(ows_layer_get(o->layers, layer_name)->exclude_items, prop_name_buffer)) return;
+  buffer_free(plan->member_open);
+  buffer_free(plan->member_close);
+  free(plan->columns);
+  free(plan);
+}
 
-  buffer_free(prop_name_buffer);
 
-  if (strlen(value) == 0) return; /* Don't display empty property */
+/*
+ * Display the value of one feature property, according to its render plan
+ */
+static void wfs_gml_display_feature(ows * o, const wfs_gml_column * c, char * value)
+{
+  buffer *time;
 
-  /* We have to check if we use gml ns or not */
-  if ((ows_layer_get(o->layers, layer_name))->gml_ns
-      && (in_list_str((ows_layer_get(o->layers, layer_name))->gml_ns, prop_name))) gml_ns = true;
+  assert(o && c && value);
 
-  if (gml_ns) fprintf(o->output, "   <gml:%s>", prop_name);
-  else        fprintf(o->output, "   <%s:%s>", prefix->buf, prop_name);
+  if (c->value == WFS_GML_VALUE_SKIP) return;
+  if (!value[0]) return; /* Don't display empty property */
 
+  ows_output_buffer(o, c->open);
 
-  /* PSQL date must be transformed into GML format */
-  if (    buffer_cmp(prop_type, "timestamptz")
-       || buffer_cmp(prop_type, "timestamp")
-       || buffer_cmp(prop_type, "datetime")
-       || buffer_cmp(prop_type, "date")) {
+  switch (c->value) {
+  case WFS_GML_VALUE_TIME:
     time = ows_psql_timestamp_to_xml_time(value);
-    fprintf(o->output, "%s", time->buf);
+    ows_output_buffer(o, time);
     buffer_free(time);
+    break;
 
-    /* PSQL boolean must be transformed into GML format */
-  } else if (buffer_cmp(prop_type, "bool")) {
-    if (!strcmp(value, "t")) fprintf(o->output, "true");
-    if (!strcmp(value, "f")) fprintf(o->output, "false");
-
-  } else if (    buffer_cmp(prop_type, "text")
-              || buffer_cmp(prop_type, "hstore")
-              || buffer_ncmp(prop_type, "char", 4)
-              || buffer_ncmp(prop_type, "varchar", 7)) {
+  case WFS_GML_VALUE_BOOL:
+    if (!strcmp(value, "t")) ows_output_str(o, "true");
+    if (!strcmp(value, "f")) ows_output_str(o, "false");
+    break;
 
-    value_encoded = buffer_encode_xml_entities_str(value);
-    fprintf(o->output, "%s", value_encoded->buf);
-    buffer_free(value_encoded);
+  case WFS_GML_VALUE_TEXT:
+    ows_output_xml(o, value);
+    break;
 
-  } else fprintf(o->output, "%s", value);
+  default:
+    ows_output_str(o, value);
+  }
 
-  if (gml_ns) fprintf(o->output, "</gml:%s>\n", prop_name);
-  else        fprintf(o->output, "</%s:%s>\n", prefix->buf, prop_name);
+  ows_output_buffer(o, c->close);
 }
 
 
 /*
  * Display in GML all feature members returned by the request
  */
-void wfs_gml_feature_member(ows * o, wfs_request * wr, buffer * layer_name, list * properties, PGresult * res)
+void wfs_gml_feature_member(ows * o, const wfs_gml_plan * plan, PGresult * res)
 {
-  int i, j, number, end, nb_fields;
-  buffer *id_name, *ns_prefix, *prop_type, *layer;
-  array * describe;
-  assert(o && wr && res && layer_name);
+  int i, j, end;
 
-  /* CAUTION: Properties could be NULL ! */
+  assert(o && plan && res);
 
-  number = -1;
-  id_name = ows_psql_id_column(o, layer_name);
-
-  /* CAUTION: We could imagine layer without PK ! */
-  if (id_name && id_name->use) number = PQfnumber(res, id_name->buf);
-
-  ns_prefix = ows_layer_ns_prefix(o->layers, ows_layer_uri_to_prefix(o->layers, layer_name));
-  describe = ows_psql_describe_table(o, layer_name);
-
-  /* display the results in gml */
   for (i = 0, end = PQntuples(res); i < end; i++) {
-    fprintf(o->output, "  <gml:featureMember>\n");
-
-     layer = ows_layer_no_uri(o->layers, layer_name);
-
-    /* print layer's name and id according to GML version */
-    if (id_name && id_name->use) {
-      if (wr->format == WFS_GML311)
-        fprintf(o->output,  "   <%s gml:id=\"%s.%s\">\n",
-                ows_layer_uri_to_prefix(o->layers, layer_name)->buf,
-                layer->buf, PQgetvalue(res, i, number));
-      else fprintf(o->output, "   <%s fid=\"%s.%s\">\n",
-                      ows_layer_uri_to_prefix(o->layers, layer_name)->buf,
-                      layer->buf, PQgetvalue(res, i, number));
-    } else fprintf(o->output,   "   <%s>\n", ows_layer_uri_to_prefix(o->layers, layer_name)->buf);
-
-    /* print properties */
-    for (j = 0, nb_fields = PQnfields(res) ; j < nb_fields ; j++) {
-      if (    !properties
-           || in_list_str(properties, PQfname(res, j))
-           || buffer_cmp(properties->first->value, "*")
-           || (ows_psql_not_null_properties(o, layer_name)
-              && in_list_str(ows_psql_not_null_properties(o, layer_name), PQfname(res, j)))
-           || ((ows_layer_get(o->layers, layer_name))->gml_ns
-              && in_list_str((ows_layer_get(o->layers, layer_name))->gml_ns, PQfname(res, j)))) {
-        prop_type = array_get(describe, PQfname(res, j));
-        wfs_gml_display_feature(o, wr, layer_name, ns_prefix, PQfname(res,j), prop_type, PQgetvalue(res, i ,j));
-      }
+    ows_output_buffer(o, plan->member_open);
+    if (plan->id_column != -1) {
+      ows_output_str(o, PQgetvalue(res, i, plan->id_column));
+      ows_output_str(o, "\">\n");
     }
 
-    fprintf(o->output, "   </%s>\n", ows_layer_uri_to_prefix(o->layers, layer_name)->buf);
-    fprintf(o->output, "  </gml:featureMember>\n");
+    for (j = 0 ; j < plan->nb_fields ; j++)
+      wfs_gml_display_feature(o, &plan->columns[j], PQgetvalue(res, i, j));
+
+    ows_output_buffer(o, plan->member_close);
   }
 }
 
@@ -245,55 +299,55 @@ static void wfs_gml_display_namespaces(ows * o, wfs_request * wr)
   assert(namespaces);
 
   if (wr->format == WFS_GML212)
-    fprintf(o->output, "Content-Type: text/xml; subtype=gml/2.1.2\n\n");
+    ows_output_str(o, "Content-Type: text/xml; subtype=gml/2.1.2\n\n");
   else if (wr->format == WFS_GML311)
-    fprintf(o->output, "Content-Type: text/xml; subtype=gml/3.1.1\n\n");
+    ows_output_str(o, "Content-Type: text/xml; subtype=gml/3.1.1\n\n");
 
-  fprintf(o->output, "<?xml version='1.0' encoding='%s'?>\n", o->encoding->buf);
-  fprintf(o->output, "<wfs:FeatureCollection\n");
+  ows_output_printf(o, "<?xml version='1.0' encoding='%s'?>\n", o->encoding->buf);
+  ows_output_str(o, "<wfs:FeatureCollection\n");
 
   for (an = namespaces->first; an != NULL; an = an->next)
-    fprintf(o->output, " xmlns:%s='%s'\n", an->key->buf, an->value->buf);
+    ows_output_printf(o, " xmlns:%s='%s'\n", an->key->buf, an->value->buf);
 
-  fprintf(o->output, " xmlns:wfs='http://www.opengis.net/wfs'\n");
-  fprintf(o->output, " xmlns:xsi='http://www.w3.org/2001/XMLSchema-instance'\n");
-  fprintf(o->output, " xmlns:gml='http://www.opengis.net/gml'\n");
-  fprintf(o->output, " xmlns:xsd='http://www.w3.org/2001/XMLSchema'\n");
-  fprintf(o->output, " xmlns:ogc='http://www.opengis.net/ogc'\n");
-  fprintf(o->output, " xmlns:xlink='http://www.w3.org/1999/xlink'\n");
-  fprintf(o->output, " xmlns:ows='http://www.opengis.net/ows'\n");
+  ows_output_str(o, " xmlns:wfs='http://www.opengis.net/wfs'\n");
+  ows_output_str(o, " xmlns:xsi='http://www.w3.org/2001/XMLSchema-instance'\n");
+  ows_output_str(o, " xmlns:gml='http://www.opengis.net/gml'\n");
+  ows_output_str(o, " xmlns:xsd='http://www.w3.org/2001/XMLSchema'\n");
+  ows_output_str(o, " xmlns:ogc='http://www.opengis.net/ogc'\n");
+  ows_output_str(o, " xmlns:xlink='http://www.w3.org/1999/xlink'\n");
+  ows_output_str(o, " xmlns:ows='http://www.opengis.net/ows'\n");
 
-  fprintf(o->output, " xsi:schemaLocation='");
+  ows_output_str(o, " xsi:schemaLocation='");
   if (ows_version_get(o->request->version) == 100)
-    fprintf(o->output, "%s\n    %s?service=WFS&amp;version=1.0.0&amp;request=DescribeFeatureType",
-            namespaces->first->value->buf, o->online_resource->buf);
+    ows_output_printf(o, "%s\n    %s?service=WFS&amp;version=1.0.0&amp;request=DescribeFeatureType",
+              namespaces->first->value->buf, o->online_resource->buf);
   else
-    fprintf(o->output, "%s\n    %s?service=WFS&amp;version=1.1.0&amp;request=DescribeFeatureType",
-            namespaces->first->value->buf, o->online_resource->buf);
+    ows_output_printf(o, "%s\n    %s?service=WFS&amp;version=1.1.0&amp;request=DescribeFeatureType",
+              namespaces->first->value->buf, o->online_resource->buf);
 
   /* FeatureId request could be without Typename parameter */
   if (wr->typename) {
-    fprintf(o->output, "&amp;Typename=");
+    ows_output_str(o, "&amp;Typename=");
     for (ln = wr->typename->first ; ln ; ln = ln->next) {
-      fprintf(o->output, "%s", ln->value->buf);
-      if (ln->next) fprintf(o->output, ",");
+      ows_output_str(o, ln->value->buf);
+      if (ln->next) ows_output_str(o, ",");
     }
   }
 
   if (ows_version_get(o->request->version) == 100) {
-    fprintf(o->output, "   http://www.opengis.net/wfs\n");
-    fprintf(o->output, "   http://schemas.opengis.net/wfs/1.0.0/WFS-basic.xsd\n");
+    ows_output_str(o, "   http://www.opengis.net/wfs\n");
+    ows_output_str(o, "   http://schemas.opengis.net/wfs/1.0.0/WFS-basic.xsd\n");
   } else {
-    fprintf(o->output, "   http://www.opengis.net/wfs\n");
-    fprintf(o->output, "   http://schemas.opengis.net/wfs/1.1.0/wfs.xsd\n");
+    ows_output_str(o, "   http://www.opengis.net/wfs\n");
+    ows_output_str(o, "   http://schemas.opengis.net/wfs/1.1.0/wfs.xsd\n");
   }
 
   if (wr->format == WFS_GML212) {
-    fprintf(o->output, "   http://www.opengis.net/gml\n");
-    fprintf(o->output, "   http://schemas.opengis.net/gml/2.1.2/feature.xsd'\n");
+    ows_output_str(o, "   http://www.opengis.net/gml\n");
+    ows_output_str(o, "   http://schemas.opengis.net/gml/2.1.2/feature.xsd'\n");
   } else {
-    fprintf(o->output, "   http://www.opengis.net/gml\n");
-    fprintf(o->output, "   http://schemas.opengis.net/gml/3.1.1/base/gml.xsd'\n");
+    ows_output_str(o, "   http://www.opengis.net/gml\n");
+    ows_output_str(o, "   http://schemas.opengis.net/gml/3.1.1/base/gml.xsd'\n");
   }
 
   array_free(namespaces);
@@ -316,21 +370,25 @@ static void wfs_gml_display_hits(ows * o, wfs_request * wr, mlist * request_list
 
   wfs_gml_display_namespaces(o, wr);
 
-  /* Just count the number of features */
+  /* Just count the number of features, all counts are pipelined */
   for (ln = request_list->first->value->first ; ln ; ln = ln->next) {
     buffer_add_head_str(ln->value, "SELECT count(*) FROM (");
     buffer_add_str(ln->value, ") AS foo");
+    ows_psql_pipeline_send(o, ln->value->buf);
+  }
+  ows_psql_pipeline_send(o, "SELECT localtimestamp");
 
-    res = ows_psql_exec(o, ln->value->buf);
+  for (ln = request_list->first->value->first ; ln ; ln = ln->next) {
+    res = ows_psql_pipeline_result(o);
     if (PQresultStatus(res) == PGRES_TUPLES_OK)
       hits = hits + atoi(PQgetvalue(res, 0, 0));
     PQclear(res);
   }
 
   /* Render GML hits output */
-  res = ows_psql_exec(o, "SELECT localtimestamp");
+  res = ows_psql_pipeline_result(o);
   date = ows_psql_timestamp_to_xml_time(PQgetvalue(res, 0, 0));
-  fprintf(o->output, " timeStamp='%s' numberOfFeatures='%d' />\n", date->buf, hits);
+  ows_output_printf(o, " timeStamp='%s' numberOfFeatures='%d' />\n", date->buf, hits);
   buffer_free(date);
   PQclear(res);
 }
@@ -346,6 +404,8 @@ static void wfs_gml_display_results(ows * o, wfs_request * wr, mlist * request_l
   list *fe;
   PGresult *res;
   ows_bbox *outer_b;
+  wfs_gml_plan *plan;
+  buffer *bbox_sql = NULL;
 
   assert(o && wr && request_list);
 
@@ -354,11 +414,29 @@ static void wfs_gml_display_results(ows * o, wfs_request * wr, mlist * request_l
 
   /* Display the first node and namespaces */
   wfs_gml_display_namespaces(o, wr);
-  fprintf(o->output, ">\n");
+  ows_output_str(o, ">\n");
+
+  /*
+   * Bbox and features statements are independent: they're sent together,
+   * and when no cursor is involved, every layer statement is sent upfront
+   */
+  if (o->display_bbox) {
+    bbox_sql = ows_bbox_boundaries_sql(o, request_list->first->next->value, request_list->last->value, wr->srs);
+    if (bbox_sql) ows_psql_pipeline_send(o, bbox_sql->buf);
+  }
+
+  for (ln = request_list->first->value->first ; ln ; ln = ln->next) {
+    ows_psql_cursor_send(o, ln->value->buf);
+    if (o->fetch_size > 0) break;
+  }
 
   /* Display only if we really asked the bbox of the features retrieved. Overhead could be signifiant ! */
   if (o->display_bbox) {
-    outer_b = ows_bbox_boundaries(o, request_list->first->next->value, request_list->last->value, wr->srs);
+    if (bbox_sql) {
+      outer_b = ows_bbox_boundaries_result(ows_psql_pipeline_result(o), wr->srs);
+      buffer_free(bbox_sql);
+    } else outer_b = ows_bbox_init();
+
     wfs_gml_bounded_by(o, wr, outer_b->xmin, outer_b->ymin, outer_b->xmax, outer_b->ymax, outer_b->srs);
     ows_bbox_free(outer_b);
   }
@@ -370,11 +448,16 @@ static void wfs_gml_display_results(ows * o, wfs_request * wr, mlist * request_l
 
   for (ln = request_list->first->value->first ; ln ; ln = ln->next) {
 
-    res = ows_psql_exec(o, ln->value->buf);
+    /* Following cursors are only sent once the previous one is closed */
+    if (!o->pipeline->first) ows_psql_cursor_send(o, ln->value->buf);
+    res = ows_psql_cursor_result(o);
 
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
       PQclear(res);
 
+      /* Discard statements still pending */
+      while (o->pipeline->first) PQclear(ows_psql_pipeline_result(o));
+
       /* Increments the nodes */
       if (wr->typename)     ln_typename = ln_typename->next;
       if (wr->featureid)    mln_fid = mln_fid->next;
@@ -396,11 +479,14 @@ static void wfs_gml_display_results(ows * o, wfs_request * wr, mlist * request_l
       list_free(fe);
     }
 
-    /* Display each feature member */
-    if (wr->propertyname) wfs_gml_feature_member(o, wr, layer_uri, mln_property->value, res);
-    else                  wfs_gml_feature_member(o, wr, layer_uri, NULL, res);   /* PropertyNames not mandatory */
+    /* PropertyNames not mandatory */
+    plan = wfs_gml_plan_init(o, wr, layer_uri, wr->propertyname ? mln_property->value : NULL, res);
 
-    PQclear(res);
+    /* Display each feature member, one batch of rows at a time */
+    for ( /* empty */ ; res ; res = ows_psql_cursor_next(o, res))
+      wfs_gml_feature_member(o, plan, res);
+
+    wfs_gml_plan_free(plan);
 
     /* Increments the nodes */
     if (wr->featureid)    mln_fid = mln_fid->next;
@@ -408,7 +494,7 @@ static void wfs_gml_display_results(ows * o, wfs_request * wr, mlist * request_l
     if (wr->typename)     ln_typename = ln_typename->next;
   }
 
-  fprintf(o->output, "</wfs:FeatureCollection>\n");
+  ows_output_str(o, "</wfs:FeatureCollection>\n");
 }
 
 
@@ -565,9 +651,9 @@ static mlist *wfs_retrieve_sql_request_list(ows * o, wfs_request * wr)
   mlist *requests;
   mlist_node *mln_fid;
   list *fid, *sql_req, *from_list, *where_list;
-  list_node *ln_typename, *ln_filter;
+  list_node *ln_typename, *ln_filter, *ln_sql, *ln_where;
   buffer *geom, *sql, *where, *layer_name, *layer_uri, *sql_count;
-  int srid, size, cpt, features, max_features;
+  int srid, size, cpt, features, max_features, count;
   filter_encoding *fe;
   ows_bbox *bbox;
   char *escaped;
@@ -579,6 +665,7 @@ static mlist *wfs_retrieve_sql_request_list(ows * o, wfs_request * wr)
   ln_typename = ln_filter = NULL;
   where = geom = NULL;
   size = features = 0;
+  max_features = -1;
 
   /* Initialize the nodes to run through typename and fid */
   if (wr->typename) {
@@ -717,33 +804,9 @@ static mlist *wfs_retrieve_sql_request_list(ows * o, wfs_request * wr)
     if (max_features > 0 && wr->typename->size == 1) {
       buffer_add_str(where, " LIMIT ");
       buffer_add_int(where, max_features);
-    } else if (max_features > 0 && wr->typename->size > 1) {
-      /* We have to compute LIMIT for each layer in this case ! */
-      sql_count = buffer_init();
-      buffer_add_str(sql_count, "SELECT count(*) FROM (");
-      buffer_copy(sql_count, sql);
-      buffer_copy(sql_count, where);
-      buffer_add_str(sql_count, " LIMIT ");
-      buffer_add_int(sql_count, max_features - features );
-      buffer_add_str(sql_count, ") AS c");
-      res = ows_psql_exec(o, sql_count->buf);
-      if (PQresultStatus(res) == PGRES_TUPLES_OK) {
-        if (features + atoi(PQgetvalue(res, 0, 0)) <= max_features) {
-          buffer_add_str(where, " LIMIT ");
-          if ((max_features - features) > 0)
-            buffer_add_int(where, max_features - features);
-          else buffer_add_int(where, 0);
-          features += atoi(PQgetvalue(res, 0, 0));
-        }
-      }
-      PQclear(res);
-      buffer_free(sql_count);
     }
 
-    buffer_copy(sql, where);
-
-    /* fprintf(stderr, "sql = %s\n", sql->buf); */
-
+    /* WHERE is appended to the SELECT once every LIMIT is known */
     list_add(sql_req, sql);
     list_add(where_list, where);
     list_add_by_copy(from_list, layer_uri);
@@ -754,6 +817,43 @@ static mlist *wfs_retrieve_sql_request_list(ows * o, wfs_request * wr)
     if (wr->filter)    ln_filter = ln_filter->next;
   }
 
+  /*
+   * With several layers, we have to compute LIMIT for each layer !
+   * Counts don't depend on each other (each one is bounded by max_features),
+   * so they're all sent at once, then LIMITs are deduced in layers order
+   */
+  if (max_features > 0 && wr->typename && wr->typename->size > 1) {
+    for (ln_sql = sql_req->first, ln_where = where_list->first ; ln_sql ;
+         ln_sql = ln_sql->next, ln_where = ln_where->next) {
+      sql_count = buffer_init();
+      buffer_add_str(sql_count, "SELECT count(*) FROM (");
+      buffer_copy(sql_count, ln_sql->value);
+      buffer_copy(sql_count, ln_where->value);
+      buffer_add_str(sql_count, " LIMIT ");
+      buffer_add_int(sql_count, max_features);
+      buffer_add_str(sql_count, ") AS c");
+      ows_psql_pipeline_send(o, sql_count->buf);
+      buffer_free(sql_count);
+    }
+
+    for (ln_where = where_list->first ; ln_where ; ln_where = ln_where->next) {
+      res = ows_psql_pipeline_result(o);
+      if (PQresultStatus(res) == PGRES_TUPLES_OK) {
+        count = atoi(PQgetvalue(res, 0, 0));
+        if (count > max_features - features) count = max_features - features;
+
+        buffer_add_str(ln_where->value, " LIMIT ");
+        buffer_add_int(ln_where->value, max_features - features);
+        features += count;
+      }
+      PQclear(res);
+    }
+  }
+
+  for (ln_sql = sql_req->first, ln_where = where_list->first ; ln_sql ;
+       ln_sql = ln_sql->next, ln_where = ln_where->next)
+    buffer_copy(ln_sql->value, ln_where->value);
+
   /* requests multiple list contains three lists : sql requests, from list and where list */
   requests = mlist_init();
   mlist_add(requests, sql_req);
@@ -794,24 +894,24 @@ static void wfs_geojson_display_results(ows * o, wfs_request * wr, mlist * reque
   {
          assert(wr->callback);
 
-         fprintf(o->output, "Content-Type: application/javascript\n\n");
-         fprintf(o->output, "%s", wr->callback->buf);
-         fprintf(o->output, "(");
+         ows_output_str(o, "Content-Type: application/javascript\n\n");
+         ows_output_str(o, wr->callback->buf);
+         ows_output_str(o, "(");
 
-  } else fprintf(o->output, "Content-Type: application/json\n\n");
+  } else ows_output_str(o, "Content-Type: application/json\n\n");
   
 
-  fprintf(o->output, "{\"type\": \"FeatureCollection\", \"crs\":{\"type\":\"name\",\"properties\":{\"name\":\"");
+  ows_output_str(o, "{\"type\": \"FeatureCollection\", \"crs\":{\"type\":\"name\",\"properties\":{\"name\":\"");
   if (ows_version_get(o->request->version) == 100)
-    fprintf(o->output, "EPSG:%i", wr->srs->srid);
+    ows_output_printf(o, "EPSG:%i", wr->srs->srid);
   else
-    fprintf(o->output, "urn:ogc:def:crs:EPSG::%i", wr->srs->srid);
+    ows_output_printf(o, "urn:ogc:def:crs:EPSG::%i", wr->srs->srid);
 
-  fprintf(o->output, "\"}}, \"features\": [");
+  ows_output_str(o, "\"}}, \"features\": [");
 
   for (ln = request_list->first->value->first ; ln ; ln = ln->next) {
 
-    res = ows_psql_exec(o, ln->value->buf);
+    res = ows_psql_cursor_open(o, ln->value->buf);
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
       PQclear(res);
       ll = ll->next;
@@ -827,66 +927,68 @@ static void wfs_geojson_display_results(ows * o, wfs_request * wr, mlist * reque
          number = PQfnumber(res, id_name->buf);
     buffer_empty(id_name);
 
-    for (i=0 ; i < PQntuples(res) ; i++) {
-
-      first_col = true;
-      geoms = 0;
+    /* Rows are rendered one batch at a time */
+    for ( /* empty */ ; res ; res = ows_psql_cursor_next(o, res)) {
+      for (i=0 ; i < PQntuples(res) ; i++) {
 
-      if (first_row) first_row = false;
-      else fprintf(o->output, ",");
-
-      if ( number >= 0 ) {
-        buffer_add_str(id_name, "\"id\": \"");
-        buffer_copy(id_name, ows_layer_no_uri(o->layers, ll->value));
-        buffer_add_str(id_name, ".");
-        buffer_add_str(id_name, PQgetvalue(res, i, number));
-        buffer_add_str(id_name, "\", ");
-      }
-      for (an = prop_table->first, j=0 ; an ; an = an->next, j++) {
-        
-        if (ows_psql_is_geometry_column(o, ll->value, an->key)) {
-          buffer_add_str(geom, PQgetvalue(res, i, j));
-          geoms++;
-        } else {
+        first_col = true;
+        geoms = 0;
 
-          if (first_col)  first_col = false;
-          else buffer_add_str(prop, ", \"");
+        if (first_row) first_row = false;
+        else ows_output_str(o, ",");
 
-          buffer_copy(prop, an->key);
-          buffer_add_str(prop, "\": \"");
-          value_enc = buffer_encode_json_str(PQgetvalue(res, i, j));
-          buffer_copy(prop, value_enc);
-          buffer_free(value_enc);
-          buffer_add(prop, '"');
+        if ( number >= 0 ) {
+          buffer_add_str(id_name, "\"id\": \"");
+          buffer_copy(id_name, ows_layer_no_uri(o->layers, ll->value));
+          buffer_add_str(id_name, ".");
+          buffer_add_str(id_name, PQgetvalue(res, i, number));
+          buffer_add_str(id_name, "\", ");
+        }
+        for (an = prop_table->first, j=0 ; an ; an = an->next, j++) {
+
+          if (ows_psql_is_geometry_column(o, ll->value, an->key)) {
+            buffer_add_str(geom, PQgetvalue(res, i, j));
+            geoms++;
+          } else {
+
+            if (first_col)  first_col = false;
+            else buffer_add_str(prop, ", \"");
+
+            buffer_copy(prop, an->key);
+            buffer_add_str(prop, "\": \"");
+            value_enc = buffer_encode_json_str(PQgetvalue(res, i, j));
+            buffer_copy(prop, value_enc);
+            buffer_free(value_enc);
+            buffer_add(prop, '"');
+          }
         }
-      }
 
-      if (geoms == 0) {
-        fprintf(o->output,
-                "{\"type\":\"Feature\", %s\"properties\":{\"%s}}\n",
-                id_name->buf, prop->buf);
-      } else if (geoms == 1) {
-        fprintf(o->output,
-                "{\"type\":\"Feature\", %s\"properties\":{\"%s}, \"geometry\":%s}\n",
-                id_name->buf, prop->buf, geom->buf);
-      } else if (geoms > 1) {
-        fprintf(o->output,
-                "{\"type\":\"Feature\", %s\"properties\":{\"%s}, \"geometry\":%s%s]}}\n",
-                id_name->buf,
-                prop->buf, "{ \"type\": \"GeometryCollection\", \"geometries\": [",
-                geom->buf);
+        if (geoms == 0) {
+          ows_output_printf(o,
+                    "{\"type\":\"Feature\", %s\"properties\":{\"%s}}\n",
+                    id_name->buf, prop->buf);
+        } else if (geoms == 1) {
+          ows_output_printf(o,
+                    "{\"type\":\"Feature\", %s\"properties\":{\"%s}, \"geometry\":%s}\n",
+                    id_name->buf, prop->buf, geom->buf);
+        } else if (geoms > 1) {
+          ows_output_printf(o,
+                    "{\"type\":\"Feature\", %s\"properties\":{\"%s}, \"geometry\":%s%s]}}\n",
+                    id_name->buf,
+                    prop->buf, "{ \"type\": \"GeometryCollection\", \"geometries\": [",
+                    geom->buf);
+        }
+        buffer_empty(prop);
+        buffer_empty(geom);
+        buffer_empty(id_name);
       }
-      buffer_empty(prop);
-      buffer_empty(geom);
-      buffer_empty(id_name);
     }
 
-    PQclear(res);
     ll = ll->next;
   }
 
-  fprintf(o->output, "]}");
-  if (wr->format == WFS_JSONP) fprintf(o->output, ");");
+  ows_output_str(o, "]}");
+  if (wr->format == WFS_JSONP) ows_output_str(o, ");");
 
   buffer_free(geom);
   buffer_free(prop);
@@ -58,6 +58,9 @@ wfs_request *wfs_request_init()
   wr->callback = NULL;
 
   wr->insert_results = NULL;
+  wr->extent_geoms = NULL;
+  wr->extent_reset = NULL;
+  wr->valid_geoms = NULL;
   wr->delete_results = 0;
   wr->update_results = 0;
 
@@ -181,6 +184,9 @@ void wfs_request_free(wfs_request * wr)
   if (wr->sortby)         buffer_free(wr->sortby);
   if (wr->sections)       list_free(wr->sections);
   if (wr->insert_results) alist_free(wr->insert_results);
+  if (wr->extent_geoms)   alist_free(wr->extent_geoms);
+  if (wr->extent_reset)   list_free(wr->extent_reset);
+  if (wr->valid_geoms)    list_free(wr->valid_geoms);
   if (wr->callback)       buffer_free(wr->callback);
 
   free(wr);
@@ -948,7 +954,6 @@ void wfs_request_check(ows * o, wfs_request * wr, const array * cgi)
  */
 void wfs(ows * o, wfs_request * wf)
 {
-  buffer *op;
   assert(o && wf);
 
   /* Run the request's execution */
@@ -979,8 +984,9 @@ void wfs(ows * o, wfs_request * wf)
 
       } else {
         if (array_is_key(o->cgi, "operations")) {
-          op = array_get(o->cgi, "operations");
-          wfs_parse_operation(o, wf, op);
+          wfs_parse_operation(o, wf);
+        } else if (o->stream) {
+          wfs_parse_operation_stream(o, wf);
         } else {
           ows_error(o, OWS_ERROR_INVALID_PARAMETER_VALUE, "Operation parameter must be set", "Transaction");
           return;
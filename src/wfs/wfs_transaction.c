@@ -69,6 +69,72 @@ static buffer *wfs_execute_transaction_request(ows * o, wfs_request * wr, buffer
 }
 
 
+/*
+ * Keep a written geometry, to widen the layer's cached extent
+ * once the transaction is committed
+ */
+static void wfs_transaction_extent_add(ows * o, wfs_request * wr, buffer * layer_name, buffer * geom)
+{
+  buffer *key;
+  bool exists;
+
+  assert(o);
+  assert(wr);
+  assert(layer_name);
+  assert(geom);
+
+  if (o->extent_ttl <= 0) return;
+  if (!wr->extent_geoms) wr->extent_geoms = alist_init();
+
+  key = buffer_from_str(layer_name->buf);
+  exists = alist_is_key(wr->extent_geoms, key->buf);
+  alist_add(wr->extent_geoms, key, buffer_from_str(geom->buf));
+  if (exists) buffer_free(key);
+}
+
+
+/*
+ * Mark a layer's cached extent as unreliable
+ * once the transaction is committed
+ */
+static void wfs_transaction_extent_reset(ows * o, wfs_request * wr, buffer * layer_name)
+{
+  assert(o);
+  assert(wr);
+  assert(layer_name);
+
+  if (o->extent_ttl <= 0) return;
+  if (!wr->extent_reset) wr->extent_reset = list_init();
+
+  if (!in_list(wr->extent_reset, layer_name)) list_add_by_copy(wr->extent_reset, layer_name);
+}
+
+
+/*
+ * Report committed changes to the layers' cached extents
+ */
+static void wfs_transaction_extent_update(ows * o, wfs_request * wr)
+{
+  alist_node *an;
+  list_node *ln;
+
+  assert(o);
+  assert(wr);
+
+  if (wr->extent_reset)
+    for (ln = wr->extent_reset->first ; ln ; ln = ln->next)
+      ows_layer_extent_reset(o, ln->value);
+
+  if (wr->extent_geoms)
+    for (an = wr->extent_geoms->first ; an ; an = an->next)
+      if (!wr->extent_reset || !in_list(wr->extent_reset, an->key))
+        ows_layer_extent_widen(o, an->key, an->value);
+
+  /* Rendered capabilities hold the former extents */
+  if (wr->extent_reset || wr->extent_geoms) wfs_capabilities_cache_reset(o);
+}
+
+
 /*
  * Summarize overall results of transaction request
  */
@@ -81,20 +147,20 @@ static void wfs_transaction_summary(ows * o, wfs_request * wr, buffer * result)
   assert(wr);
   assert(result);
 
-  fprintf(o->output, "<wfs:TransactionSummary>\n");
+  ows_output_str(o, "<wfs:TransactionSummary>\n");
 
   if (buffer_cmp(result, "PGRES_COMMAND_OK")) {
 
     if (wr->insert_results) {
       for (an = wr->insert_results->first ; an ; an = an->next) nb += an->value->size;
-      fprintf(o->output, " <wfs:totalInserted>%d</wfs:totalInserted>\n", nb);
+      ows_output_printf(o, " <wfs:totalInserted>%d</wfs:totalInserted>\n", nb);
     }
 
-    fprintf(o->output, "<wfs:totalUpdated>%d</wfs:totalUpdated>\n", wr->update_results);
-    fprintf(o->output, " <wfs:totalDeleted>%d</wfs:totalDeleted>\n", wr->delete_results);
+    ows_output_printf(o, "<wfs:totalUpdated>%d</wfs:totalUpdated>\n", wr->update_results);
+    ows_output_printf(o, " <wfs:totalDeleted>%d</wfs:totalDeleted>\n", wr->delete_results);
   }
 
-  fprintf(o->output, "</wfs:TransactionSummary>\n");
+  ows_output_str(o, "</wfs:TransactionSummary>\n");
 }
 
 
@@ -116,26 +182,26 @@ static void wfs_transaction_insert_result(ows * o, wfs_request * wr, buffer * re
   if ((!cgi_method_get()) && (buffer_cmp(result, "PGRES_COMMAND_OK") && (wr->insert_results->first))) {
 
     if (ows_version_get(o->request->version) == 110)
-      fprintf(o->output, "<wfs:InsertResults>\n");
+      ows_output_str(o, "<wfs:InsertResults>\n");
 
     for (an = wr->insert_results->first ; an ; an = an->next) {
 
       if (ows_version_get(o->request->version) == 100) {
-        fprintf(o->output, "<wfs:InsertResult handle=\"%s\">", an->key->buf);
+        ows_output_printf(o, "<wfs:InsertResult handle=\"%s\">", an->key->buf);
         for (ln = an->value->first ; ln ; ln = ln->next)
-          fprintf(o->output, "<ogc:FeatureId fid=\"%s\"/>", ln->value->buf);
-        fprintf(o->output, "</wfs:InsertResult>\n");
+          ows_output_printf(o, "<ogc:FeatureId fid=\"%s\"/>", ln->value->buf);
+        ows_output_str(o, "</wfs:InsertResult>\n");
       } else {
         for (ln = an->value->first ; ln ; ln = ln->next) {
-          fprintf(o->output, "<wfs:Feature handle=\"%s\">\n", an->key->buf);
-          fprintf(o->output, " <ogc:FeatureId fid=\"%s\"/>\n", ln->value->buf);
-          fprintf(o->output, "</wfs:Feature>\n");
+          ows_output_printf(o, "<wfs:Feature handle=\"%s\">\n", an->key->buf);
+          ows_output_printf(o, " <ogc:FeatureId fid=\"%s\"/>\n", ln->value->buf);
+          ows_output_str(o, "</wfs:Feature>\n");
         }
       }
     }
 
     if (ows_version_get(o->request->version) == 110)
-      fprintf(o->output, "</wfs:InsertResults>");
+      ows_output_str(o, "</wfs:InsertResults>");
   }
 }
 
@@ -157,25 +223,25 @@ static void wfs_transaction_result(ows * o, wfs_request * wr, buffer * result, b
           && !buffer_cmp(result, "PGRES_COMMAND_OK"))) {
 
     if (ows_version_get(o->request->version) == 110)
-      fprintf(o->output, "<wfs:TransactionResults>\n");
+      ows_output_str(o, "<wfs:TransactionResults>\n");
     else {
-      fprintf(o->output, "<wfs:TransactionResult>\n");
+      ows_output_str(o, "<wfs:TransactionResult>\n");
       /* display status transaction only for 1.0.0 version */
-      fprintf(o->output, "<wfs:Status>");
+      ows_output_str(o, "<wfs:Status>");
 
       if (buffer_cmp(result, "PGRES_COMMAND_OK"))
-        fprintf(o->output, "<wfs:SUCCESS/>");
-      else fprintf(o->output, "<wfs:FAILED/>");
+        ows_output_str(o, "<wfs:SUCCESS/>");
+      else ows_output_str(o, "<wfs:FAILED/>");
 
-      fprintf(o->output, "</wfs:Status>\n");
+      ows_output_str(o, "</wfs:Status>\n");
     }
 
 
     if (ows_version_get(o->request->version) == 100)
-      fprintf(o->output, "</wfs:TransactionResult>\n");
+      ows_output_str(o, "</wfs:TransactionResult>\n");
     else {
-      fprintf(o->output, "</wfs:Action>\n");
-      fprintf(o->output, "</wfs:TransactionResults>\n");
+      ows_output_str(o, "</wfs:Action>\n");
+      ows_output_str(o, "</wfs:TransactionResults>\n");
     }
   }
 }
@@ -198,23 +264,23 @@ static void wfs_transaction_response(ows * o, wfs_request * wr, buffer * result,
     return;
   }
 
-  fprintf(o->output, "Content-Type: application/xml\n\n");
-  fprintf(o->output, "<?xml version='1.0' encoding='%s'?>\n", o->encoding->buf);
+  ows_output_str(o, "Content-Type: application/xml\n\n");
+  ows_output_printf(o, "<?xml version='1.0' encoding='%s'?>\n", o->encoding->buf);
 
   if (ows_version_get(o->request->version) == 100)
-    fprintf(o->output, "<wfs:WFS_TransactionResponse version=\"1.0.0\"\n");
-  else fprintf(o->output, "<wfs:TransactionResponse version=\"1.1.0\"\n");
+    ows_output_str(o, "<wfs:WFS_TransactionResponse version=\"1.0.0\"\n");
+  else ows_output_str(o, "<wfs:TransactionResponse version=\"1.1.0\"\n");
 
-  fprintf(o->output, " xmlns:wfs=\"http://www.opengis.net/wfs\"\n");
-  fprintf(o->output, " xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n");
-  fprintf(o->output, " xmlns:ogc=\"http://www.opengis.net/ogc\"\n");
+  ows_output_str(o, " xmlns:wfs=\"http://www.opengis.net/wfs\"\n");
+  ows_output_str(o, " xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n");
+  ows_output_str(o, " xmlns:ogc=\"http://www.opengis.net/ogc\"\n");
 
   if (ows_version_get(o->request->version) == 100) {
-    fprintf(o->output, " xsi:schemaLocation='http://www.opengis.net/wfs");
-    fprintf(o->output, " http://schemas.opengis.net/wfs/1.0.0/WFS-transaction.xsd'>\n");
+    ows_output_str(o, " xsi:schemaLocation='http://www.opengis.net/wfs");
+    ows_output_str(o, " http://schemas.opengis.net/wfs/1.0.0/WFS-transaction.xsd'>\n");
   } else {
-    fprintf(o->output, " xsi:schemaLocation='http://www.opengis.net/wfs");
-    fprintf(o->output, " http://schemas.opengis.net/wfs/1.1.0/wfs.xsd'>\n");
+    ows_output_str(o, " xsi:schemaLocation='http://www.opengis.net/wfs");
+    ows_output_str(o, " http://schemas.opengis.net/wfs/1.1.0/wfs.xsd'>\n");
   }
 
   if (ows_version_get(o->request->version) == 100) {
@@ -227,8 +293,8 @@ static void wfs_transaction_response(ows * o, wfs_request * wr, buffer * result,
   }
 
   if (ows_version_get(o->request->version) == 100)
-    fprintf(o->output, "</wfs:WFS_TransactionResponse>\n");
-  else fprintf(o->output, "</wfs:TransactionResponse>\n");
+    ows_output_str(o, "</wfs:WFS_TransactionResponse>\n");
+  else ows_output_str(o, "</wfs:TransactionResponse>\n");
 }
 
 
@@ -251,7 +317,6 @@ static buffer *wfs_retrieve_value(ows * o, wfs_request * wr, buffer * value, xml
   if (!content_escaped) {
     xmlFree(content);
     buffer_free(value);
-    xmlFreeDoc(xmldoc);
     ows_error(o, OWS_ERROR_FORBIDDEN_CHARACTER,
               "Some forbidden character are present into the request", "transaction");
   }
@@ -311,32 +376,364 @@ static buffer *wfs_retrieve_typename(ows * o, wfs_request * wr, xmlNodePtr n)
 
 
 /*
- * Insert features into the database
- * Method POST, XML
+ * Columns and values of a feature to insert, appended to sql and values
+ * (each one preceded by a comma)
+ * Return NULL, or the error
  */
-static buffer *wfs_insert_xml(ows * o, wfs_request * wr, xmlDocPtr xmldoc, xmlNodePtr n)
+static buffer *wfs_insert_columns(ows * o, wfs_request * wr, xmlDocPtr xmldoc, xmlNodePtr n,
+                                  buffer * layer_name, ows_srs * srs_root, buffer * sql, buffer * values)
 {
-  buffer *values, *column, *layer_name, *layer_ns_prefix, *result, *sql, *gml;
-  buffer *handle, *id_column, *fid_full_name, *dup_sql, *id;
+  buffer *column, *gml, *result;
   xmlNodePtr node, elemt;
   filter_encoding *fe;
-  PGresult *res;
   array * table;
   char *escaped;
-  list *l;
-  ows_srs * srs_root = NULL;
+
+  node = n->children;
+
+  /* Jump to the next element if spaces */
+  while (node != NULL && node->type != XML_ELEMENT_NODE) node = node->next;
+
+  /* Fill SQL fields and values at once */
+  for ( /* empty */ ; node; node = node->next) {
+
+    if (node->type == XML_ELEMENT_NODE &&
+        ( buffer_cmp(ows_layer_ns_uri(o->layers, layer_name), (char *) node->ns->href)
+          || !strcmp("http://www.opengis.net/gml",     (char *) node->ns->href)
+          || !strcmp("http://www.opengis.net/gml/3.2", (char *) node->ns->href))) {
+
+      /* We have to ignore if not present in database,
+                     gml elements (name, description, boundedBy) */
+      if (    !strcmp("http://www.opengis.net/gml",     (char *) node->ns->href)
+           || !strcmp("http://www.opengis.net/gml/3.2", (char *) node->ns->href)) {
+        table = ows_psql_describe_table(o, layer_name);
+        if (!array_is_key(table, (char *) node->name)) continue;
+      }
+      buffer_add(sql, ',');
+      buffer_add(values, ',');
+
+      column = buffer_from_str((char *) node->name);
+
+      buffer_add_str(sql, "\"");
+      escaped = ows_psql_escape_string(o, column->buf);
+      if (escaped) {
+        buffer_add_str(sql, escaped);
+        free(escaped);
+      }
+      buffer_add_str(sql, "\"");
+
+      /* If column's type is a geometry, transform the GML into WKT */
+      if (ows_psql_is_geometry_column(o, layer_name, column)) {
+        elemt = node->children;
+
+        /* Jump to the next element if spaces */
+        while (elemt != NULL && elemt->type != XML_ELEMENT_NODE) elemt = elemt->next;
+        if (elemt != NULL) {
+          if (!strcmp((char *) elemt->name, "Box") ||
+              !strcmp((char *) elemt->name, "Envelope")) {
+
+            fe = filter_encoding_init();
+            fe->sql = fe_envelope(o, layer_name, fe, fe->sql, elemt);
+            if (fe->error_code != FE_NO_ERROR) {
+              result = fill_fe_error(o, fe);
+              buffer_free(column);
+              filter_encoding_free(fe);
+              return result;
+            }
+            buffer_copy(values, fe->sql);
+            filter_encoding_free(fe);
+            wfs_transaction_extent_reset(o, wr, layer_name);
+
+          } else if (!strcmp((char *) elemt->name, "Null")) {
+            buffer_add_str(values, "''");
+          } else {
+            gml = ows_psql_gml_to_sql_staged(o, elemt, srs_root, wr->valid_geoms);
+            if (gml) {
+              ows_psql_param_geometry(o, values, gml->buf);
+              wfs_transaction_extent_add(o, wr, layer_name, gml);
+              buffer_free(gml);
+            } else {
+              buffer_free(column);
+              return buffer_from_str("Error invalid Geometry");
+            }
+          }
+        }
+        else
+          buffer_add_str(values, "NULL");
+
+      } else values = wfs_retrieve_value(o, wr, values, xmldoc, node);
+
+      buffer_free(column);
+    }
+  }
+
+  return NULL;
+}
+
+
+/*
+ * Features of an Insert, staged to be written in bulk
+ */
+typedef struct Wfs_insert_feature {
+  xmlNodePtr node;
+  buffer * layer_name;
+  buffer * id;
+  enum wfs_insert_idgen idgen;
+} wfs_insert_feature;
+
+
+/*
+ * ReplaceDuplicate: look with a single request which ids of a layer
+ * are already used (or used by a previous feature of the same Insert)
+ * Those get a new id, others use their own
+ */
+static void wfs_insert_bulk_duplicates(ows * o, wfs_insert_feature * f, int size, int first)
+{
+  buffer *sql, *ids, *id_column, *type;
+  PGresult *res;
+  char *c;
+  int i, j, k;
+
+  id_column = ows_psql_id_column(o, f[first].layer_name);
+  type = ows_psql_type(o, f[first].layer_name, id_column);
+
+  sql = buffer_init();
+  ids = buffer_init();
+  buffer_add(ids, '{');
+
+  for (i = first, k = 0 ; i < size ; i++) {
+    if (f[i].idgen != WFS_REPLACE_DUPLICATE || !buffer_cmp(f[i].layer_name, f[first].layer_name->buf))
+      continue;
+
+    /* As an array item, f[i] is the k th one */
+    if (k++) buffer_add(ids, ',');
+    buffer_add(ids, '"');
+    for (c = f[i].id->buf ; *c ; c++) {
+      if (*c == '"' || *c == '\\') buffer_add(ids, '\\');
+      buffer_add(ids, *c);
+    }
+    buffer_add(ids, '"');
+  }
+  buffer_add(ids, '}');
+
+  buffer_add_str(sql, "SELECT u.i FROM unnest(CAST(");
+  ows_psql_param_str(o, sql, ids->buf);
+  buffer_add_str(sql, " AS text[])) WITH ORDINALITY AS u(v, i) WHERE EXISTS (SELECT 1 FROM \"");
+  buffer_copy(sql, ows_psql_schema_name(o, f[first].layer_name));
+  buffer_add_str(sql, "\".\"");
+  buffer_copy(sql, ows_psql_table_name(o, f[first].layer_name));
+  buffer_add_str(sql, "\" WHERE \"");
+  buffer_copy(sql, id_column);
+  buffer_add_str(sql, "\" = CAST(u.v AS \"");
+  if (type) buffer_copy(sql, type);
+  else buffer_add_str(sql, "text");
+  buffer_add_str(sql, "\"))");
+
+  res = ows_psql_exec(o, sql->buf);
+
+  for (i = first, k = 0 ; i < size ; i++) {
+    if (f[i].idgen != WFS_REPLACE_DUPLICATE || !buffer_cmp(f[i].layer_name, f[first].layer_name->buf))
+      continue;
+    k++;
+    f[i].idgen = WFS_USE_EXISTING;
+
+    /* As one by one, a failed request means a new id */
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+      f[i].idgen = WFS_GENERATE_NEW;
+      continue;
+    }
+
+    for (j = 0 ; j < PQntuples(res) ; j++)
+      if (atoi(PQgetvalue(res, j, 0)) == k) f[i].idgen = WFS_GENERATE_NEW;
+
+    /* Already inserted by a previous feature */
+    for (j = 0 ; j < i && f[i].idgen == WFS_USE_EXISTING ; j++)
+      if (f[j].idgen == WFS_USE_EXISTING && f[j].id->use
+          && buffer_cmp(f[j].layer_name, f[i].layer_name->buf)
+          && buffer_cmp(f[j].id, f[i].id->buf))
+        f[i].idgen = WFS_GENERATE_NEW;
+  }
+
+  PQclear(res);
+  buffer_free(ids);
+  buffer_free(sql);
+}
+
+
+/*
+ * Insert features in bulk: ids reserved once by layer, and consecutive
+ * features of the same layer and columns written as a multi-rows INSERT
+ * (ids are reported as one by one inserts would)
+ */
+static buffer *wfs_insert_xml_bulk(ows * o, wfs_request * wr, xmlDocPtr xmldoc, xmlNodePtr first,
+                                   buffer * handle, enum wfs_insert_idgen handle_idgen, ows_srs * srs_root)
+{
+  wfs_insert_feature *f;
+  buffer *sql, *columns, *values, *rows_columns, *result, *fid_full_name;
+  xmlNodePtr n;
+  xmlChar *attr;
+  list *l, *ids;
+  list_node *ln;
+  int i, j, size, count, rows, rows_layer;
+
+  for (size = 0, n = first ; n ; n = n->next)
+    if (n->type == XML_ELEMENT_NODE) size++;
+
+  f = malloc((size ? size : 1) * sizeof(wfs_insert_feature));
+  assert(f);
+
+  /* Stage the features, with their layer and their own id if any */
+  result = NULL;
+  for (size = 0, n = first ; n && !result ; n = n->next) {
+    if (n->type != XML_ELEMENT_NODE) continue;
+
+    f[size].node = n;
+    f[size].layer_name = buffer_init();
+    f[size].id = buffer_init();
+    f[size].idgen = handle_idgen;
+
+    buffer_add_str(f[size].layer_name, (char *) n->ns->href);
+    buffer_add(f[size].layer_name, ':');
+    buffer_add_str(f[size].layer_name, (char *) n->name);
+
+    attr = NULL;
+    if (xmlHasProp(n, (xmlChar *) "id"))       attr = xmlGetProp(n, (xmlChar *) "id");
+    else if (xmlHasProp(n, (xmlChar *) "fid")) attr = xmlGetProp(n, (xmlChar *) "fid");
+
+    if (attr) {
+      buffer_add_str(f[size].id, (char *) attr);
+      xmlFree(attr);
+    } else f[size].idgen = WFS_GENERATE_NEW;
+
+    if (f[size].id->use) {
+      l = list_explode('.', f[size].id);
+      if (l->last) {
+        buffer_empty(f[size].id);
+        buffer_copy(f[size].id, l->last->value);
+      }
+      list_free(l);
+    }
+
+    if (!ows_layer_writable(o->layers, f[size].layer_name))
+      result = buffer_from_str("Error unknown or not writable Layer Name");
+    else if (!ows_psql_id_column(o, f[size].layer_name))
+      result = buffer_from_str("Error unknown Layer Name or not id column available");
+
+    size++;
+  }
+
+  /* ReplaceDuplicate, one request by layer */
+  for (i = 0 ; i < size && !result ; i++)
+    if (f[i].idgen == WFS_REPLACE_DUPLICATE) wfs_insert_bulk_duplicates(o, f, size, i);
+
+  /* GenerateNew, ids reserved at once by layer */
+  for (i = 0 ; i < size && !result ; i++) {
+    if (f[i].idgen != WFS_GENERATE_NEW) continue;
+
+    for (j = i, count = 0 ; j < size ; j++)
+      if (f[j].idgen == WFS_GENERATE_NEW && buffer_cmp(f[j].layer_name, f[i].layer_name->buf)) count++;
+
+    ids = ows_psql_generate_ids(o, f[i].layer_name, count);
+    for (j = i, ln = ids->first ; j < size && ln ; j++) {
+      if (f[j].idgen != WFS_GENERATE_NEW || !buffer_cmp(f[j].layer_name, f[i].layer_name->buf)) continue;
+      buffer_empty(f[j].id);
+      buffer_copy(f[j].id, ln->value);
+      f[j].idgen = WFS_USE_EXISTING;
+      ln = ln->next;
+    }
+    list_free(ids);
+  }
+
+  sql = buffer_init();
+  columns = buffer_init();
+  values = buffer_init();
+  rows_columns = buffer_init();
+  rows = rows_layer = 0;
+
+  for (i = 0 ; i < size && !result ; i++) {
+
+    /* Retrieve the id of the inserted feature to report it in transaction response */
+    fid_full_name = buffer_init();
+    buffer_add_str(fid_full_name, (char *) f[i].node->name);
+    buffer_add(fid_full_name, '.');
+    buffer_copy(fid_full_name, f[i].id);
+    alist_add(wr->insert_results, handle, fid_full_name);
+
+    buffer_empty(columns);
+    buffer_empty(values);
+    buffer_add(columns, '"');
+    buffer_copy(columns, ows_psql_id_column(o, f[i].layer_name));
+    buffer_add(columns, '"');
+
+    result = wfs_insert_columns(o, wr, xmldoc, f[i].node, f[i].layer_name, srs_root, columns, values);
+    if (result) break;
+
+    /* Rows are written once the layer or the columns change, or when enough */
+    if (rows && (   rows == o->bulk_insert
+                 || !buffer_cmp(f[rows_layer].layer_name, f[i].layer_name->buf)
+                 || !buffer_cmp(rows_columns, columns->buf))) {
+      result = wfs_execute_transaction_request(o, wr, sql);
+      if (!buffer_cmp(result, "PGRES_COMMAND_OK")) break;
+      buffer_free(result);
+      result = NULL;
+      rows = 0;
+    }
+
+    if (!rows) {
+      buffer_empty(sql);
+      buffer_add_str(sql, "INSERT INTO \"");
+      buffer_copy(sql, ows_psql_schema_name(o, f[i].layer_name));
+      buffer_add_str(sql, "\".\"");
+      buffer_copy(sql, ows_psql_table_name(o, f[i].layer_name));
+      buffer_add_str(sql, "\" (");
+      buffer_copy(sql, columns);
+      buffer_add_str(sql, ") VALUES (");
+      buffer_empty(rows_columns);
+      buffer_copy(rows_columns, columns);
+      rows_layer = i;
+    } else buffer_add_str(sql, ", (");
+
+    /* As 'id' could be NULL in GML */
+    if (f[i].id->use) ows_psql_param_str(o, sql, f[i].id->buf);
+    else buffer_add_str(sql, "null");
+    buffer_copy(sql, values);
+    buffer_add(sql, ')');
+    rows++;
+  }
+
+  if (!result && rows) result = wfs_execute_transaction_request(o, wr, sql);
+  if (!result) result = buffer_from_str("PGRES_COMMAND_OK");
+
+  for (i = 0 ; i < size ; i++) {
+    buffer_free(f[i].layer_name);
+    buffer_free(f[i].id);
+  }
+  free(f);
+
+  buffer_free(sql);
+  buffer_free(columns);
+  buffer_free(values);
+  buffer_free(rows_columns);
+
+  return result;
+}
+
+
+/*
+ * Handle, idgen and srsName of an Insert operation
+ * Return NULL, or the error
+ */
+static buffer *wfs_insert_parameters(ows * o, xmlNodePtr n, buffer * handle,
+                                     enum wfs_insert_idgen * handle_idgen, ows_srs ** srs_root)
+{
   xmlChar *attr = NULL;
-  enum wfs_insert_idgen idgen = WFS_GENERATE_NEW;
-  enum wfs_insert_idgen handle_idgen = WFS_GENERATE_NEW;
 
   assert(o);
-  assert(wr);
-  assert(xmldoc);
   assert(n);
+  assert(handle);
 
-  sql = buffer_init();
-  handle = buffer_init();
-  result = NULL;
+  *handle_idgen = WFS_GENERATE_NEW;
+  *srs_root = NULL;
 
   /* retrieve handle attribute to report it in transaction response */
   if (xmlHasProp(n, (xmlChar *) "handle")) {
@@ -353,8 +750,8 @@ static buffer *wfs_insert_xml(ows * o, wfs_request * wr, xmlDocPtr xmldoc, xmlNo
   */
   if (xmlHasProp(n, (xmlChar *) "idgen")) {
     attr =  xmlGetProp(n, (xmlChar *) "idgen");
-    if (!strcmp((char *) attr, "ReplaceDuplicate")) handle_idgen = WFS_REPLACE_DUPLICATE;
-    else if (!strcmp((char *) attr, "UseExisting")) handle_idgen = WFS_USE_EXISTING;
+    if (!strcmp((char *) attr, "ReplaceDuplicate")) *handle_idgen = WFS_REPLACE_DUPLICATE;
+    else if (!strcmp((char *) attr, "UseExisting")) *handle_idgen = WFS_USE_EXISTING;
     xmlFree(attr);
     attr = NULL;
   }
@@ -365,264 +762,221 @@ static buffer *wfs_insert_xml(ows * o, wfs_request * wr, xmlDocPtr xmldoc, xmlNo
    */
   if (xmlHasProp(n, (xmlChar *) "srsName")) {
     attr =  xmlGetProp(n, (xmlChar *) "srsName");
-    srs_root = ows_srs_init();
+    *srs_root = ows_srs_init();
 
-    if (!ows_srs_set_from_srsname(o, srs_root, (char *) attr)) {
-      buffer_free(sql);
-      buffer_free(handle);
-      ows_srs_free(srs_root);
+    if (!ows_srs_set_from_srsname(o, *srs_root, (char *) attr)) {
+      ows_srs_free(*srs_root);
+      *srs_root = NULL;
       xmlFree(attr);
-      result = buffer_from_str("Unkwnown or wrong CRS used");
-      return result;
+      return buffer_from_str("Unkwnown or wrong CRS used");
     }
 
     xmlFree(attr);
-    attr = NULL;
   }
 
-  n = n->children;
+  return NULL;
+}
 
-  /* jump to the next element if there are spaces */
-  while (n->type != XML_ELEMENT_NODE) n = n->next;
 
-  /* Create Insert SQL query for each Typename */
-  for ( /* Empty */ ; n ; n = n->next) {
-    if (n->type != XML_ELEMENT_NODE) continue;
+/*
+ * Insert a feature into the database
+ * Return the result of the request
+ */
+static buffer *wfs_insert_feature_xml(ows * o, wfs_request * wr, xmlDocPtr xmldoc, xmlNodePtr n,
+                                      buffer * handle, enum wfs_insert_idgen handle_idgen, ows_srs * srs_root)
+{
+  buffer *values, *layer_name, *layer_ns_prefix, *result, *sql;
+  buffer *id_column, *fid_full_name, *dup_sql, *id;
+  PGresult *res;
+  char *escaped;
+  list *l;
+  xmlChar *attr = NULL;
+  enum wfs_insert_idgen idgen = WFS_GENERATE_NEW;
 
-    id = buffer_init();
-    values = buffer_init();
-    layer_name = buffer_init();
+  assert(o);
+  assert(wr);
+  assert(n);
 
-    /* name of the table in which features must be inserted */
-    buffer_add_str(layer_name, (char *) n->ns->href);
-    buffer_add(layer_name, ':');
-    buffer_add_str(layer_name, (char *) n->name);
-
-    if (!layer_name || !ows_layer_writable(o->layers, layer_name)) {
-      buffer_free(id);
-      buffer_free(sql);
-      buffer_free(values);
-      buffer_free(handle);
-      if (layer_name) buffer_free(layer_name);
-      if (srs_root) ows_srs_free(srs_root);
-      result = buffer_from_str("Error unknown or not writable Layer Name");
-      return result;
-    }
+  id = buffer_init();
+  layer_name = buffer_init();
 
-    idgen = handle_idgen;
+  /* name of the table in which features must be inserted */
+  buffer_add_str(layer_name, (char *) n->ns->href);
+  buffer_add(layer_name, ':');
+  buffer_add_str(layer_name, (char *) n->name);
 
-    /* In GML 3 GML:id is used, in GML 2.1.2 fid is used.
-     * In both cases no other attribute allowed in this element
-     * and in both cases (f)id is optionnal !
-     */
-    if (xmlHasProp(n, (xmlChar *) "id"))       attr = xmlGetProp(n, (xmlChar *) "id");
-    else if (xmlHasProp(n, (xmlChar *) "fid")) attr = xmlGetProp(n, (xmlChar *) "fid");
+  if (!ows_layer_writable(o->layers, layer_name)) {
+    buffer_free(id);
+    buffer_free(layer_name);
+    return buffer_from_str("Error unknown or not writable Layer Name");
+  }
 
-    if (attr) {
-      buffer_empty(id);
-      buffer_add_str(id, (char *) attr);
-      xmlFree(attr);
-    } else idgen = WFS_GENERATE_NEW;
-    /* FIXME should we end on error if UseExisting or Replace without id set ? */
-
-    id_column = ows_psql_id_column(o, layer_name);
-    if (!id_column) {
-      buffer_free(id);
-      buffer_free(sql);
-      buffer_free(values);
-      buffer_free(layer_name);
-      if (srs_root) ows_srs_free(srs_root);
-      result = buffer_from_str("Error unknown Layer Name or not id column available");
-      return result;
-    }
+  idgen = handle_idgen;
 
-    if (id->use) {
-      l = list_explode('.', id);
-      if (l->last) {
-        buffer_empty(id);
-        buffer_copy(id, l->last->value);
-      }
-      list_free(l);
-    }
+  /* In GML 3 GML:id is used, in GML 2.1.2 fid is used.
+   * In both cases no other attribute allowed in this element
+   * and in both cases (f)id is optionnal !
+   */
+  if (xmlHasProp(n, (xmlChar *) "id"))       attr = xmlGetProp(n, (xmlChar *) "id");
+  else if (xmlHasProp(n, (xmlChar *) "fid")) attr = xmlGetProp(n, (xmlChar *) "fid");
 
-    layer_ns_prefix = ows_layer_ns_prefix(o->layers, layer_name);
-    (void)layer_ns_prefix; // FIXME : unused variable ?
-
-    /* ReplaceDuplicate look if an ID is already used
-     *
-     * May not be safe if another transaction occur between
-     * this select and the related insert !!!
-     */
-    if (idgen == WFS_REPLACE_DUPLICATE) {
-      dup_sql = buffer_init();
-
-      buffer_add_str(dup_sql, "SELECT count(*) FROM \"");
-      buffer_copy(dup_sql, ows_psql_schema_name(o, layer_name));
-      buffer_add_str(dup_sql, "\".\"");
-      buffer_copy(dup_sql, ows_psql_table_name(o, layer_name));
-      buffer_add_str(dup_sql, "\" WHERE ");
-      buffer_copy(dup_sql, id_column);
-      buffer_add_str(dup_sql, "='");
-      escaped = ows_psql_escape_string(o, id->buf);
-      if (escaped) {
-        buffer_add_str(dup_sql, escaped);
-        free(escaped);
-      }
-      buffer_add_str(dup_sql, "';");
+  if (attr) {
+    buffer_add_str(id, (char *) attr);
+    xmlFree(attr);
+  } else idgen = WFS_GENERATE_NEW;
+  /* FIXME should we end on error if UseExisting or Replace without id set ? */
 
-      res = ows_psql_exec(o, dup_sql->buf);
-      if (PQresultStatus(res) != PGRES_TUPLES_OK || atoi((char *) PQgetvalue(res, 0, 0)) != 0)
-        idgen = WFS_GENERATE_NEW;
-      else
-        idgen = WFS_USE_EXISTING;
+  id_column = ows_psql_id_column(o, layer_name);
+  if (!id_column) {
+    buffer_free(id);
+    buffer_free(layer_name);
+    return buffer_from_str("Error unknown Layer Name or not id column available");
+  }
 
-      buffer_free(dup_sql);
-      PQclear(res);
+  if (id->use) {
+    l = list_explode('.', id);
+    if (l->last) {
+      buffer_empty(id);
+      buffer_copy(id, l->last->value);
     }
+    list_free(l);
+  }
 
-    if (idgen == WFS_GENERATE_NEW) {
-      buffer_free(id);
-      id = ows_psql_generate_id(o, layer_name);
-    }
+  layer_ns_prefix = ows_layer_ns_prefix(o->layers, layer_name);
+  (void)layer_ns_prefix; // FIXME : unused variable ?
 
-    /* Retrieve the id of the inserted feature
-     * to report it in transaction respons
-     */
-    fid_full_name = buffer_init();
-    buffer_add_str(fid_full_name, (char *) n->name);
-    buffer_add(fid_full_name, '.');
-    buffer_copy(fid_full_name, id);
-    alist_add(wr->insert_results, handle, fid_full_name);
+  /* ReplaceDuplicate look if an ID is already used
+   *
+   * May not be safe if another transaction occur between
+   * this select and the related insert !!!
+   */
+  if (idgen == WFS_REPLACE_DUPLICATE) {
+    dup_sql = buffer_init();
+
+    buffer_add_str(dup_sql, "SELECT count(*) FROM \"");
+    buffer_copy(dup_sql, ows_psql_schema_name(o, layer_name));
+    buffer_add_str(dup_sql, "\".\"");
+    buffer_copy(dup_sql, ows_psql_table_name(o, layer_name));
+    buffer_add_str(dup_sql, "\" WHERE ");
+    buffer_copy(dup_sql, id_column);
+    buffer_add_str(dup_sql, "='");
+    escaped = ows_psql_escape_string(o, id->buf);
+    if (escaped) {
+      buffer_add_str(dup_sql, escaped);
+      free(escaped);
+    }
+    buffer_add_str(dup_sql, "';");
 
-    buffer_add_str(sql, "INSERT INTO \"");
-    buffer_copy(sql, ows_psql_schema_name(o, layer_name));
-    buffer_add_str(sql, "\".\"");
-    buffer_copy(sql, ows_psql_table_name(o, layer_name));
-    buffer_add_str(sql, "\" (\"");
-    buffer_copy(sql, id_column);
-    buffer_add_str(sql, "\"");
+    res = ows_psql_exec(o, dup_sql->buf);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK || atoi((char *) PQgetvalue(res, 0, 0)) != 0)
+      idgen = WFS_GENERATE_NEW;
+    else
+      idgen = WFS_USE_EXISTING;
 
-    node = n->children;
+    buffer_free(dup_sql);
+    PQclear(res);
+  }
 
-    /* Jump to the next element if spaces */
-    while (node != NULL && node->type != XML_ELEMENT_NODE) node = node->next;
+  if (idgen == WFS_GENERATE_NEW) {
+    buffer_free(id);
+    id = ows_psql_generate_id(o, layer_name);
+  }
 
-    /* Fill SQL fields and values at once */
-    for ( /* empty */ ; node; node = node->next) {
+  /* Retrieve the id of the inserted feature
+   * to report it in transaction respons
+   */
+  fid_full_name = buffer_init();
+  buffer_add_str(fid_full_name, (char *) n->name);
+  buffer_add(fid_full_name, '.');
+  buffer_copy(fid_full_name, id);
+  alist_add(wr->insert_results, handle, fid_full_name);
 
+  sql = buffer_init();
+  values = buffer_init();
 
-      if (node->type == XML_ELEMENT_NODE &&
-          ( buffer_cmp(ows_layer_ns_uri(o->layers, layer_name), (char *) node->ns->href)
-            || !strcmp("http://www.opengis.net/gml",     (char *) node->ns->href)
-            || !strcmp("http://www.opengis.net/gml/3.2", (char *) node->ns->href))) {
+  buffer_add_str(sql, "INSERT INTO \"");
+  buffer_copy(sql, ows_psql_schema_name(o, layer_name));
+  buffer_add_str(sql, "\".\"");
+  buffer_copy(sql, ows_psql_table_name(o, layer_name));
+  buffer_add_str(sql, "\" (\"");
+  buffer_copy(sql, id_column);
+  buffer_add_str(sql, "\"");
 
-        /* We have to ignore if not present in database,
-                       gml elements (name, description, boundedBy) */
-        if (    !strcmp("http://www.opengis.net/gml",     (char *) node->ns->href)
-             || !strcmp("http://www.opengis.net/gml/3.2", (char *) node->ns->href)) {
-          table = ows_psql_describe_table(o, layer_name);
-          if (!array_is_key(table, (char *) node->name)) continue;
-        }
-        buffer_add(sql, ',');
-        buffer_add(values, ',');
+  result = wfs_insert_columns(o, wr, xmldoc, n, layer_name, srs_root, sql, values);
+  if (result) {
+    buffer_free(sql);
+    buffer_free(values);
+    buffer_free(id);
+    buffer_free(layer_name);
+    return result;
+  }
 
-        column = buffer_from_str((char *) node->name);
+  /* As 'id' could be NULL in GML */
+  if (id->use) {
+    buffer_add_str(sql, ") VALUES ('");
+    escaped = ows_psql_escape_string(o, id->buf);
+    if (escaped) {
+      buffer_add_str(sql, escaped);
+      free(escaped);
+    }
+    buffer_add_str(sql, "'");
+  } else buffer_add_str(sql, ") VALUES (null");
 
-        buffer_add_str(sql, "\"");
-        escaped = ows_psql_escape_string(o, column->buf);
-        if (escaped) {
-          buffer_add_str(sql, escaped);
-          free(escaped);
-        }
-        buffer_add_str(sql, "\"");
+  buffer_copy(sql, values);
+  buffer_add_str(sql, ") ");
 
-        /* If column's type is a geometry, transform the GML into WKT */
-        if (ows_psql_is_geometry_column(o, layer_name, column)) {
-          elemt = node->children;
+  /* Run the request to insert the feature */
+  result = wfs_execute_transaction_request(o, wr, sql);
 
-          /* Jump to the next element if spaces */
-          while (elemt != NULL && elemt->type != XML_ELEMENT_NODE) elemt = elemt->next;
-          if (elemt != NULL) {
-            if (!strcmp((char *) elemt->name, "Box") ||
-                !strcmp((char *) elemt->name, "Envelope")) {
+  buffer_free(sql);
+  buffer_free(values);
+  buffer_free(id);
+  buffer_free(layer_name);
 
-              fe = filter_encoding_init();
-              fe->sql = fe_envelope(o, layer_name, fe, fe->sql, elemt);
-              if (fe->error_code != FE_NO_ERROR) {
-                result = fill_fe_error(o, fe);
-                buffer_free(sql);
-                buffer_free(values);
-                buffer_free(column);
-                buffer_free(id);
-                filter_encoding_free(fe);
-                if (srs_root) ows_srs_free(srs_root);
-                return result;
-              }
-              buffer_copy(values, fe->sql);
-              filter_encoding_free(fe);
+  return result;
+}
 
-            } else if (!strcmp((char *) elemt->name, "Null")) {
-              buffer_add_str(values, "''");
-            } else {
-              gml = ows_psql_gml_to_sql(o, elemt, srs_root);
-              if (gml) {
-                buffer_add_str(values, "'");
-                buffer_copy(values, gml);
-                buffer_add_str(values, "'");
-                buffer_free(gml);
-              } else {
-                buffer_free(sql);
-                buffer_free(values);
-                buffer_free(column);
-                buffer_free(id);
-                buffer_free(layer_name);
-                if (srs_root) ows_srs_free(srs_root);
 
-                result = buffer_from_str("Error invalid Geometry");
-                return result;
-              }
-            }
-          }
-          else
-            buffer_add_str(values, "NULL");
+/*
+ * Insert features into the database
+ * Method POST, XML
+ */
+static buffer *wfs_insert_xml(ows * o, wfs_request * wr, xmlDocPtr xmldoc, xmlNodePtr n)
+{
+  buffer *handle, *result;
+  ows_srs * srs_root;
+  enum wfs_insert_idgen handle_idgen;
 
-        } else values = wfs_retrieve_value(o, wr, values, xmldoc, node);
+  assert(o);
+  assert(wr);
+  assert(xmldoc);
+  assert(n);
 
-        buffer_free(column);
-      }
-    }
+  handle = buffer_init();
 
-    /* As 'id' could be NULL in GML */
-    if (id->use) {
-      buffer_add_str(sql, ") VALUES ('");
-      escaped = ows_psql_escape_string(o, id->buf);
-      if (escaped) {
-        buffer_add_str(sql, escaped);
-        free(escaped);
-      }
-      buffer_add_str(sql, "'");
-    } else buffer_add_str(sql, ") VALUES (null");
+  result = wfs_insert_parameters(o, n, handle, &handle_idgen, &srs_root);
+  if (result) {
+    buffer_free(handle);
+    return result;
+  }
 
-    buffer_copy(sql, values);
-    buffer_add_str(sql, ") ");
+  if (o->bulk_insert > 0) {
+    result = wfs_insert_xml_bulk(o, wr, xmldoc, n->children, handle, handle_idgen, srs_root);
+    if (srs_root) ows_srs_free(srs_root);
+    return result;
+  }
 
-    buffer_free(values);
-    buffer_free(id);
+  /* Create Insert SQL query for each Typename */
+  for (n = n->children ; n ; n = n->next) {
+    if (n->type != XML_ELEMENT_NODE) continue;
 
-    /* Run the request to insert each feature */
-    if(result) buffer_free(result);
-    result = wfs_execute_transaction_request(o, wr, sql);
-    if (!buffer_cmp(result, "PGRES_COMMAND_OK")) {
-      buffer_free(sql);
-      if (srs_root) ows_srs_free(srs_root);
-      return result;
-    }
-    buffer_empty(sql);
-    buffer_free(layer_name);
+    if (result) buffer_free(result);
+    result = wfs_insert_feature_xml(o, wr, xmldoc, n, handle, handle_idgen, srs_root);
+    if (!buffer_cmp(result, "PGRES_COMMAND_OK")) break;
   }
 
-  buffer_free(sql);
   if (srs_root) ows_srs_free(srs_root);
+  if (!result) result = buffer_from_str("PGRES_COMMAND_OK");
 
   return result;
 }
@@ -721,6 +1075,10 @@ void wfs_delete(ows * o, wfs_request * wr)
     buffer_add_str(sql, "; ");
     buffer_free(where);
 
+    if (o->extent_delete == OWS_EXTENT_DELETE_RESET)
+      wfs_transaction_extent_reset(o, wr, layer_name);
+    buffer_free(layer_name);
+
     /*incrementation of the nodes */
     if (wr->featureid) mln_fid = mln_fid->next;
     if (wr->typename)  ln_typename = ln_typename->next;
@@ -728,6 +1086,7 @@ void wfs_delete(ows * o, wfs_request * wr)
   }
 
   result = wfs_execute_transaction_request(o, wr, sql);
+  if (buffer_cmp(result, "PGRES_COMMAND_OK")) wfs_transaction_extent_update(o, wr);
 
   locator = buffer_init();
   buffer_add_str(locator, "Delete");
@@ -748,7 +1107,7 @@ void wfs_delete(ows * o, wfs_request * wr)
  */
 static buffer *wfs_delete_xml(ows * o, wfs_request * wr, xmlNodePtr n)
 {
-  buffer *typename, *layer_name, *xmlstring, *result, *sql, *s, *t;
+  buffer *typename, *layer_name, *result, *sql, *s, *t;
   filter_encoding *filter;
 
   assert(o);
@@ -793,12 +1152,9 @@ static buffer *wfs_delete_xml(ows * o, wfs_request * wr, xmlNodePtr n)
   while (n->type != XML_ELEMENT_NODE) n = n->next;
   buffer_add_str(sql, " WHERE ");
 
-  /* put xml filter into a buffer */
-  xmlstring = buffer_init();
-  xmlstring = cgi_add_xml_into_buffer(xmlstring, n);
-
+  /* xml filter is translated right from the request document */
   filter = filter_encoding_init();
-  filter = fe_filter(o, filter, typename, xmlstring);
+  filter = fe_filter_node(o, filter, typename, n);
 
   /* check if filter returned an error */
   if (filter->error_code != FE_NO_ERROR)
@@ -808,10 +1164,12 @@ static buffer *wfs_delete_xml(ows * o, wfs_request * wr, xmlNodePtr n)
     buffer_add_str(sql, ";");
     /* run the SQL request to delete all specified features */
     result = wfs_execute_transaction_request(o, wr, sql);
+
+    if (o->extent_delete == OWS_EXTENT_DELETE_RESET)
+      wfs_transaction_extent_reset(o, wr, layer_name);
   }
 
   filter_encoding_free(filter);
-  buffer_free(xmlstring);
   buffer_free(typename);
   buffer_free(sql);
 
@@ -825,7 +1183,7 @@ static buffer *wfs_delete_xml(ows * o, wfs_request * wr, xmlNodePtr n)
  */
 static buffer *wfs_update_xml(ows * o, wfs_request * wr, xmlDocPtr xmldoc, xmlNodePtr n)
 {
-  buffer *typename, *layer_name, *xmlstring, *result, *sql, *property_name, *values, *gml, *s, *t;
+  buffer *typename, *layer_name, *result, *sql, *property_name, *values, *gml, *s, *t;
   filter_encoding *filter, *fe;
   xmlNodePtr node, elemt;
   xmlChar *content;
@@ -965,15 +1323,15 @@ static buffer *wfs_update_xml(ows * o, wfs_request * wr, xmlDocPtr xmldoc, xmlNo
 
               filter_encoding_free(fe);
               buffer_copy(values, fe->sql);
+              wfs_transaction_extent_reset(o, wr, layer_name);
 
             } else if (!strcmp((char *) elemt->name, "Null")) {
               buffer_add_str(values, "''");
             } else {
-              gml = ows_psql_gml_to_sql(o, elemt, srs_root);
+              gml = ows_psql_gml_to_sql_staged(o, elemt, srs_root, wr->valid_geoms);
               if (gml) {
-                buffer_add_str(values, "'");
-                buffer_copy(values, gml);
-                buffer_add_str(values, "'");
+                ows_psql_param_geometry(o, values, gml->buf);
+                wfs_transaction_extent_add(o, wr, layer_name, gml);
                 buffer_free(gml);
               } else {
                 buffer_free(values);
@@ -994,16 +1352,12 @@ static buffer *wfs_update_xml(ows * o, wfs_request * wr, xmlDocPtr xmldoc, xmlNo
 
       if (!strcmp((char *) n->name, "Filter")) {
         buffer_add_str(sql, " WHERE ");
-        xmlstring = buffer_init();
-        xmlstring = cgi_add_xml_into_buffer(xmlstring, n);
-
         filter = filter_encoding_init();
-        filter = fe_filter(o, filter, typename, xmlstring);
+        filter = fe_filter_node(o, filter, typename, n);
 
         /* check if filter returned an error */
         if (filter->error_code != FE_NO_ERROR) {
           result = fill_fe_error(o, filter);
-          buffer_free(xmlstring);
           filter_encoding_free(filter);
           buffer_free(values);
           buffer_free(sql);
@@ -1013,7 +1367,6 @@ static buffer *wfs_update_xml(ows * o, wfs_request * wr, xmlDocPtr xmldoc, xmlNo
 
         } else {
           buffer_copy(sql, filter->sql);
-          buffer_free(xmlstring);
           filter_encoding_free(filter);
         }
       }
@@ -1037,92 +1390,361 @@ static buffer *wfs_update_xml(ows * o, wfs_request * wr, xmlDocPtr xmldoc, xmlNo
 
 
 /*
- * Parse XML operations to execute each transaction operation
+ * Check at once the validity of the geometries an operation wrote
+ * An invalid one is reported rather than result, as a check
+ * geometry by geometry would have stopped the operation on it
  */
-void wfs_parse_operation(ows * o, wfs_request * wr, buffer * op)
+static void wfs_transaction_check_valid(ows * o, wfs_request * wr, const char *operation, buffer * result)
+{
+  assert(o);
+  assert(wr);
+  assert(result);
+
+  if (!wr->valid_geoms || !wr->valid_geoms->first) return;
+
+  if (ows_psql_geometries_invalid(o, wr->valid_geoms)) {
+    buffer_empty(result);
+    if (!strcmp(operation, "Update")) buffer_add_str(result, "Invalid GML Geometry");
+    else buffer_add_str(result, "Error invalid Geometry");
+  }
+
+  list_free(wr->valid_geoms);
+  wr->valid_geoms = list_init();
+}
+
+
+/*
+ * Fill locator with handle attribute if specified, else with operation name
+ */
+static void wfs_transaction_locator(xmlNodePtr n, buffer * locator)
 {
-  xmlDocPtr xmldoc;
-  xmlNodePtr n;
   xmlAttr *att;
   xmlChar *content;
 
-  buffer *sql, *result, *end_transaction, *locator;
+  if (n->properties) {
+    att = n->properties;
+
+    if (!strcmp((char *) att->name, "handle")) {
+      content = xmlNodeGetContent(att->children);
+      buffer_add_str(locator, (char *) content);
+      xmlFree(content);
+    } else buffer_add_str(locator, (char *) n->name);
+  } else     buffer_add_str(locator, (char *) n->name);
+}
+
+
+/*
+ * Initialize the transaction inside postgresql
+ * Return the result of the transaction so far
+ */
+static buffer *wfs_transaction_begin(ows * o, wfs_request * wr)
+{
+  buffer *sql, *result;
+
+  wr->insert_results = alist_init();
+  if (o->check_valid_geom) wr->valid_geoms = list_init();
+
+  sql = buffer_from_str("BEGIN;");
+  result = wfs_execute_transaction_request(o, wr, sql);
+  buffer_free(sql);
+
+  buffer_empty(result);
+  buffer_add_str(result, "PGRES_COMMAND_OK");
+
+  return result;
+}
+
+
+/*
+ * Execute an operation of the transaction
+ * Return its result, locator filled if failed
+ */
+static buffer *wfs_transaction_operation(ows * o, wfs_request * wr, xmlDocPtr xmldoc, xmlNodePtr n,
+    buffer * result, buffer * locator)
+{
+  if (!strcmp((char *) n->name, "Insert")) {
+    buffer_free(result);
+    result = wfs_insert_xml(o, wr, xmldoc, n);
+  } else if (!strcmp((char *) n->name, "Delete")) {
+    buffer_free(result);
+    result = wfs_delete_xml(o, wr, n);
+  } else if (!strcmp((char *) n->name, "Update")) {
+    buffer_free(result);
+    result = wfs_update_xml(o, wr, xmldoc, n);
+  }
+
+  /* Once failed, the check waits for the rollback */
+  if (buffer_cmp(result, "PGRES_COMMAND_OK")) wfs_transaction_check_valid(o, wr, (char *) n->name, result);
+
+  /* fill locator only if transaction failed */
+  if (!buffer_cmp(result, "PGRES_COMMAND_OK")) wfs_transaction_locator(n, locator);
+
+  return result;
+}
+
+
+/*
+ * End the transaction according to the result
+ */
+static void wfs_transaction_end(ows * o, wfs_request * wr, buffer * result, const char *operation)
+{
+  buffer *sql, *end_transaction;
+
+  if (buffer_cmp(result, "PGRES_COMMAND_OK")) sql = buffer_from_str("COMMIT;");
+  else                                        sql = buffer_from_str("ROLLBACK;");
+
+  end_transaction = wfs_execute_transaction_request(o, wr, sql);
+  if (!buffer_cmp(result, "PGRES_COMMAND_OK") && operation)
+    wfs_transaction_check_valid(o, wr, operation, result);
+  if (buffer_cmp(result, "PGRES_COMMAND_OK") && buffer_cmp(end_transaction, "PGRES_COMMAND_OK"))
+    wfs_transaction_extent_update(o, wr);
+  buffer_free(end_transaction);
+  buffer_free(sql);
+}
+
+
+/*
+ * Parse XML operations to execute each transaction operation
+ */
+void wfs_parse_operation(ows * o, wfs_request * wr)
+{
+  xmlDocPtr xmldoc;
+  xmlNodePtr n, operation;
+  buffer *result, *locator;
 
   assert(o);
   assert(wr);
-  assert(op);
 
-  sql = buffer_init();
-  locator = buffer_init();
-  wr->insert_results = alist_init();
-  content = NULL;
+  operation = NULL;
 
-  xmldoc = xmlParseMemory(op->buf, op->use);
+  /* request document, as parsed (and validated) once */
+  xmldoc = o->request->doc;
 
-  if (!xmldoc) {
-    xmlFreeDoc(xmldoc);
+  if (!xmldoc || !(n = xmlDocGetRootElement(xmldoc))) {
     wfs_error(o, wr, WFS_ERROR_NO_MATCHING, "xml isn't valid", "transaction");
     return;
   }
 
-  /* jump to the next element if there are spaces */
-  n = xmldoc->children;
-  while (n->type != XML_ELEMENT_NODE) n = n->next;
-  n = n->children;
-  while (n->type != XML_ELEMENT_NODE) n = n->next; /* FIXME really ? */
+  locator = buffer_init();
+  result = wfs_transaction_begin(o, wr);
 
-  /* initialize the transaction inside postgresql */
-  buffer_add_str(sql, "BEGIN;");
-  result = wfs_execute_transaction_request(o, wr, sql);
+  /* go through the operations while transaction is successful */
+  for (n = n->children ; n && (buffer_cmp(result, "PGRES_COMMAND_OK")) ; n = n->next) {
+    if (n->type != XML_ELEMENT_NODE) continue;
+    if (!n->ns || !n->ns->href || strcmp((char *) n->ns->href, "http://www.opengis.net/wfs")) continue;
+    if (   strcmp((char *) n->name, "Insert")
+        && strcmp((char *) n->name, "Delete")
+        && strcmp((char *) n->name, "Update")) continue;
+    operation = n;
 
-  buffer_empty(result);
-  buffer_add_str(result, "PGRES_COMMAND_OK");
-  buffer_empty(sql);
+    result = wfs_transaction_operation(o, wr, xmldoc, n, result, locator);
+  }
+
+  wfs_transaction_end(o, wr, result, operation ? (char *) operation->name : NULL);
+
+  /* display the xml transaction response */
+  wfs_transaction_response(o, wr, result, locator);
+
+  buffer_free(result);
+  buffer_free(locator);
+}
+
+
+/*
+ * Copy the element the reader is on, with its subtree, as the root
+ * of a new document, then move the reader after it
+ * The subtree is validated by the reader meanwhile (if asked)
+ * Return NULL if the input is not well formed, or not valid
+ */
+static xmlNodePtr wfs_stream_copy(ows * o, xmlTextReaderPtr r, int *ret)
+{
+  xmlNodePtr n, copy;
+  xmlDocPtr doc;
+  xmlNsPtr *ns;
+  int i;
+
+  n = xmlTextReaderExpand(r);
+  if (!n) {
+    *ret = -1;
+    return NULL;
+  }
+
+  doc = xmlNewDoc((xmlChar *) "1.0");
+  copy = xmlDocCopyNode(n, doc, 1);
+  xmlDocSetRootElement(doc, copy);
+
+  /* Namespaces in scope too, as QName values (typeName...) use them */
+  ns = xmlGetNsList(n->doc, n);
+  for (i = 0 ; ns && ns[i] ; i++)
+    if (!xmlSearchNs(doc, copy, ns[i]->prefix)) xmlNewNs(copy, ns[i]->href, ns[i]->prefix);
+  if (ns) xmlFree(ns);
+
+  *ret = xmlTextReaderNext(r);
+  if (*ret < 0 || (o->check_schema && xmlTextReaderIsValid(r) != 1)
+      || !ows_libxml_check_namespace(o, copy)) {
+    xmlFreeDoc(doc);
+    *ret = -1;
+    return NULL;
+  }
+
+  return copy;
+}
+
+
+/*
+ * Insert the features of a streamed Insert operation, one by one
+ * (reader on the Insert element, n being its copy without children)
+ * Return the reader status, once after the operation
+ */
+static int wfs_insert_stream(ows * o, wfs_request * wr, xmlTextReaderPtr r, xmlNodePtr n, buffer ** result)
+{
+  buffer *handle;
+  xmlNodePtr f;
+  ows_srs *srs_root;
+  enum wfs_insert_idgen handle_idgen;
+  int ret;
+
+  handle = buffer_init();
+
+  buffer_free(*result);
+  *result = wfs_insert_parameters(o, n, handle, &handle_idgen, &srs_root);
+  if (*result) {
+    buffer_free(handle);
+    return 1;
+  }
+  *result = buffer_from_str("PGRES_COMMAND_OK");
+
+  if (xmlTextReaderIsEmptyElement(r)) {
+    buffer_free(handle);
+    if (srs_root) ows_srs_free(srs_root);
+    return xmlTextReaderRead(r);
+  }
+
+  for (ret = xmlTextReaderRead(r) ; ret == 1 && buffer_cmp(*result, "PGRES_COMMAND_OK") ; ) {
+
+    if (xmlTextReaderDepth(r) == 1 && xmlTextReaderNodeType(r) == XML_READER_TYPE_END_ELEMENT) {
+      ret = xmlTextReaderRead(r);
+      break;
+    }
+
+    if (xmlTextReaderNodeType(r) != XML_READER_TYPE_ELEMENT) {
+      ret = xmlTextReaderRead(r);
+      continue;
+    }
+
+    f = wfs_stream_copy(o, r, &ret);
+    if (!f) break;
+
+    buffer_free(*result);
+    *result = wfs_insert_feature_xml(o, wr, f->doc, f, handle, handle_idgen, srs_root);
+    xmlFreeDoc(f->doc);
+
+    /* Geometries to check stay bounded too, the last ones are checked by the caller */
+    if (buffer_cmp(*result, "PGRES_COMMAND_OK") && wr->valid_geoms
+        && wr->valid_geoms->size >= WFS_VALID_GEOMS_BATCH)
+      wfs_transaction_check_valid(o, wr, "Insert", *result);
+  }
+
+  if (srs_root) ows_srs_free(srs_root);
+
+  return ret;
+}
+
+
+/*
+ * Execute the operations of a Transaction read as a stream, one
+ * operation (and for an Insert, one feature) at a time: memory used
+ * is the one of the largest, not of the whole request
+ */
+void wfs_parse_operation_stream(ows * o, wfs_request * wr)
+{
+  xmlTextReaderPtr r;
+  xmlSchemaValidCtxtPtr schema_ctx = NULL;
+  enum ows_schema_type schema_type;
+  xmlNodePtr n;
+  buffer *result, *locator, *operation, *schema;
+  int ret;
+
+  assert(o);
+  assert(wr);
+  assert(o->stream);
+
+  r = xmlReaderForIO(cgi_stream_read, NULL, o->stream, NULL, NULL, 0);
+  if (!r) {
+    ows_error(o, OWS_ERROR_REQUEST_HTTP, "Error on QUERY input", "request");
+    return;
+  }
+
+  schema_type = (ows_version_get(o->request->version) == 100) ? WFS_SCHEMA_TYPE_100 : WFS_SCHEMA_TYPE_110;
+
+  if (o->check_schema) {
+    schema = ows_schema_find(o, schema_type) ? NULL : wfs_generate_schema(o, o->request->version);
+    schema_ctx = ows_schema_valid_ctxt(o, schema, false, schema_type);
+    if (schema) buffer_free(schema);
+
+    if (!schema_ctx || xmlTextReaderSchemaValidateCtxt(r, schema_ctx, 0)) {
+      if (schema_ctx) xmlSchemaFreeValidCtxt(schema_ctx);
+      xmlFreeTextReader(r);
+      ows_error(o, OWS_ERROR_INVALID_PARAMETER_VALUE, "XML request isn't valid", "request");
+      return;
+    }
+  }
+
+  /* Root element, already checked to be a not empty Transaction */
+  while ((ret = xmlTextReaderRead(r)) == 1 && xmlTextReaderNodeType(r) != XML_READER_TYPE_ELEMENT);
+  if (ret == 1) ret = xmlTextReaderRead(r);
+
+  locator = buffer_init();
+  operation = buffer_init();
+  result = wfs_transaction_begin(o, wr);
 
   /* go through the operations while transaction is successful */
-  for ( /* empty */ ; n && (buffer_cmp(result, "PGRES_COMMAND_OK")) ; n = n->next) {
-    if (n->type != XML_ELEMENT_NODE) continue;
+  while (ret == 1 && buffer_cmp(result, "PGRES_COMMAND_OK")) {
 
-    if (!strcmp((char *) n->name, "Insert")) {
-      buffer_free(result);
-      result = wfs_insert_xml(o, wr, xmldoc, n);
-    } else if (!strcmp((char *) n->name, "Delete")) {
-      buffer_free(result);
-      result = wfs_delete_xml(o, wr, n);
-    } else if (!strcmp((char *) n->name, "Update")) {
-      buffer_free(result);
-      result = wfs_update_xml(o, wr, xmldoc, n);
+    if (xmlTextReaderDepth(r) != 1 || xmlTextReaderNodeType(r) != XML_READER_TYPE_ELEMENT) {
+      ret = xmlTextReaderRead(r);
+      continue;
     }
 
-    /* fill locator only if transaction failed */
-    if (!buffer_cmp(result, "PGRES_COMMAND_OK")) {
-      /* fill locator with  handle attribute if specified
-         else with transaction name */
-      if (n->properties) {
-        att = n->properties;
+    buffer_empty(operation);
+    buffer_add_str(operation, (char *) xmlTextReaderConstLocalName(r));
 
-        if (!strcmp((char *) att->name, "handle")) {
-          content = xmlNodeGetContent(att->children);
-          buffer_add_str(locator, (char *) content);
-          xmlFree(content);
-        } else buffer_add_str(locator, (char *) n->name);
-      } else     buffer_add_str(locator, (char *) n->name);
+    if (buffer_cmp(operation, "Insert")) {
+      n = xmlDocCopyNode(xmlTextReaderCurrentNode(r), xmlNewDoc((xmlChar *) "1.0"), 2);
+      xmlDocSetRootElement(n->doc, n);
+      ret = wfs_insert_stream(o, wr, r, n, &result);
+
+      if (buffer_cmp(result, "PGRES_COMMAND_OK"))
+        wfs_transaction_check_valid(o, wr, operation->buf, result);
+      if (!buffer_cmp(result, "PGRES_COMMAND_OK")) wfs_transaction_locator(n, locator);
+
+    } else {
+      n = wfs_stream_copy(o, r, &ret);
+      if (!n) break;
+      result = wfs_transaction_operation(o, wr, n->doc, n, result, locator);
     }
+
+    xmlFreeDoc(n->doc);
   }
 
-  /* end the transaction according to the result */
-  if (buffer_cmp(result, "PGRES_COMMAND_OK")) buffer_add_str(sql, "COMMIT;");
-  else                                        buffer_add_str(sql, "ROLLBACK;");
+  /* Not well formed, or not valid: nothing is kept */
+  if (ret < 0 || (schema_ctx && xmlTextReaderIsValid(r) != 1)) {
+    buffer_empty(result);
+    buffer_add_str(result, "XML request isn't valid");
+    wfs_transaction_end(o, wr, result, NULL);
+    ows_error(o, OWS_ERROR_INVALID_PARAMETER_VALUE, "XML request isn't valid", "request");
+  } else {
+    wfs_transaction_end(o, wr, result, operation->use ? operation->buf : NULL);
+    wfs_transaction_response(o, wr, result, locator);
+  }
 
-  end_transaction = wfs_execute_transaction_request(o, wr, sql);
-  buffer_free(end_transaction);
+  xmlFreeTextReader(r);
 
-  /* display the xml transaction response */
-  wfs_transaction_response(o, wr, result, locator);
+  /* Context is reused only if the validation went up to the end */
+  if (schema_ctx && ret == 0) ows_schema_valid_ctxt_release(o, schema_ctx, schema_type);
+  else if (schema_ctx) xmlSchemaFreeValidCtxt(schema_ctx);
 
-  buffer_free(sql);
   buffer_free(result);
   buffer_free(locator);
-
-  xmlFreeDoc(xmldoc);
+  buffer_free(operation);
 }
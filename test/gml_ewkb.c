@@ -0,0 +1,71 @@
+/*
+  Copyright (c) <2007-2012> <Barbara Philippot - Olivier Courtin>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+
+/*
+ * Native GML to EWKB conversion
+ *
+ * Print, in hexadecimal EWKB, the geometry of a GML file as converted
+ * by ows_gml_to_ewkb, so it could be compared with what PostGIS
+ * ST_AsEWKB(ST_GeomFromGML(...)) returns for the same GML.
+ * Fails if the geometry would be left to PostGIS instead.
+ *
+ * Use: gml_ewkb srid flip file.xml (see demo/check.sh)
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/ows/ows.h"
+
+
+int main(int argc, char *argv[])
+{
+  xmlDocPtr xmldoc;
+  buffer *ewkb;
+
+  if (argc != 4) {
+    fprintf(stderr, "Use: %s srid flip file.xml\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  xmldoc = xmlReadFile(argv[3], NULL, XML_PARSE_NONET);
+  if (!xmldoc || !xmlDocGetRootElement(xmldoc)) {
+    fprintf(stderr, "%s: not a valid XML document\n", argv[3]);
+    return EXIT_FAILURE;
+  }
+
+  ewkb = ows_gml_to_ewkb(xmlDocGetRootElement(xmldoc), atoi(argv[1]), atoi(argv[2]) != 0);
+  xmlFreeDoc(xmldoc);
+  xmlCleanupParser();
+
+  if (!ewkb) {
+    fprintf(stderr, "%s: geometry not handled by ows_gml_to_ewkb\n", argv[3]);
+    return EXIT_FAILURE;
+  }
+
+  printf("%s\n", ewkb->buf);
+  buffer_free(ewkb);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,255 @@
+/*
+  Copyright (c) <2007-2012> <Barbara Philippot - Olivier Courtin>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+
+/*
+ * KVP lexer microbenchmark
+ *
+ * Compare the character class tables used by cgi_parse_kvp against the
+ * former per character regular expressions: every byte is first checked
+ * to be classified the same way, then each KVP request file given on the
+ * command line (or found in a given directory) is lexed with both
+ * implementations.
+ *
+ * Use: make bench-kvp
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "../src/ows/ows.h"
+
+
+#define KVP_BENCH_LOOP 200
+#define KVP_BENCH_QUERY_MAX 1000000
+
+
+static bool kvp_regexp_key_char(char c)
+{
+  char string[2];
+
+  string[0] = c;
+  string[1] = '\0';
+
+  return check_regexp(string, "[A-Za-zà-ÿ]");
+}
+
+
+static bool kvp_regexp_value_char(char c, bool filter)
+{
+  char string[2];
+
+  string[0] = c;
+  string[1] = '\0';
+
+  return check_regexp(string, "[A-Za-zà-ÿ0-9.\\=;,():/\\*_ \\-]")
+         || (filter && check_regexp(string, "[A-Za-zà-ÿ0-9.#\\,():/_<> %\"\'=\\*!\\-]|\\[|\\]"));
+}
+
+
+/*
+ * Same decoding than cgi_parse_kvp does before lexing
+ */
+static void kvp_decode(char *q)
+{
+  int x, y;
+  char hex[3];
+
+  for (x = 0, y = 0; q[y]; ++x, ++y) {
+    if ((q[x] = q[y]) == '%' && q[y + 1] && q[y + 2]) {
+      hex[0] = q[y + 1];
+      hex[1] = q[y + 2];
+      hex[2] = '\0';
+      q[x] = (char) strtol(hex, NULL, 16);
+      y += 2;
+    }
+  }
+  q[x] = '\0';
+
+  for (x = 0; q[x]; x++) {
+    if (q[x] == '+' || q[x] == '\n' || q[x] == '\r') q[x] = ' ';
+  }
+}
+
+
+/*
+ * Lex a query the way cgi_parse_kvp does, return accepted characters number
+ */
+static int kvp_lex(const char *q, bool use_regexp)
+{
+  int i, nkey, nval;
+  bool in_key, in_filter;
+  char key[7];
+
+  in_key = true;
+  in_filter = false;
+  nkey = nval = 0;
+
+  for (i = 0; q[i]; i++) {
+    if (q[i] == '&') {
+      in_key = true;
+      in_filter = false;
+      nkey = nval = 0;
+    } else if (q[i] == '=') {
+      if (!nval) {
+        in_key = false;
+        in_filter = (nkey == 6 && !strncmp(key, "filter", 6));
+      } else nval++;
+    } else if (in_key) {
+      if (!(use_regexp ? kvp_regexp_key_char(q[i]) : cgi_kvp_key_char(q[i]))) return i;
+      if (nkey < 6) key[nkey] = tolower(q[i]);
+      nkey++;
+    } else {
+      if (!(use_regexp ? kvp_regexp_value_char(q[i], in_filter) : cgi_kvp_value_char(q[i], in_filter))) return i;
+      nval++;
+    }
+  }
+
+  return i;
+}
+
+
+static char *kvp_read_file(const char *path)
+{
+  FILE *f;
+  char *q;
+  size_t n;
+
+  f = fopen(path, "r");
+  if (!f) return NULL;
+
+  q = malloc(KVP_BENCH_QUERY_MAX + 1);
+  assert(q);
+  n = fread(q, 1, KVP_BENCH_QUERY_MAX, f);
+  q[n] = '\0';
+  fclose(f);
+
+  /* Request files are one line long */
+  q[strcspn(q, "\n")] = '\0';
+  kvp_decode(q);
+
+  return q;
+}
+
+
+static double kvp_elapsed(clock_t start)
+{
+  return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+
+static void kvp_bench_file(const char *path, double *t_regexp, double *t_table, long *chars)
+{
+  char *q;
+  int i, n_regexp, n_table;
+  clock_t start;
+
+  q = kvp_read_file(path);
+  if (!q) return;
+
+  n_regexp = n_table = 0;
+
+  start = clock();
+  for (i = 0; i < KVP_BENCH_LOOP; i++) n_regexp = kvp_lex(q, true);
+  *t_regexp += kvp_elapsed(start);
+
+  start = clock();
+  for (i = 0; i < KVP_BENCH_LOOP; i++) n_table = kvp_lex(q, false);
+  *t_table += kvp_elapsed(start);
+
+  if (n_regexp != n_table) {
+    fprintf(stderr, "%s: lexers disagree at char %d / %d\n", path, n_regexp, n_table);
+    exit(EXIT_FAILURE);
+  }
+
+  *chars += (long) n_table * KVP_BENCH_LOOP;
+  free(q);
+}
+
+
+int main(int argc, char *argv[])
+{
+  int c, i, files;
+  double t_regexp, t_table;
+  long chars;
+  char path[4096];
+  struct stat st;
+  struct dirent *de;
+  DIR *d;
+
+  /* Both lexers must accept exactly the same bytes */
+  for (c = 1; c < 256; c++) {
+    if (    kvp_regexp_key_char((char) c) != cgi_kvp_key_char((char) c)
+         || kvp_regexp_value_char((char) c, false) != cgi_kvp_value_char((char) c, false)
+         || kvp_regexp_value_char((char) c, true) != cgi_kvp_value_char((char) c, true)) {
+      fprintf(stderr, "character class mismatch on byte 0x%02X\n", c);
+      return EXIT_FAILURE;
+    }
+  }
+
+  t_regexp = t_table = 0.0;
+  chars = 0;
+  files = 0;
+
+  for (i = 1; i < argc; i++) {
+    if (stat(argv[i], &st)) continue;
+
+    if (!S_ISDIR(st.st_mode)) {
+      kvp_bench_file(argv[i], &t_regexp, &t_table, &chars);
+      files++;
+      continue;
+    }
+
+    d = opendir(argv[i]);
+    if (!d) continue;
+
+    while ((de = readdir(d))) {
+      if (de->d_name[0] == '.') continue;
+      snprintf(path, sizeof(path), "%s/%s", argv[i], de->d_name);
+      if (stat(path, &st) || !S_ISREG(st.st_mode)) continue;
+      kvp_bench_file(path, &t_regexp, &t_table, &chars);
+      files++;
+    }
+    closedir(d);
+  }
+
+  fprintf(stdout, "KVP requests:  %d (%d loops)\n", files, KVP_BENCH_LOOP);
+  fprintf(stdout, "Chars lexed:   %ld\n", chars);
+  fprintf(stdout, "Regexp lexer:  %.3f s\n", t_regexp);
+  fprintf(stdout, "Table lexer:   %.3f s\n", t_table);
+  if (t_table > 0.0)
+    fprintf(stdout, "Speedup:       %.0fx\n", t_regexp / t_table);
+
+  return EXIT_SUCCESS;
+}
+
+
+/*
+ * vim: expandtab sw=4 ts=4
+ */
@@ -0,0 +1,102 @@
+/*
+  Copyright (c) <2007-2012> <Barbara Philippot - Olivier Courtin>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+
+/*
+ * Prepared statements cache regression test
+ *
+ * A same request shape, first run with an int4 literal, then with
+ * numeric and int8 ones, must never be executed through a statement
+ * prepared for other parameters types.
+ * Statements are prepared between requests, as a FastCGI worker does.
+ *
+ * Use: statement_cache "conninfo" (see demo/check.sh)
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "../src/ows/ows.h"
+
+/* Built along with ows.c, whose main is renamed */
+#undef main
+
+
+static bool statement_cache_run(ows * o, const char *sql, const char *expected)
+{
+  PGresult *res;
+  bool ok;
+
+  res = ows_psql_statement_exec(o, sql);
+  ok = PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1
+       && !strcmp(PQgetvalue(res, 0, 0), expected);
+  if (!ok) fprintf(stderr, "%s: %s", sql, PQresultErrorMessage(res));
+  PQclear(res);
+
+  ows_psql_statements_prepare(o);
+
+  return ok;
+}
+
+
+int main(int argc, char *argv[])
+{
+  ows *o;
+  bool ok;
+
+  if (argc != 2) {
+    fprintf(stderr, "Use: %s conninfo\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  o = calloc(1, sizeof(ows));
+  assert(o);
+  o->statement_cache = 8;
+  o->pg = PQconnectdb(argv[1]);
+  if (PQstatus(o->pg) != CONNECTION_OK) {
+    fprintf(stderr, "%s", PQerrorMessage(o->pg));
+    return EXIT_FAILURE;
+  }
+
+  ok =    statement_cache_run(o, "SELECT 7 > 5", "t")
+       && statement_cache_run(o, "SELECT 7 > 5", "t")
+       && statement_cache_run(o, "SELECT 7 > 5.5", "t")
+       && statement_cache_run(o, "SELECT 7 > 5.5", "t")
+       && statement_cache_run(o, "SELECT 7 > 3000000000", "f")
+       && statement_cache_run(o, "SELECT 7 > 3000000000", "f")
+       && statement_cache_run(o, "SELECT 7 > 6", "t");
+
+  /* Each shape and types prepared once, then reused */
+  if (ok && (o->statements->misses != 3 || o->statements->hits != 4)) {
+    fprintf(stderr, "%lu hits, %lu misses\n", o->statements->hits, o->statements->misses);
+    ok = false;
+  }
+
+  ows_psql_statements_free(o->statements);
+  PQfinish(o->pg);
+  free(o);
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}